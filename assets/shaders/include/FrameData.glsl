@@ -0,0 +1,8 @@
+// Values shared by all programs. They are updated once per frame by FrameUniformBuffer.
+layout (std140) uniform FrameData {
+	mat4 uView;
+	mat4 uProjection;
+	mat4 uViewProjection;
+	vec4 uViewport;
+	float uTime;
+};
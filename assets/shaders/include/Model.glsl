@@ -0,0 +1,16 @@
+// The model matrix of the drawn object.
+#ifdef INSTANCED
+// A mat4 attribute takes 4 locations: 3, 4, 5, 6.
+layout (location = 3) in mat4 aInstanceModel;
+#else
+uniform mat4 uModel;
+#endif
+
+
+mat4 getModelMatrix() {
+#ifdef INSTANCED
+	return aInstanceModel;
+#else
+	return uModel;
+#endif
+}
@@ -1,25 +1,58 @@
+#include "CommandBuffer.hpp"
+#include "FrameUniformBuffer.hpp"
+#include "GlExtensions.hpp"
+#include "GlStateCache.hpp"
+#include "HeadlessContext.hpp"
+#include "MappedFile.hpp"
+#include "MultiDrawMesh.hpp"
+#include "RenderQueue.hpp"
 #include "Shader.hpp"
+#include "ShaderCompileQueue.hpp"
+#include "ShaderInterface.hpp"
+#include "ShaderLibrary.hpp"
+#include "ShaderProgramCache.hpp"
 #include "ShaderUniform.hpp"
 #include "ShaderUniformStore.hpp"
+#include "StreamingRingBuffer.hpp"
+#include "ThreadPool.hpp"
+#include "TransformStore.hpp"
 #include "Utilities.hpp"
-#include "VertexFormat.hpp"
+#include "VertexArrayCache.hpp"
+#include "benchmark/Benchmark.hpp"
 #include "camera/FreeMotionCamera.hpp"
 #include "camera/MovementDirection.hpp"
+#include "culling/FrustumCuller.hpp"
+#include "culling/OcclusionCuller.hpp"
 #include "model/GeometricModelFactory.hpp"
+#include "model/MeshFile.hpp"
+#include "model/PackedModel.hpp"
+#include "raster/SoftwareRasterizer.hpp"
+#include "raster/SoftwareTexture.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
 #include <vector>
 
-#include <glm/ext/matrix_clip_space.hpp>
-#include <glm/ext/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/mat4x4.hpp>
 
 // glad.h must be included before any header files that require OpenGL (like GLFW).
 #include <glad/glad.h>
+#if WITH_GLFW
 #include <GLFW/glfw3.h>
+#endif
 #include <stb_image.h>
 
 
@@ -27,17 +60,70 @@ static constexpr int WINDOW_WIDTH = 1024;
 static constexpr int WINDOW_HEIGHT = 728;
 static constexpr auto WINDOW_TITLE = "LearnOpenGL";
 
-static GLuint _vertexArrayBufferId = 0;
+// Opaque geometry with the depth test. The cubes aren't closed from inside, so the culling is off.
+static constexpr PipelineState OPAQUE_PIPELINE_STATE = {
+		.isDepthTestEnabled = true,
+		.isDepthWriteEnabled = true,
+		.depthFunc = GL_LESS,
+		.isBlendEnabled = false,
+		.isCullFaceEnabled = false,
+};
+
+static constexpr float CUBE_SCALE = 0.28f;
+
+// All meshes of the scene in shared buffers, so the visible instances of all of them are drawn with one call.
+static std::unique_ptr<MultiDrawMesh> _sceneMeshes;
+// It's converted from assets/meshes/cube.obj by the build. The path is relative to bin, like the assets.
+static constexpr std::string_view SCENE_MESH_FILE_NAME = "meshes/cube.mesh";
+// Per-frame instance data. A region holds 16k model matrices.
+static constexpr size_t INSTANCE_STREAM_REGION_SIZE = 1024 * 1024;
+static std::unique_ptr<StreamingRingBuffer> _instanceStream;
+static TransformStore _cubeTransforms;
+static std::vector<glm::mat4> _cubeModelMatrices;
+// The radii of the bounding spheres. The centers are the cube positions.
+static std::vector<float> _cubeBoundsRadius;
+static std::vector<uint32_t> _visibleCubeIndices;
+// The cubes in the frustum are the occluders too: the scene has no larger meshes.
+static std::unique_ptr<GeometricModel> _occluderModel;
+static std::unique_ptr<OcclusionCuller> _occlusionCuller;
+static constexpr int OCCLUSION_BUFFER_SCALE_DOWN = 4;
+static size_t _occlusionCandidatesCount = 0;
+static size_t _occlusionVisibleCount = 0;
+static RenderQueue _renderQueue;
+// The frame is recorded to the command buffers by all threads and replayed on the GL thread.
+// The frame commands set the per-frame values, the scene ones are recorded per chunk of the render queue.
+static CommandBuffer _frameCommands;
+static std::vector<CommandBuffer> _sceneCommands;
+static constexpr size_t MIN_RECORDING_CHUNK_SIZE = 4096;
+
+// Ids of the objects in the render queue keys and in the commands.
+static constexpr uint32_t OPAQUE_PASS = 0;
+static constexpr uint32_t OPAQUE_PIPELINE_ID = 0;
+static constexpr uint32_t CUBE_SHADER_ID = 0;
+static constexpr uint32_t CUBE_MATERIAL_ID = 0;
+// The vertex array of the shared buffers of _sceneMeshes.
+static constexpr uint32_t SCENE_MESHES_ID = 0;
+// The index of the cube in _sceneMeshes.
+static constexpr uint32_t CUBE_MESH_INDEX = 0;
+static constexpr GLint FIRST_SAMPLER_INDEX = 0;
+static constexpr GLint SECOND_SAMPLER_INDEX = 1;
 static GLuint _wallTextureId = 0;
 static GLuint _faceTextureId = 0;
-static size_t _verticesAmount = 0;
-static size_t _indicesAmount = 0;
-static std::unique_ptr<Shader> _shader;
+static std::shared_ptr<Shader> _shader;
+static std::shared_ptr<Shader> _fallbackShader;
+static ShaderCompileQueue _shaderCompileQueue;
+static std::unique_ptr<ShaderLibrary> _shaderLibrary;
+static std::unique_ptr<FrameUniformBuffer> _frameUniformBuffer;
+static glm::ivec2 _frameBufferSize = {0, 0};
 
 static FreeMotionCamera _camera;
 
 static glm::vec2 _cursorPos = {0.f, 0.f};
 static double _lastUpdateTimeSeconds = 0.f;
+static double _lastStatsReportTimeSeconds = 0.f;
+static constexpr double STATS_REPORT_PERIOD_SECONDS = 1.0;
+// The headless mode simulates 60 FPS.
+static constexpr double HEADLESS_FRAME_TIME_SECONDS = 1.0 / 60.0;
 
 struct CubeDrawParams
 {
@@ -58,6 +144,15 @@ static std::vector<CubeDrawParams> _cubesDrawParams = {
 };
 
 
+void setFrameBufferSize(int width, int height)
+{
+	glViewport(0, 0, width, height);
+	_frameBufferSize = {width, height};
+}
+
+
+// The windowed mode. Builds without GLFW (e.g. on Linux render boxes) have the headless mode only.
+#if WITH_GLFW
 void onGlfwError(int error, const char* description)
 {
 	std::cerr
@@ -70,7 +165,7 @@ void onGlfwError(int error, const char* description)
 void onFrameBufferSizeChanged(GLFWwindow* window, int width, int height)
 {
 	(void)(window);
-	glViewport(0, 0, width, height);
+	setFrameBufferSize(width, height);
 }
 
 
@@ -98,6 +193,19 @@ void onCursorMove(GLFWwindow* window, double posX, double posY)
 }
 
 
+void onKey(GLFWwindow* window, int key, int scanCode, int action, int mods)
+{
+	(void)(window);
+	(void)(scanCode);
+	(void)(mods);
+
+	if (key == GLFW_KEY_R && action == GLFW_PRESS) {
+		// Rebuild the shaders whose files have been edited.
+		_shaderLibrary->reloadChanged();
+	}
+}
+
+
 void processInput(GLFWwindow* window)
 {
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
@@ -131,14 +239,30 @@ void processInput(GLFWwindow* window)
 		_camera.processMovementInput(axisX, axisY);
 	}
 }
+#endif
 
 
 void loadShaderProgram()
 {
-	_shader = std::make_unique<Shader>("../assets/shaders/default.vsh", "../assets/shaders/default.fsh");
-	if (!_shader->isValid()) {
-		_shader.reset();
-	}
+	ShaderProgramCache::setDirectory("../cache/shaders");
+	// The uniform stores get the slots of the generated interface, so the values are set by indices.
+	ShaderUniformStore::setPredefinedSlots(ShaderInterface::UNIFORM_NAMES);
+	_shaderLibrary = std::make_unique<ShaderLibrary>(_shaderCompileQueue);
+
+	// The fallback shader is tiny and built synchronously, so there is always something to draw with.
+	_fallbackShader = _shaderLibrary->get(
+			"../assets/shaders/fallback.vsh",
+			"../assets/shaders/fallback.fsh",
+			{"INSTANCED"},
+			Shader::BuildMode::Sync
+	);
+
+	// Only the textured instanced variant is drawn, so the others aren't compiled.
+	_shader = _shaderLibrary->get(
+			"../assets/shaders/default.vsh",
+			"../assets/shaders/default.fsh",
+			{"TEXTURED", "INSTANCED"}
+	);
 }
 
 
@@ -153,12 +277,22 @@ GLuint loadTexture(const std::string_view textureFilename, const GLint internalF
 {
 	GLuint textureId = 0;
 
-	// Load texture data from file.
+	// Load texture data from file. The encoded image is decoded right from the mapped file.
+	const MappedFile textureFile(textureFilename);
+	if (!textureFile.isOpen()) {
+		std::cerr << "Texture file opening failed: " << textureFilename << std::endl;
+		return textureId;
+	}
+
 	stbi_set_flip_vertically_on_load(true);
 	int textureWidth = 0;
 	int textureHeight = 0;
 	int textureChannelsNum = 0;
-	unsigned char* textureData = stbi_load(textureFilename.data(), &textureWidth, &textureHeight, &textureChannelsNum, 0);
+	const std::span<const std::byte> encodedData = textureFile.getBytes();
+	unsigned char* textureData = stbi_load_from_memory(
+			reinterpret_cast<const stbi_uc*>(encodedData.data()), (int) encodedData.size(),
+			&textureWidth, &textureHeight, &textureChannelsNum, 0
+	);
 	if (textureData == nullptr) {
 		std::cerr << "stbi error! " << stbi_failure_reason() << ": " << textureFilename << std::endl;
 		return textureId;
@@ -166,7 +300,7 @@ GLuint loadTexture(const std::string_view textureFilename, const GLint internalF
 
 	// Generate and bind texture.
 	glGenTextures(1, &textureId);
-	glBindTexture(GL_TEXTURE_2D, textureId);
+	GlStateCache::bindTexture(0, GL_TEXTURE_2D, textureId);
 
 	// Set wrapping.
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -188,7 +322,7 @@ GLuint loadTexture(const std::string_view textureFilename, const GLint internalF
 	stbi_image_free(textureData);
 
 	// Reset bound texture.
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GlStateCache::bindTexture(0, GL_TEXTURE_2D, 0);
 
 	std::cout << "Texture is loaded: " << textureFilename << std::endl;
 
@@ -196,149 +330,312 @@ GLuint loadTexture(const std::string_view textureFilename, const GLint internalF
 }
 
 
-void doOnce()
+/**
+ * @brief Prints the counters of the previous frame once per STATS_REPORT_PERIOD_SECONDS and resets them.
+ */
+void reportFrameStats(const double curTimeSeconds)
+{
+	if (curTimeSeconds - _lastStatsReportTimeSeconds >= STATS_REPORT_PERIOD_SECONDS) {
+		_lastStatsReportTimeSeconds = curTimeSeconds;
+
+		const Shader::UniformUploadStats& uploadStats = Shader::getUniformUploadStats();
+		std::cout << "[Stats] Uniform uploads per frame:"
+				<< " issued " << uploadStats.issued
+				<< ", skipped " << uploadStats.skipped
+				<< std::endl;
+
+		const GlStateCache::Stats& stateStats = GlStateCache::getStats();
+		std::cout << "[Stats] GL state calls per frame:"
+				<< " issued " << stateStats.issued
+				<< ", elided " << stateStats.elided
+				<< std::endl;
+
+		// The stream counters are accumulated over the whole period, so a rare stall isn't missed.
+		const StreamingRingBuffer::Stats& streamStats = _instanceStream->getStats();
+		std::cout << "[Stats] Instance stream for " << streamStats.framesCount << " frames:"
+				<< " allocated " << streamStats.allocatedBytes << " bytes"
+				<< ", stalls " << streamStats.stallsCount << " (" << streamStats.stallsMs << " ms)"
+				<< ", orphans " << streamStats.orphansCount
+				<< ", overflows " << streamStats.overflowsCount
+				<< std::endl;
+		_instanceStream->resetStats();
+
+		std::cout << "[Stats] Occlusion culling: " << _occlusionCandidatesCount << " candidates"
+				<< ", visible " << _occlusionVisibleCount
+				<< std::endl;
+	}
+
+	Shader::resetUniformUploadStats();
+	GlStateCache::resetStats();
+}
+
+
+/**
+ * @brief Places the cubes of the scene. Both the GL and the software rendering draw them.
+ */
+void addSceneCubes()
+{
+	// The cube vertices are in [-1, 1], so the sphere around the cube has the radius of sqrt(3).
+	const float cubeRadius = CUBE_SCALE * std::sqrt(3.f);
+	for (const auto& drawParams: _cubesDrawParams) {
+		const glm::quat rotation = glm::angleAxis(glm::radians(drawParams.angleDegrees), glm::vec3(0.f, 1.f, 0.f));
+		_cubeTransforms.add({drawParams.pos, rotation, glm::vec3(CUBE_SCALE)});
+		_cubeBoundsRadius.push_back(cubeRadius);
+	}
+	_cubeModelMatrices.resize(_cubeTransforms.size());
+	_visibleCubeIndices.resize(_cubeTransforms.size());
+}
+
+
+void doOnce(double startTimeSeconds)
 {
-	_lastUpdateTimeSeconds = glfwGetTime();
+	_lastUpdateTimeSeconds = startTimeSeconds;
 
 	loadShaderProgram();
 
+	_frameUniformBuffer = std::make_unique<FrameUniformBuffer>();
+
 	_wallTextureId = loadTexture("../assets/textures/wall.jpg", GL_RGB, GL_RGB);
 	_faceTextureId = loadTexture("../assets/textures/awesomeface.png", GL_RGBA, GL_RGBA);
 
-	// Create and bind vertex array object (VAO).
-	// All the next calls of glBindBuffer, glVertexAttribPointer, glEnableVertexAttribArray will be bound to this vao.
-	glGenVertexArrays(1, &_vertexArrayBufferId);
-	glBindVertexArray(_vertexArrayBufferId);
+	// The mesh file is converted by the build. It's uploaded straight from the mapping and unmapped after that.
+	if (const std::optional<MeshFile> sceneMeshFile = MeshFile::open(SCENE_MESH_FILE_NAME)) {
+		_sceneMeshes = std::make_unique<MultiDrawMesh>(*sceneMeshFile);
+	} else {
+		std::cerr << "The scene meshes are packed at the start instead." << std::endl;
+		// The 20-byte packed vertices instead of the 36-byte float ones: the dequantization is folded into the instances.
+		const PackedModel sceneModels[] = {
+				PackedModel::pack(GeometricModelFactory::createCubeModel(), PackedModel::PositionEncoding::Half),
+//				PackedModel::pack(GeometricModelFactory::createRectangleModel(), PackedModel::PositionEncoding::Half),
+		};
+		_sceneMeshes = std::make_unique<MultiDrawMesh>(sceneModels);
+	}
+	_instanceStream = std::make_unique<StreamingRingBuffer>(INSTANCE_STREAM_REGION_SIZE);
+	_sceneMeshes->setInstanceStream(_instanceStream.get());
+
+	_occluderModel = std::make_unique<GeometricModel>(GeometricModelFactory::createCubeModel());
+	_occlusionCuller = std::make_unique<OcclusionCuller>(
+			WINDOW_WIDTH / OCCLUSION_BUFFER_SCALE_DOWN,
+			WINDOW_HEIGHT / OCCLUSION_BUFFER_SCALE_DOWN
+	);
+
+	addSceneCubes();
+}
+
+
+/**
+ * @brief Translates the sorted render queue to commands. It runs on worker threads, so it must not touch GL.
+ */
+struct CubeRecordingVisitor
+{
+	CommandBuffer* commands = nullptr;
+
+	void beginPass(uint32_t pass, bool isTranslucent)
+	{
+		(void) pass;
+		(void) isTranslucent;
+		commands->bindPipeline(OPAQUE_PIPELINE_ID);
+	}
 
-	// Create and bind vertex buffer object (VBO).
-	GLuint vboId = 0;
-	glGenBuffers(1, &vboId);
-	glBindBuffer(GL_ARRAY_BUFFER, vboId);
+	void bindShader(uint32_t shaderId) { commands->bindShader(shaderId); }
 
-	//
-	// Fill vbo.
-	//
+	void bindMaterial(uint32_t materialId) { commands->bindMaterial(materialId); }
 
-//	const GeometricModel model = GeometricModelFactory::createRectangleModel();
-	const GeometricModel model = GeometricModelFactory::createCubeModel();
-	const std::vector<VertexFormat>& vertices = model.getVertices();
-	_verticesAmount = vertices.size();
+	void bindVertexArray(uint32_t meshesId) { commands->bindVertexArray(meshesId); }
+
+	// The items of a run share the state, so they are drawn with one call, even if they are instances of different meshes.
+	void draw(std::span<const RenderQueue::Item> items)
+	{
+		const CommandBuffer::DrawInstancesData instances = commands->drawInstances(SCENE_MESHES_ID, items.size());
+		for (size_t i = 0; i < items.size(); ++i) {
+			instances.modelMatrices[i] = _cubeModelMatrices[items[i].payload];
+			instances.meshIndices[i] = CUBE_MESH_INDEX;
+		}
+	}
+};
 
-	const size_t bufferBytesSize = sizeof(vertices[0]) * _verticesAmount;
-	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) bufferBytesSize, vertices.data(), GL_STATIC_DRAW);
 
-	// Create and fill Element Buffer Object (EBO).
-	// It contains vertex indices (from VBO) which need to draw.
-	GLuint elementsBuffer = 0;
-	glGenBuffers(1, &elementsBuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementsBuffer);
+// Executes the recorded commands on the GL thread.
+struct CubeReplayVisitor
+{
+	Shader* shader = nullptr;
+	// Uniforms are uploaded by the shader binding, so the values set after it are uploaded before the next draw.
+	bool isUniformChanged = false;
 
-	const std::vector<unsigned int>& indices = model.getIndices();
-	_indicesAmount = indices.size();
-	const size_t elementsBufferSize = _indicesAmount * sizeof(indices[0]);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr) elementsBufferSize, indices.data(), GL_STATIC_DRAW);
+	void bindPipeline(uint32_t pipelineId)
+	{
+		(void) pipelineId;
+		GlStateCache::applyPipelineState(OPAQUE_PIPELINE_STATE);
+	}
 
-	// Configure vertex attributes.
+	void bindShader(uint32_t shaderId)
 	{
-		// 0. in vec3 aPos
-		const int attrLocation = 0;                     // The position of the attribute in the vertex shader.
-		const int attrSize = 3;                         // The number of components per the vertex attribute. Must be 1, 2, 3, 4.
-		const int attrStride = sizeof(VertexFormat);    // The next vertex attribute can be found after that amount of bytes.
-		const int attrDataOffset = 0;					// The offset of the attribute in bytes in the buffer data array.
-		glVertexAttribPointer(attrLocation, attrSize, GL_FLOAT, GL_FALSE, attrStride, (void*) attrDataOffset);
-		glEnableVertexAttribArray(attrLocation);
+		(void) shaderId;
+		shader->bind();
+		isUniformChanged = false;
 	}
+
+	void bindMaterial(uint32_t materialId)
 	{
-		// 1. in vec4 aColor
-		const int attrLocation = 1;
-		const int attrSize = 4;
-		const int attrStride = sizeof(VertexFormat);
-		const int attrDataOffset = sizeof(VertexFormat::Pos);
-		glVertexAttribPointer(attrLocation, attrSize, GL_FLOAT, GL_FALSE, attrStride, (void*) attrDataOffset);
-		glEnableVertexAttribArray(attrLocation);
+		(void) materialId;
+		GlStateCache::bindTexture(FIRST_SAMPLER_INDEX, GL_TEXTURE_2D, _wallTextureId);
+		GlStateCache::bindTexture(SECOND_SAMPLER_INDEX, GL_TEXTURE_2D, _faceTextureId);
 	}
+
+	void bindVertexArray(uint32_t meshesId)
 	{
-		// 2. in vec2 aTexCoords
-		const int attrLocation = 2;
-		const int attrSize = 2;
-		const int attrStride = sizeof(VertexFormat);
-		const int attrDataOffset = sizeof(VertexFormat::Pos) + sizeof(VertexFormat::Color);
-		glVertexAttribPointer(attrLocation, attrSize, GL_FLOAT, GL_FALSE, attrStride, (void*) attrDataOffset);
-		glEnableVertexAttribArray(attrLocation);
+		// The meshes bind their VAO on the draw.
+		(void) meshesId;
 	}
 
-	// Reset bound VAO.
-	glBindVertexArray(0);
+	void setUniform(int slot, const ShaderUniform& uniform)
+	{
+		shader->getUniforms().set(slot, uniform);
+		isUniformChanged = true;
+	}
 
-	// Enable Z-buffer testing. It requires to clear z-buffer each frame calling glClear(GL_DEPTH_BUFFER_BIT).
-	glEnable(GL_DEPTH_TEST);
-}
+	void drawInstances(uint32_t meshesId, std::span<const glm::mat4> modelMatrices, std::span<const uint32_t> meshIndices)
+	{
+		(void) meshesId;
+		if (isUniformChanged) {
+			shader->bind();
+			isUniformChanged = false;
+		}
+		_sceneMeshes->setInstances(meshIndices, modelMatrices);
+		_sceneMeshes->draw();
+	}
+};
 
 
-void doMainUpdate()
+/**
+ * @param curTimeSeconds The time of the frame. The headless mode passes a fixed step, so its frames are reproducible.
+ */
+void doMainUpdate(double curTimeSeconds)
 {
-	const double curTimeSeconds = glfwGetTime();
 	const auto deltaTime = static_cast<float>(curTimeSeconds - _lastUpdateTimeSeconds);
 	_lastUpdateTimeSeconds = curTimeSeconds;
 	_camera.update(deltaTime);
 
+	reportFrameStats(curTimeSeconds);
+
+	// The depth test requires to clear z-buffer each frame calling glClear(GL_DEPTH_BUFFER_BIT).
+	// The depth write must be enabled for the clear.
+	GlStateCache::applyPipelineState(OPAQUE_PIPELINE_STATE);
+
 	// Clear the frame buffer.
 	glClearColor(0.7f, 0.7f, 0.8f, 1.f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	const GLint firstSamplerIndex = 0;
-	glActiveTexture(GL_TEXTURE0 + firstSamplerIndex);
-	glBindTexture(GL_TEXTURE_2D, _wallTextureId);
-
-	const GLint secondSamplerIndex = 1;
-	glActiveTexture(GL_TEXTURE0 + secondSamplerIndex);
-	glBindTexture(GL_TEXTURE_2D, _faceTextureId);
-
-	if (_shader) {
-		ShaderUniformStore& uniforms = _shader->getUniforms();
-
-		// Set uniform values after the shader binding.
-		const auto v = static_cast<float>(std::sin(curTimeSeconds));
-		const float progress = v * 0.5f + 0.5f; // [0, 1]
-		uniforms.set(ShaderUniform::Float("uProgress", progress));
+	// Values shared by all shader programs are written once per frame.
+	FrameData frameData;
+	frameData.view = _camera.getViewMatrix();
+	const float aspectRatio = WINDOW_WIDTH / (float) WINDOW_HEIGHT;
+	frameData.projection = _camera.getProjectionMatrix(aspectRatio);
+	frameData.viewProjection = frameData.projection * frameData.view;
+	frameData.viewport = glm::vec4(0.f, 0.f, (float) _frameBufferSize.x, (float) _frameBufferSize.y);
+	frameData.time = static_cast<float>(curTimeSeconds);
+	_frameUniformBuffer->update(frameData);
+
+	// Draw with the fallback shader, until the main one is built.
+	_shaderCompileQueue.poll();
+	Shader* shader = _shader->isValid() ? _shader.get() : _fallbackShader.get();
+	if (!shader->isValid()) {
+		shader = nullptr;
+	}
 
-		uniforms.set(ShaderUniform::Sampler("sampler0", firstSamplerIndex));
-		uniforms.set(ShaderUniform::Sampler("sampler1", secondSamplerIndex));
+	if (!shader) {
+		return;
+	}
 
-		const glm::mat4 view = _camera.getViewMatrix();
-		uniforms.set(ShaderUniform::Mat4("uView", view));
+	// Set wireframe mode drawing.
+	// glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-		const float aspectRatio = WINDOW_WIDTH / (float) WINDOW_HEIGHT;
-		const float fovY = _camera.getFovYRadians();
-		const glm::mat4 projection = glm::perspective(fovY, aspectRatio, 0.1f, 100.f);
-		uniforms.set(ShaderUniform::Mat4("uProjection", projection));
+	// Only the cubes in the view are sent to GPU.
+	const Frustum frustum = Frustum::fromViewProjection(frameData.viewProjection);
+	const SphereBoundsSoa cubeBounds = {
+			_cubeTransforms.getPositionsX(),
+			_cubeTransforms.getPositionsY(),
+			_cubeTransforms.getPositionsZ(),
+			_cubeBoundsRadius,
+	};
+	size_t visibleCubesCount = FrustumCuller::cullSpheres(frustum, cubeBounds, _visibleCubeIndices);
+	_cubeTransforms.computeModelMatrices(_cubeModelMatrices);
+
+	// The cubes behind the others aren't sent to GPU either.
+	ThreadPool& threadPool = ThreadPool::getShared();
+	_occlusionCuller->beginFrame(frameData.viewProjection);
+	for (size_t i = 0; i < visibleCubesCount; ++i) {
+		_occlusionCuller->addOccluder(*_occluderModel, _cubeModelMatrices[_visibleCubeIndices[i]]);
+	}
+	_occlusionCuller->rasterizeOccluders(threadPool);
+	const std::span<uint32_t> candidateIndices(_visibleCubeIndices.data(), visibleCubesCount);
+	_occlusionCandidatesCount = visibleCubesCount;
+	visibleCubesCount = _occlusionCuller->cullSpheresParallel(threadPool, cubeBounds, candidateIndices, candidateIndices);
+	_occlusionVisibleCount = visibleCubesCount;
+
+	// The draws are sorted by state, and the cubes are roughly front-to-back inside the state.
+	_renderQueue.clear();
+	for (size_t i = 0; i < visibleCubesCount; ++i) {
+		const uint32_t cubeIndex = _visibleCubeIndices[i];
+		const float viewDepth = -(frameData.view * _cubeModelMatrices[cubeIndex][3]).z;
+		const float depth01 = viewDepth / FreeMotionCamera::Z_FAR;
+		_renderQueue.push(RenderSortKey::makeOpaque(OPAQUE_PASS, CUBE_SHADER_ID, CUBE_MATERIAL_ID, SCENE_MESHES_ID, depth01), cubeIndex);
 	}
+	_renderQueue.sort();
+
+	// Set uniform values before the draws.
+	_frameCommands.clear();
+	const auto v = static_cast<float>(std::sin(curTimeSeconds));
+	const float progress = v * 0.5f + 0.5f; // [0, 1]
+	_frameCommands.setUniform(ShaderInterface::Default::uProgress, progress);
+	_frameCommands.setUniform(ShaderInterface::Default::sampler0, FIRST_SAMPLER_INDEX);
+	_frameCommands.setUniform(ShaderInterface::Default::sampler1, SECOND_SAMPLER_INDEX);
+
+	// Chunks of the queue are recorded in parallel. A chunk starts with the state changes relative to the previous one.
+	CommandBuffer::recordParallel(threadPool, _renderQueue.size(), MIN_RECORDING_CHUNK_SIZE, _sceneCommands,
+			[](CommandBuffer& commands, size_t begin, size_t end) {
+				CubeRecordingVisitor recordingVisitor = {&commands};
+				_renderQueue.submit(recordingVisitor, begin, end);
+			});
+
+	_instanceStream->beginFrame();
+	CubeReplayVisitor replayVisitor = {shader};
+	_frameCommands.replay(replayVisitor);
+	for (const CommandBuffer& commands : _sceneCommands) {
+		commands.replay(replayVisitor);
+	}
+	_instanceStream->endFrame();
+}
 
-	glBindVertexArray(_vertexArrayBufferId);
 
-	// Set wireframe mode drawing.
-	// glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+void printContextInfo()
+{
+	const auto version = glGetString(GL_VERSION);
+	std::cout << "OpenGL version: " << version << "\n";
+	std::cout << "\tRenderer: " << glGetString(GL_RENDERER) << "\n";
 
-	// Draw vertices directly from VBO connected to _vertexArrayBufferId.
-	// glDrawArrays(GL_TRIANGLES, 0, (GLsizei) _verticesAmount);
+	GLint maxVertexAttributes = 0;
+	glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxVertexAttributes);
+	std::cout << "\tMax vertex attributes: " << maxVertexAttributes << std::endl;
+}
 
-	for (const auto& drawParams: _cubesDrawParams) {
-		if (_shader) {
-			glm::mat4 model = glm::mat4(1.f);
-			model = glm::translate(model, drawParams.pos);
-			model = glm::scale(model, glm::vec3(0.28f));
-			model = glm::rotate(model, glm::radians(drawParams.angleDegrees), glm::vec3(0.f, 1.f, 0.f));
-			_shader->getUniforms().set(ShaderUniform::Mat4("uModel", model));
-		}
 
-		_shader->bind();
-		// Draw vertices from VBO whom indices appear in EBO connected to _vertexArrayBufferId.
-		glDrawElements(GL_TRIANGLES, (GLsizei) _indicesAmount, GL_UNSIGNED_INT, nullptr);
-	}
+void releaseGlObjects()
+{
+	// GL objects must be released while the context is alive.
+	_frameUniformBuffer.reset();
+	_shader.reset();
+	_fallbackShader.reset();
+	_shaderLibrary.reset();
+	_shaderCompileQueue.clear();
+	_sceneMeshes.reset();
+	_instanceStream.reset();
+	VertexArrayCache::clear();
 }
 
 
-int main()
+#if WITH_GLFW
+int runWindowed()
 {
 	glfwSetErrorCallback(onGlfwError);
 
@@ -347,15 +644,22 @@ int main()
 		return -1;
 	}
 
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 #if OS_MACOS
 	// The initialisation doesn't work on the MacOS without such an instruction.
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-	GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE, nullptr, nullptr);
+	// GL 4.3 enables multi-draw indirect. GL 3.3 is the fallback, where it isn't available (e.g. on MacOS).
+	GLFWwindow* window = nullptr;
+	for (const glm::ivec2 version : {glm::ivec2(4, 3), glm::ivec2(3, 3)}) {
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version.x);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version.y);
+		window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE, nullptr, nullptr);
+		if (window) {
+			break;
+		}
+	}
 	if (!window) {
 		std::cerr << "Window or OpenGL context creation failed." << std::endl;
 		glfwTerminate();
@@ -371,12 +675,9 @@ int main()
 		return -1;
 	}
 
-	const auto version = glGetString(GL_VERSION);
-	std::cout << "OpenGL version: " << version << "\n";
+	GlExtensions::load(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
 
-	GLint maxVertexAttributes = 0;
-	glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxVertexAttributes);
-	std::cout << "\tMax vertex attributes: " << maxVertexAttributes << std::endl;
+	printContextInfo();
 
 	int width = 0;
 	int height = 0;
@@ -386,6 +687,7 @@ int main()
 
 	// Set mouse input.
 	glfwSetScrollCallback(window, onScroll);
+	glfwSetKeyCallback(window, onKey);
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	if (glfwRawMouseMotionSupported() == GLFW_TRUE) {
 		glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
@@ -397,19 +699,234 @@ int main()
 	_cursorPos.x = static_cast<float>(cursorX);
 	_cursorPos.y = static_cast<float>(cursorY);
 
-	doOnce();
+	doOnce(glfwGetTime());
 
 	while (!glfwWindowShouldClose(window)) {
 		processInput(window);
 
-		doMainUpdate();
+		doMainUpdate(glfwGetTime());
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
 
+	releaseGlObjects();
+
 	glfwDestroyWindow(window);
 	glfwTerminate();
 
 	return 0;
 }
+#endif
+
+
+/**
+ * @brief Renders the given number of frames to an offscreen framebuffer and prints the frame timings.
+ * @param dumpFileName The final frame is saved to this PPM file, if it isn't empty.
+ */
+int runHeadless(int framesCount, std::string_view dumpFileName)
+{
+	HeadlessContext context(WINDOW_WIDTH, WINDOW_HEIGHT);
+	if (!context.isValid()) {
+		std::cerr << "Headless OpenGL context creation failed." << std::endl;
+		return -1;
+	}
+
+	printContextInfo();
+	setFrameBufferSize(context.getWidth(), context.getHeight());
+
+	doOnce(0.0);
+
+	// The frames must be drawn with the main shader, so the timings and the image don't depend on the build speed.
+	while (!_shaderCompileQueue.isIdle()) {
+		_shaderCompileQueue.poll();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// Every frame is finished before the next one, so its time includes the rendering, not only the submission.
+	std::vector<double> updateMs(framesCount);
+	std::vector<double> frameMs(framesCount);
+	for (int i = 0; i < framesCount; ++i) {
+		const auto startTime = std::chrono::steady_clock::now();
+		doMainUpdate((i + 1) * HEADLESS_FRAME_TIME_SECONDS);
+		const auto updateEndTime = std::chrono::steady_clock::now();
+		glFinish();
+		const auto endTime = std::chrono::steady_clock::now();
+
+		updateMs[i] = std::chrono::duration<double, std::milli>(updateEndTime - startTime).count();
+		frameMs[i] = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+	}
+	handleGLErrors();
+
+	const auto printTimings = [](const char* label, std::vector<double> timings) {
+		if (timings.empty()) {
+			return;
+		}
+		std::sort(timings.begin(), timings.end());
+		const double totalMs = std::accumulate(timings.begin(), timings.end(), 0.0);
+		std::cout << "\t" << label << ":"
+				<< " avg " << totalMs / (double) timings.size() << " ms"
+				<< ", median " << timings[timings.size() / 2] << " ms"
+				<< ", p95 " << timings[timings.size() * 95 / 100] << " ms"
+				<< ", min " << timings.front() << " ms"
+				<< ", max " << timings.back() << " ms"
+				<< "\n";
+	};
+	const double totalMs = std::accumulate(frameMs.begin(), frameMs.end(), 0.0);
+	std::cout << std::fixed << std::setprecision(3)
+			<< "[Headless] " << framesCount << " frames " << context.getWidth() << "x" << context.getHeight()
+			<< " in " << totalMs << " ms, " << framesCount * 1000.0 / totalMs << " FPS\n";
+	printTimings("update", updateMs);
+	printTimings("frame ", frameMs);
+	std::cout << std::flush;
+
+	int exitCode = 0;
+	if (!dumpFileName.empty()) {
+		if (context.saveImage(dumpFileName)) {
+			std::cout << "[Headless] The final frame is saved: " << dumpFileName << std::endl;
+		} else {
+			exitCode = -1;
+		}
+	}
+
+	releaseGlObjects();
+	return exitCode;
+}
+
+
+/**
+ * @brief Decodes a texture for the software rasterizer. The rows are flipped like in loadTexture().
+ */
+SoftwareTexture loadSoftwareTexture(const std::string_view textureFilename)
+{
+	const MappedFile textureFile(textureFilename);
+	if (!textureFile.isOpen()) {
+		std::cerr << "Texture file opening failed: " << textureFilename << std::endl;
+		return {};
+	}
+
+	stbi_set_flip_vertically_on_load(true);
+	int textureWidth = 0;
+	int textureHeight = 0;
+	int textureChannelsNum = 0;
+	const std::span<const std::byte> encodedData = textureFile.getBytes();
+	unsigned char* textureData = stbi_load_from_memory(
+			reinterpret_cast<const stbi_uc*>(encodedData.data()), (int) encodedData.size(),
+			&textureWidth, &textureHeight, &textureChannelsNum, 0
+	);
+	if (textureData == nullptr) {
+		std::cerr << "stbi error! " << stbi_failure_reason() << ": " << textureFilename << std::endl;
+		return {};
+	}
+
+	SoftwareTexture texture(textureWidth, textureHeight, textureChannelsNum, textureData);
+	stbi_image_free(textureData);
+	return texture;
+}
+
+
+/**
+ * @brief Renders the scene on CPU without any GL context and prints the frame timings and the throughput.
+ * @param dumpFileName The final frame is saved to this PPM file, if it isn't empty.
+ */
+int runSoftware(int framesCount, std::string_view dumpFileName)
+{
+	const SoftwareTexture wallTexture = loadSoftwareTexture("../assets/textures/wall.jpg");
+	const SoftwareTexture faceTexture = loadSoftwareTexture("../assets/textures/awesomeface.png");
+	if (!wallTexture.isValid() || !faceTexture.isValid()) {
+		return -1;
+	}
+
+	const GeometricModel cubeModel = GeometricModelFactory::createCubeModel();
+	addSceneCubes();
+	_cubeTransforms.computeModelMatrices(_cubeModelMatrices);
+
+	ThreadPool& pool = ThreadPool::getShared();
+	SoftwareRasterizer rasterizer(WINDOW_WIDTH, WINDOW_HEIGHT);
+	std::cout << "[Software] " << pool.getThreadsCount() << " threads, " << Simd::getIsaName(Simd::getBestIsa()) << std::endl;
+
+	std::vector<double> frameMs(framesCount);
+	SoftwareRasterizer::Stats totalStats;
+	for (int i = 0; i < framesCount; ++i) {
+		const auto startTime = std::chrono::steady_clock::now();
+		_camera.update((float) HEADLESS_FRAME_TIME_SECONDS);
+		const float aspectRatio = WINDOW_WIDTH / (float) WINDOW_HEIGHT;
+		const glm::mat4 viewProjection = _camera.getProjectionMatrix(aspectRatio) * _camera.getViewMatrix();
+
+		rasterizer.clear(glm::vec4(0.7f, 0.7f, 0.8f, 1.f));
+		rasterizer.drawTexturedInstances(cubeModel, _cubeModelMatrices, viewProjection, wallTexture, faceTexture);
+		const SoftwareRasterizer::Stats stats = rasterizer.flush(pool);
+		frameMs[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		totalStats.trianglesCount += stats.trianglesCount;
+		totalStats.shadedPixelsCount += stats.shadedPixelsCount;
+		totalStats.vertexMs += stats.vertexMs;
+		totalStats.setupMs += stats.setupMs;
+		totalStats.rasterMs += stats.rasterMs;
+	}
+
+	std::sort(frameMs.begin(), frameMs.end());
+	const double totalMs = std::accumulate(frameMs.begin(), frameMs.end(), 0.0);
+	const double totalSeconds = totalMs / 1000.0;
+	std::cout << std::fixed << std::setprecision(3)
+			<< "[Software] " << framesCount << " frames " << rasterizer.getWidth() << "x" << rasterizer.getHeight()
+			<< " in " << totalMs << " ms, " << framesCount * 1000.0 / totalMs << " FPS\n"
+			<< "\tframe: avg " << totalMs / framesCount << " ms, median " << frameMs[frameMs.size() / 2] << " ms"
+			<< ", min " << frameMs.front() << " ms, max " << frameMs.back() << " ms\n"
+			<< "\tstages: vertex " << totalStats.vertexMs / framesCount << " ms, setup " << totalStats.setupMs / framesCount
+			<< " ms, raster " << totalStats.rasterMs / framesCount << " ms\n"
+			<< "\tthroughput: " << (double) totalStats.trianglesCount / totalSeconds / 1e6 << " M triangles/s, "
+			<< (double) totalStats.shadedPixelsCount / totalSeconds / 1e6 << " M pixels/s" << std::endl;
+
+	if (!dumpFileName.empty()) {
+		if (!rasterizer.saveImage(dumpFileName)) {
+			return -1;
+		}
+		std::cout << "[Software] The final frame is saved: " << dumpFileName << std::endl;
+	}
+	return 0;
+}
+
+
+void printUsage()
+{
+	std::cerr << "Usage:\n"
+			<< "\tLearnOpenGL - the windowed mode\n"
+			<< "\tLearnOpenGL --headless <frames count> [--dump <image.ppm>] - offscreen rendering with the frame timings\n"
+			<< "\tLearnOpenGL --software <frames count> [--dump <image.ppm>] - the same on CPU, without OpenGL\n"
+			<< "\tLearnOpenGL --benchmark <name> - CPU-only benchmarks" << std::endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+	const std::vector<std::string_view> args(argv + 1, argv + argc);
+
+	if (args.size() >= 2 && args[0] == "--benchmark") {
+		return Benchmark::run(args[1]);
+	}
+
+	if (!args.empty() && (args[0] == "--headless" || args[0] == "--software")) {
+		const int framesCount = (args.size() >= 2) ? std::atoi(args[1].data()) : 0;
+		const bool hasDump = (args.size() >= 4 && args[2] == "--dump");
+		if (framesCount <= 0 || (args.size() > 2 && !hasDump)) {
+			printUsage();
+			return -1;
+		}
+		const std::string_view dumpFileName = hasDump ? args[3] : std::string_view();
+		return (args[0] == "--software") ? runSoftware(framesCount, dumpFileName) : runHeadless(framesCount, dumpFileName);
+	}
+
+	if (!args.empty()) {
+		printUsage();
+		return -1;
+	}
+
+#if WITH_GLFW
+	return runWindowed();
+#else
+	std::cerr << "The build has no GLFW: only the headless mode is available." << std::endl;
+	printUsage();
+	return -1;
+#endif
+}
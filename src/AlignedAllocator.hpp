@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+
+/**
+ * @brief The allocator for containers, which aligns the data for SIMD loads.
+ */
+template <typename T, size_t Alignment>
+class AlignedAllocator
+{
+public:
+	using value_type = T;
+
+	template <typename U>
+	struct rebind
+	{
+		using other = AlignedAllocator<U, Alignment>;
+	};
+
+public:
+	AlignedAllocator() noexcept = default;
+
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept
+	{
+	}
+
+	[[nodiscard]]
+	T* allocate(size_t count)
+	{
+		return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+	}
+
+	void deallocate(T* data, size_t count) noexcept
+	{
+		::operator delete(data, count * sizeof(T), std::align_val_t(Alignment));
+	}
+
+	template <typename U>
+	bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+};
+
+
+template <typename T, size_t Alignment>
+using AlignedVector = std::vector<T, AlignedAllocator<T, Alignment>>;
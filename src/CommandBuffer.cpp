@@ -0,0 +1,96 @@
+#include "CommandBuffer.hpp"
+
+#include "ThreadPool.hpp"
+#include "Utilities.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+
+void CommandBuffer::clear()
+{
+	_size = 0;
+	_commandsCount = 0;
+}
+
+
+void CommandBuffer::reserve(size_t size)
+{
+	if (size > _data.size()) {
+		_data.resize(size);
+	}
+}
+
+
+void CommandBuffer::setUniform(int slot, const ShaderUniform& uniform)
+{
+	const size_t dataSize = uniform.getDataSize();
+	std::byte* command = allocateCommand(RenderCommand::Type::SetUniform, alignSize(sizeof(RenderCommand::SetUniform)) + dataSize);
+
+	auto* setUniform = reinterpret_cast<RenderCommand::SetUniform*>(command);
+	setUniform->name = uniform.getName();
+	setUniform->slot = slot;
+	setUniform->type = uniform.getType();
+	setUniform->arraySize = uniform.getArraySize();
+	std::memcpy(command + alignSize(sizeof(RenderCommand::SetUniform)), uniform.getData(), dataSize);
+}
+
+
+CommandBuffer::DrawInstancesData CommandBuffer::drawInstances(uint32_t meshes, size_t instancesCount)
+{
+	const size_t headerSize = alignSize(sizeof(RenderCommand::DrawInstances));
+	const size_t matricesSize = instancesCount * sizeof(glm::mat4);
+	const size_t size = headerSize + matricesSize + instancesCount * sizeof(uint32_t);
+	std::byte* command = allocateCommand(RenderCommand::Type::DrawInstances, size);
+
+	auto* draw = reinterpret_cast<RenderCommand::DrawInstances*>(command);
+	draw->meshes = meshes;
+	draw->instancesCount = (uint32_t) instancesCount;
+
+	auto* modelMatrices = reinterpret_cast<glm::mat4*>(command + headerSize);
+	auto* meshIndices = reinterpret_cast<uint32_t*>(command + headerSize + matricesSize);
+	return {{modelMatrices, instancesCount}, {meshIndices, instancesCount}};
+}
+
+
+void CommandBuffer::recordParallel(ThreadPool& pool, size_t count, size_t minChunkSize,
+		std::vector<CommandBuffer>& buffers, const RecordFunction& function)
+{
+	buffers.resize(pool.getChunksCount(count, minChunkSize));
+	for (CommandBuffer& buffer : buffers) {
+		buffer.clear();
+	}
+
+	pool.parallelFor(count, minChunkSize, [&](size_t begin, size_t end, size_t chunkIndex) {
+		function(buffers[chunkIndex], begin, end);
+	});
+}
+
+
+std::byte* CommandBuffer::allocateCommand(RenderCommand::Type type, size_t size)
+{
+	size = alignSize(size);
+	assertTrue(size <= std::numeric_limits<uint32_t>::max());
+
+	const size_t offset = _size;
+	_size += size;
+	if (_size > _data.size()) {
+		// Grow geometrically: the resize zeroes the new memory, and it should happen only during the first frames.
+		_data.resize(std::max(_size, _data.size() * 2));
+	}
+	++_commandsCount;
+
+	std::byte* command = _data.data() + offset;
+	auto* header = reinterpret_cast<RenderCommand::Header*>(command);
+	header->type = type;
+	header->size = (uint32_t) size;
+	return command;
+}
+
+
+void CommandBuffer::recordBind(RenderCommand::Type type, uint32_t id)
+{
+	std::byte* command = allocateCommand(type, sizeof(RenderCommand::Bind));
+	reinterpret_cast<RenderCommand::Bind*>(command)->id = id;
+}
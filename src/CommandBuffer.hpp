@@ -0,0 +1,227 @@
+#pragma once
+
+#include "AlignedAllocator.hpp"
+#include "ShaderUniform.hpp"
+#include "ShaderUniformSlot.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+
+
+class ThreadPool;
+
+
+/**
+ * @brief POD commands of CommandBuffer. Every command starts with the header and is followed by its payload.
+ * Objects are referenced by ids, which are resolved on the replay, so the commands don't depend on the graphics API.
+ */
+namespace RenderCommand {
+	// Every command starts at the multiple of the alignment, so the payload can be read in place.
+	constexpr size_t ALIGNMENT = 16;
+
+	enum class Type : uint32_t
+	{
+		BindPipeline,
+		BindShader,
+		BindMaterial,
+		BindVertexArray,
+		SetUniform,
+		DrawInstances,
+	};
+
+	struct Header
+	{
+		Type type = Type::BindPipeline;
+		// The size of the whole command with the header and the payload.
+		uint32_t size = 0;
+	};
+
+	/**
+	 * @brief BindPipeline, BindShader, BindMaterial and BindVertexArray.
+	 */
+	struct Bind
+	{
+		Header header;
+		uint32_t id = 0;
+	};
+
+	/**
+	 * @brief Followed by the value data of ShaderUniform::getDataSize() bytes.
+	 */
+	struct SetUniform
+	{
+		Header header;
+		// The name must outlive the buffer, like the names of the generated slots do.
+		UniformName name;
+		int32_t slot = -1;
+		ShaderUniform::Type type = ShaderUniform::Type::Int;
+		int32_t arraySize = 1;
+	};
+
+	/**
+	 * @brief Followed by the model matrices and the mesh indices of the instances.
+	 */
+	struct DrawInstances
+	{
+		Header header;
+		uint32_t meshes = 0;
+		uint32_t instancesCount = 0;
+	};
+
+	static_assert(std::is_trivially_copyable_v<Bind>);
+	static_assert(std::is_trivially_copyable_v<SetUniform>);
+	static_assert(std::is_trivially_copyable_v<DrawInstances>);
+}
+
+
+/**
+ * @brief Records draw commands into linear memory and replays them later, usually on the GL thread.
+ * The recording doesn't touch GPU objects, so separate buffers can be recorded by worker threads in parallel
+ * and replayed one after another in order. The stream can also be inspected without a GPU.
+ */
+class CommandBuffer
+{
+public:
+	/**
+	 * @brief Instance data of a recorded draw, which the caller fills in place.
+	 * It's valid until the next command is recorded.
+	 */
+	struct DrawInstancesData
+	{
+		std::span<glm::mat4> modelMatrices;
+		std::span<uint32_t> meshIndices;
+	};
+
+	/**
+	 * @brief The function which records the items [begin, end) to the buffer.
+	 */
+	using RecordFunction = std::function<void(CommandBuffer& buffer, size_t begin, size_t end)>;
+
+public:
+	void clear();
+
+	void reserve(size_t size);
+
+	/**
+	 * @brief Returns the size of the recorded commands in bytes.
+	 */
+	[[nodiscard]]
+	size_t getSize() const { return _size; }
+
+	[[nodiscard]]
+	size_t getCommandsCount() const { return _commandsCount; }
+
+	[[nodiscard]]
+	std::span<const std::byte> getData() const { return {_data.data(), _size}; }
+
+	void bindPipeline(uint32_t pipeline) { recordBind(RenderCommand::Type::BindPipeline, pipeline); }
+
+	void bindShader(uint32_t shader) { recordBind(RenderCommand::Type::BindShader, shader); }
+
+	void bindMaterial(uint32_t material) { recordBind(RenderCommand::Type::BindMaterial, material); }
+
+	void bindVertexArray(uint32_t vertexArray) { recordBind(RenderCommand::Type::BindVertexArray, vertexArray); }
+
+	/**
+	 * @brief Sets the uniform value of the currently bound shader. The value is copied to the buffer.
+	 */
+	void setUniform(int slot, const ShaderUniform& uniform);
+
+	template <typename T>
+	void setUniform(const ShaderUniformSlot<T>& slot, const std::type_identity_t<T>& value)
+	{
+		setUniform(slot.index, ShaderUniform(slot.name, slot.type, 1, &value));
+	}
+
+	/**
+	 * @brief Records the instanced draw of the meshes and returns the memory for the instance data.
+	 * @param meshes The id of the meshes container. The mesh indices address the meshes in it.
+	 */
+	[[nodiscard]]
+	DrawInstancesData drawInstances(uint32_t meshes, size_t instancesCount);
+
+	/**
+	 * @brief Passes the commands in the recording order to the visitor.
+	 * @param visitor An object with the functions:
+	 * 	bindPipeline(uint32_t pipeline), bindShader(uint32_t shader), bindMaterial(uint32_t material),
+	 * 	bindVertexArray(uint32_t vertexArray), setUniform(int slot, const ShaderUniform& uniform),
+	 * 	drawInstances(uint32_t meshes, std::span<const glm::mat4> modelMatrices, std::span<const uint32_t> meshIndices).
+	 */
+	template <typename Visitor>
+	void replay(Visitor& visitor) const;
+
+	/**
+	 * @brief Splits [0, count) into the chunks of ThreadPool::parallelFor() and records every chunk to its own buffer.
+	 * The buffers are resized to the chunks count and cleared. Replaying them in order gives the whole stream.
+	 */
+	static void recordParallel(ThreadPool& pool, size_t count, size_t minChunkSize,
+			std::vector<CommandBuffer>& buffers, const RecordFunction& function);
+
+private:
+	static constexpr size_t alignSize(size_t size)
+	{
+		return (size + RenderCommand::ALIGNMENT - 1) / RenderCommand::ALIGNMENT * RenderCommand::ALIGNMENT;
+	}
+
+	/**
+	 * @brief Appends the command of the given size with the payload and returns it.
+	 */
+	std::byte* allocateCommand(RenderCommand::Type type, size_t size);
+
+	void recordBind(RenderCommand::Type type, uint32_t id);
+
+private:
+	// The memory is kept by clear(), so the recording of the next frame doesn't allocate.
+	AlignedVector<std::byte, RenderCommand::ALIGNMENT> _data;
+	size_t _size = 0;
+	size_t _commandsCount = 0;
+};
+
+
+template <typename Visitor>
+void CommandBuffer::replay(Visitor& visitor) const
+{
+	using namespace RenderCommand;
+
+	const std::byte* command = _data.data();
+	const std::byte* const end = command + _size;
+	while (command < end) {
+		const auto* header = reinterpret_cast<const Header*>(command);
+		switch (header->type) {
+			case Type::BindPipeline:
+				visitor.bindPipeline(reinterpret_cast<const Bind*>(command)->id);
+				break;
+			case Type::BindShader:
+				visitor.bindShader(reinterpret_cast<const Bind*>(command)->id);
+				break;
+			case Type::BindMaterial:
+				visitor.bindMaterial(reinterpret_cast<const Bind*>(command)->id);
+				break;
+			case Type::BindVertexArray:
+				visitor.bindVertexArray(reinterpret_cast<const Bind*>(command)->id);
+				break;
+			case Type::SetUniform: {
+				const auto* setUniform = reinterpret_cast<const SetUniform*>(command);
+				const std::byte* valueData = command + alignSize(sizeof(SetUniform));
+				visitor.setUniform(setUniform->slot, ShaderUniform(setUniform->name, setUniform->type, setUniform->arraySize, valueData));
+				break;
+			}
+			case Type::DrawInstances: {
+				const auto* draw = reinterpret_cast<const DrawInstances*>(command);
+				const auto* modelMatrices = reinterpret_cast<const glm::mat4*>(command + alignSize(sizeof(DrawInstances)));
+				const auto* meshIndices = reinterpret_cast<const uint32_t*>(modelMatrices + draw->instancesCount);
+				visitor.drawInstances(draw->meshes,
+						std::span<const glm::mat4>(modelMatrices, draw->instancesCount),
+						std::span<const uint32_t>(meshIndices, draw->instancesCount));
+				break;
+			}
+		}
+		command += header->size;
+	}
+}
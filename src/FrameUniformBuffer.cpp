@@ -0,0 +1,37 @@
+#include "FrameUniformBuffer.hpp"
+
+#include "GlStateCache.hpp"
+#include "Utilities.hpp"
+
+
+FrameUniformBuffer::FrameUniformBuffer()
+{
+	glGenBuffers(1, &_bufferId);
+	GlStateCache::bindBuffer(GL_UNIFORM_BUFFER, _bufferId);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+
+	// The buffer stays bound to the binding point for the whole lifetime.
+	GlStateCache::bindBufferBase(GL_UNIFORM_BUFFER, BINDING_POINT, _bufferId);
+
+	handleGLErrors();
+}
+
+
+FrameUniformBuffer::~FrameUniformBuffer() noexcept
+{
+	if (_bufferId > 0) {
+		glDeleteBuffers(1, &_bufferId);
+		GlStateCache::forgetBuffer(_bufferId);
+		_bufferId = 0;
+	}
+}
+
+
+void FrameUniformBuffer::update(const FrameData& frameData)
+{
+	assertTrue(isValid());
+
+	// The generic binding isn't reset: nothing else relies on it, and the next frame elides the bind.
+	GlStateCache::bindBuffer(GL_UNIFORM_BUFFER, _bufferId);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &frameData);
+}
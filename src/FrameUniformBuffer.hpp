@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+#include <string_view>
+
+
+/**
+ * @brief Per-frame values shared by all shader programs.
+ * The layout mirrors the std140 "FrameData" uniform block declared in the shaders.
+ */
+struct FrameData
+{
+	glm::mat4 view = glm::mat4(1.f);
+	glm::mat4 projection = glm::mat4(1.f);
+	// projection * view
+	glm::mat4 viewProjection = glm::mat4(1.f);
+	// x, y - the lower left corner; z, w - the width and the height of the viewport in pixels.
+	glm::vec4 viewport = glm::vec4(0.f);
+	// Seconds since the application start.
+	float time = 0.f;
+	// std140 rounds the block size up to the vec4 alignment.
+	float padding[3] = {};
+};
+
+static_assert(sizeof(FrameData) == 224, "FrameData must match the std140 layout of the uniform block.");
+
+
+/**
+ * @brief Uniform buffer with FrameData. It's written once per frame
+ * and stays bound to BINDING_POINT, which every Shader attaches its FrameData block to.
+ */
+class FrameUniformBuffer
+{
+public:
+	static constexpr GLuint BINDING_POINT = 0;
+	static constexpr std::string_view BLOCK_NAME = "FrameData";
+
+public:
+	FrameUniformBuffer();
+
+	~FrameUniformBuffer() noexcept;
+
+	FrameUniformBuffer(const FrameUniformBuffer&) = delete;
+
+	FrameUniformBuffer& operator=(const FrameUniformBuffer&) = delete;
+
+	[[nodiscard]]
+	bool isValid() const { return _bufferId > 0; }
+
+	void update(const FrameData& frameData);
+
+private:
+	GLuint _bufferId = 0;
+};
@@ -0,0 +1,81 @@
+#include "GlExtensions.hpp"
+
+#include <iostream>
+
+
+void GlExtensions::load(GLADloadproc loadProc)
+{
+	const bool hasProgramBinary = isVersionAtLeast(4, 1) || hasExtension("GL_ARB_get_program_binary");
+	if (hasProgramBinary) {
+		getProgramBinary = reinterpret_cast<PfnGetProgramBinary>(loadProc("glGetProgramBinary"));
+		programBinary = reinterpret_cast<PfnProgramBinary>(loadProc("glProgramBinary"));
+		programParameteri = reinterpret_cast<PfnProgramParameteri>(loadProc("glProgramParameteri"));
+
+		// Drivers may expose the extension, but support no binary formats at all.
+		GLint formatsAmount = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatsAmount);
+		_isProgramBinarySupported = getProgramBinary && programBinary && programParameteri && (formatsAmount > 0);
+	}
+
+	if (hasExtension("GL_KHR_parallel_shader_compile")) {
+		maxShaderCompilerThreads = reinterpret_cast<PfnMaxShaderCompilerThreads>(loadProc("glMaxShaderCompilerThreadsKHR"));
+	} else if (hasExtension("GL_ARB_parallel_shader_compile")) {
+		maxShaderCompilerThreads = reinterpret_cast<PfnMaxShaderCompilerThreads>(loadProc("glMaxShaderCompilerThreadsARB"));
+	}
+	if (maxShaderCompilerThreads) {
+		// Let the driver choose the amount of compiler threads.
+		maxShaderCompilerThreads(0xFFFFFFFF);
+	}
+
+	const bool hasMultiDrawIndirect = isVersionAtLeast(4, 3)
+			|| (hasExtension("GL_ARB_multi_draw_indirect") && hasExtension("GL_ARB_base_instance"));
+	if (hasMultiDrawIndirect) {
+		multiDrawElementsIndirect = reinterpret_cast<PfnMultiDrawElementsIndirect>(loadProc("glMultiDrawElementsIndirect"));
+	}
+
+	if (isVersionAtLeast(4, 4) || hasExtension("GL_ARB_buffer_storage")) {
+		bufferStorage = reinterpret_cast<PfnBufferStorage>(loadProc("glBufferStorage"));
+	}
+
+	if (isVersionAtLeast(4, 3) || hasExtension("GL_ARB_vertex_attrib_binding")) {
+		vertexAttribFormat = reinterpret_cast<PfnVertexAttribFormat>(loadProc("glVertexAttribFormat"));
+		vertexAttribIFormat = reinterpret_cast<PfnVertexAttribIFormat>(loadProc("glVertexAttribIFormat"));
+		vertexAttribBinding = reinterpret_cast<PfnVertexAttribBinding>(loadProc("glVertexAttribBinding"));
+		vertexBindingDivisor = reinterpret_cast<PfnVertexBindingDivisor>(loadProc("glVertexBindingDivisor"));
+		// It's the flag of the support, so it's set only if all entry points are there.
+		if (vertexAttribFormat && vertexAttribIFormat && vertexAttribBinding && vertexBindingDivisor) {
+			bindVertexBuffer = reinterpret_cast<PfnBindVertexBuffer>(loadProc("glBindVertexBuffer"));
+		}
+	}
+
+	std::cout << "[GlExtensions] Program binaries: " << (_isProgramBinarySupported ? "yes" : "no") << "\n"
+			<< "[GlExtensions] Parallel shader compile: " << (isParallelShaderCompileSupported() ? "yes" : "no") << "\n"
+			<< "[GlExtensions] Multi-draw indirect: " << (isMultiDrawIndirectSupported() ? "yes" : "no") << "\n"
+			<< "[GlExtensions] Buffer storage: " << (isBufferStorageSupported() ? "yes" : "no") << "\n"
+			<< "[GlExtensions] Vertex attrib binding: " << (isVertexAttribBindingSupported() ? "yes" : "no")
+			<< std::endl;
+}
+
+
+bool GlExtensions::hasExtension(std::string_view name)
+{
+	GLint extensionsAmount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionsAmount);
+	for (GLint i = 0; i < extensionsAmount; ++i) {
+		const auto* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, (GLuint) i));
+		if (extension != nullptr && name == extension) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool GlExtensions::isVersionAtLeast(int major, int minor)
+{
+	GLint contextMajor = 0;
+	GLint contextMinor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+	glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+	return (contextMajor > major) || (contextMajor == major && contextMinor >= minor);
+}
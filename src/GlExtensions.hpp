@@ -0,0 +1,126 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <string_view>
+
+
+// The bundled glad loader is generated for GL 3.3 core without extensions.
+// The constants and the entry points of newer versions and extensions, which are used optionally, are declared here.
+
+// GL 4.1, GL_ARB_get_program_binary
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// GL_KHR_parallel_shader_compile, GL_ARB_parallel_shader_compile
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// GL 4.0, GL_ARB_draw_indirect
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+// GL 4.4, GL_ARB_buffer_storage
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+
+/**
+ * @brief Loads optional GL entry points which aren't provided by glad.
+ * Every entry point stays nullptr, if the context doesn't support it, so check the is*Supported() functions first.
+ */
+class GlExtensions
+{
+public:
+	using PfnGetProgramBinary = void (APIENTRYP)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+	using PfnProgramBinary = void (APIENTRYP)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+	using PfnProgramParameteri = void (APIENTRYP)(GLuint program, GLenum pname, GLint value);
+	using PfnMaxShaderCompilerThreads = void (APIENTRYP)(GLuint count);
+	using PfnBufferStorage = void (APIENTRYP)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+	using PfnMultiDrawElementsIndirect = void (APIENTRYP)(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride);
+	using PfnBindVertexBuffer = void (APIENTRYP)(GLuint bindingIndex, GLuint buffer, GLintptr offset, GLsizei stride);
+	using PfnVertexAttribFormat = void (APIENTRYP)(GLuint attribIndex, GLint size, GLenum type, GLboolean normalized, GLuint relativeOffset);
+	using PfnVertexAttribIFormat = void (APIENTRYP)(GLuint attribIndex, GLint size, GLenum type, GLuint relativeOffset);
+	using PfnVertexAttribBinding = void (APIENTRYP)(GLuint attribIndex, GLuint bindingIndex);
+	using PfnVertexBindingDivisor = void (APIENTRYP)(GLuint bindingIndex, GLuint divisor);
+
+public:
+	/**
+	 * @brief Loads the entry points. It must be called after gladLoadGLLoader with the current context.
+	 */
+	static void load(GLADloadproc loadProc);
+
+	[[nodiscard]]
+	static bool hasExtension(std::string_view name);
+
+	[[nodiscard]]
+	static bool isVersionAtLeast(int major, int minor);
+
+	[[nodiscard]]
+	static bool isProgramBinarySupported() { return _isProgramBinarySupported; }
+
+	/**
+	 * @brief Checks whether GL_COMPLETION_STATUS_KHR can be queried without waiting for compilation and linking.
+	 */
+	[[nodiscard]]
+	static bool isParallelShaderCompileSupported() { return maxShaderCompilerThreads != nullptr; }
+
+	/**
+	 * @brief Checks whether many draws can be issued with one glMultiDrawElementsIndirect call.
+	 * The base instance of the commands is required too, as the per-draw data is addressed by it.
+	 */
+	[[nodiscard]]
+	static bool isMultiDrawIndirectSupported() { return multiDrawElementsIndirect != nullptr; }
+
+	/**
+	 * @brief Checks whether immutable buffers can be mapped persistently.
+	 */
+	[[nodiscard]]
+	static bool isBufferStorageSupported() { return bufferStorage != nullptr; }
+
+	/**
+	 * @brief Checks whether the vertex formats of a VAO are separate from the buffers, so a VAO serves any buffers.
+	 */
+	[[nodiscard]]
+	static bool isVertexAttribBindingSupported() { return bindVertexBuffer != nullptr; }
+
+	// GL 4.1, GL_ARB_get_program_binary
+	static inline PfnGetProgramBinary getProgramBinary = nullptr;
+	static inline PfnProgramBinary programBinary = nullptr;
+	static inline PfnProgramParameteri programParameteri = nullptr;
+
+	// GL_KHR_parallel_shader_compile, GL_ARB_parallel_shader_compile
+	static inline PfnMaxShaderCompilerThreads maxShaderCompilerThreads = nullptr;
+
+	// GL 4.4, GL_ARB_buffer_storage
+	static inline PfnBufferStorage bufferStorage = nullptr;
+
+	// GL 4.3, GL_ARB_multi_draw_indirect with GL_ARB_base_instance
+	static inline PfnMultiDrawElementsIndirect multiDrawElementsIndirect = nullptr;
+
+	// GL 4.3, GL_ARB_vertex_attrib_binding
+	static inline PfnBindVertexBuffer bindVertexBuffer = nullptr;
+	static inline PfnVertexAttribFormat vertexAttribFormat = nullptr;
+	static inline PfnVertexAttribIFormat vertexAttribIFormat = nullptr;
+	static inline PfnVertexAttribBinding vertexAttribBinding = nullptr;
+	static inline PfnVertexBindingDivisor vertexBindingDivisor = nullptr;
+
+private:
+	static inline bool _isProgramBinarySupported = false;
+};
@@ -0,0 +1,266 @@
+#include "GlStateCache.hpp"
+
+#include <algorithm>
+
+
+namespace {
+	template <size_t Size>
+	constexpr std::array<GLuint, Size> makeUnknownIds(GLuint unknownId)
+	{
+		std::array<GLuint, Size> ids;
+		ids.fill(unknownId);
+		return ids;
+	}
+}
+
+
+GlStateCache::Stats GlStateCache::_stats;
+
+GLuint GlStateCache::_programId = UNKNOWN_ID;
+GLuint GlStateCache::_vertexArrayId = UNKNOWN_ID;
+std::array<GLuint, GlStateCache::BUFFER_TARGETS.size()> GlStateCache::_bufferIds =
+		makeUnknownIds<BUFFER_TARGETS.size()>(UNKNOWN_ID);
+std::array<GLuint, GlStateCache::MAX_UNIFORM_BUFFER_BINDINGS> GlStateCache::_uniformBufferIds =
+		makeUnknownIds<MAX_UNIFORM_BUFFER_BINDINGS>(UNKNOWN_ID);
+int GlStateCache::_activeTextureUnit = -1;
+std::array<GLuint, GlStateCache::MAX_TEXTURE_UNITS * GlStateCache::TEXTURE_TARGETS.size()> GlStateCache::_textureIds =
+		makeUnknownIds<MAX_TEXTURE_UNITS * TEXTURE_TARGETS.size()>(UNKNOWN_ID);
+std::array<GLuint, GlStateCache::MAX_TEXTURE_UNITS> GlStateCache::_samplerIds =
+		makeUnknownIds<MAX_TEXTURE_UNITS>(UNKNOWN_ID);
+
+PipelineState GlStateCache::_pipelineState;
+bool GlStateCache::_isPipelineStateKnown = false;
+
+
+void GlStateCache::invalidate()
+{
+	_programId = UNKNOWN_ID;
+	_vertexArrayId = UNKNOWN_ID;
+	_bufferIds.fill(UNKNOWN_ID);
+	_uniformBufferIds.fill(UNKNOWN_ID);
+	_activeTextureUnit = -1;
+	_textureIds.fill(UNKNOWN_ID);
+	_samplerIds.fill(UNKNOWN_ID);
+	_isPipelineStateKnown = false;
+}
+
+
+void GlStateCache::useProgram(GLuint programId)
+{
+	if (checkChange(_programId != programId)) {
+		glUseProgram(programId);
+		_programId = programId;
+	}
+}
+
+
+void GlStateCache::bindVertexArray(GLuint vertexArrayId)
+{
+	if (checkChange(_vertexArrayId != vertexArrayId)) {
+		glBindVertexArray(vertexArrayId);
+		_vertexArrayId = vertexArrayId;
+		// Another VAO brings its own element array buffer.
+		_bufferIds[findBufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN_ID;
+	}
+}
+
+
+void GlStateCache::bindBuffer(GLenum target, GLuint bufferId)
+{
+	const int targetIndex = findBufferTargetIndex(target);
+	if (targetIndex < 0) {
+		++_stats.issued;
+		glBindBuffer(target, bufferId);
+		return;
+	}
+
+	if (checkChange(_bufferIds[targetIndex] != bufferId)) {
+		glBindBuffer(target, bufferId);
+		_bufferIds[targetIndex] = bufferId;
+	}
+}
+
+
+void GlStateCache::bindBufferBase(GLenum target, GLuint index, GLuint bufferId)
+{
+	const int targetIndex = findBufferTargetIndex(target);
+	if (target == GL_UNIFORM_BUFFER && index < MAX_UNIFORM_BUFFER_BINDINGS) {
+		const bool isChanged = (_uniformBufferIds[index] != bufferId) || (_bufferIds[targetIndex] != bufferId);
+		if (!checkChange(isChanged)) {
+			return;
+		}
+		_uniformBufferIds[index] = bufferId;
+	} else {
+		++_stats.issued;
+	}
+
+	glBindBufferBase(target, index, bufferId);
+	if (targetIndex >= 0) {
+		_bufferIds[targetIndex] = bufferId;
+	}
+}
+
+
+void GlStateCache::bindTexture(int unit, GLenum target, GLuint textureId)
+{
+	const int targetIndex = findTextureTargetIndex(target);
+	if (unit < 0 || unit >= MAX_TEXTURE_UNITS || targetIndex < 0) {
+		++_stats.issued;
+		_activeTextureUnit = unit;
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(target, textureId);
+		return;
+	}
+
+	GLuint& boundTextureId = _textureIds[unit * TEXTURE_TARGETS.size() + targetIndex];
+	if (checkChange(boundTextureId != textureId)) {
+		activateTextureUnit(unit);
+		glBindTexture(target, textureId);
+		boundTextureId = textureId;
+	}
+}
+
+
+void GlStateCache::bindSampler(int unit, GLuint samplerId)
+{
+	if (unit < 0 || unit >= MAX_TEXTURE_UNITS) {
+		++_stats.issued;
+		glBindSampler((GLuint) unit, samplerId);
+		return;
+	}
+
+	if (checkChange(_samplerIds[unit] != samplerId)) {
+		glBindSampler((GLuint) unit, samplerId);
+		_samplerIds[unit] = samplerId;
+	}
+}
+
+
+void GlStateCache::applyPipelineState(const PipelineState& state)
+{
+	const PipelineState& current = _pipelineState;
+	const bool isKnown = _isPipelineStateKnown;
+
+	if (checkChange(!isKnown || current.isDepthTestEnabled != state.isDepthTestEnabled)) {
+		setCapability(GL_DEPTH_TEST, state.isDepthTestEnabled);
+	}
+	if (checkChange(!isKnown || current.isDepthWriteEnabled != state.isDepthWriteEnabled)) {
+		glDepthMask(state.isDepthWriteEnabled ? GL_TRUE : GL_FALSE);
+	}
+	if (checkChange(!isKnown || current.depthFunc != state.depthFunc)) {
+		glDepthFunc(state.depthFunc);
+	}
+
+	if (checkChange(!isKnown || current.isBlendEnabled != state.isBlendEnabled)) {
+		setCapability(GL_BLEND, state.isBlendEnabled);
+	}
+	const bool isBlendFuncChanged = (current.blendSrcFactor != state.blendSrcFactor)
+			|| (current.blendDstFactor != state.blendDstFactor);
+	if (checkChange(!isKnown || isBlendFuncChanged)) {
+		glBlendFunc(state.blendSrcFactor, state.blendDstFactor);
+	}
+
+	if (checkChange(!isKnown || current.isCullFaceEnabled != state.isCullFaceEnabled)) {
+		setCapability(GL_CULL_FACE, state.isCullFaceEnabled);
+	}
+	if (checkChange(!isKnown || current.cullFace != state.cullFace)) {
+		glCullFace(state.cullFace);
+	}
+	if (checkChange(!isKnown || current.frontFace != state.frontFace)) {
+		glFrontFace(state.frontFace);
+	}
+
+	_pipelineState = state;
+	_isPipelineStateKnown = true;
+}
+
+
+void GlStateCache::forgetBuffer(GLuint bufferId)
+{
+	for (GLuint& id : _bufferIds) {
+		if (id == bufferId) {
+			id = 0;
+		}
+	}
+	for (GLuint& id : _uniformBufferIds) {
+		if (id == bufferId) {
+			id = 0;
+		}
+	}
+}
+
+
+void GlStateCache::forgetTexture(GLuint textureId)
+{
+	for (GLuint& id : _textureIds) {
+		if (id == textureId) {
+			id = 0;
+		}
+	}
+}
+
+
+void GlStateCache::forgetVertexArray(GLuint vertexArrayId)
+{
+	if (_vertexArrayId == vertexArrayId) {
+		_vertexArrayId = 0;
+		_bufferIds[findBufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = 0;
+	}
+}
+
+
+const GlStateCache::Stats& GlStateCache::getStats()
+{
+	return _stats;
+}
+
+
+void GlStateCache::resetStats()
+{
+	_stats = Stats();
+}
+
+
+int GlStateCache::findTextureTargetIndex(GLenum target)
+{
+	const auto it = std::find(TEXTURE_TARGETS.begin(), TEXTURE_TARGETS.end(), target);
+	return (it != TEXTURE_TARGETS.end()) ? (int) (it - TEXTURE_TARGETS.begin()) : -1;
+}
+
+
+int GlStateCache::findBufferTargetIndex(GLenum target)
+{
+	const auto it = std::find(BUFFER_TARGETS.begin(), BUFFER_TARGETS.end(), target);
+	return (it != BUFFER_TARGETS.end()) ? (int) (it - BUFFER_TARGETS.begin()) : -1;
+}
+
+
+void GlStateCache::activateTextureUnit(int unit)
+{
+	// It isn't counted: it's a part of the bind.
+	if (_activeTextureUnit != unit) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		_activeTextureUnit = unit;
+	}
+}
+
+
+void GlStateCache::setCapability(GLenum capability, bool isEnabled)
+{
+	if (isEnabled) {
+		glEnable(capability);
+	} else {
+		glDisable(capability);
+	}
+}
+
+
+bool GlStateCache::checkChange(bool isChanged)
+{
+	if (isChanged) {
+		++_stats.issued;
+	} else {
+		++_stats.elided;
+	}
+	return isChanged;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "GlExtensions.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * @brief An immutable bundle of the fixed-function state used by a draw.
+ * Bundles are declared once (usually as constants) and applied with GlStateCache::applyPipelineState(),
+ * which issues the calls only for the fields which differ from the current state.
+ */
+struct PipelineState
+{
+	bool isDepthTestEnabled = true;
+	bool isDepthWriteEnabled = true;
+	GLenum depthFunc = GL_LESS;
+
+	bool isBlendEnabled = false;
+	GLenum blendSrcFactor = GL_ONE;
+	GLenum blendDstFactor = GL_ZERO;
+
+	bool isCullFaceEnabled = false;
+	GLenum cullFace = GL_BACK;
+	GLenum frontFace = GL_CCW;
+
+	bool operator==(const PipelineState&) const = default;
+};
+
+
+/**
+ * @brief Shadows the GL state of the current context and skips the calls which wouldn't change it.
+ *
+ * All binds of the shadowed state must go through the cache, otherwise the shadow becomes wrong.
+ * If some code changes the state directly, call invalidate(): the next call of every kind is issued then.
+ * The cache knows nothing about deleted objects, so report deletions with the forget*() functions.
+ */
+class GlStateCache
+{
+public:
+	/**
+	 * @brief Counters of the state changing calls since the last reset.
+	 */
+	struct Stats
+	{
+		size_t issued = 0;
+		size_t elided = 0;
+	};
+
+	static constexpr int MAX_TEXTURE_UNITS = 16;
+	static constexpr int MAX_UNIFORM_BUFFER_BINDINGS = 16;
+
+public:
+	/**
+	 * @brief Marks the whole state as unknown.
+	 */
+	static void invalidate();
+
+	static void useProgram(GLuint programId);
+
+	/**
+	 * @brief Binds the VAO. The element array buffer binding is a part of the VAO state, so its shadow is updated too.
+	 */
+	static void bindVertexArray(GLuint vertexArrayId);
+
+	static void bindBuffer(GLenum target, GLuint bufferId);
+
+	/**
+	 * @brief Binds the buffer to the indexed binding point. Like glBindBufferBase, it also binds the buffer to the target.
+	 */
+	static void bindBufferBase(GLenum target, GLuint index, GLuint bufferId);
+
+	/**
+	 * @brief Binds the texture to the unit. The active texture unit is switched only if the binding changes.
+	 */
+	static void bindTexture(int unit, GLenum target, GLuint textureId);
+
+	static void bindSampler(int unit, GLuint samplerId);
+
+	static void applyPipelineState(const PipelineState& state);
+
+	/**
+	 * @brief Updates the shadow after glDeleteBuffers: GL unbinds a deleted buffer from the bindings of the context.
+	 */
+	static void forgetBuffer(GLuint bufferId);
+
+	static void forgetTexture(GLuint textureId);
+
+	static void forgetVertexArray(GLuint vertexArrayId);
+
+	[[nodiscard]]
+	static const Stats& getStats();
+
+	/**
+	 * @brief Resets the counters. It's supposed to be called at the beginning of each frame.
+	 */
+	static void resetStats();
+
+private:
+	// Texture targets which are shadowed. Binds to other targets are passed through.
+	static constexpr std::array<GLenum, 4> TEXTURE_TARGETS = {
+			GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D,
+	};
+	// Buffer targets which are shadowed. GL_ELEMENT_ARRAY_BUFFER is a part of the VAO state.
+	static constexpr std::array<GLenum, 7> BUFFER_TARGETS = {
+			GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER,
+			GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_PIXEL_UNPACK_BUFFER,
+			GL_DRAW_INDIRECT_BUFFER,
+	};
+	// The shadow of a binding which isn't known, so the next bind is always issued.
+	static constexpr GLuint UNKNOWN_ID = 0xFFFFFFFF;
+
+	[[nodiscard]]
+	static int findTextureTargetIndex(GLenum target);
+
+	[[nodiscard]]
+	static int findBufferTargetIndex(GLenum target);
+
+	static void activateTextureUnit(int unit);
+
+	static void setCapability(GLenum capability, bool isEnabled);
+
+	/**
+	 * @brief Counts the call and tells whether it has to be issued.
+	 */
+	static bool checkChange(bool isChanged);
+
+private:
+	static Stats _stats;
+
+	static GLuint _programId;
+	static GLuint _vertexArrayId;
+	static std::array<GLuint, BUFFER_TARGETS.size()> _bufferIds;
+	static std::array<GLuint, MAX_UNIFORM_BUFFER_BINDINGS> _uniformBufferIds;
+	static int _activeTextureUnit;
+	// Indexed by unit * TEXTURE_TARGETS.size() + target index.
+	static std::array<GLuint, MAX_TEXTURE_UNITS * TEXTURE_TARGETS.size()> _textureIds;
+	static std::array<GLuint, MAX_TEXTURE_UNITS> _samplerIds;
+
+	static PipelineState _pipelineState;
+	static bool _isPipelineStateKnown;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+
+namespace Hash {
+	static constexpr uint32_t FNV1A_32_OFFSET_BASIS = 2166136261u;
+	static constexpr uint32_t FNV1A_32_PRIME = 16777619u;
+	static constexpr uint64_t FNV1A_64_OFFSET_BASIS = 14695981039346656037ull;
+	static constexpr uint64_t FNV1A_64_PRIME = 1099511628211ull;
+
+	/**
+	 * @brief Calculates 32-bit FNV-1a hash of the string. It can be evaluated at compile time.
+	 */
+	[[nodiscard]]
+	constexpr uint32_t fnv1a32(std::string_view text, uint32_t hash = FNV1A_32_OFFSET_BASIS)
+	{
+		for (const char c : text) {
+			hash ^= static_cast<uint8_t>(c);
+			hash *= FNV1A_32_PRIME;
+		}
+		return hash;
+	}
+
+	/**
+	 * @brief Calculates 64-bit FNV-1a hash of the string.
+	 * @param hash The hash of the previous chunk, if the text is hashed by parts.
+	 */
+	[[nodiscard]]
+	constexpr uint64_t fnv1a64(std::string_view text, uint64_t hash = FNV1A_64_OFFSET_BASIS)
+	{
+		for (const char c : text) {
+			hash ^= static_cast<uint8_t>(c);
+			hash *= FNV1A_64_PRIME;
+		}
+		return hash;
+	}
+}
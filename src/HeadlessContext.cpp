@@ -0,0 +1,193 @@
+#include "HeadlessContext.hpp"
+
+#include "GlExtensions.hpp"
+#include "ImageFile.hpp"
+#include "Utilities.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#if WITH_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+
+HeadlessContext::HeadlessContext(int width, int height)
+		: _width(width)
+		, _height(height)
+{
+	if (!createContext() || !createFramebuffer()) {
+		destroy();
+	}
+}
+
+
+HeadlessContext::~HeadlessContext() noexcept
+{
+	destroy();
+}
+
+
+std::vector<uint8_t> HeadlessContext::readPixels() const
+{
+	const size_t rowSize = (size_t) _width * 3;
+	std::vector<uint8_t> pixels(rowSize * _height);
+	if (!isValid()) {
+		return pixels;
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebufferId);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, _width, _height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+	handleGLErrors();
+
+	// GL rows go from bottom to top.
+	for (int y = 0; y < _height / 2; ++y) {
+		uint8_t* topRow = pixels.data() + y * rowSize;
+		uint8_t* bottomRow = pixels.data() + (_height - 1 - y) * rowSize;
+		std::swap_ranges(topRow, topRow + rowSize, bottomRow);
+	}
+	return pixels;
+}
+
+
+bool HeadlessContext::saveImage(std::string_view fileName) const
+{
+	return ImageFile::savePpm(fileName, _width, _height, readPixels());
+}
+
+
+#if WITH_EGL
+
+bool HeadlessContext::createContext()
+{
+	// The surfaceless platform of Mesa doesn't need a display server. Other drivers get the default display.
+	const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	EGLDisplay display = EGL_NO_DISPLAY;
+	if (getPlatformDisplay) {
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (display == EGL_NO_DISPLAY) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint majorVersion = 0;
+	EGLint minorVersion = 0;
+	if (display == EGL_NO_DISPLAY || eglInitialize(display, &majorVersion, &minorVersion) != EGL_TRUE) {
+		std::cerr << "[HeadlessContext] EGL initialization failed: " << std::hex << eglGetError() << std::dec << std::endl;
+		return false;
+	}
+	_display = display;
+	std::cout << "EGL version: " << majorVersion << "." << minorVersion
+			<< " (" << eglQueryString(display, EGL_VENDOR) << ")" << std::endl;
+
+	if (eglBindAPI(EGL_OPENGL_API) != EGL_TRUE) {
+		std::cerr << "[HeadlessContext] EGL doesn't support OpenGL." << std::endl;
+		return false;
+	}
+
+	// The rendering goes to the framebuffer object, so any config with OpenGL fits, or none at all.
+	const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+	EGLConfig config = nullptr;
+	EGLint configsCount = 0;
+	eglChooseConfig(display, configAttributes, &config, 1, &configsCount);
+
+	// GL 4.3 enables multi-draw indirect. GL 3.3 is the fallback, like in the windowed mode.
+	constexpr EGLint VERSIONS[][2] = {{4, 3}, {3, 3}};
+	EGLContext context = EGL_NO_CONTEXT;
+	for (const auto& version : VERSIONS) {
+		const EGLint contextAttributes[] = {
+				EGL_CONTEXT_MAJOR_VERSION, version[0],
+				EGL_CONTEXT_MINOR_VERSION, version[1],
+				EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+				EGL_NONE,
+		};
+		context = eglCreateContext(display, (configsCount > 0) ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+		if (context != EGL_NO_CONTEXT) {
+			break;
+		}
+	}
+	if (context == EGL_NO_CONTEXT) {
+		std::cerr << "[HeadlessContext] OpenGL context creation failed: " << std::hex << eglGetError() << std::dec << std::endl;
+		return false;
+	}
+	_context = context;
+
+	if (eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) != EGL_TRUE) {
+		std::cerr << "[HeadlessContext] The context can't be made current without a surface." << std::endl;
+		return false;
+	}
+
+	const auto loadProc = reinterpret_cast<GLADloadproc>(eglGetProcAddress);
+	if (!gladLoadGLLoader(loadProc)) {
+		std::cerr << "[HeadlessContext] GLAD GLLoader initialization failed." << std::endl;
+		return false;
+	}
+	GlExtensions::load(loadProc);
+	return true;
+}
+
+
+void HeadlessContext::destroy()
+{
+	if (_context != nullptr) {
+		if (_framebufferId != 0) {
+			glDeleteFramebuffers(1, &_framebufferId);
+			glDeleteRenderbuffers(1, &_colorRenderbufferId);
+			glDeleteRenderbuffers(1, &_depthRenderbufferId);
+			_framebufferId = 0;
+			_colorRenderbufferId = 0;
+			_depthRenderbufferId = 0;
+		}
+		eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(_display, _context);
+		_context = nullptr;
+	}
+	if (_display != nullptr) {
+		eglTerminate(_display);
+		_display = nullptr;
+	}
+}
+
+#else
+
+bool HeadlessContext::createContext()
+{
+	std::cerr << "[HeadlessContext] The build has no EGL support." << std::endl;
+	return false;
+}
+
+
+void HeadlessContext::destroy()
+{
+}
+
+#endif
+
+
+bool HeadlessContext::createFramebuffer()
+{
+	glGenRenderbuffers(1, &_colorRenderbufferId);
+	glBindRenderbuffer(GL_RENDERBUFFER, _colorRenderbufferId);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, _width, _height);
+
+	glGenRenderbuffers(1, &_depthRenderbufferId);
+	glBindRenderbuffer(GL_RENDERBUFFER, _depthRenderbufferId);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, _width, _height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &_framebufferId);
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebufferId);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colorRenderbufferId);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depthRenderbufferId);
+
+	// The framebuffer stays bound: all frames are drawn to it.
+	const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	handleGLErrors();
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		std::cerr << "[HeadlessContext] The framebuffer is incomplete: " << std::hex << status << std::dec << std::endl;
+		return false;
+	}
+	return true;
+}
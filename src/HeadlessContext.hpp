@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <glad/glad.h>
+
+
+/**
+ * @brief An OpenGL context without a window, which renders to its own framebuffer object.
+ * The context is created with EGL on the surfaceless platform, so it works on machines without a display
+ * and without a GPU (Mesa llvmpipe). It's available only in builds with WITH_EGL.
+ */
+class HeadlessContext
+{
+public:
+	/**
+	 * @brief Creates the context, makes it current, loads GL functions and binds the framebuffer of the given size.
+	 * GL 4.3 is requested first, GL 3.3 is the fallback.
+	 */
+	HeadlessContext(int width, int height);
+
+	~HeadlessContext() noexcept;
+
+	HeadlessContext(const HeadlessContext&) = delete;
+
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	[[nodiscard]]
+	bool isValid() const { return _framebufferId != 0; }
+
+	[[nodiscard]]
+	int getWidth() const { return _width; }
+
+	[[nodiscard]]
+	int getHeight() const { return _height; }
+
+	/**
+	 * @brief Reads the color buffer as RGB rows from top to bottom.
+	 */
+	[[nodiscard]]
+	std::vector<uint8_t> readPixels() const;
+
+	/**
+	 * @brief Saves the color buffer to a binary PPM file.
+	 */
+	bool saveImage(std::string_view fileName) const;
+
+private:
+	bool createContext();
+
+	bool createFramebuffer();
+
+	void destroy();
+
+private:
+	int _width = 0;
+	int _height = 0;
+
+	// EGL handles. They are void pointers, so the EGL headers don't leak to the includers.
+	void* _display = nullptr;
+	void* _context = nullptr;
+
+	GLuint _framebufferId = 0;
+	GLuint _colorRenderbufferId = 0;
+	GLuint _depthRenderbufferId = 0;
+};
@@ -0,0 +1,22 @@
+#include "ImageFile.hpp"
+
+#include "Utilities.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+
+bool ImageFile::savePpm(std::string_view fileName, int width, int height, std::span<const uint8_t> rgbPixels)
+{
+	assertTrue(rgbPixels.size() == (size_t) width * height * 3);
+
+	auto outputFile = std::ofstream(std::string(fileName), std::ios::binary | std::ios::trunc);
+	outputFile << "P6\n" << width << " " << height << "\n255\n";
+	outputFile.write(reinterpret_cast<const char*>(rgbPixels.data()), (std::streamsize) rgbPixels.size());
+	if (!outputFile) {
+		std::cerr << "[ImageFile] The image writing failed: " << fileName << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+
+/**
+ * @brief Saving of rendered frames for regression checks.
+ */
+namespace ImageFile {
+	/**
+	 * @brief Saves the image to a binary PPM file. It needs no library and is readable by most image tools.
+	 * @param rgbPixels RGB rows from top to bottom without padding.
+	 */
+	bool savePpm(std::string_view fileName, int width, int height, std::span<const uint8_t> rgbPixels);
+}
@@ -0,0 +1,43 @@
+#include "IndirectCommandBuilder.hpp"
+
+#include "Utilities.hpp"
+
+#include <algorithm>
+#include <utility>
+
+
+IndirectCommandBuilder::IndirectCommandBuilder(std::vector<MeshRange> meshes)
+		: _meshes(std::move(meshes))
+		, _meshOffsets(_meshes.size())
+{
+	_commands.reserve(_meshes.size());
+}
+
+
+void IndirectCommandBuilder::build(std::span<const uint32_t> instanceMeshes)
+{
+	std::fill(_meshOffsets.begin(), _meshOffsets.end(), 0);
+	for (const uint32_t mesh : instanceMeshes) {
+		assertTrue(mesh < _meshes.size());
+		++_meshOffsets[mesh];
+	}
+
+	_commands.clear();
+	uint32_t offset = 0;
+	for (size_t mesh = 0; mesh < _meshes.size(); ++mesh) {
+		const uint32_t instancesCount = _meshOffsets[mesh];
+		_meshOffsets[mesh] = offset;
+		if (instancesCount == 0) {
+			continue;
+		}
+
+		const MeshRange& range = _meshes[mesh];
+		_commands.push_back({range.indexCount, instancesCount, range.firstIndex, range.baseVertex, offset});
+		offset += instancesCount;
+	}
+
+	_instanceOrder.resize(instanceMeshes.size());
+	for (uint32_t i = 0; i < (uint32_t) instanceMeshes.size(); ++i) {
+		_instanceOrder[_meshOffsets[instanceMeshes[i]]++] = i;
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+/**
+ * @brief The command layout of glMultiDrawElementsIndirect and GL_DRAW_INDIRECT_BUFFER.
+ */
+struct DrawElementsIndirectCommand
+{
+	uint32_t count = 0;
+	uint32_t instanceCount = 0;
+	uint32_t firstIndex = 0;
+	int32_t baseVertex = 0;
+	// The first element of the instance attributes, so the draw reads its own part of the instance buffer.
+	uint32_t baseInstance = 0;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20);
+
+
+/**
+ * @brief The place of one mesh in the shared vertex and index buffers.
+ */
+struct MeshRange
+{
+	uint32_t indexCount = 0;
+	uint32_t firstIndex = 0;
+	int32_t baseVertex = 0;
+};
+
+
+/**
+ * @brief Builds indirect draw commands from the visible instances of meshes, which share the buffers.
+ * The instances are grouped by mesh with the counting sort, and every mesh with instances gets one command.
+ * It doesn't touch GL, so the commands can be built on any thread.
+ */
+class IndirectCommandBuilder
+{
+public:
+	explicit IndirectCommandBuilder(std::vector<MeshRange> meshes);
+
+	[[nodiscard]]
+	size_t getMeshesCount() const { return _meshes.size(); }
+
+	[[nodiscard]]
+	const MeshRange& getMesh(size_t mesh) const { return _meshes[mesh]; }
+
+	/**
+	 * @param instanceMeshes The mesh index of every visible instance.
+	 */
+	void build(std::span<const uint32_t> instanceMeshes);
+
+	/**
+	 * @brief The commands in the ascending order of meshes. Meshes without instances are skipped.
+	 */
+	[[nodiscard]]
+	std::span<const DrawElementsIndirectCommand> getCommands() const { return _commands; }
+
+	/**
+	 * @brief The order of the instance data for the commands: element i is the index of the instance in build() input.
+	 * The instances of a command occupy [baseInstance, baseInstance + instanceCount).
+	 */
+	[[nodiscard]]
+	std::span<const uint32_t> getInstanceOrder() const { return _instanceOrder; }
+
+private:
+	std::vector<MeshRange> _meshes;
+	std::vector<DrawElementsIndirectCommand> _commands;
+	std::vector<uint32_t> _instanceOrder;
+	// The instances count of every mesh, and then its offset in _instanceOrder.
+	std::vector<uint32_t> _meshOffsets;
+};
@@ -0,0 +1,133 @@
+#include "MappedFile.hpp"
+
+#include <iostream>
+#include <utility>
+
+#if OS_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::MappedFile(const std::filesystem::path& filePath)
+{
+#if OS_WINDOWS
+	// Other processes may write, rename and delete the file while it's open, e.g. an editor saving a shader.
+	const DWORD shareMode = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+	HANDLE fileHandle = CreateFileW(filePath.c_str(), GENERIC_READ, shareMode, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		return;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize)) {
+		CloseHandle(fileHandle);
+		return;
+	}
+
+	_fileHandle = fileHandle;
+	_isOpen = true;
+	if (fileSize.QuadPart == 0) {
+		// Empty files can't be mapped.
+		return;
+	}
+
+	_mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	_data = (_mappingHandle != nullptr) ? MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (_data == nullptr) {
+		std::cerr << "[MappedFile] File mapping failed: " << filePath.generic_string()
+				<< " (error " << GetLastError() << ")" << std::endl;
+		close();
+		return;
+	}
+	_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	const int fileDescriptor = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fileDescriptor < 0) {
+		return;
+	}
+
+	struct stat fileStat {};
+	if (::fstat(fileDescriptor, &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+		::close(fileDescriptor);
+		return;
+	}
+
+	_isOpen = true;
+	if (fileStat.st_size > 0) {
+		void* data = ::mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		if (data == MAP_FAILED) {
+			std::cerr << "[MappedFile] File mapping failed: " << filePath.generic_string() << std::endl;
+			_isOpen = false;
+		} else {
+			_data = data;
+			_size = static_cast<size_t>(fileStat.st_size);
+		}
+	}
+
+	// The mapping stays valid after the descriptor is closed.
+	::close(fileDescriptor);
+#endif
+}
+
+
+MappedFile::~MappedFile() noexcept
+{
+	close();
+}
+
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (&other == this) {
+		return *this;
+	}
+
+	close();
+	std::swap(_data, other._data);
+	std::swap(_size, other._size);
+	std::swap(_isOpen, other._isOpen);
+#if OS_WINDOWS
+	std::swap(_fileHandle, other._fileHandle);
+	std::swap(_mappingHandle, other._mappingHandle);
+#endif
+	return *this;
+}
+
+
+void MappedFile::close()
+{
+#if OS_WINDOWS
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+	}
+	if (_mappingHandle != nullptr) {
+		CloseHandle(_mappingHandle);
+	}
+	if (_fileHandle != nullptr) {
+		CloseHandle(_fileHandle);
+	}
+	_mappingHandle = nullptr;
+	_fileHandle = nullptr;
+#else
+	if (_data != nullptr) {
+		::munmap(const_cast<void*>(_data), _size);
+	}
+#endif
+	_data = nullptr;
+	_size = 0;
+	_isOpen = false;
+}
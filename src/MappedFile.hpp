@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+
+/**
+ * @brief A read-only memory mapping of a whole file.
+ * The contents are accessed in place without copying: the pages are loaded by the OS on the first access.
+ * The views returned by the getters are valid while the object is alive.
+ */
+class MappedFile
+{
+public:
+	MappedFile() = default;
+
+	/**
+	 * @brief Maps the file. Check isOpen() for the result: a missing file isn't reported, since it's often expected.
+	 */
+	explicit MappedFile(const std::filesystem::path& filePath);
+
+	~MappedFile() noexcept;
+
+	MappedFile(const MappedFile&) = delete;
+
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept;
+
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	/**
+	 * @brief Checks whether the file is mapped. An empty file is open, but it has no data.
+	 */
+	[[nodiscard]]
+	bool isOpen() const { return _isOpen; }
+
+	[[nodiscard]]
+	size_t getSize() const { return _size; }
+
+	[[nodiscard]]
+	std::string_view getText() const { return {static_cast<const char*>(_data), _size}; }
+
+	[[nodiscard]]
+	std::span<const std::byte> getBytes() const { return {static_cast<const std::byte*>(_data), _size}; }
+
+private:
+	void close();
+
+private:
+	const void* _data = nullptr;
+	size_t _size = 0;
+	bool _isOpen = false;
+#if OS_WINDOWS
+	// The handles are HANDLE values. They are kept as void* to keep windows.h out of the header.
+	void* _fileHandle = nullptr;
+	void* _mappingHandle = nullptr;
+#endif
+};
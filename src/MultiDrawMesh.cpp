@@ -0,0 +1,336 @@
+#include "MultiDrawMesh.hpp"
+
+#include "GlExtensions.hpp"
+#include "GlStateCache.hpp"
+#include "StreamingRingBuffer.hpp"
+#include "Utilities.hpp"
+#include "VertexArrayCache.hpp"
+#include "model/MeshFile.hpp"
+#include "model/PackedIndices.hpp"
+#include "model/PackedModel.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace {
+	std::vector<MeshRange> makeMeshRanges(std::span<const GeometricModel> models)
+	{
+		std::vector<MeshRange> ranges;
+		ranges.reserve(models.size());
+		uint32_t firstIndex = 0;
+		int32_t baseVertex = 0;
+		for (const GeometricModel& model : models) {
+			ranges.push_back({(uint32_t) model.getIndices().size(), firstIndex, baseVertex});
+			firstIndex += (uint32_t) model.getIndices().size();
+			baseVertex += (int32_t) model.getVertices().size();
+		}
+		return ranges;
+	}
+
+
+	std::vector<MeshRange> makeMeshRanges(std::span<const PackedModel> models)
+	{
+		std::vector<MeshRange> ranges;
+		ranges.reserve(models.size());
+		uint32_t firstIndex = 0;
+		int32_t baseVertex = 0;
+		for (const PackedModel& model : models) {
+			ranges.push_back({(uint32_t) model.getIndices().getCount(), firstIndex, baseVertex});
+			firstIndex += (uint32_t) model.getIndices().getCount();
+			baseVertex += (int32_t) model.getVertices().size();
+		}
+		return ranges;
+	}
+
+
+	// The indices of all submeshes are relative to the one vertex blob of the file, so the base vertices are 0.
+	std::vector<MeshRange> makeMeshRanges(const MeshFile& meshFile, size_t lodIndex)
+	{
+		assertTrue(lodIndex < meshFile.getLods().size());
+		const MeshFile::Lod& lod = meshFile.getLods()[lodIndex];
+		std::vector<MeshRange> ranges;
+		ranges.reserve(lod.submeshesCount);
+		for (const MeshFile::Submesh& submesh : meshFile.getSubmeshes().subspan(lod.firstSubmesh, lod.submeshesCount)) {
+			ranges.push_back({submesh.indicesCount, submesh.firstIndex, 0});
+		}
+		return ranges;
+	}
+
+
+	template <typename T>
+	void appendBytes(std::vector<std::byte>& bytes, const T* data, size_t count)
+	{
+		const size_t start = bytes.size();
+		bytes.resize(start + count * sizeof(T));
+		if (count > 0) {
+			std::memcpy(bytes.data() + start, data, count * sizeof(T));
+		}
+	}
+}
+
+
+MultiDrawMesh::MultiDrawMesh(std::span<const GeometricModel> models)
+		: _commandBuilder(makeMeshRanges(models))
+		, _isMultiDrawIndirect(GlExtensions::isMultiDrawIndirectSupported())
+{
+	// The indices of every model stay relative to its vertices: the base vertex of the command offsets them.
+	// So 16 bits are enough, if every model has up to 65536 vertices, however many all of them have.
+	std::vector<VertexFormat> vertices;
+	std::vector<GeometricModel::IndexType> allIndices;
+	size_t maxModelVerticesCount = 0;
+	for (const GeometricModel& model : models) {
+		vertices.insert(vertices.end(), model.getVertices().begin(), model.getVertices().end());
+		allIndices.insert(allIndices.end(), model.getIndices().begin(), model.getIndices().end());
+		maxModelVerticesCount = std::max(maxModelVerticesCount, model.getVertices().size());
+	}
+	const PackedIndices indices(allIndices, maxModelVerticesCount);
+	createBuffers(
+			std::as_bytes(std::span(vertices)),
+			{static_cast<const std::byte*>(indices.getData()), indices.getBytesCount()},
+			indices.getIndexSize()
+	);
+}
+
+
+MultiDrawMesh::MultiDrawMesh(std::span<const PackedModel> models)
+		: _commandBuilder(makeMeshRanges(models))
+		, _isMultiDrawIndirect(GlExtensions::isMultiDrawIndirectSupported())
+{
+	const PackedModel::PositionEncoding encoding = models.empty() ? PackedModel::PositionEncoding::Half : models[0].getPositionEncoding();
+	_vertexLayout = (encoding == PackedModel::PositionEncoding::Half)
+			? &VertexLayouts::PACKED_VERTEX_FORMAT_HALF
+			: &VertexLayouts::PACKED_VERTEX_FORMAT_UNORM16;
+
+	// The indices of a model take 16 bits, if it has up to 65536 vertices. The shared buffer takes 16 bits,
+	// if all of them do, otherwise the short indices are widened. Either way the indices stay relative to the model.
+	const bool isShort = std::all_of(models.begin(), models.end(), [](const PackedModel& model) {
+		return model.getIndices().getIndexSize() == sizeof(uint16_t);
+	});
+	std::vector<std::byte> vertexData;
+	std::vector<std::byte> indexData;
+	for (const PackedModel& model : models) {
+		assertTrue(model.getPositionEncoding() == encoding);
+		appendBytes(vertexData, model.getVertices().data(), model.getVertices().size());
+
+		const PackedIndices& indices = model.getIndices();
+		if (isShort || indices.getIndexSize() == sizeof(uint32_t)) {
+			appendBytes(indexData, static_cast<const std::byte*>(indices.getData()), indices.getBytesCount());
+		} else {
+			for (size_t i = 0; i < indices.getCount(); ++i) {
+				const uint32_t index = indices[i];
+				appendBytes(indexData, &index, 1);
+			}
+		}
+
+		_dequantizationMatrices.push_back(model.getDequantization().getMatrix());
+	}
+	createBuffers(vertexData, indexData, isShort ? sizeof(uint16_t) : sizeof(uint32_t));
+}
+
+
+MultiDrawMesh::MultiDrawMesh(const MeshFile& meshFile, size_t lodIndex)
+		: _commandBuilder(makeMeshRanges(meshFile, lodIndex))
+		, _isMultiDrawIndirect(GlExtensions::isMultiDrawIndirectSupported())
+		, _vertexLayout(&meshFile.getVertexLayout())
+{
+	if (_vertexLayout != &VertexLayouts::VERTEX_FORMAT) {
+		_dequantizationMatrices.assign(_commandBuilder.getMeshesCount(), meshFile.getDequantization().getMatrix());
+	}
+	// The whole index blob is uploaded, so the commands address the submeshes by their indices in the file.
+	createBuffers(meshFile.getVertexData(), meshFile.getIndexData(), meshFile.getIndexSize());
+}
+
+
+MultiDrawMesh::~MultiDrawMesh() noexcept
+{
+	deleteBuffers();
+}
+
+
+void MultiDrawMesh::setInstances(std::span<const uint32_t> instanceMeshes, std::span<const glm::mat4> modelMatrices)
+{
+	assertTrue(isValid());
+	assertTrue(instanceMeshes.size() == modelMatrices.size());
+
+	_commandBuilder.build(instanceMeshes);
+	if (instanceMeshes.empty()) {
+		return;
+	}
+
+	if (!_instanceStream || !writeInstancesToStream(instanceMeshes, modelMatrices)) {
+		writeInstancesToBuffer(instanceMeshes, modelMatrices);
+	}
+
+	if (_isMultiDrawIndirect) {
+		uploadCommands();
+	}
+}
+
+
+void MultiDrawMesh::draw() const
+{
+	assertTrue(isValid());
+	if (_commandBuilder.getCommands().empty()) {
+		return;
+	}
+
+	if (_isMultiDrawIndirect) {
+		drawIndirect();
+	} else {
+		drawOneByOne();
+	}
+}
+
+
+size_t MultiDrawMesh::getDrawCallsCount() const
+{
+	const size_t commandsCount = _commandBuilder.getCommands().size();
+	return _isMultiDrawIndirect ? std::min<size_t>(commandsCount, 1) : commandsCount;
+}
+
+
+bool MultiDrawMesh::writeInstancesToStream(std::span<const uint32_t> instanceMeshes, std::span<const glm::mat4> modelMatrices)
+{
+	// The matrix alignment lets the attributes address the allocation by the instance index.
+	const size_t size = _commandBuilder.getInstanceOrder().size() * sizeof(glm::mat4);
+	const StreamingRingBuffer::Allocation allocation = _instanceStream->allocate(size, sizeof(glm::mat4));
+	if (!allocation.isValid()) {
+		return false;
+	}
+
+	// The matrices are gathered right into the mapped memory: no intermediate copy.
+	gatherInstanceMatrices(instanceMeshes, modelMatrices, static_cast<glm::mat4*>(allocation.data));
+	_instanceStream->commit(allocation);
+
+	_instanceSourceBufferId = _instanceStream->getBufferId();
+	_instanceSourceFirst = allocation.offset / sizeof(glm::mat4);
+	return true;
+}
+
+
+void MultiDrawMesh::writeInstancesToBuffer(std::span<const uint32_t> instanceMeshes, std::span<const glm::mat4> modelMatrices)
+{
+	_orderedMatrices.resize(_commandBuilder.getInstanceOrder().size());
+	gatherInstanceMatrices(instanceMeshes, modelMatrices, _orderedMatrices.data());
+
+	// The buffer is orphaned on every call: the driver gives new memory, if the previous contents are still used
+	// by the GPU, so the write doesn't wait for the previous frame draws. The capacity only grows, with a margin,
+	// so a slowly growing scene doesn't change the size of the storage every frame.
+	GlStateCache::bindBuffer(GL_ARRAY_BUFFER, _instanceBufferId);
+	if (_orderedMatrices.size() > _instancesCapacity) {
+		_instancesCapacity = std::max(_orderedMatrices.size(), _instancesCapacity * 3 / 2);
+	}
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) (_instancesCapacity * sizeof(glm::mat4)), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr) (_orderedMatrices.size() * sizeof(glm::mat4)), _orderedMatrices.data());
+
+	_instanceSourceBufferId = _instanceBufferId;
+	_instanceSourceFirst = 0;
+}
+
+
+void MultiDrawMesh::gatherInstanceMatrices(
+		std::span<const uint32_t> instanceMeshes,
+		std::span<const glm::mat4> modelMatrices,
+		glm::mat4* orderedMatrices
+) const
+{
+	const std::span<const uint32_t> instanceOrder = _commandBuilder.getInstanceOrder();
+	if (_dequantizationMatrices.empty()) {
+		for (size_t i = 0; i < instanceOrder.size(); ++i) {
+			orderedMatrices[i] = modelMatrices[instanceOrder[i]];
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < instanceOrder.size(); ++i) {
+		const uint32_t instance = instanceOrder[i];
+		orderedMatrices[i] = modelMatrices[instance] * _dequantizationMatrices[instanceMeshes[instance]];
+	}
+}
+
+
+void MultiDrawMesh::uploadCommands()
+{
+	const std::span<const DrawElementsIndirectCommand> commands = _commandBuilder.getCommands();
+	GlStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, _commandBufferId);
+	if (commands.size() > _commandsCapacity) {
+		_commandsCapacity = std::max(commands.size(), _commandsCapacity * 3 / 2);
+	}
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, (GLsizeiptr) (_commandsCapacity * sizeof(DrawElementsIndirectCommand)), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, (GLsizeiptr) commands.size_bytes(), commands.data());
+}
+
+
+void MultiDrawMesh::bindVertexArray(size_t firstInstance) const
+{
+	const VertexStream streams[] = {
+			{_vertexLayout, _vertexBufferId, 0},
+			{&VertexLayouts::INSTANCE_MODEL_MATRIX, _instanceSourceBufferId, (_instanceSourceFirst + firstInstance) * sizeof(glm::mat4)},
+	};
+	VertexArrayCache::bind(streams, _indexBufferId);
+}
+
+
+void MultiDrawMesh::drawIndirect() const
+{
+	// The base instances of the commands are added to the offset of the instance stream.
+	bindVertexArray(0);
+	const std::span<const DrawElementsIndirectCommand> commands = _commandBuilder.getCommands();
+	GlStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, _commandBufferId);
+	GlExtensions::multiDrawElementsIndirect(GL_TRIANGLES, _indexType, nullptr, (GLsizei) commands.size(), 0);
+}
+
+
+void MultiDrawMesh::drawOneByOne() const
+{
+	for (const DrawElementsIndirectCommand& command : _commandBuilder.getCommands()) {
+		bindVertexArray(command.baseInstance);
+		const auto* indicesOffset = (const void*) (command.firstIndex * _indexSize);
+		glDrawElementsInstancedBaseVertex(
+				GL_TRIANGLES,
+				(GLsizei) command.count,
+				_indexType,
+				indicesOffset,
+				(GLsizei) command.instanceCount,
+				command.baseVertex
+		);
+	}
+}
+
+
+void MultiDrawMesh::createBuffers(std::span<const std::byte> vertexData, std::span<const std::byte> indexData, size_t indexSize)
+{
+	_indexType = (indexSize == sizeof(uint16_t)) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	_indexSize = indexSize;
+
+	// The buffers are filled through GL_ARRAY_BUFFER: the element array binding belongs to the bound VAO.
+	glGenBuffers(1, &_vertexBufferId);
+	GlStateCache::bindBuffer(GL_ARRAY_BUFFER, _vertexBufferId);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) vertexData.size(), vertexData.data(), GL_STATIC_DRAW);
+
+	glGenBuffers(1, &_indexBufferId);
+	GlStateCache::bindBuffer(GL_ARRAY_BUFFER, _indexBufferId);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) indexData.size(), indexData.data(), GL_STATIC_DRAW);
+
+	glGenBuffers(1, &_instanceBufferId);
+
+	if (_isMultiDrawIndirect) {
+		glGenBuffers(1, &_commandBufferId);
+	}
+
+	handleGLErrors();
+}
+
+
+void MultiDrawMesh::deleteBuffers()
+{
+	for (GLuint* bufferId : {&_vertexBufferId, &_indexBufferId, &_instanceBufferId, &_commandBufferId}) {
+		if (*bufferId > 0) {
+			VertexArrayCache::forgetBuffer(*bufferId);
+			glDeleteBuffers(1, bufferId);
+			GlStateCache::forgetBuffer(*bufferId);
+			*bufferId = 0;
+		}
+	}
+}
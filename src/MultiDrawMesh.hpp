@@ -0,0 +1,140 @@
+#pragma once
+
+#include "IndirectCommandBuilder.hpp"
+#include "VertexLayout.hpp"
+#include "model/GeometricModel.hpp"
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+class MeshFile;
+class PackedModel;
+class StreamingRingBuffer;
+
+
+/**
+ * @brief Several meshes in shared buffers, which draws instances of all of them with one glMultiDrawElementsIndirect call.
+ *
+ * The commands are built on the CPU from the visible instances. Every command addresses its model matrices
+ * in the instance buffer by the base instance. The matrix is the mat4 attribute, which takes 4 consecutive locations
+ * and advances once per instance (glVertexAttribDivisor). It's read by the INSTANCED variant of the vertex shaders.
+ * Without multi-draw indirect (GL 3.3) the same commands are issued one by one,
+ * and the base instance is emulated by the offset of the instance attributes.
+ * With an instance stream the matrices are written straight into the streaming buffer instead of the own one.
+ * The packed vertices are drawn as they are: the dequantization of every mesh is folded into the model matrices
+ * of its instances.
+ */
+class MultiDrawMesh
+{
+public:
+	explicit MultiDrawMesh(std::span<const GeometricModel> models);
+
+	/**
+	 * @brief Uploads the packed vertices and indices as they are. All models must have the same position encoding.
+	 */
+	explicit MultiDrawMesh(std::span<const PackedModel> models);
+
+	/**
+	 * @brief Uploads the vertex and the index blobs of the mapped file straight to the buffers: no copies on the way.
+	 * Every submesh of the LOD is a mesh. The file may be closed after that.
+	 */
+	explicit MultiDrawMesh(const MeshFile& meshFile, size_t lodIndex = 0);
+
+	~MultiDrawMesh() noexcept;
+
+	MultiDrawMesh(const MultiDrawMesh&) = delete;
+
+	MultiDrawMesh& operator=(const MultiDrawMesh&) = delete;
+
+	[[nodiscard]]
+	bool isValid() const { return _vertexBufferId > 0; }
+
+	[[nodiscard]]
+	size_t getMeshesCount() const { return _commandBuilder.getMeshesCount(); }
+
+	/**
+	 * @brief Sets the ring buffer, which the model matrices are written to. nullptr switches to the own buffer.
+	 * The frame of the ring must be started before setInstances(). The own buffer is used, if the ring is full.
+	 */
+	void setInstanceStream(StreamingRingBuffer* instanceStream) { _instanceStream = instanceStream; }
+
+	/**
+	 * @brief Builds the commands and uploads them with the model matrices. They are drawn until the next call.
+	 * @param instanceMeshes The mesh of every instance.
+	 * @param modelMatrices The model matrix of every instance.
+	 */
+	void setInstances(std::span<const uint32_t> instanceMeshes, std::span<const glm::mat4> modelMatrices);
+
+	/**
+	 * @brief Draws all instances with the currently bound shader.
+	 */
+	void draw() const;
+
+	/**
+	 * @brief Returns the number of GL draw calls, which draw() issues.
+	 */
+	[[nodiscard]]
+	size_t getDrawCallsCount() const;
+
+private:
+	/**
+	 * @return false, if the stream hasn't enough room.
+	 */
+	bool writeInstancesToStream(std::span<const uint32_t> instanceMeshes, std::span<const glm::mat4> modelMatrices);
+
+	void writeInstancesToBuffer(std::span<const uint32_t> instanceMeshes, std::span<const glm::mat4> modelMatrices);
+
+	/**
+	 * @brief Writes the model matrices in the order of the commands with the dequantization of their meshes.
+	 */
+	void gatherInstanceMatrices(
+			std::span<const uint32_t> instanceMeshes,
+			std::span<const glm::mat4> modelMatrices,
+			glm::mat4* orderedMatrices
+	) const;
+
+	void uploadCommands();
+
+	/**
+	 * @brief Binds the VAO with the instance attributes starting at the given instance of the current instance source.
+	 */
+	void bindVertexArray(size_t firstInstance) const;
+
+	void drawIndirect() const;
+
+	void drawOneByOne() const;
+
+	void createBuffers(std::span<const std::byte> vertexData, std::span<const std::byte> indexData, size_t indexSize);
+
+	void deleteBuffers();
+
+private:
+	IndirectCommandBuilder _commandBuilder;
+	// The model matrices in the order of the commands.
+	std::vector<glm::mat4> _orderedMatrices;
+	bool _isMultiDrawIndirect = false;
+	const VertexLayout* _vertexLayout = &VertexLayouts::VERTEX_FORMAT;
+	// The dequantization matrix of every mesh. It's empty for the float vertices, which need none.
+	std::vector<glm::mat4> _dequantizationMatrices;
+
+	StreamingRingBuffer* _instanceStream = nullptr;
+	// The buffer with the model matrices of the last setInstances(), and the element of the first one.
+	GLuint _instanceSourceBufferId = 0;
+	size_t _instanceSourceFirst = 0;
+
+	GLuint _vertexBufferId = 0;
+	GLuint _indexBufferId = 0;
+	GLuint _instanceBufferId = 0;
+	GLuint _commandBufferId = 0;
+	// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, and its size.
+	GLenum _indexType = GL_UNSIGNED_INT;
+	size_t _indexSize = sizeof(uint32_t);
+	size_t _instancesCapacity = 0;
+	size_t _commandsCapacity = 0;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+
+/**
+ * @brief The compact vertex of PackedModel: 20 bytes instead of 36 of VertexFormat, and it has a normal too.
+ */
+struct PackedVertexFormat {
+	// Half floats or 16-bit unsigned normalized values, which the dequantization of the model maps to the model space.
+	// The 4th value is 0: it keeps the color 4-byte aligned.
+	uint16_t pos[4] = {};
+	// RGBA8, normalized.
+	uint8_t color[4] = {};
+	// Half floats, so the repeating coordinates outside [0, 1] are kept.
+	uint16_t texCoords[2] = {};
+	// The octahedral encoding of the unit normal: 2 signed normalized 16-bit values.
+	int16_t normal[2] = {};
+};
+
+static_assert(sizeof(PackedVertexFormat) == 20);
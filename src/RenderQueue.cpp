@@ -0,0 +1,88 @@
+#include "RenderQueue.hpp"
+
+#include "Utilities.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+uint32_t RenderSortKey::quantizeDepth(float depth01)
+{
+	const float clampedDepth = std::clamp(depth01, 0.f, 1.f);
+	return (uint32_t) std::lround(clampedDepth * (float) MAX_DEPTH);
+}
+
+
+uint64_t RenderSortKey::makeOpaque(uint32_t pass, uint32_t shader, uint32_t material, uint32_t vertexArray, float depth01)
+{
+	assertTrue(pass <= MAX_PASS && shader <= MAX_SHADER && material <= MAX_MATERIAL && vertexArray <= MAX_VERTEX_ARRAY);
+	return (uint64_t(pass & MAX_PASS) << PASS_SHIFT)
+			| (uint64_t(shader & MAX_SHADER) << OPAQUE_SHADER_SHIFT)
+			| (uint64_t(material & MAX_MATERIAL) << OPAQUE_MATERIAL_SHIFT)
+			| (uint64_t(vertexArray & MAX_VERTEX_ARRAY) << OPAQUE_VERTEX_ARRAY_SHIFT)
+			| (uint64_t(quantizeDepth(depth01)) << OPAQUE_DEPTH_SHIFT);
+}
+
+
+uint64_t RenderSortKey::makeTranslucent(uint32_t pass, uint32_t shader, uint32_t material, uint32_t vertexArray, float depth01)
+{
+	assertTrue(pass <= MAX_PASS && shader <= MAX_SHADER && material <= MAX_MATERIAL && vertexArray <= MAX_VERTEX_ARRAY);
+	// The far draws go first.
+	const uint32_t invertedDepth = MAX_DEPTH - quantizeDepth(depth01);
+	return (uint64_t(pass & MAX_PASS) << PASS_SHIFT)
+			| (uint64_t(1) << TRANSLUCENCY_SHIFT)
+			| (uint64_t(invertedDepth) << TRANSLUCENT_DEPTH_SHIFT)
+			| (uint64_t(shader & MAX_SHADER) << TRANSLUCENT_SHADER_SHIFT)
+			| (uint64_t(material & MAX_MATERIAL) << TRANSLUCENT_MATERIAL_SHIFT)
+			| (uint64_t(vertexArray & MAX_VERTEX_ARRAY) << TRANSLUCENT_VERTEX_ARRAY_SHIFT);
+}
+
+
+void RenderQueue::sort()
+{
+	const size_t count = _items.size();
+	if (count < 2) {
+		return;
+	}
+
+	// The histograms of all digits are collected in one read of the items.
+	_histograms.assign(RADIX_PASSES * RADIX_SIZE, 0);
+	for (const Item& item : _items) {
+		for (int pass = 0; pass < RADIX_PASSES; ++pass) {
+			const size_t digit = (item.key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1);
+			++_histograms[pass * RADIX_SIZE + digit];
+		}
+	}
+
+	_sortBuffer.resize(count);
+	Item* source = _items.data();
+	Item* destination = _sortBuffer.data();
+	for (int pass = 0; pass < RADIX_PASSES; ++pass) {
+		uint32_t* histogram = _histograms.data() + pass * RADIX_SIZE;
+		const int shift = pass * RADIX_BITS;
+
+		// The digit is the same for all items (like the pass bits usually), so the order doesn't change.
+		const size_t firstDigit = (source[0].key >> shift) & (RADIX_SIZE - 1);
+		if (histogram[firstDigit] == count) {
+			continue;
+		}
+
+		// Offsets of the digits in the destination.
+		uint32_t offset = 0;
+		for (size_t digit = 0; digit < RADIX_SIZE; ++digit) {
+			const uint32_t digitCount = histogram[digit];
+			histogram[digit] = offset;
+			offset += digitCount;
+		}
+
+		for (size_t i = 0; i < count; ++i) {
+			const size_t digit = (source[i].key >> shift) & (RADIX_SIZE - 1);
+			destination[histogram[digit]++] = source[i];
+		}
+		std::swap(source, destination);
+	}
+
+	if (source != _items.data()) {
+		_items.swap(_sortBuffer);
+	}
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+/**
+ * @brief Packs the draw state into a 64-bit key, so sorting the keys groups draws with the same state.
+ *
+ * Opaque draws (from the most significant bits):   pass | 0 | shader | material | vertex array | depth
+ * Translucent draws:                                pass | 1 | depth (inverted) | shader | material | vertex array
+ *
+ * Opaque draws are grouped by state first and go roughly front-to-back inside a group, which helps the early depth test.
+ * Translucent draws must be blended back-to-front, so the depth takes priority over the state for them.
+ */
+namespace RenderSortKey {
+	static constexpr int PASS_BITS = 5;
+	static constexpr int TRANSLUCENCY_BITS = 1;
+	static constexpr int SHADER_BITS = 10;
+	static constexpr int MATERIAL_BITS = 12;
+	static constexpr int VERTEX_ARRAY_BITS = 12;
+	static constexpr int DEPTH_BITS = 24;
+	static_assert(PASS_BITS + TRANSLUCENCY_BITS + SHADER_BITS + MATERIAL_BITS + VERTEX_ARRAY_BITS + DEPTH_BITS == 64);
+
+	static constexpr uint32_t MAX_PASS = (1u << PASS_BITS) - 1;
+	static constexpr uint32_t MAX_SHADER = (1u << SHADER_BITS) - 1;
+	static constexpr uint32_t MAX_MATERIAL = (1u << MATERIAL_BITS) - 1;
+	static constexpr uint32_t MAX_VERTEX_ARRAY = (1u << VERTEX_ARRAY_BITS) - 1;
+	static constexpr uint32_t MAX_DEPTH = (1u << DEPTH_BITS) - 1;
+
+	static constexpr int TRANSLUCENCY_SHIFT = 64 - PASS_BITS - TRANSLUCENCY_BITS;
+	static constexpr int PASS_SHIFT = TRANSLUCENCY_SHIFT + TRANSLUCENCY_BITS;
+
+	static constexpr int OPAQUE_SHADER_SHIFT = TRANSLUCENCY_SHIFT - SHADER_BITS;
+	static constexpr int OPAQUE_MATERIAL_SHIFT = OPAQUE_SHADER_SHIFT - MATERIAL_BITS;
+	static constexpr int OPAQUE_VERTEX_ARRAY_SHIFT = OPAQUE_MATERIAL_SHIFT - VERTEX_ARRAY_BITS;
+	static constexpr int OPAQUE_DEPTH_SHIFT = OPAQUE_VERTEX_ARRAY_SHIFT - DEPTH_BITS;
+
+	static constexpr int TRANSLUCENT_DEPTH_SHIFT = TRANSLUCENCY_SHIFT - DEPTH_BITS;
+	static constexpr int TRANSLUCENT_SHADER_SHIFT = TRANSLUCENT_DEPTH_SHIFT - SHADER_BITS;
+	static constexpr int TRANSLUCENT_MATERIAL_SHIFT = TRANSLUCENT_SHADER_SHIFT - MATERIAL_BITS;
+	static constexpr int TRANSLUCENT_VERTEX_ARRAY_SHIFT = TRANSLUCENT_MATERIAL_SHIFT - VERTEX_ARRAY_BITS;
+	static_assert(OPAQUE_DEPTH_SHIFT == 0 && TRANSLUCENT_VERTEX_ARRAY_SHIFT == 0);
+
+	/**
+	 * @brief Converts the depth to the key field.
+	 * @param depth01 The view depth normalized to [0, 1], where 0 is the near plane. It's clamped.
+	 */
+	[[nodiscard]]
+	uint32_t quantizeDepth(float depth01);
+
+	/**
+	 * @param shader, material, vertexArray Small dense ids of the objects, which are assigned by the renderer.
+	 */
+	[[nodiscard]]
+	uint64_t makeOpaque(uint32_t pass, uint32_t shader, uint32_t material, uint32_t vertexArray, float depth01);
+
+	[[nodiscard]]
+	uint64_t makeTranslucent(uint32_t pass, uint32_t shader, uint32_t material, uint32_t vertexArray, float depth01);
+
+	[[nodiscard]]
+	constexpr uint32_t getPass(uint64_t key) { return (uint32_t) (key >> PASS_SHIFT); }
+
+	[[nodiscard]]
+	constexpr bool isTranslucent(uint64_t key) { return ((key >> TRANSLUCENCY_SHIFT) & 1) != 0; }
+
+	/**
+	 * @brief Returns the key without the depth: items with equal states are drawn together.
+	 */
+	[[nodiscard]]
+	constexpr uint64_t getState(uint64_t key)
+	{
+		constexpr uint64_t depthMask = uint64_t(MAX_DEPTH);
+		return isTranslucent(key) ? (key & ~(depthMask << TRANSLUCENT_DEPTH_SHIFT)) : (key & ~(depthMask << OPAQUE_DEPTH_SHIFT));
+	}
+
+	[[nodiscard]]
+	constexpr uint32_t getShader(uint64_t key)
+	{
+		const int shift = isTranslucent(key) ? TRANSLUCENT_SHADER_SHIFT : OPAQUE_SHADER_SHIFT;
+		return (uint32_t) (key >> shift) & MAX_SHADER;
+	}
+
+	[[nodiscard]]
+	constexpr uint32_t getMaterial(uint64_t key)
+	{
+		const int shift = isTranslucent(key) ? TRANSLUCENT_MATERIAL_SHIFT : OPAQUE_MATERIAL_SHIFT;
+		return (uint32_t) (key >> shift) & MAX_MATERIAL;
+	}
+
+	[[nodiscard]]
+	constexpr uint32_t getVertexArray(uint64_t key)
+	{
+		const int shift = isTranslucent(key) ? TRANSLUCENT_VERTEX_ARRAY_SHIFT : OPAQUE_VERTEX_ARRAY_SHIFT;
+		return (uint32_t) (key >> shift) & MAX_VERTEX_ARRAY;
+	}
+}
+
+
+/**
+ * @brief Collects the draws of a frame, sorts them by the keys and submits them with the minimum of state changes.
+ * An item references the draw data of the caller by the payload index, so the queue never touches GPU objects.
+ */
+class RenderQueue
+{
+public:
+	struct Item
+	{
+		uint64_t key = 0;
+		// The index of the draw data on the caller side.
+		uint32_t payload = 0;
+	};
+
+	/**
+	 * @brief Counters of the last submit().
+	 */
+	struct Stats
+	{
+		size_t itemsCount = 0;
+		// Runs of items with the same state. Each run can be drawn with one instanced call.
+		size_t drawsCount = 0;
+		size_t passChanges = 0;
+		size_t shaderChanges = 0;
+		size_t materialChanges = 0;
+		size_t vertexArrayChanges = 0;
+	};
+
+public:
+	void clear() { _items.clear(); }
+
+	void reserve(size_t count) { _items.reserve(count); }
+
+	void push(uint64_t key, uint32_t payload) { _items.push_back({key, payload}); }
+
+	[[nodiscard]]
+	size_t size() const { return _items.size(); }
+
+	[[nodiscard]]
+	std::span<const Item> getItems() const { return _items; }
+
+	/**
+	 * @brief Sorts the items by the keys with LSD radix sort. It's stable: items with equal keys keep the push order.
+	 */
+	void sort();
+
+	/**
+	 * @brief Walks the items in the current order and reports only the state which differs from the previous item.
+	 * @param visitor An object with the functions:
+	 * 	beginPass(uint32_t pass, bool isTranslucent),
+	 * 	bindShader(uint32_t shader), bindMaterial(uint32_t material), bindVertexArray(uint32_t vertexArray),
+	 * 	draw(std::span<const Item> items) - items share the whole state except the depth.
+	 */
+	template <typename Visitor>
+	Stats submit(Visitor& visitor) const { return submit(visitor, 0, _items.size()); }
+
+	/**
+	 * @brief Walks the items [begin, end) only. The first item is compared with the item before the range,
+	 * so consecutive ranges report the same state changes as one walk, and the ranges can be walked on different threads.
+	 * Only a run which crosses the range boundary is split into two draws.
+	 */
+	template <typename Visitor>
+	Stats submit(Visitor& visitor, size_t begin, size_t end) const;
+
+private:
+	static constexpr int RADIX_BITS = 11;
+	static constexpr int RADIX_PASSES = (64 + RADIX_BITS - 1) / RADIX_BITS;
+	static constexpr size_t RADIX_SIZE = size_t(1) << RADIX_BITS;
+
+	std::vector<Item> _items;
+	// The second buffer of the radix sort. It's kept to avoid an allocation per frame.
+	std::vector<Item> _sortBuffer;
+	std::vector<uint32_t> _histograms;
+};
+
+
+template <typename Visitor>
+RenderQueue::Stats RenderQueue::submit(Visitor& visitor, size_t begin, size_t end) const
+{
+	Stats stats;
+	stats.itemsCount = end - begin;
+
+	size_t runBegin = begin;
+	for (size_t i = begin; i < end; ++i) {
+		const uint64_t key = _items[i].key;
+		if (i > begin && RenderSortKey::getState(key) == RenderSortKey::getState(_items[i - 1].key)) {
+			continue;
+		}
+
+		const uint32_t pass = RenderSortKey::getPass(key);
+		const bool isTranslucent = RenderSortKey::isTranslucent(key);
+		const uint32_t shader = RenderSortKey::getShader(key);
+		const uint32_t material = RenderSortKey::getMaterial(key);
+		const uint32_t vertexArray = RenderSortKey::getVertexArray(key);
+
+		const bool isFirst = (i == 0);
+		const uint64_t previousKey = isFirst ? 0 : _items[i - 1].key;
+		const bool isPassChanged = isFirst
+				|| pass != RenderSortKey::getPass(previousKey)
+				|| isTranslucent != RenderSortKey::isTranslucent(previousKey);
+		const bool isShaderChanged = isFirst || shader != RenderSortKey::getShader(previousKey);
+		const bool isMaterialChanged = isFirst || material != RenderSortKey::getMaterial(previousKey);
+		const bool isVertexArrayChanged = isFirst || vertexArray != RenderSortKey::getVertexArray(previousKey);
+
+		if (i > runBegin) {
+			visitor.draw(std::span<const Item>(_items.data() + runBegin, i - runBegin));
+			++stats.drawsCount;
+		}
+		runBegin = i;
+
+		if (isPassChanged) {
+			visitor.beginPass(pass, isTranslucent);
+			++stats.passChanges;
+		}
+		if (isShaderChanged) {
+			visitor.bindShader(shader);
+			++stats.shaderChanges;
+		}
+		if (isMaterialChanged) {
+			visitor.bindMaterial(material);
+			++stats.materialChanges;
+		}
+		if (isVertexArrayChanged) {
+			visitor.bindVertexArray(vertexArray);
+			++stats.vertexArrayChanges;
+		}
+	}
+
+	if (end > runBegin) {
+		visitor.draw(std::span<const Item>(_items.data() + runBegin, end - runBegin));
+		++stats.drawsCount;
+	}
+
+	return stats;
+}
@@ -1,48 +1,66 @@
 #include "Shader.hpp"
 
+#include "FrameUniformBuffer.hpp"
+#include "GlExtensions.hpp"
+#include "GlStateCache.hpp"
 #include "Utilities.hpp"
 #include "ShaderUniform.hpp"
 #include "ShaderUniformStore.hpp"
 
-#include <fstream>
+#include <algorithm>
 #include <iostream>
-#include <sstream>
 #include <vector>
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/mat4x4.hpp>
 
 
-Shader::Shader(std::string_view vertexFileName, std::string_view fragmentFileName)
+Shader::UniformUploadStats Shader::_uploadStats;
+
+
+Shader::Shader(std::string_view vertexFileName, std::string_view fragmentFileName, BuildMode buildMode)
+		: Shader(
+				ShaderPreprocessor::process(vertexFileName, ShaderDefines()),
+				ShaderPreprocessor::process(fragmentFileName, ShaderDefines()),
+				buildMode
+		)
+{
+}
+
+
+Shader::Shader(const PreprocessedShader& vertexSource, const PreprocessedShader& fragmentSource, BuildMode buildMode)
+		: _vertexFileName(vertexSource.fileName)
+		, _fragmentFileName(fragmentSource.fileName)
+		, _vertexSourceFiles(vertexSource.dependencies)
+		, _fragmentSourceFiles(fragmentSource.dependencies)
 {
 	_uniforms = std::make_unique<ShaderUniformStore>();
 
-	// Load and compile vertex shader.
-	const std::string vertexText = loadShaderText(vertexFileName);
-	const GLuint vertexShaderId = compileShader(ShaderType::Vertex, vertexText);
-	if (vertexShaderId == 0) {
-		std::cerr << "[Shader] Shader is not compiled: " << vertexFileName << std::endl;
-	}
+	// Shaders with identical sources share one program within the process.
+	const uint64_t programKey = ShaderProgramCache::makeKey(vertexSource.segments, fragmentSource.segments);
+	_program = ShaderProgramCache::find(programKey);
+	_origin = "shared program";
+
+	if (!_program) {
+		// The binary stored on the previous launch saves compilation and linking.
+		const GLuint programId = ShaderProgramCache::loadBinary(programKey);
+		if (programId > 0) {
+			_program = std::make_shared<ShaderProgram>(programId);
+			_origin = "binary cache";
+		} else {
+			_program = startProgramBuild(vertexSource.segments, fragmentSource.segments);
+			_origin = "sources";
+		}
 
-	// Load and compile fragment shader.
-	const std::string fragmentText = loadShaderText(fragmentFileName);
-	const GLuint fragmentShaderId = compileShader(ShaderType::Fragment, fragmentText);
-	if (fragmentShaderId == 0) {
-		std::cerr << "[Shader] Shader is not compiled: " << fragmentFileName << std::endl;
+		if (_program) {
+			_program->key = programKey;
+			ShaderProgramCache::add(programKey, _program);
+		}
 	}
 
-	// Create and link shader program.
-	_shaderProgramId = linkProgram(vertexShaderId, fragmentShaderId);
-	if (_shaderProgramId > 0) {
-		std::cout << "[Shader] Shader is loaded.\n"
-				<< "\tvertex: " << vertexFileName << "\n"
-				<< "\tfragment: " << fragmentFileName
-				<< std::endl;
+	if (buildMode == BuildMode::Sync) {
+		completeBuild();
 	}
-
-	// When the shader program is linked, shaders are no longer needed.
-	glDeleteShader(vertexShaderId);
-	glDeleteShader(fragmentShaderId);
 }
 
 
@@ -65,7 +83,19 @@ Shader& Shader::operator=(Shader&& other) noexcept
 	}
 
 	deleteProgram();
-	std::swap(_shaderProgramId, other._shaderProgramId);
+	std::swap(_buildStatus, other._buildStatus);
+	std::swap(_vertexFileName, other._vertexFileName);
+	std::swap(_fragmentFileName, other._fragmentFileName);
+	std::swap(_vertexSourceFiles, other._vertexSourceFiles);
+	std::swap(_fragmentSourceFiles, other._fragmentSourceFiles);
+	std::swap(_origin, other._origin);
+	std::swap(_program, other._program);
+	if (_program) {
+		// The uniforms owner is identified by the address, so it's outdated now.
+		_program->uniformsOwner = nullptr;
+	}
+	std::swap(_uniformInfos, other._uniformInfos);
+	std::swap(_slotInfos, other._slotInfos);
 	std::swap(_uniforms, other._uniforms);
 	return *this;
 }
@@ -73,47 +103,145 @@ Shader& Shader::operator=(Shader&& other) noexcept
 
 void Shader::deleteProgram()
 {
-	if (isValid()) {
-		glDeleteProgram(_shaderProgramId);
+	// The program is deleted, when the last Shader which shares it releases it.
+	_program.reset();
+	_uniformInfos.clear();
+	_slotInfos.clear();
+	if (_uniforms) {
+		_uniforms->resetAll();
 	}
-	_shaderProgramId = 0;
-	_uniforms->resetAll();
 }
 
 
-std::string Shader::loadShaderText(std::string_view fileName)
+bool Shader::updateBuildStatus()
 {
-	std::string result;
+	if (_buildStatus != BuildStatus::Pending) {
+		return true;
+	}
 
-	auto inputFile = std::ifstream(std::string(fileName));
-	if (!inputFile) {
-		std::cerr << "[Shader] File opening failed: " << fileName << std::endl;
-		return result;
+	if (_program && !isProgramBuildCompleted(*_program)) {
+		return false;
 	}
 
-	std::stringstream ss;
-	ss << inputFile.rdbuf();
-	result = ss.str();
+	completeBuild();
+	return true;
+}
 
-	return result;
+
+void Shader::completeBuild()
+{
+	if (_program && _program->status == ShaderProgram::Status::Linking) {
+		finishProgramBuild(*_program, _vertexSourceFiles, _fragmentSourceFiles);
+	}
+
+	if (!_program || _program->status != ShaderProgram::Status::Linked) {
+		_buildStatus = BuildStatus::Failed;
+		_program.reset();
+		return;
+	}
+
+	_uniformInfos = reflectUniforms(_program->id);
+	bindSharedUniformBlocks(_program->id);
+	_buildStatus = BuildStatus::Ready;
+
+	std::cout << "[Shader] Shader is loaded from " << _origin << ".\n"
+			<< "\tvertex: " << _vertexFileName << "\n"
+			<< "\tfragment: " << _fragmentFileName
+			<< std::endl;
 }
 
 
-GLuint Shader::compileShader(Shader::ShaderType type, const std::string& sourceText)
+ShaderProgramPtr Shader::startProgramBuild(
+		std::span<const std::string_view> vertexSegments,
+		std::span<const std::string_view> fragmentSegments
+)
 {
-	assertTrue(!sourceText.empty());
-	if (sourceText.empty()) {
+	// The status of the commands isn't checked here. The check would wait for the driver to finish them.
+	const GLuint vertexShaderId = compileShader(ShaderType::Vertex, vertexSegments);
+	const GLuint fragmentShaderId = compileShader(ShaderType::Fragment, fragmentSegments);
+	if (vertexShaderId == 0 || fragmentShaderId == 0) {
+		glDeleteShader(vertexShaderId);
+		glDeleteShader(fragmentShaderId);
+		return nullptr;
+	}
+
+	auto program = std::make_shared<ShaderProgram>(linkProgram(vertexShaderId, fragmentShaderId));
+	program->status = ShaderProgram::Status::Linking;
+	program->vertexShaderId = vertexShaderId;
+	program->fragmentShaderId = fragmentShaderId;
+	return program;
+}
+
+
+bool Shader::isProgramBuildCompleted(const ShaderProgram& program)
+{
+	if (program.status != ShaderProgram::Status::Linking) {
+		return true;
+	}
+
+	// Without the extension there is no way to ask without waiting.
+	if (!GlExtensions::isParallelShaderCompileSupported()) {
+		return true;
+	}
+
+	GLint isCompleted = GL_FALSE;
+	glGetProgramiv(program.id, GL_COMPLETION_STATUS_KHR, &isCompleted);
+	return isCompleted == GL_TRUE;
+}
+
+
+void Shader::finishProgramBuild(
+		ShaderProgram& program,
+		const std::vector<std::string>& vertexSourceFiles,
+		const std::vector<std::string>& fragmentSourceFiles
+)
+{
+	const bool isVertexCompiled = checkCompileStatus(ShaderType::Vertex, program.vertexShaderId, vertexSourceFiles);
+	const bool isFragmentCompiled = checkCompileStatus(ShaderType::Fragment, program.fragmentShaderId, fragmentSourceFiles);
+
+	const bool isLinked = isVertexCompiled && isFragmentCompiled && checkLinkStatus(program.id);
+
+	// When the shader program is linked, shaders are no longer needed.
+	glDeleteShader(program.vertexShaderId);
+	glDeleteShader(program.fragmentShaderId);
+	program.vertexShaderId = 0;
+	program.fragmentShaderId = 0;
+
+	program.status = isLinked ? ShaderProgram::Status::Linked : ShaderProgram::Status::Failed;
+	if (isLinked) {
+		ShaderProgramCache::storeBinary(program.key, program.id);
+	}
+}
+
+
+GLuint Shader::compileShader(Shader::ShaderType type, std::span<const std::string_view> sourceSegments)
+{
+	assertTrue(!sourceSegments.empty());
+	if (sourceSegments.empty()) {
 		return 0;
 	}
 
 	const GLenum shaderType = getGlShaderType(type);
 	const GLuint shaderId = glCreateShader(shaderType);
 
-	const char* srcTextPtr = sourceText.data();
-	glShaderSource(shaderId, 1, &srcTextPtr, nullptr);
+	// The segments are parts of the file texts, so they aren't null-terminated, and the lengths are passed explicitly.
+	std::vector<const GLchar*> segmentPtrs;
+	std::vector<GLint> segmentLengths;
+	segmentPtrs.reserve(sourceSegments.size());
+	segmentLengths.reserve(sourceSegments.size());
+	for (const std::string_view segment : sourceSegments) {
+		segmentPtrs.push_back(segment.data());
+		segmentLengths.push_back((GLint) segment.size());
+	}
+	glShaderSource(shaderId, (GLsizei) segmentPtrs.size(), segmentPtrs.data(), segmentLengths.data());
 	glCompileShader(shaderId);
 
-	// Check for errors.
+	return shaderId;
+}
+
+
+bool Shader::checkCompileStatus(ShaderType type, GLuint shaderId, const std::vector<std::string>& sourceFiles)
+{
 	GLint status = 0;
 	glGetShaderiv(shaderId, GL_COMPILE_STATUS, &status);
 	if (status == GL_FALSE) {
@@ -121,13 +249,16 @@ GLuint Shader::compileShader(Shader::ShaderType type, const std::string& sourceT
 		msg.resize(512);
 		glGetShaderInfoLog(shaderId, (GLint) msg.size(), nullptr, msg.data());
 		std::string typeStr = (type == ShaderType::Vertex) ? "Vertex" : "Fragment";
-		std::cerr << "[Shader] " << typeStr << " shader compilation failed:\n\t" << msg << std::endl;
-
-		glDeleteShader(shaderId);
-		return 0;
+		std::cerr << "[Shader] " << typeStr << " shader compilation failed:\n\t" << msg << "\n";
+		// The log refers to the files by the source string numbers set by #line directives.
+		for (size_t i = 0; i < sourceFiles.size(); ++i) {
+			std::cerr << "\tsource " << i << ": " << sourceFiles[i] << "\n";
+		}
+		std::cerr << std::flush;
+		return false;
 	}
 
-	return shaderId;
+	return true;
 }
 
 
@@ -140,9 +271,18 @@ GLuint Shader::linkProgram(GLuint vertexShaderId, GLuint fragmentShaderId)
 	const GLuint programId = glCreateProgram();
 	glAttachShader(programId, vertexShaderId);
 	glAttachShader(programId, fragmentShaderId);
+	if (GlExtensions::isProgramBinarySupported()) {
+		// Allows to store the program binary to the cache.
+		GlExtensions::programParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 	glLinkProgram(programId);
 
-	// Check for errors.
+	return programId;
+}
+
+
+bool Shader::checkLinkStatus(GLuint programId)
+{
 	GLint status = 0;
 	glGetProgramiv(programId, GL_LINK_STATUS, &status);
 	if (status == GL_FALSE) {
@@ -150,19 +290,64 @@ GLuint Shader::linkProgram(GLuint vertexShaderId, GLuint fragmentShaderId)
 		msg.resize(512);
 		glGetProgramInfoLog(programId, (GLint) msg.size(), nullptr, msg.data());
 		std::cerr << "Shader program link failed:\n\t" << msg << std::endl;
+		return false;
+	}
 
-		glDeleteProgram(programId);
-		return 0;
+	return true;
+}
+
+
+Shader::UniformInfoMap Shader::reflectUniforms(GLuint programId)
+{
+	UniformInfoMap result;
+
+	GLint uniformsAmount = 0;
+	glGetProgramiv(programId, GL_ACTIVE_UNIFORMS, &uniformsAmount);
+	GLint maxNameLength = 0;
+	glGetProgramiv(programId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::string name;
+	for (GLint i = 0; i < uniformsAmount; ++i) {
+		name.resize(std::max(maxNameLength, 1));
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum type = GL_NONE;
+		glGetActiveUniform(programId, (GLuint) i, (GLsizei) name.size(), &nameLength, &arraySize, &type, name.data());
+		name.resize(nameLength);
+
+		// Uniforms of uniform blocks don't have locations. They are fed through buffers.
+		const GLint location = glGetUniformLocation(programId, name.data());
+		if (location < 0) {
+			continue;
+		}
+
+		// The name of an array uniform is reported as "name[0]".
+		constexpr std::string_view arraySuffix = "[0]";
+		if (name.ends_with(arraySuffix)) {
+			name.resize(name.size() - arraySuffix.size());
+		}
+
+		result[name] = UniformInfo {location, type, arraySize};
 	}
 
-	return programId;
+	return result;
+}
+
+
+void Shader::bindSharedUniformBlocks(GLuint programId)
+{
+	const std::string blockName(FrameUniformBuffer::BLOCK_NAME);
+	const GLuint blockIndex = glGetUniformBlockIndex(programId, blockName.c_str());
+	if (blockIndex != GL_INVALID_INDEX) {
+		glUniformBlockBinding(programId, blockIndex, FrameUniformBuffer::BINDING_POINT);
+	}
 }
 
 
 void Shader::bind() const
 {
 	assertTrue(isValid());
-	glUseProgram(_shaderProgramId);
+	GlStateCache::useProgram(_program->id);
 
 	updateUniformValues();
 }
@@ -177,25 +362,74 @@ void Shader::updateUniformValues() const
 		return;
 	}
 
-	for (const auto& [name, uniformPtr] : *_uniforms) {
-		if (!uniformPtr) {
-			return;
+	resolveUniformSlots();
+
+	// The program may be shared with other shaders, which upload their own values.
+	if (_program->uniformsOwner != this) {
+		for (const auto& [name, info] : _uniformInfos) {
+			info.uploadedVersion = 0;
 		}
+		_program->uniformsOwner = this;
+	}
 
-		// TODO Check that the type of *uniformPtr matches
-		//  to the type of the real uniform in the shader program.
+	const ShaderUniformStore& uniforms = *_uniforms;
+	for (int slot = 0; slot < (int) _slotInfos.size(); ++slot) {
+		// The uniform may be absent in the program or be optimized out by the linker.
+		const UniformInfo* info = _slotInfos[slot];
+		if (info == nullptr || !uniforms.isSet(slot)) {
+			continue;
+		}
 
-		// glGetUniformLocation must be called when the program is bound.
-		const GLint location = glGetUniformLocation(_shaderProgramId, name.data());
-		if (location >= 0) {
-			uniformPtr->bind(location);
+		// The program keeps uniform values between binds, so only changed values need to be sent.
+		const uint64_t version = uniforms.getVersion(slot);
+		if (info->uploadedVersion == version) {
+			++_uploadStats.skipped;
+			continue;
+		}
 
-			handleGLErrors();
+		const ShaderUniform uniform = uniforms.get(slot);
+		if (!uniform.matchesGlType(info->type) || uniform.getArraySize() > info->arraySize) {
+			if (!info->isMismatchReported) {
+				std::cerr << "[Shader] Uniform type mismatch: " << uniforms.getSlotName(slot)
+						<< " (GL type 0x" << std::hex << info->type << std::dec
+						<< ", array size " << info->arraySize << ")" << std::endl;
+				info->isMismatchReported = true;
+			}
+			continue;
 		}
+
+		uniform.bind(info->location);
+		info->uploadedVersion = version;
+		++_uploadStats.issued;
+
+		handleGLErrors();
+	}
+}
+
+
+void Shader::resolveUniformSlots() const
+{
+	const size_t slotsCount = _uniforms->getSlotsCount();
+	while (_slotInfos.size() < slotsCount) {
+		const std::string& name = _uniforms->getSlotName((int) _slotInfos.size());
+		const auto infoIt = _uniformInfos.find(name);
+		_slotInfos.push_back((infoIt != _uniformInfos.end()) ? &infoIt->second : nullptr);
 	}
 }
 
 
+const Shader::UniformUploadStats& Shader::getUniformUploadStats()
+{
+	return _uploadStats;
+}
+
+
+void Shader::resetUniformUploadStats()
+{
+	_uploadStats = UniformUploadStats();
+}
+
+
 GLenum Shader::getGlShaderType(Shader::ShaderType type)
 {
 	GLenum shaderType = GL_INVALID_ENUM;
@@ -1,8 +1,16 @@
 #pragma once
 
+#include "ShaderPreprocessor.hpp"
+#include "ShaderProgramCache.hpp"
+
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/fwd.hpp>
@@ -18,8 +26,58 @@ class Shader
 		Fragment,
 	};
 
+	/**
+	 * @brief Describes one active uniform of a linked shader program.
+	 */
+	struct UniformInfo
+	{
+		GLint location = -1;
+		// The type of the uniform as reported by glGetActiveUniform (GL_FLOAT_MAT4, GL_SAMPLER_2D, etc).
+		GLenum type = GL_NONE;
+		// The number of array elements. It's 1, if the uniform isn't an array.
+		GLint arraySize = 1;
+		// The store version of the value which has been uploaded to the location last time.
+		// It's 0, if nothing has been uploaded yet.
+		mutable uint64_t uploadedVersion = 0;
+		// Prevents reporting the same type mismatch on every bind.
+		mutable bool isMismatchReported = false;
+	};
+
+	using UniformInfoMap = std::unordered_map<std::string, UniformInfo>;
+
 public:
-	Shader(std::string_view vertexFileName, std::string_view fragmentFileName);
+	/**
+	 * @brief Counters of glUniform* calls made by all shaders since the last reset.
+	 */
+	struct UniformUploadStats
+	{
+		size_t issued = 0;
+		size_t skipped = 0;
+	};
+
+	enum class BuildMode {
+		// The constructor waits for the program to be compiled and linked.
+		Sync,
+		// The constructor only issues the compilation and linking. Call updateBuildStatus() later.
+		Async,
+	};
+
+	enum class BuildStatus {
+		Pending,
+		Ready,
+		Failed,
+	};
+
+public:
+	/**
+	 * @brief Builds the shader from the files. Includes are resolved, no defines are injected.
+	 */
+	Shader(std::string_view vertexFileName, std::string_view fragmentFileName, BuildMode buildMode = BuildMode::Sync);
+
+	/**
+	 * @brief Builds the shader from the sources which have been preprocessed already, e.g. one permutation of a shader.
+	 */
+	Shader(const PreprocessedShader& vertexSource, const PreprocessedShader& fragmentSource, BuildMode buildMode = BuildMode::Sync);
 
 	~Shader() noexcept;
 
@@ -31,8 +89,21 @@ public:
 
 	Shader& operator=(Shader&& other) noexcept;
 
+	/**
+	 * @brief Checks whether the program is built and ready to be bound.
+	 */
 	[[nodiscard]]
-	bool isValid() const { return glIsProgram(_shaderProgramId); };
+	bool isValid() const { return _buildStatus == BuildStatus::Ready; };
+
+	[[nodiscard]]
+	BuildStatus getBuildStatus() const { return _buildStatus; }
+
+	/**
+	 * @brief Completes the asynchronous build, if the driver has finished it.
+	 * With GL_KHR_parallel_shader_compile it never waits. Without it, it waits for the driver to finish.
+	 * @return true, if the build isn't pending anymore.
+	 */
+	bool updateBuildStatus();
 
 	void bind() const;
 
@@ -40,21 +111,94 @@ public:
 
 	const ShaderUniformStore& getUniforms() const { return *_uniforms; }
 
+	[[nodiscard]]
+	static const UniformUploadStats& getUniformUploadStats();
+
+	/**
+	 * @brief Resets the upload counters. It's supposed to be called at the beginning of each frame.
+	 */
+	static void resetUniformUploadStats();
+
 private:
 	void updateUniformValues() const;
 
-	static std::string loadShaderText(std::string_view fileName);
+	/**
+	 * @brief Matches the store slots, which have been added since the last call, with the program uniforms.
+	 */
+	void resolveUniformSlots() const;
+
+	/**
+	 * @brief Makes the shader ready to use, if the program is linked successfully. Waits for the link, if it isn't finished.
+	 */
+	void completeBuild();
+
+	/**
+	 * @brief Issues compilation of the shaders and linking of the program without waiting for the results.
+	 * @return The program in Linking status, or nullptr, if the sources are empty.
+	 */
+	static ShaderProgramPtr startProgramBuild(
+			std::span<const std::string_view> vertexSegments,
+			std::span<const std::string_view> fragmentSegments
+	);
 
-	static GLuint compileShader(ShaderType type, const std::string& sourceText);
+	[[nodiscard]]
+	static bool isProgramBuildCompleted(const ShaderProgram& program);
+
+	/**
+	 * @brief Checks the results of the compilation and linking, and releases the shaders.
+	 */
+	static void finishProgramBuild(
+			ShaderProgram& program,
+			const std::vector<std::string>& vertexSourceFiles,
+			const std::vector<std::string>& fragmentSourceFiles
+	);
+
+	/**
+	 * @param sourceSegments The parts of the source. They are passed to the driver with their lengths, without joining.
+	 */
+	static GLuint compileShader(ShaderType type, std::span<const std::string_view> sourceSegments);
+
+	/**
+	 * @param sourceFiles The files the source has been assembled from. The compiler log refers to them by indices.
+	 */
+	static bool checkCompileStatus(ShaderType type, GLuint shaderId, const std::vector<std::string>& sourceFiles);
 
 	static GLuint linkProgram(GLuint vertexShaderId, GLuint fragmentShaderId);
 
+	static bool checkLinkStatus(GLuint programId);
+
+	/**
+	 * @brief Queries all active uniforms of the linked program.
+	 * @return The table of uniforms keyed by their names. Array uniforms are keyed without the "[0]" suffix.
+	 */
+	static UniformInfoMap reflectUniforms(GLuint programId);
+
+	/**
+	 * @brief Attaches the uniform blocks of the program, which are shared between programs, to their binding points.
+	 */
+	static void bindSharedUniformBlocks(GLuint programId);
+
 	static GLenum getGlShaderType(ShaderType type);
 
 	void deleteProgram();
 
 private:
-	GLuint _shaderProgramId = 0;
+	BuildStatus _buildStatus = BuildStatus::Pending;
+	std::string _vertexFileName;
+	std::string _fragmentFileName;
+	// The root files and their includes. They are kept to explain compilation errors.
+	std::vector<std::string> _vertexSourceFiles;
+	std::vector<std::string> _fragmentSourceFiles;
+	// Where the program has come from. It's for logging.
+	std::string_view _origin;
+
+	ShaderProgramPtr _program;
+
+	UniformInfoMap _uniformInfos;
+	// The program uniforms indexed by the store slots. nullptr marks a slot which isn't used by the program.
+	mutable std::vector<const UniformInfo*> _slotInfos;
 
 	ShaderUniformStorePtr _uniforms;
+
+	static UniformUploadStats _uploadStats;
 };
@@ -0,0 +1,43 @@
+#include "ShaderCompileQueue.hpp"
+
+#include "GlExtensions.hpp"
+
+#include <algorithm>
+
+
+std::shared_ptr<Shader> ShaderCompileQueue::submit(std::string_view vertexFileName, std::string_view fragmentFileName)
+{
+	auto shader = std::make_shared<Shader>(vertexFileName, fragmentFileName, Shader::BuildMode::Async);
+	_pendingShaders.push_back(shader);
+	return shader;
+}
+
+
+std::shared_ptr<Shader> ShaderCompileQueue::submit(const PreprocessedShader& vertexSource, const PreprocessedShader& fragmentSource)
+{
+	auto shader = std::make_shared<Shader>(vertexSource, fragmentSource, Shader::BuildMode::Async);
+	_pendingShaders.push_back(shader);
+	return shader;
+}
+
+
+void ShaderCompileQueue::poll()
+{
+	const bool canPollWithoutWaiting = GlExtensions::isParallelShaderCompileSupported();
+
+	size_t polledAmount = 0;
+	const auto isDone = [&](const std::shared_ptr<Shader>& shader) {
+		// The shader, which nobody else holds, isn't needed anymore.
+		if (shader.use_count() == 1) {
+			return true;
+		}
+		if (!canPollWithoutWaiting && polledAmount >= MAX_WAITING_BUILDS_PER_POLL) {
+			return false;
+		}
+		++polledAmount;
+		return shader->updateBuildStatus();
+	};
+
+	const auto removedIt = std::remove_if(_pendingShaders.begin(), _pendingShaders.end(), isDone);
+	_pendingShaders.erase(removedIt, _pendingShaders.end());
+}
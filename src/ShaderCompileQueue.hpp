@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Shader.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief Builds shaders asynchronously, so that loading doesn't stall the frame loop.
+ *
+ * Submitted shaders issue their compilation and linking back to back and return immediately.
+ * poll() is supposed to be called once per frame. It completes the builds which the driver has finished.
+ * Until a shader is complete, its isValid() returns false, so the caller draws with a fallback shader.
+ */
+class ShaderCompileQueue
+{
+public:
+	[[nodiscard]]
+	std::shared_ptr<Shader> submit(std::string_view vertexFileName, std::string_view fragmentFileName);
+
+	[[nodiscard]]
+	std::shared_ptr<Shader> submit(const PreprocessedShader& vertexSource, const PreprocessedShader& fragmentSource);
+
+	void poll();
+
+	/**
+	 * @brief Drops the pending builds. It must be called while the GL context is alive,
+	 * since the shaders, which nobody else holds, are deleted.
+	 */
+	void clear() { _pendingShaders.clear(); }
+
+	[[nodiscard]]
+	size_t getPendingCount() const { return _pendingShaders.size(); }
+
+	[[nodiscard]]
+	bool isIdle() const { return _pendingShaders.empty(); }
+
+private:
+	// Without GL_KHR_parallel_shader_compile checking a build waits for it,
+	// so the waits are spread across frames.
+	static constexpr size_t MAX_WAITING_BUILDS_PER_POLL = 1;
+
+	std::vector<std::shared_ptr<Shader>> _pendingShaders;
+};
@@ -0,0 +1,171 @@
+#include "ShaderLibrary.hpp"
+
+#include "Hash.hpp"
+#include "ShaderCompileQueue.hpp"
+#include "ShaderUniformStore.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <system_error>
+#include <unordered_set>
+
+
+ShaderLibrary::ShaderLibrary(ShaderCompileQueue& compileQueue)
+		: _compileQueue(compileQueue)
+{
+}
+
+
+std::shared_ptr<Shader> ShaderLibrary::get(
+		std::string_view vertexFileName,
+		std::string_view fragmentFileName,
+		const ShaderDefines& defines,
+		Shader::BuildMode buildMode
+)
+{
+	const uint64_t variantKey = makeVariantKey(vertexFileName, fragmentFileName, defines);
+	const auto variantIt = _variants.find(variantKey);
+	if (variantIt != _variants.end()) {
+		return variantIt->second.shader;
+	}
+
+	const PreprocessedShader& vertexSource = getSource(vertexFileName, defines);
+	const PreprocessedShader& fragmentSource = getSource(fragmentFileName, defines);
+	addDependencies(variantKey, vertexSource);
+	addDependencies(variantKey, fragmentSource);
+
+	Variant& variant = _variants[variantKey];
+	variant.vertexFileName = vertexFileName;
+	variant.fragmentFileName = fragmentFileName;
+	variant.defines = defines;
+	if (buildMode == Shader::BuildMode::Async) {
+		variant.shader = _compileQueue.submit(vertexSource, fragmentSource);
+	} else {
+		variant.shader = std::make_shared<Shader>(vertexSource, fragmentSource, Shader::BuildMode::Sync);
+	}
+
+	return variant.shader;
+}
+
+
+size_t ShaderLibrary::reloadChanged()
+{
+	std::unordered_set<std::string> changedFiles;
+	std::unordered_set<uint64_t> changedVariantKeys;
+	for (auto& [fileName, node] : _files) {
+		const auto writeTime = getWriteTime(fileName);
+		if (writeTime == node.writeTime) {
+			continue;
+		}
+		node.writeTime = writeTime;
+		changedFiles.insert(fileName);
+		changedVariantKeys.insert(node.variantKeys.begin(), node.variantKeys.end());
+	}
+
+	if (changedVariantKeys.empty()) {
+		return 0;
+	}
+
+	// Only the sources which include the changed files are preprocessed again.
+	std::erase_if(_sources, [&](const auto& entry) {
+		const std::vector<std::string>& dependencies = entry.second.dependencies;
+		return dependencies.empty() || std::any_of(dependencies.begin(), dependencies.end(), [&](const std::string& file) {
+			return changedFiles.contains(file);
+		});
+	});
+
+	size_t rebuiltAmount = 0;
+	for (const uint64_t variantKey : changedVariantKeys) {
+		Variant& variant = _variants.at(variantKey);
+		const PreprocessedShader& vertexSource = getSource(variant.vertexFileName, variant.defines);
+		const PreprocessedShader& fragmentSource = getSource(variant.fragmentFileName, variant.defines);
+		// The changed file may have got new includes.
+		addDependencies(variantKey, vertexSource);
+		addDependencies(variantKey, fragmentSource);
+
+		Shader shader(vertexSource, fragmentSource, Shader::BuildMode::Sync);
+		if (!shader.isValid()) {
+			std::cerr << "[ShaderLibrary] Shader reloading failed, the previous version is kept.\n"
+					<< "\tvertex: " << variant.vertexFileName << "\n"
+					<< "\tfragment: " << variant.fragmentFileName
+					<< std::endl;
+			continue;
+		}
+
+		// The values are carried over, so the caller doesn't have to set them again.
+		shader.getUniforms() = variant.shader->getUniforms();
+		*variant.shader = std::move(shader);
+		++rebuiltAmount;
+	}
+
+	std::cout << "[ShaderLibrary] Shader variants rebuilt: " << rebuiltAmount
+			<< " of " << changedVariantKeys.size() << " affected." << std::endl;
+	return rebuiltAmount;
+}
+
+
+const PreprocessedShader& ShaderLibrary::getSource(std::string_view fileName, const ShaderDefines& defines)
+{
+	const uint64_t sourceKey = makeSourceKey(fileName, defines);
+	const auto sourceIt = _sources.find(sourceKey);
+	if (sourceIt != _sources.end()) {
+		return sourceIt->second;
+	}
+
+	return _sources.emplace(sourceKey, ShaderPreprocessor::process(fileName, defines)).first->second;
+}
+
+
+void ShaderLibrary::addDependencies(uint64_t variantKey, const PreprocessedShader& source)
+{
+	// A file, which has failed to open, has no dependencies, but it's tracked to catch its appearance.
+	std::vector<std::string> files = source.dependencies;
+	if (files.empty()) {
+		files.push_back(source.fileName);
+	}
+
+	for (const std::string& file : files) {
+		auto [nodeIt, isInserted] = _files.try_emplace(file);
+		FileNode& node = nodeIt->second;
+		if (isInserted) {
+			node.writeTime = getWriteTime(file);
+		}
+		if (std::find(node.variantKeys.begin(), node.variantKeys.end(), variantKey) == node.variantKeys.end()) {
+			node.variantKeys.push_back(variantKey);
+		}
+	}
+}
+
+
+uint64_t ShaderLibrary::makeSourceKey(std::string_view fileName, const ShaderDefines& defines)
+{
+	uint64_t hash = Hash::fnv1a64(fileName);
+	const uint64_t definesKey = defines.getKey();
+	hash = Hash::fnv1a64(std::string_view(reinterpret_cast<const char*>(&definesKey), sizeof(definesKey)), hash);
+	return hash;
+}
+
+
+uint64_t ShaderLibrary::makeVariantKey(
+		std::string_view vertexFileName,
+		std::string_view fragmentFileName,
+		const ShaderDefines& defines
+)
+{
+	uint64_t hash = Hash::fnv1a64(vertexFileName);
+	// The separator keeps ("ab", "c") and ("a", "bc") apart.
+	hash = Hash::fnv1a64(std::string_view("\0", 1), hash);
+	hash = Hash::fnv1a64(fragmentFileName, hash);
+	const uint64_t definesKey = defines.getKey();
+	hash = Hash::fnv1a64(std::string_view(reinterpret_cast<const char*>(&definesKey), sizeof(definesKey)), hash);
+	return hash;
+}
+
+
+std::filesystem::file_time_type ShaderLibrary::getWriteTime(const std::string& fileName)
+{
+	// A missing file gets the minimal time, so its appearance is a change too.
+	std::error_code error;
+	const auto writeTime = std::filesystem::last_write_time(fileName, error);
+	return error ? std::filesystem::file_time_type::min() : writeTime;
+}
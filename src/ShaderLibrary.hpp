@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Shader.hpp"
+#include "ShaderPreprocessor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+class ShaderCompileQueue;
+
+/**
+ * @brief Keeps permutations (variants) of shaders. A variant is a pair of shader files built with a set of defines.
+ *
+ * Variants are built on the first request only, so permutations which are never used are never compiled.
+ * Preprocessed sources are cached per file and defines, so variants which share a file preprocess it once.
+ * The include graph (file -> variants which depend on it) is kept to rebuild only the variants whose files have changed.
+ */
+class ShaderLibrary
+{
+public:
+	explicit ShaderLibrary(ShaderCompileQueue& compileQueue);
+
+	/**
+	 * @brief Returns the variant of the shader for the defines. The same variant is returned for equal requests.
+	 * @param buildMode Async variants are built by the compile queue, so the caller must check isValid() before use.
+	 */
+	[[nodiscard]]
+	std::shared_ptr<Shader> get(
+			std::string_view vertexFileName,
+			std::string_view fragmentFileName,
+			const ShaderDefines& defines = ShaderDefines(),
+			Shader::BuildMode buildMode = Shader::BuildMode::Async
+	);
+
+	/**
+	 * @brief Rebuilds the variants which depend on files changed on disk since the variants were built.
+	 * The rebuilt shader replaces the old one in place, so the pointers returned by get() stay valid.
+	 * If the new sources fail to build, the old shader is kept.
+	 * @return The number of rebuilt variants.
+	 */
+	size_t reloadChanged();
+
+	[[nodiscard]]
+	size_t getVariantsCount() const { return _variants.size(); }
+
+private:
+	struct Variant
+	{
+		std::string vertexFileName;
+		std::string fragmentFileName;
+		ShaderDefines defines;
+		std::shared_ptr<Shader> shader;
+	};
+
+	struct FileNode
+	{
+		std::filesystem::file_time_type writeTime;
+		// The keys of the variants which include the file directly or indirectly.
+		std::vector<uint64_t> variantKeys;
+	};
+
+	/**
+	 * @brief Returns the preprocessed source from the cache, preprocessing the file on a miss.
+	 */
+	const PreprocessedShader& getSource(std::string_view fileName, const ShaderDefines& defines);
+
+	void addDependencies(uint64_t variantKey, const PreprocessedShader& source);
+
+	[[nodiscard]]
+	static uint64_t makeSourceKey(std::string_view fileName, const ShaderDefines& defines);
+
+	[[nodiscard]]
+	static uint64_t makeVariantKey(std::string_view vertexFileName, std::string_view fragmentFileName, const ShaderDefines& defines);
+
+	[[nodiscard]]
+	static std::filesystem::file_time_type getWriteTime(const std::string& fileName);
+
+private:
+	ShaderCompileQueue& _compileQueue;
+	std::unordered_map<uint64_t, Variant> _variants;
+	std::unordered_map<uint64_t, PreprocessedShader> _sources;
+	std::unordered_map<std::string, FileNode> _files;
+};
@@ -0,0 +1,242 @@
+#include "ShaderPreprocessor.hpp"
+
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+
+namespace {
+	std::string_view trimLeft(std::string_view text)
+	{
+		const size_t start = text.find_first_not_of(" \t");
+		return (start == std::string_view::npos) ? std::string_view() : text.substr(start);
+	}
+
+
+	// Checks whether the line is the given directive: # and spaces before the name are allowed.
+	bool startsWithDirective(std::string_view line, std::string_view directive, std::string_view& rest)
+	{
+		line = trimLeft(line);
+		if (!line.starts_with('#')) {
+			return false;
+		}
+		line = trimLeft(line.substr(1));
+		if (!line.starts_with(directive)) {
+			return false;
+		}
+		rest = line.substr(directive.size());
+		return rest.empty() || rest.front() == ' ' || rest.front() == '\t' || rest.front() == '"';
+	}
+}
+
+
+ShaderDefines::ShaderDefines(std::initializer_list<std::string_view> names)
+{
+	for (const std::string_view name : names) {
+		set(name);
+	}
+}
+
+
+ShaderDefines& ShaderDefines::set(std::string_view name, std::string_view value)
+{
+	const auto it = std::lower_bound(_defines.begin(), _defines.end(), name, [](const auto& define, std::string_view name) {
+		return define.first < name;
+	});
+
+	if (it != _defines.end() && it->first == name) {
+		it->second = value;
+	} else {
+		_defines.emplace(it, std::string(name), std::string(value));
+	}
+	return *this;
+}
+
+
+uint64_t ShaderDefines::getKey() const
+{
+	uint64_t hash = Hash::FNV1A_64_OFFSET_BASIS;
+	for (const auto& [name, value] : _defines) {
+		hash = Hash::fnv1a64(name, hash);
+		hash = Hash::fnv1a64("=", hash);
+		hash = Hash::fnv1a64(value, hash);
+		hash = Hash::fnv1a64(";", hash);
+	}
+	return hash;
+}
+
+
+std::string ShaderDefines::toSource() const
+{
+	std::string result;
+	for (const auto& [name, value] : _defines) {
+		result.append("#define ").append(name).append(" ").append(value).append("\n");
+	}
+	return result;
+}
+
+
+std::string PreprocessedShader::getText() const
+{
+	std::string result;
+	for (const std::string_view segment : segments) {
+		result.append(segment);
+	}
+	return result;
+}
+
+
+PreprocessedShader ShaderPreprocessor::process(std::string_view fileName, const ShaderDefines& defines)
+{
+	PreprocessedShader result;
+	result.fileName = fileName;
+
+	if (!appendFile(std::filesystem::path(fileName), result, &defines)) {
+		result.segments.clear();
+	}
+
+	return result;
+}
+
+
+bool ShaderPreprocessor::appendFile(
+		const std::filesystem::path& filePath,
+		PreprocessedShader& result,
+		const ShaderDefines* defines
+)
+{
+	const std::string normalizedPath = filePath.lexically_normal().generic_string();
+	if (std::find(result.dependencies.begin(), result.dependencies.end(), normalizedPath) != result.dependencies.end()) {
+		// The file has been included already.
+		return true;
+	}
+
+	const MappedFile file(filePath);
+	if (!file.isOpen()) {
+		std::cerr << "[ShaderPreprocessor] File opening failed: " << normalizedPath << std::endl;
+		return false;
+	}
+	// The file is unmapped right after the copying, so it can be edited while the shader is cached.
+	const std::string_view text = result.fileTexts.emplace_back(file.getText());
+
+	const size_t sourceIndex = result.dependencies.size();
+	result.dependencies.push_back(normalizedPath);
+
+	// The root file gets the defines after #version, which must be the first directive.
+	// If there is no #version, the defines go first.
+	bool areDefinesInjected = (defines == nullptr);
+	if (!areDefinesInjected && !hasVersionDirective(text)) {
+		appendGenerated(result, defines->toSource() + makeLineDirective(1, sourceIndex));
+		areDefinesInjected = true;
+	}
+
+	// Lines between directives are passed as one segment pointing into the text of the file.
+	size_t runStart = 0;
+	size_t lineNumber = 0;
+	size_t lineStart = 0;
+	while (lineStart < text.size()) {
+		size_t lineEnd = text.find('\n', lineStart);
+		lineEnd = (lineEnd == std::string_view::npos) ? text.size() : lineEnd + 1;
+		const std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+		lineStart = lineEnd;
+		++lineNumber;
+
+		const std::string_view includeName = parseIncludeDirective(line);
+		if (!includeName.empty()) {
+			appendFileSegment(result, text.substr(runStart, lineEnd - line.size() - runStart));
+			runStart = lineEnd;
+
+			const std::filesystem::path includePath = filePath.parent_path() / includeName;
+			appendGenerated(result, makeLineDirective(1, result.dependencies.size()));
+			if (!appendFile(includePath, result, nullptr)) {
+				std::cerr << "[ShaderPreprocessor] Include failed: " << includeName << "\n"
+						<< "\tincluded from: " << normalizedPath << ":" << lineNumber << std::endl;
+				return false;
+			}
+			// Continue the numbering of the current file.
+			appendGenerated(result, makeLineDirective(lineNumber + 1, sourceIndex));
+			continue;
+		}
+
+		if (!areDefinesInjected && isVersionDirective(line)) {
+			appendFileSegment(result, text.substr(runStart, lineEnd - runStart));
+			runStart = lineEnd;
+			if (!line.ends_with('\n')) {
+				appendGenerated(result, "\n");
+			}
+			appendGenerated(result, defines->toSource() + makeLineDirective(lineNumber + 1, sourceIndex));
+			areDefinesInjected = true;
+		}
+	}
+
+	if (runStart < text.size()) {
+		appendFileSegment(result, text.substr(runStart));
+		// The following directive must start on a new line.
+		if (!text.ends_with('\n')) {
+			appendGenerated(result, "\n");
+		}
+	}
+
+	return true;
+}
+
+
+void ShaderPreprocessor::appendFileSegment(PreprocessedShader& result, std::string_view segment)
+{
+	if (!segment.empty()) {
+		result.segments.push_back(segment);
+	}
+}
+
+
+void ShaderPreprocessor::appendGenerated(PreprocessedShader& result, std::string text)
+{
+	result.segments.push_back(result.generatedText.emplace_back(std::move(text)));
+}
+
+
+std::string ShaderPreprocessor::makeLineDirective(size_t lineNumber, size_t sourceIndex)
+{
+	return "#line " + std::to_string(lineNumber) + " " + std::to_string(sourceIndex) + "\n";
+}
+
+
+std::string_view ShaderPreprocessor::parseIncludeDirective(std::string_view line)
+{
+	std::string_view rest;
+	if (!startsWithDirective(line, "include", rest)) {
+		return {};
+	}
+
+	const size_t openQuote = rest.find('"');
+	const size_t closeQuote = (openQuote != std::string_view::npos) ? rest.find('"', openQuote + 1) : std::string_view::npos;
+	if (closeQuote == std::string_view::npos) {
+		return {};
+	}
+
+	return rest.substr(openQuote + 1, closeQuote - openQuote - 1);
+}
+
+
+bool ShaderPreprocessor::isVersionDirective(std::string_view line)
+{
+	std::string_view rest;
+	return startsWithDirective(line, "version", rest);
+}
+
+
+bool ShaderPreprocessor::hasVersionDirective(std::string_view text)
+{
+	size_t lineStart = 0;
+	while (lineStart < text.size()) {
+		size_t lineEnd = text.find('\n', lineStart);
+		lineEnd = (lineEnd == std::string_view::npos) ? text.size() : lineEnd + 1;
+		if (isVersionDirective(text.substr(lineStart, lineEnd - lineStart))) {
+			return true;
+		}
+		lineStart = lineEnd;
+	}
+	return false;
+}
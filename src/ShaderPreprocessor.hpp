@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief A set of preprocessor definitions which selects one variant (permutation) of a shader.
+ * Definitions are kept sorted by names, so equal sets have equal keys regardless of the order of set() calls.
+ */
+class ShaderDefines
+{
+public:
+	ShaderDefines() = default;
+
+	/**
+	 * @brief Defines every name as 1.
+	 */
+	ShaderDefines(std::initializer_list<std::string_view> names);
+
+	ShaderDefines& set(std::string_view name, std::string_view value = "1");
+
+	[[nodiscard]]
+	bool isEmpty() const { return _defines.empty(); }
+
+	/**
+	 * @brief Returns the hash of the whole set.
+	 */
+	[[nodiscard]]
+	uint64_t getKey() const;
+
+	/**
+	 * @brief Returns "#define NAME VALUE" lines.
+	 */
+	[[nodiscard]]
+	std::string toSource() const;
+
+private:
+	std::vector<std::pair<std::string, std::string>> _defines;
+};
+
+
+/**
+ * @brief The result of the preprocessing of one shader file.
+ *
+ * The source isn't assembled into one string. It's a list of segments, which point into the texts of the files
+ * and into the generated directives, and it's passed to glShaderSource as is.
+ * The object owns the memory of the segments, so it's movable, but not copyable.
+ * The texts are copied out of the file mappings: the shaders are cached for the hot reload, and the mappings
+ * would keep the files locked on Windows and turn an in-place rewrite by an editor into SIGBUS on POSIX.
+ */
+struct PreprocessedShader
+{
+	PreprocessedShader() = default;
+
+	PreprocessedShader(const PreprocessedShader&) = delete;
+
+	PreprocessedShader& operator=(const PreprocessedShader&) = delete;
+
+	PreprocessedShader(PreprocessedShader&&) noexcept = default;
+
+	PreprocessedShader& operator=(PreprocessedShader&&) noexcept = default;
+
+	[[nodiscard]]
+	bool isValid() const { return !segments.empty(); }
+
+	/**
+	 * @brief Joins the segments. It's for debugging: the compilation doesn't need it.
+	 */
+	[[nodiscard]]
+	std::string getText() const;
+
+	// The name of the root file. It's used for logging.
+	std::string fileName;
+	// The source with resolved includes and injected defines in order. It's empty, if the preprocessing failed.
+	std::vector<std::string_view> segments;
+	// The root file and all included files. The root file is the first one.
+	// The index of a file is used as the source string number in #line directives, so compiler logs refer to it.
+	std::vector<std::string> dependencies;
+
+	// The memory referenced by segments. Moving a deque keeps addresses of its elements.
+	std::deque<std::string> fileTexts;
+	std::deque<std::string> generatedText;
+};
+
+
+/**
+ * @brief Prepares a GLSL file for compilation:
+ * - resolves #include "file" directives relative to the including file; every file is included once;
+ * - injects the defines right after the #version directive.
+ */
+class ShaderPreprocessor
+{
+public:
+	[[nodiscard]]
+	static PreprocessedShader process(std::string_view fileName, const ShaderDefines& defines);
+
+private:
+	static bool appendFile(const std::filesystem::path& filePath, PreprocessedShader& result, const ShaderDefines* defines);
+
+	static void appendFileSegment(PreprocessedShader& result, std::string_view segment);
+
+	static void appendGenerated(PreprocessedShader& result, std::string text);
+
+	[[nodiscard]]
+	static std::string makeLineDirective(size_t lineNumber, size_t sourceIndex);
+
+	/**
+	 * @brief Extracts the file name from the line like: #include "file"
+	 * @return Empty string, if the line isn't an include directive.
+	 */
+	[[nodiscard]]
+	static std::string_view parseIncludeDirective(std::string_view line);
+
+	[[nodiscard]]
+	static bool isVersionDirective(std::string_view line);
+
+	/**
+	 * @brief Checks the lines of the text with isVersionDirective(), so "#version" in a comment doesn't count.
+	 */
+	[[nodiscard]]
+	static bool hasVersionDirective(std::string_view text);
+};
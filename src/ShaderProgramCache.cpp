@@ -0,0 +1,223 @@
+#include "ShaderProgramCache.hpp"
+
+#include "GlExtensions.hpp"
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+#include "Utilities.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+
+namespace {
+	// "LOGP" - LearnOpenGL program.
+	constexpr uint32_t BINARY_FILE_MAGIC = 0x50474F4C;
+	constexpr uint32_t BINARY_FILE_VERSION = 1;
+
+	struct BinaryFileHeader
+	{
+		uint32_t magic = BINARY_FILE_MAGIC;
+		uint32_t version = BINARY_FILE_VERSION;
+		uint64_t key = 0;
+		uint32_t binaryFormat = 0;
+		uint32_t binaryLength = 0;
+	};
+
+
+	std::string_view getGlString(GLenum name)
+	{
+		const auto* str = reinterpret_cast<const char*>(glGetString(name));
+		return (str != nullptr) ? std::string_view(str) : std::string_view();
+	}
+}
+
+
+ShaderProgram::~ShaderProgram() noexcept
+{
+	if (vertexShaderId > 0) {
+		glDeleteShader(vertexShaderId);
+	}
+	if (fragmentShaderId > 0) {
+		glDeleteShader(fragmentShaderId);
+	}
+	if (id > 0) {
+		glDeleteProgram(id);
+		id = 0;
+	}
+}
+
+
+void ShaderProgramCache::setDirectory(std::string_view directory)
+{
+	_directory = directory;
+}
+
+
+uint64_t ShaderProgramCache::makeKey(std::string_view vertexSource, std::string_view fragmentSource)
+{
+	return makeKey(std::span(&vertexSource, 1), std::span(&fragmentSource, 1));
+}
+
+
+uint64_t ShaderProgramCache::makeKey(
+		std::span<const std::string_view> vertexSegments,
+		std::span<const std::string_view> fragmentSegments
+)
+{
+	// FNV-1a is hashed byte by byte, so hashing the segments in turn equals hashing the joined text.
+	// The separator prevents equal keys for different splits of the same text between the shaders.
+	uint64_t hash = getDriverHash();
+	for (const std::string_view segment : vertexSegments) {
+		hash = Hash::fnv1a64(segment, hash);
+	}
+	hash = Hash::fnv1a64(std::string_view("\0", 1), hash);
+	for (const std::string_view segment : fragmentSegments) {
+		hash = Hash::fnv1a64(segment, hash);
+	}
+	return hash;
+}
+
+
+ShaderProgramPtr ShaderProgramCache::find(uint64_t key)
+{
+	const auto it = _programs.find(key);
+	if (it == _programs.end()) {
+		return nullptr;
+	}
+
+	ShaderProgramPtr program = it->second.lock();
+	if (!program) {
+		_programs.erase(it);
+	}
+	return program;
+}
+
+
+void ShaderProgramCache::add(uint64_t key, const ShaderProgramPtr& program)
+{
+	_programs[key] = program;
+}
+
+
+GLuint ShaderProgramCache::loadBinary(uint64_t key)
+{
+	if (_directory.empty() || !GlExtensions::isProgramBinarySupported()) {
+		return 0;
+	}
+
+	const std::string fileName = getBinaryFileName(key);
+	GLuint programId = 0;
+	// The file is unmapped before it may be removed: Windows doesn't remove mapped files.
+	{
+		// The binary is passed to the driver right from the mapped file.
+		const MappedFile file(fileName);
+		if (!file.isOpen()) {
+			return 0;
+		}
+
+		const std::span<const std::byte> bytes = file.getBytes();
+		BinaryFileHeader header;
+		const bool hasHeader = bytes.size() >= sizeof(header);
+		if (hasHeader) {
+			std::memcpy(&header, bytes.data(), sizeof(header));
+		}
+		const bool isHeaderValid = hasHeader
+				&& (header.magic == BINARY_FILE_MAGIC)
+				&& (header.version == BINARY_FILE_VERSION)
+				&& (header.key == key)
+				&& (header.binaryLength == bytes.size() - sizeof(header));
+
+		if (isHeaderValid) {
+			programId = glCreateProgram();
+			const std::span<const std::byte> binary = bytes.subspan(sizeof(header));
+			GlExtensions::programBinary(programId, header.binaryFormat, binary.data(), (GLsizei) binary.size());
+
+			// The driver rejects binaries of other driver builds or hardware. That isn't an error.
+			GLint status = GL_FALSE;
+			glGetProgramiv(programId, GL_LINK_STATUS, &status);
+			if (status == GL_FALSE) {
+				glDeleteProgram(programId);
+				programId = 0;
+			}
+		}
+	}
+
+	if (programId == 0) {
+		std::cout << "[ShaderProgramCache] Outdated program binary is dropped: " << fileName << std::endl;
+		std::error_code errorCode;
+		std::filesystem::remove(fileName, errorCode);
+		return 0;
+	}
+
+	// Clear errors which glProgramBinary may have produced on rejection.
+	handleGLErrors();
+	return programId;
+}
+
+
+void ShaderProgramCache::storeBinary(uint64_t key, GLuint programId)
+{
+	if (_directory.empty() || !GlExtensions::isProgramBinarySupported()) {
+		return;
+	}
+
+	GLint binaryLength = 0;
+	glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if (binaryLength <= 0) {
+		return;
+	}
+
+	std::vector<char> binary(binaryLength);
+	GLenum binaryFormat = 0;
+	GLsizei writtenLength = 0;
+	GlExtensions::getProgramBinary(programId, binaryLength, &writtenLength, &binaryFormat, binary.data());
+	if (writtenLength <= 0) {
+		return;
+	}
+
+	std::error_code errorCode;
+	std::filesystem::create_directories(_directory, errorCode);
+
+	// Write to a temporary file first, so another process never reads a partially written binary.
+	const std::string fileName = getBinaryFileName(key);
+	const std::string tempFileName = fileName + ".tmp";
+	{
+		auto outputFile = std::ofstream(tempFileName, std::ios::binary | std::ios::trunc);
+		if (!outputFile) {
+			std::cerr << "[ShaderProgramCache] File opening failed: " << tempFileName << std::endl;
+			return;
+		}
+
+		BinaryFileHeader header;
+		header.key = key;
+		header.binaryFormat = binaryFormat;
+		header.binaryLength = (uint32_t) writtenLength;
+		outputFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		outputFile.write(binary.data(), writtenLength);
+	}
+	std::filesystem::rename(tempFileName, fileName, errorCode);
+	if (errorCode) {
+		std::cerr << "[ShaderProgramCache] Program binary storing failed: " << fileName << std::endl;
+	}
+}
+
+
+std::string ShaderProgramCache::getBinaryFileName(uint64_t key)
+{
+	char keyStr[17] = {};
+	std::snprintf(keyStr, sizeof(keyStr), "%016llx", static_cast<unsigned long long>(key));
+	return _directory + "/" + keyStr + ".bin";
+}
+
+
+uint64_t ShaderProgramCache::getDriverHash()
+{
+	uint64_t hash = Hash::fnv1a64(getGlString(GL_VENDOR));
+	hash = Hash::fnv1a64(getGlString(GL_RENDERER), hash);
+	hash = Hash::fnv1a64(getGlString(GL_VERSION), hash);
+	return hash;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+
+/**
+ * @brief A linked GL program. It's shared by all Shader objects built from the same sources,
+ * and it's deleted together with the last of them.
+ */
+struct ShaderProgram
+{
+	enum class Status {
+		// Compilation and linking are issued, but the result isn't checked yet.
+		Linking,
+		Linked,
+		Failed,
+	};
+
+	explicit ShaderProgram(GLuint programId)
+			: id(programId)
+	{
+	}
+
+	~ShaderProgram() noexcept;
+
+	ShaderProgram(const ShaderProgram&) = delete;
+
+	ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+	GLuint id = 0;
+	Status status = Status::Linked;
+	// The cache key of the program.
+	uint64_t key = 0;
+	// The attached shaders are kept until the link result is checked, since their logs explain failures.
+	GLuint vertexShaderId = 0;
+	GLuint fragmentShaderId = 0;
+	// Uniform values are the state of the program. It's the object which has uploaded them last time.
+	const void* uniformsOwner = nullptr;
+};
+
+using ShaderProgramPtr = std::shared_ptr<ShaderProgram>;
+
+
+/**
+ * @brief Deduplicates programs within the process and keeps program binaries on disk between launches.
+ *
+ * A program is identified by a key, which is the hash of its sources (with all injected defines)
+ * and of the driver vendor, renderer and version strings. So any change of the sources or of the driver
+ * leads to another key, and an outdated binary is never loaded.
+ */
+class ShaderProgramCache
+{
+public:
+	/**
+	 * @brief Sets the directory for program binaries. The binaries aren't stored, if it's empty.
+	 */
+	static void setDirectory(std::string_view directory);
+
+	[[nodiscard]]
+	static uint64_t makeKey(std::string_view vertexSource, std::string_view fragmentSource);
+
+	/**
+	 * @brief The same as makeKey() for the sources which are split into segments. The key doesn't depend on the split.
+	 */
+	[[nodiscard]]
+	static uint64_t makeKey(std::span<const std::string_view> vertexSegments, std::span<const std::string_view> fragmentSegments);
+
+	/**
+	 * @brief Finds the program with the given key, which is alive in the process.
+	 * @return nullptr, if there is no such program.
+	 */
+	[[nodiscard]]
+	static ShaderProgramPtr find(uint64_t key);
+
+	/**
+	 * @brief Registers the program for deduplication.
+	 */
+	static void add(uint64_t key, const ShaderProgramPtr& program);
+
+	/**
+	 * @brief Creates the program from the binary stored on disk.
+	 * @return 0, if there is no binary, or the driver rejects it. The rejected binary is removed.
+	 */
+	[[nodiscard]]
+	static GLuint loadBinary(uint64_t key);
+
+	/**
+	 * @brief Stores the binary of the linked program to disk.
+	 * The program must be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT.
+	 */
+	static void storeBinary(uint64_t key, GLuint programId);
+
+private:
+	[[nodiscard]]
+	static std::string getBinaryFileName(uint64_t key);
+
+	[[nodiscard]]
+	static uint64_t getDriverHash();
+
+private:
+	static inline std::string _directory;
+	static inline std::unordered_map<uint64_t, std::weak_ptr<ShaderProgram>> _programs;
+};
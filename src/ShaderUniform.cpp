@@ -1,6 +1,8 @@
 #include "ShaderUniform.hpp"
 #include "Utilities.hpp"
 
+#include <cstring>
+
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
@@ -10,216 +12,194 @@
 #include <glad/glad.h>
 
 
-class UniformSampler : public ShaderUniform
+ShaderUniform::ShaderUniform(UniformName name, Type type, int arraySize, const void* data)
+		: _name(name)
+		, _type(type)
+		, _arraySize(arraySize)
 {
-public:
-	UniformSampler(const std::string_view name, int value)
-			: ShaderUniform(name, 1)
-			, _value(value)
-	{
-	}
-
-	void bind(int uniformLocation) const override
-	{
-		glUniform1i(uniformLocation, _value);
+	// An empty array (e.g. from an empty span) is a valid no-op uniform: it has no data and is never uploaded.
+	assertTrue(arraySize >= 0);
+	assertTrue(data != nullptr || arraySize == 0);
+
+	const size_t dataSize = getDataSize();
+	if (dataSize > MAX_INLINE_DATA_SIZE || arraySize > 1) {
+		_externalData = static_cast<const std::byte*>(data);
+	} else if (dataSize > 0) {
+		// The data of an empty array may be nullptr, which memcpy doesn't accept even for 0 bytes.
+		// getData() of an empty uniform points to the inline data, so the readers don't get nullptr either.
+		std::memcpy(_inlineData, data, dataSize);
 	}
-
-private:
-	int _value = 0;
-};
+}
 
 
-class UniformInt : public ShaderUniform
+void ShaderUniform::bind(int uniformLocation) const
 {
-public:
-	UniformInt(const std::string_view name, int value)
-			: ShaderUniform(name, 1)
-			, _value(value)
-	{
+	if (_arraySize == 0) {
+		return;
 	}
 
-	void bind(int uniformLocation) const override
-	{
-		glUniform1i(uniformLocation, _value);
+	const auto* ints = reinterpret_cast<const GLint*>(getData());
+	const auto* floats = reinterpret_cast<const GLfloat*>(getData());
+
+	switch (_type) {
+		case Type::Sampler:
+		case Type::Int:
+			glUniform1iv(uniformLocation, _arraySize, ints);
+			break;
+		case Type::Float:
+			glUniform1fv(uniformLocation, _arraySize, floats);
+			break;
+		case Type::Vec2:
+			glUniform2fv(uniformLocation, _arraySize, floats);
+			break;
+		case Type::Vec3:
+			glUniform3fv(uniformLocation, _arraySize, floats);
+			break;
+		case Type::Vec4:
+			glUniform4fv(uniformLocation, _arraySize, floats);
+			break;
+		case Type::Mat4: {
+			const GLboolean transpose = GL_FALSE;
+			glUniformMatrix4fv(uniformLocation, _arraySize, transpose, floats);
+			break;
+		}
+		default:
+			assertNeverReachHere("Unknown ShaderUniform::Type: " + std::to_string(static_cast<int>(_type)));
+			break;
 	}
+}
 
-private:
-	int _value = 0;
-};
-
-
-class UniformFloat : public ShaderUniform
-{
-public:
-	UniformFloat(const std::string_view name, float value)
-			: ShaderUniform(name, 1)
-			, _value(value)
-	{
-	}
 
-	void bind(int uniformLocation) const override
-	{
-		glUniform1f(uniformLocation, _value);
+bool ShaderUniform::matchesGlType(unsigned int glType) const
+{
+	switch (_type) {
+		case Type::Sampler:
+			switch (glType) {
+				case GL_SAMPLER_1D:
+				case GL_SAMPLER_2D:
+				case GL_SAMPLER_3D:
+				case GL_SAMPLER_CUBE:
+				case GL_SAMPLER_2D_SHADOW:
+				case GL_SAMPLER_2D_ARRAY:
+				case GL_SAMPLER_BUFFER:
+				case GL_INT_SAMPLER_2D:
+				case GL_UNSIGNED_INT_SAMPLER_2D:
+					return true;
+				default:
+					return false;
+			}
+		case Type::Int:
+			return (glType == GL_INT) || (glType == GL_BOOL);
+		case Type::Float:
+			return glType == GL_FLOAT;
+		case Type::Vec2:
+			return glType == GL_FLOAT_VEC2;
+		case Type::Vec3:
+			return glType == GL_FLOAT_VEC3;
+		case Type::Vec4:
+			return glType == GL_FLOAT_VEC4;
+		case Type::Mat4:
+			return glType == GL_FLOAT_MAT4;
+		default:
+			return false;
 	}
-
-private:
-	float _value = 0.f;
-};
+}
 
 
-class UniformVec2 : public ShaderUniform
+ShaderUniform ShaderUniform::Sampler(UniformName name, int value)
 {
-public:
-	UniformVec2(const std::string_view name, float v1, float v2)
-			: ShaderUniform(name, 1)
-			, _v1(v1)
-			, _v2(v2)
-	{
-	}
-
-	void bind(int uniformLocation) const override
-	{
-		glUniform2f(uniformLocation, _v1, _v2);
-	}
-
-private:
-	float _v1 = 0.f;
-	float _v2 = 0.f;
-};
+	return {name, Type::Sampler, 1, &value};
+}
 
 
-class UniformVec3 : public ShaderUniform
+ShaderUniform ShaderUniform::Float(UniformName name, float value)
 {
-public:
-	UniformVec3(const std::string_view name, float v1, float v2, float v3)
-			: ShaderUniform(name, 1)
-			, _v1(v1)
-			, _v2(v2)
-			, _v3(v3)
-	{
-	}
-
-	void bind(int uniformLocation) const override
-	{
-		glUniform3f(uniformLocation, _v1, _v2, _v3);
-	}
-
-private:
-	float _v1 = 0.f;
-	float _v2 = 0.f;
-	float _v3 = 0.f;
-};
+	return {name, Type::Float, 1, &value};
+}
 
 
-class UniformVec4 : public ShaderUniform
+ShaderUniform ShaderUniform::Int(UniformName name, int value)
 {
-public:
-	UniformVec4(const std::string_view name, float v1, float v2, float v3, float v4)
-			: ShaderUniform(name, 1)
-			, _v1(v1)
-			, _v2(v2)
-			, _v3(v3)
-			, _v4(v4)
-	{
-	}
-
-	void bind(int uniformLocation) const override
-	{
-		glUniform4f(uniformLocation, _v1, _v2, _v3, _v4);
-	}
-
-private:
-	float _v1 = 0.f;
-	float _v2 = 0.f;
-	float _v3 = 0.f;
-	float _v4 = 0.f;
-};
+	return {name, Type::Int, 1, &value};
+}
 
 
-class UniformMat4 : public ShaderUniform
+ShaderUniform ShaderUniform::Vec2(UniformName name, float v1, float v2)
 {
-public:
-	UniformMat4(const std::string_view name, const glm::mat4& mat)
-			: ShaderUniform(name, 1)
-			, _mat(mat)
-	{
-	}
+	const glm::vec2 vec = {v1, v2};
+	return {name, Type::Vec2, 1, glm::value_ptr(vec)};
+}
 
-	void bind(int uniformLocation) const override
-	{
-		const GLboolean transpose = GL_FALSE;
-		glUniformMatrix4fv(uniformLocation, getArraySize(), transpose, glm::value_ptr(_mat));
-	}
 
-private:
-	glm::mat4 _mat;
-};
+ShaderUniform ShaderUniform::Vec2(UniformName name, const glm::vec2& vec)
+{
+	return {name, Type::Vec2, 1, glm::value_ptr(vec)};
+}
 
 
-ShaderUniform::ShaderUniform(const std::string_view name, int arraySize)
-		: _name(name)
-		, _arraySize(arraySize)
+ShaderUniform ShaderUniform::Vec3(UniformName name, float v1, float v2, float v3)
 {
-	assertFalse(_name.empty());
-	_arraySize = std::max(_arraySize, 1);
+	const glm::vec3 vec = {v1, v2, v3};
+	return {name, Type::Vec3, 1, glm::value_ptr(vec)};
 }
 
 
-ShaderUniformPtr ShaderUniform::Sampler(const std::string_view name, int value)
+ShaderUniform ShaderUniform::Vec3(UniformName name, const glm::vec3& vec)
 {
-	return std::make_unique<UniformSampler>(name, value);
+	return {name, Type::Vec3, 1, glm::value_ptr(vec)};
 }
 
 
-ShaderUniformPtr ShaderUniform::Float(const std::string_view name, float value)
+ShaderUniform ShaderUniform::Vec4(UniformName name, float v1, float v2, float v3, float v4)
 {
-	return std::make_unique<UniformFloat>(name, value);
+	const glm::vec4 vec = {v1, v2, v3, v4};
+	return {name, Type::Vec4, 1, glm::value_ptr(vec)};
 }
 
 
-ShaderUniformPtr ShaderUniform::Int(const std::string_view name, int value)
+ShaderUniform ShaderUniform::Vec4(UniformName name, const glm::vec4& vec)
 {
-	return std::make_unique<UniformInt>(name, value);
+	return {name, Type::Vec4, 1, glm::value_ptr(vec)};
 }
 
 
-ShaderUniformPtr ShaderUniform::Vec2(const std::string_view name, float v1, float v2)
+ShaderUniform ShaderUniform::Mat4(UniformName name, const glm::mat4& mat)
 {
-	return std::make_unique<UniformVec2>(name, v1, v2);
+	return {name, Type::Mat4, 1, glm::value_ptr(mat)};
 }
 
 
-ShaderUniformPtr ShaderUniform::Vec2(const std::string_view name, const glm::vec2& vec)
+ShaderUniform ShaderUniform::IntArray(UniformName name, std::span<const int> values)
 {
-	return std::make_unique<UniformVec2>(name, vec.x, vec.y);
+	return {name, Type::Int, (int) values.size(), values.data()};
 }
 
 
-ShaderUniformPtr ShaderUniform::Vec3(const std::string_view name, float v1, float v2, float v3)
+ShaderUniform ShaderUniform::FloatArray(UniformName name, std::span<const float> values)
 {
-	return std::make_unique<UniformVec3>(name, v1, v2, v3);
+	return {name, Type::Float, (int) values.size(), values.data()};
 }
 
 
-ShaderUniformPtr ShaderUniform::Vec3(const std::string_view name, const glm::vec3& vec)
+ShaderUniform ShaderUniform::Vec2Array(UniformName name, std::span<const glm::vec2> values)
 {
-	return std::make_unique<UniformVec3>(name, vec.x, vec.y, vec.z);
+	return {name, Type::Vec2, (int) values.size(), values.data()};
 }
 
 
-ShaderUniformPtr ShaderUniform::Vec4(const std::string_view name, float v1, float v2, float v3, float v4)
+ShaderUniform ShaderUniform::Vec3Array(UniformName name, std::span<const glm::vec3> values)
 {
-	return std::make_unique<UniformVec4>(name, v1, v2, v3, v4);
+	return {name, Type::Vec3, (int) values.size(), values.data()};
 }
 
 
-ShaderUniformPtr ShaderUniform::Vec4(const std::string_view name, const glm::vec4& vec)
+ShaderUniform ShaderUniform::Vec4Array(UniformName name, std::span<const glm::vec4> values)
 {
-	return std::make_unique<UniformVec4>(name, vec.x, vec.y, vec.z, vec.w);
+	return {name, Type::Vec4, (int) values.size(), values.data()};
 }
 
 
-ShaderUniformPtr ShaderUniform::Mat4(const std::string_view name, const glm::mat4& mat)
+ShaderUniform ShaderUniform::Mat4Array(UniformName name, std::span<const glm::mat4> values)
 {
-	return std::make_unique<UniformMat4>(name, mat);
+	return {name, Type::Mat4, (int) values.size(), values.data()};
 }
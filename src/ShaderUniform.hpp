@@ -1,66 +1,195 @@
 #pragma once
 
+#include "Hash.hpp"
+
 #include <glm/fwd.hpp>
 
-#include <memory>
-#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string_view>
 
 
-class ShaderUniform;
-using ShaderUniformPtr = std::unique_ptr<ShaderUniform>;
+/**
+ * @brief The name of a uniform variable with its precomputed hash.
+ * Declare it as constexpr to calculate the hash at compile time.
+ * It doesn't own the name string, so the string must outlive the object.
+ */
+class UniformName
+{
+public:
+	constexpr UniformName(const char* name)
+			: UniformName(std::string_view(name))
+	{
+	}
+
+	constexpr UniformName(std::string_view name)
+			: _name(name)
+			, _hash(Hash::fnv1a32(name))
+	{
+	}
+
+	/**
+	 * @param hash The hash of the name which has been calculated earlier.
+	 */
+	constexpr UniformName(std::string_view name, uint32_t hash)
+			: _name(name)
+			, _hash(hash)
+	{
+	}
+
+	[[nodiscard]]
+	constexpr std::string_view getView() const { return _name; }
+
+	[[nodiscard]]
+	constexpr uint32_t getHash() const { return _hash; }
+
+private:
+	std::string_view _name;
+	uint32_t _hash = 0;
+};
+
 
 /**
- * @brief Represents one named uniform variable in a shader program.
+ * @brief Represents a value of one named uniform variable in a shader program.
+ * It's a small value type which never allocates memory.
+ * A single value is copied inside the object. An array is referenced, so the array data must outlive the object.
  */
 class ShaderUniform
 {
 public:
-	ShaderUniform(std::string_view name, int arraySize);
+	enum class Type : uint8_t
+	{
+		Sampler,
+		Int,
+		Float,
+		Vec2,
+		Vec3,
+		Vec4,
+		Mat4,
+	};
+
+	// The size of the largest single value (mat4).
+	static constexpr size_t MAX_INLINE_DATA_SIZE = 16 * sizeof(float);
+
+	/**
+	 * @param name The name of the uniform variable in a shader.
+	 * @param type The type of one element.
+	 * @param arraySize The number of elements pointed by data. It must be 1, if the uniform isn't an array.
+	 * 0 makes an empty no-op uniform, which is never uploaded.
+	 * @param data Tightly packed elements of the given type.
+	 */
+	ShaderUniform(UniformName name, Type type, int arraySize, const void* data);
 
-	virtual ~ShaderUniform() noexcept = default;
+	[[nodiscard]]
+	const UniformName& getName() const { return _name; }
 
 	[[nodiscard]]
-	const std::string& getName() const { return _name; }
+	Type getType() const { return _type; }
 
 	[[nodiscard]]
 	int getArraySize() const { return _arraySize; }
 
-	virtual void bind(int uniformLocation) const = 0;
+	[[nodiscard]]
+	const std::byte* getData() const { return (_externalData != nullptr) ? _externalData : _inlineData; }
 
 	[[nodiscard]]
-	static ShaderUniformPtr Sampler(std::string_view name, int sampler);
+	size_t getDataSize() const { return getElementSize(_type) * _arraySize; }
+
+	/**
+	 * @brief Uploads the value to the uniform location of the currently bound program. Empty arrays upload nothing.
+	 */
+	void bind(int uniformLocation) const;
+
+	/**
+	 * @brief Checks whether the value can be uploaded to a program uniform of the given type.
+	 * @param glType The type reported by glGetActiveUniform (GL_FLOAT_VEC3, GL_SAMPLER_2D, etc).
+	 */
+	[[nodiscard]]
+	bool matchesGlType(unsigned int glType) const;
 
 	[[nodiscard]]
-	static ShaderUniformPtr Int(std::string_view name, int value);
+	static constexpr size_t getElementSize(Type type);
 
 	[[nodiscard]]
-	static ShaderUniformPtr Float(std::string_view name, float value);
+	static ShaderUniform Sampler(UniformName name, int sampler);
 
 	[[nodiscard]]
-	static ShaderUniformPtr Vec2(std::string_view name, float v1, float v2);
+	static ShaderUniform Int(UniformName name, int value);
 
 	[[nodiscard]]
-	static ShaderUniformPtr Vec2(std::string_view name, const glm::vec2& vec);
+	static ShaderUniform Float(UniformName name, float value);
 
 	[[nodiscard]]
-	static ShaderUniformPtr Vec3(std::string_view name, float v1, float v2, float v3);
+	static ShaderUniform Vec2(UniformName name, float v1, float v2);
 
 	[[nodiscard]]
-	static ShaderUniformPtr Vec3(std::string_view name, const glm::vec3& vec);
+	static ShaderUniform Vec2(UniformName name, const glm::vec2& vec);
 
 	[[nodiscard]]
-	static ShaderUniformPtr Vec4(std::string_view name, float v1, float v2, float v3, float v4);
+	static ShaderUniform Vec3(UniformName name, float v1, float v2, float v3);
 
 	[[nodiscard]]
-	static ShaderUniformPtr Vec4(std::string_view name, const glm::vec4& vec);
+	static ShaderUniform Vec3(UniformName name, const glm::vec3& vec);
 
 	[[nodiscard]]
-	static ShaderUniformPtr Mat4(std::string_view name, const glm::mat4& mat);
+	static ShaderUniform Vec4(UniformName name, float v1, float v2, float v3, float v4);
+
+	[[nodiscard]]
+	static ShaderUniform Vec4(UniformName name, const glm::vec4& vec);
+
+	[[nodiscard]]
+	static ShaderUniform Mat4(UniformName name, const glm::mat4& mat);
+
+	[[nodiscard]]
+	static ShaderUniform IntArray(UniformName name, std::span<const int> values);
+
+	[[nodiscard]]
+	static ShaderUniform FloatArray(UniformName name, std::span<const float> values);
+
+	[[nodiscard]]
+	static ShaderUniform Vec2Array(UniformName name, std::span<const glm::vec2> values);
+
+	[[nodiscard]]
+	static ShaderUniform Vec3Array(UniformName name, std::span<const glm::vec3> values);
+
+	[[nodiscard]]
+	static ShaderUniform Vec4Array(UniformName name, std::span<const glm::vec4> values);
+
+	[[nodiscard]]
+	static ShaderUniform Mat4Array(UniformName name, std::span<const glm::mat4> values);
 
 private:
-	// The name of the uniform variable in a shader.
-	std::string _name;
+	UniformName _name;
+	Type _type = Type::Int;
 	// The size of the uniform array denoted by _name. It must be 1, if the uniform isn't an array.
-	int _arraySize = 0;
+	// 0 for an empty array, which is never uploaded.
+	int _arraySize = 1;
+	// Points to array data. It's nullptr, if the value is stored in _inlineData.
+	const std::byte* _externalData = nullptr;
+	// It's left uninitialized intentionally: only getDataSize() bytes are used.
+	alignas(16) std::byte _inlineData[MAX_INLINE_DATA_SIZE];
 };
+
+
+constexpr size_t ShaderUniform::getElementSize(Type type)
+{
+	constexpr size_t floatSize = sizeof(float);
+	switch (type) {
+		case Type::Sampler:
+		case Type::Int:
+			return sizeof(int);
+		case Type::Float:
+			return floatSize;
+		case Type::Vec2:
+			return 2 * floatSize;
+		case Type::Vec3:
+			return 3 * floatSize;
+		case Type::Vec4:
+			return 4 * floatSize;
+		case Type::Mat4:
+			return 16 * floatSize;
+		default:
+			return 0;
+	}
+}
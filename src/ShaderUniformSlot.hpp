@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ShaderUniform.hpp"
+
+
+/**
+ * @brief A typed handle of a uniform with the slot index known at compile time.
+ * Handles are generated from the shader sources (see tools/ShaderInterfaceGenerator.cpp),
+ * so the C++ type of the value matches the GLSL type, and a removed or renamed uniform is a compilation error.
+ * @tparam T The C++ type of one element: int for samplers, float, glm::vec2, glm::vec3, glm::vec4 or glm::mat4.
+ */
+template <typename T>
+struct ShaderUniformSlot
+{
+	int index = -1;
+	UniformName name;
+	ShaderUniform::Type type = ShaderUniform::Type::Int;
+	int arraySize = 1;
+};
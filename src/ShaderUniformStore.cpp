@@ -1,30 +1,128 @@
 #include "ShaderUniformStore.hpp"
 
-#include "ShaderUniform.hpp"
 #include "Utilities.hpp"
 
+#include <algorithm>
+#include <cstring>
+
+
+std::span<const UniformName> ShaderUniformStore::_predefinedSlotNames;
+
+
+ShaderUniformStore::ShaderUniformStore()
+{
+	_slots.reserve(std::max(INITIAL_SLOTS_CAPACITY, _predefinedSlotNames.size()));
+	_slotNameHashes.reserve(_slots.capacity());
+	_data.resize(INITIAL_DATA_CAPACITY);
+
+	for (const UniformName& name : _predefinedSlotNames) {
+		getOrCreateSlot(name);
+	}
+}
+
+
+void ShaderUniformStore::setPredefinedSlots(std::span<const UniformName> names)
+{
+	_predefinedSlotNames = names;
+}
 
-ShaderUniformStore::ShaderUniformStore() = default;
 
 ShaderUniformStore::~ShaderUniformStore() = default;
 
 
 void ShaderUniformStore::resetAll()
 {
-	_uniforms.clear();
+	for (Slot& slot : _slots) {
+		slot.isSet = false;
+	}
+}
+
+
+void ShaderUniformStore::reset(UniformName name)
+{
+	const int slot = findSlot(name);
+	if (slot != INVALID_SLOT) {
+		_slots[slot].isSet = false;
+	}
 }
 
 
-void ShaderUniformStore::reset(std::string_view name)
+void ShaderUniformStore::set(const ShaderUniform& uniform)
 {
-	_uniforms.erase(std::string(name));
+	set(getOrCreateSlot(uniform.getName()), uniform);
 }
 
 
-void ShaderUniformStore::set(ShaderUniformPtr&& uniformPtr)
+void ShaderUniformStore::set(int slotIndex, const ShaderUniform& uniform)
 {
-	if (!uniformPtr) {
+	assertTrue(slotIndex >= 0 && slotIndex < (int) _slots.size());
+
+	Slot& slot = _slots[slotIndex];
+	const size_t dataSize = uniform.getDataSize();
+	if (dataSize > slot.dataCapacity) {
+		slot.dataOffset = allocateData(dataSize);
+		slot.dataCapacity = dataSize;
+		slot.isSet = false;
+	}
+
+	std::byte* slotData = _data.data() + slot.dataOffset;
+	const bool isSameValue = slot.isSet
+			&& (slot.type == uniform.getType())
+			&& (slot.arraySize == uniform.getArraySize())
+			&& (std::memcmp(slotData, uniform.getData(), dataSize) == 0);
+	if (isSameValue) {
+		// Keep the version, so the unchanged value isn't uploaded again.
 		return;
 	}
-	_uniforms[uniformPtr->getName()] = std::move(uniformPtr);
+
+	std::memcpy(slotData, uniform.getData(), dataSize);
+	slot.type = uniform.getType();
+	slot.arraySize = uniform.getArraySize();
+	slot.isSet = true;
+	slot.version = ++_lastVersion;
+}
+
+
+int ShaderUniformStore::findSlot(UniformName name) const
+{
+	const uint32_t hash = name.getHash();
+	for (size_t i = 0; i < _slotNameHashes.size(); ++i) {
+		if (_slotNameHashes[i] == hash && _slots[i].name == name.getView()) {
+			return (int) i;
+		}
+	}
+	return INVALID_SLOT;
+}
+
+
+int ShaderUniformStore::getOrCreateSlot(UniformName name)
+{
+	const int existingSlot = findSlot(name);
+	if (existingSlot != INVALID_SLOT) {
+		return existingSlot;
+	}
+
+	Slot& slot = _slots.emplace_back();
+	slot.name = name.getView();
+	_slotNameHashes.push_back(name.getHash());
+	return (int) _slots.size() - 1;
+}
+
+
+ShaderUniform ShaderUniformStore::get(int slotIndex) const
+{
+	const Slot& slot = _slots[slotIndex];
+	const UniformName name(slot.name, _slotNameHashes[slotIndex]);
+	return {name, slot.type, slot.arraySize, _data.data() + slot.dataOffset};
+}
+
+
+size_t ShaderUniformStore::allocateData(size_t size)
+{
+	const size_t offset = (_dataSize + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+	_dataSize = offset + size;
+	if (_dataSize > _data.size()) {
+		_data.resize(std::max(_dataSize, _data.size() * 2));
+	}
+	return offset;
 }
@@ -1,33 +1,136 @@
 #pragma once
 
-#include <memory>
-#include <unordered_map>
+#include "ShaderUniform.hpp"
+#include "ShaderUniformSlot.hpp"
 
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
 
-class Shader;
-class ShaderUniform;
-using ShaderUniformPtr = std::unique_ptr<ShaderUniform>;
 
 /**
  * @brief Represents a store for uniform variables of one particular shader program.
+ *
+ * Values are kept in a flat table of slots. A slot is created once per uniform name
+ * and its index never changes, so consumers can cache per-slot data.
+ * All values share one contiguous data buffer. After the first frame, setting values
+ * of the same sizes doesn't allocate memory.
+ *
+ * Every store starts with the predefined slots, so the generated ShaderUniformSlot handles
+ * address the same slots in all stores without name lookups.
  */
 class ShaderUniformStore
 {
+public:
+	static constexpr int INVALID_SLOT = -1;
+
 public:
 	ShaderUniformStore();
 
 	~ShaderUniformStore();
 
+	ShaderUniformStore(const ShaderUniformStore&) = default;
+
+	ShaderUniformStore& operator=(const ShaderUniformStore&) = default;
+
+	/**
+	 * @brief Sets the names of the slots which every store created later starts with, in the given order.
+	 * @param names The names must outlive all stores. They are usually the generated ShaderInterface::UNIFORM_NAMES.
+	 */
+	static void setPredefinedSlots(std::span<const UniformName> names);
+
+	/**
+	 * @brief Unsets all values. The slots are kept.
+	 */
 	void resetAll();
 
-	void reset(std::string_view name);
+	void reset(UniformName name);
+
+	void set(const ShaderUniform& uniform);
+
+	/**
+	 * @brief Sets the value to the slot directly, skipping the name lookup.
+	 * @param slot The slot which has been returned by getOrCreateSlot() for the name of the uniform.
+	 */
+	void set(int slot, const ShaderUniform& uniform);
+
+	/**
+	 * @brief Sets the value through the generated handle: no name lookup, and the value type is checked at compile time.
+	 */
+	template <typename T>
+	void set(const ShaderUniformSlot<T>& slot, const std::type_identity_t<T>& value)
+	{
+		set(slot.index, ShaderUniform(slot.name, slot.type, 1, &value));
+	}
+
+	/**
+	 * @brief Sets the array value. The values are copied to the store.
+	 */
+	template <typename T>
+	void set(const ShaderUniformSlot<T>& slot, std::span<const std::type_identity_t<T>> values)
+	{
+		set(slot.index, ShaderUniform(slot.name, slot.type, (int) values.size(), values.data()));
+	}
 
-	void set(ShaderUniformPtr&& uniformPtr);
+	[[nodiscard]]
+	int findSlot(UniformName name) const;
 
-	auto begin() const { return _uniforms.begin(); };
+	int getOrCreateSlot(UniformName name);
 
-	auto end() const { return _uniforms.end(); };
+	[[nodiscard]]
+	size_t getSlotsCount() const { return _slots.size(); }
+
+	[[nodiscard]]
+	const std::string& getSlotName(int slot) const { return _slots[slot].name; }
+
+	[[nodiscard]]
+	bool isSet(int slot) const { return _slots[slot].isSet; }
+
+	/**
+	 * @brief Returns the version of the last change of the slot value.
+	 * Versions are unique across the store, so a consumer can compare a version
+	 * with the one it saw last time to find out whether the value has changed.
+	 */
+	[[nodiscard]]
+	uint64_t getVersion(int slot) const { return _slots[slot].version; }
+
+	/**
+	 * @brief Returns the value of the slot. The value references the store data,
+	 * so it's valid until the next change of the store.
+	 */
+	[[nodiscard]]
+	ShaderUniform get(int slot) const;
 
 private:
-	std::unordered_map<std::string, ShaderUniformPtr> _uniforms;
+	struct Slot
+	{
+		std::string name;
+		ShaderUniform::Type type = ShaderUniform::Type::Int;
+		int arraySize = 0;
+		// The position of the value in _data.
+		size_t dataOffset = 0;
+		size_t dataCapacity = 0;
+		// 0 is reserved for "never uploaded" state on the consumer side.
+		uint64_t version = 0;
+		bool isSet = false;
+	};
+
+	static constexpr size_t INITIAL_SLOTS_CAPACITY = 32;
+	static constexpr size_t INITIAL_DATA_CAPACITY = 4096;
+	static constexpr size_t DATA_ALIGNMENT = 16;
+
+	size_t allocateData(size_t size);
+
+private:
+	static std::span<const UniformName> _predefinedSlotNames;
+
+	std::vector<Slot> _slots;
+	// Name hashes of _slots. They are kept apart to make the lookup scan cache friendly.
+	std::vector<uint32_t> _slotNameHashes;
+	std::vector<std::byte> _data;
+	size_t _dataSize = 0;
+	uint64_t _lastVersion = 0;
 };
@@ -0,0 +1,61 @@
+#include "Simd.hpp"
+
+
+Simd::Isa Simd::getBestIsa()
+{
+	static const Isa bestIsa = []() {
+		if (isSupported(Isa::Avx)) {
+			return Isa::Avx;
+		}
+		if (isSupported(Isa::Sse)) {
+			return Isa::Sse;
+		}
+		return Isa::Scalar;
+	}();
+	return bestIsa;
+}
+
+
+bool Simd::isSupported(Isa isa)
+{
+	switch (isa) {
+		case Isa::Scalar:
+			return true;
+		case Isa::Sse:
+			// SSE2 is a part of x86-64.
+			return SIMD_X86;
+		case Isa::Avx:
+#if SIMD_AVX && (defined(__GNUC__) || defined(__clang__))
+			return __builtin_cpu_supports("avx");
+#else
+			return SIMD_AVX;
+#endif
+		default:
+			return false;
+	}
+}
+
+
+bool Simd::isF16cSupported()
+{
+#if SIMD_F16C && (defined(__GNUC__) || defined(__clang__))
+	return __builtin_cpu_supports("f16c");
+#else
+	return SIMD_F16C;
+#endif
+}
+
+
+std::string_view Simd::getIsaName(Isa isa)
+{
+	switch (isa) {
+		case Isa::Scalar:
+			return "scalar";
+		case Isa::Sse:
+			return "SSE";
+		case Isa::Avx:
+			return "AVX";
+		default:
+			return "unknown";
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_X86 0
+#endif
+
+// GCC and Clang compile single functions for AVX, so the rest of the program doesn't require it.
+// Such functions must be called only if Simd::isSupported(Simd::Isa::Avx).
+#if SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_AVX 1
+#define SIMD_TARGET_AVX __attribute__((target("avx")))
+#elif SIMD_X86 && defined(__AVX__)
+#define SIMD_AVX 1
+#define SIMD_TARGET_AVX
+#else
+#define SIMD_AVX 0
+#define SIMD_TARGET_AVX
+#endif
+
+// The conversions between floats and half floats. They are separate from the ISA levels: some AVX CPUs lack them.
+// Such functions must be called only if Simd::isF16cSupported().
+#if SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_F16C 1
+#define SIMD_TARGET_F16C __attribute__((target("f16c")))
+#elif SIMD_X86 && defined(__AVX2__)
+#define SIMD_F16C 1
+#define SIMD_TARGET_F16C
+#else
+#define SIMD_F16C 0
+#define SIMD_TARGET_F16C
+#endif
+
+
+/**
+ * The instruction sets of the vectorized kernels. The kernel is picked at runtime by the CPU support.
+ */
+namespace Simd {
+	enum class Isa
+	{
+		Scalar,
+		// 4 floats at a time.
+		Sse,
+		// 8 floats at a time.
+		Avx,
+	};
+
+	// The alignment of SoA arrays, which suits the widest loads.
+	static constexpr size_t ALIGNMENT = 32;
+
+	/**
+	 * @brief Returns the widest instruction set which is supported by the CPU the code runs on.
+	 */
+	[[nodiscard]]
+	Isa getBestIsa();
+
+	[[nodiscard]]
+	bool isSupported(Isa isa);
+
+	[[nodiscard]]
+	std::string_view getIsaName(Isa isa);
+
+	[[nodiscard]]
+	bool isF16cSupported();
+}
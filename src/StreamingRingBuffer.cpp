@@ -0,0 +1,182 @@
+#include "StreamingRingBuffer.hpp"
+
+#include "GlExtensions.hpp"
+#include "GlStateCache.hpp"
+#include "Utilities.hpp"
+
+#include <chrono>
+#include <iostream>
+
+
+StreamingRingBuffer::StreamingRingBuffer(size_t regionSize, size_t regionsCount)
+		: _regionSize(regionSize)
+		, _regionsCount(regionsCount)
+		, _regionFences(regionsCount, nullptr)
+{
+	assertTrue(regionSize > 0 && regionsCount > 0);
+	const auto bufferSize = (GLsizeiptr) (_regionSize * _regionsCount);
+
+	glGenBuffers(1, &_bufferId);
+	GlStateCache::bindBuffer(UPDATE_TARGET, _bufferId);
+	if (GlExtensions::isBufferStorageSupported()) {
+		// Coherent: the writes become visible to GPU without explicit flushes.
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GlExtensions::bufferStorage(UPDATE_TARGET, bufferSize, nullptr, flags);
+		_persistentData = static_cast<std::byte*>(glMapBufferRange(UPDATE_TARGET, 0, bufferSize, flags));
+		if (_persistentData) {
+			_mode = Mode::PersistentMapping;
+		} else {
+			// Immutable storage can't be respecified, so the fallback needs a new buffer.
+			std::cerr << "[StreamingRingBuffer] Persistent mapping failed. The fallback mode is used." << std::endl;
+			glDeleteBuffers(1, &_bufferId);
+			GlStateCache::forgetBuffer(_bufferId);
+			glGenBuffers(1, &_bufferId);
+			GlStateCache::bindBuffer(UPDATE_TARGET, _bufferId);
+		}
+	}
+	if (_mode == Mode::UnsynchronizedMapping) {
+		glBufferData(UPDATE_TARGET, bufferSize, nullptr, GL_STREAM_DRAW);
+	}
+
+	handleGLErrors();
+}
+
+
+StreamingRingBuffer::~StreamingRingBuffer() noexcept
+{
+	deleteFences();
+	if (_bufferId > 0) {
+		if (_persistentData) {
+			GlStateCache::bindBuffer(UPDATE_TARGET, _bufferId);
+			glUnmapBuffer(UPDATE_TARGET);
+			_persistentData = nullptr;
+		}
+		glDeleteBuffers(1, &_bufferId);
+		GlStateCache::forgetBuffer(_bufferId);
+		_bufferId = 0;
+	}
+}
+
+
+void StreamingRingBuffer::beginFrame()
+{
+	assertTrue(!_isFrameStarted);
+	_region = (_region + 1) % _regionsCount;
+	_regionOffset = 0;
+	_isFrameStarted = true;
+	++_stats.framesCount;
+
+	waitForRegion(_region);
+}
+
+
+void StreamingRingBuffer::endFrame()
+{
+	assertTrue(_isFrameStarted && !_hasUncommittedAllocation);
+	_isFrameStarted = false;
+
+	GLsync& fence = _regionFences[_region];
+	if (fence) {
+		glDeleteSync(fence);
+	}
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+
+StreamingRingBuffer::Allocation StreamingRingBuffer::allocate(size_t size, size_t alignment)
+{
+	assertTrue(_isFrameStarted && !_hasUncommittedAllocation);
+	assertTrue(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+	const size_t regionStart = _region * _regionSize;
+	const size_t offset = (regionStart + _regionOffset + alignment - 1) & ~(alignment - 1);
+	if (offset + size > regionStart + _regionSize) {
+		++_stats.overflowsCount;
+		return {};
+	}
+	_regionOffset = offset + size - regionStart;
+	_stats.allocatedBytes += size;
+
+	Allocation allocation;
+	allocation.offset = offset;
+	allocation.size = size;
+	if (_mode == Mode::PersistentMapping) {
+		allocation.data = _persistentData + offset;
+		return allocation;
+	}
+
+	// The fence of the region has guaranteed, that GPU doesn't read the range, so the driver needn't synchronize.
+	GlStateCache::bindBuffer(UPDATE_TARGET, _bufferId);
+	const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+	allocation.data = glMapBufferRange(UPDATE_TARGET, (GLintptr) offset, (GLsizeiptr) size, access);
+	_hasUncommittedAllocation = allocation.isValid();
+	return allocation;
+}
+
+
+void StreamingRingBuffer::commit(const Allocation& allocation)
+{
+	if (_mode == Mode::PersistentMapping || !allocation.isValid()) {
+		return;
+	}
+
+	assertTrue(_hasUncommittedAllocation);
+	_hasUncommittedAllocation = false;
+	GlStateCache::bindBuffer(UPDATE_TARGET, _bufferId);
+	glUnmapBuffer(UPDATE_TARGET);
+}
+
+
+void StreamingRingBuffer::waitForRegion(size_t region)
+{
+	GLsync& fence = _regionFences[region];
+	if (!fence) {
+		return;
+	}
+
+	// The usual case: GPU has finished the frame long ago.
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED) {
+		if (_mode == Mode::UnsynchronizedMapping) {
+			// Don't wait: the driver gives new storage, and the old one lives until GPU is done with it.
+			orphan();
+			return;
+		}
+
+		++_stats.stallsCount;
+		const auto startTime = std::chrono::steady_clock::now();
+		constexpr GLuint64 TIMEOUT_NS = 1'000'000'000;
+		do {
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, TIMEOUT_NS);
+		} while (status == GL_TIMEOUT_EXPIRED);
+		const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - startTime;
+		_stats.stallsMs += duration.count();
+	}
+
+	if (status == GL_WAIT_FAILED) {
+		std::cerr << "[StreamingRingBuffer] Waiting for the fence has failed." << std::endl;
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+
+void StreamingRingBuffer::orphan()
+{
+	++_stats.orphansCount;
+	GlStateCache::bindBuffer(UPDATE_TARGET, _bufferId);
+	glBufferData(UPDATE_TARGET, (GLsizeiptr) (_regionSize * _regionsCount), nullptr, GL_STREAM_DRAW);
+	// No region of the new storage is used by GPU.
+	deleteFences();
+}
+
+
+void StreamingRingBuffer::deleteFences()
+{
+	for (GLsync& fence : _regionFences) {
+		if (fence) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+}
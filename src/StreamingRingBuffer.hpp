@@ -0,0 +1,135 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+
+/**
+ * @brief A buffer for the data which is written by CPU every frame and read by GPU once (instance data, uniforms).
+ *
+ * The buffer is split into regions: one per frame in flight. A frame writes only to its own region,
+ * and the fence placed at the end of the frame tells when GPU has finished reading it, so the region can be reused.
+ *
+ * With GL_ARB_buffer_storage the buffer is mapped persistently once, and the writes go straight to the GPU visible memory.
+ * Otherwise every allocation maps its range with GL_MAP_UNSYNCHRONIZED_BIT, and commit() unmaps it.
+ * If GPU falls behind, the persistent ring waits for the fence (a stall), while the fallback one orphans the buffer.
+ */
+class StreamingRingBuffer
+{
+public:
+	enum class Mode
+	{
+		PersistentMapping,
+		UnsynchronizedMapping,
+	};
+
+	struct Allocation
+	{
+		// nullptr, if the region of the frame doesn't have enough room.
+		void* data = nullptr;
+		// The offset in the buffer for glVertexAttribPointer, glBindBufferRange, etc.
+		size_t offset = 0;
+		size_t size = 0;
+
+		[[nodiscard]]
+		bool isValid() const { return data != nullptr; }
+	};
+
+	/**
+	 * @brief Counters since the last resetStats().
+	 */
+	struct Stats
+	{
+		size_t framesCount = 0;
+		size_t allocatedBytes = 0;
+		// Waits for GPU to release the region of a new frame.
+		size_t stallsCount = 0;
+		double stallsMs = 0.0;
+		// Reallocations of the storage instead of waiting (the fallback mode).
+		size_t orphansCount = 0;
+		// Allocations which haven't fit into the region.
+		size_t overflowsCount = 0;
+	};
+
+	static constexpr size_t DEFAULT_REGIONS_COUNT = 3;
+
+public:
+	/**
+	 * @param regionSize The maximum size of the data of one frame.
+	 * @param regionsCount The number of frames in flight.
+	 */
+	explicit StreamingRingBuffer(size_t regionSize, size_t regionsCount = DEFAULT_REGIONS_COUNT);
+
+	~StreamingRingBuffer() noexcept;
+
+	StreamingRingBuffer(const StreamingRingBuffer&) = delete;
+
+	StreamingRingBuffer& operator=(const StreamingRingBuffer&) = delete;
+
+	[[nodiscard]]
+	bool isValid() const { return _bufferId > 0; }
+
+	[[nodiscard]]
+	GLuint getBufferId() const { return _bufferId; }
+
+	[[nodiscard]]
+	Mode getMode() const { return _mode; }
+
+	/**
+	 * @brief Switches to the region of the next frame. It waits, if GPU still reads the region.
+	 */
+	void beginFrame();
+
+	/**
+	 * @brief Places the fence after the commands of the frame, which read the region.
+	 */
+	void endFrame();
+
+	/**
+	 * @brief Sub-allocates the memory in the region of the current frame.
+	 * The memory must be written before commit(), and used by GPU commands of the current frame only.
+	 * @param alignment The alignment of the offset (e.g. GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT). It must be a power of 2.
+	 */
+	[[nodiscard]]
+	Allocation allocate(size_t size, size_t alignment);
+
+	/**
+	 * @brief Makes the written data visible to GPU. It must be called before the draws, which read the allocation.
+	 * In the fallback mode only one allocation may be uncommitted at a time.
+	 */
+	void commit(const Allocation& allocation);
+
+	[[nodiscard]]
+	const Stats& getStats() const { return _stats; }
+
+	void resetStats() { _stats = {}; }
+
+private:
+	void waitForRegion(size_t region);
+
+	void orphan();
+
+	void deleteFences();
+
+private:
+	// The buffer is bound to this target for the updates: it doesn't affect the bindings used by draws.
+	static constexpr GLenum UPDATE_TARGET = GL_COPY_WRITE_BUFFER;
+
+	Mode _mode = Mode::UnsynchronizedMapping;
+	GLuint _bufferId = 0;
+	size_t _regionSize = 0;
+	size_t _regionsCount = 0;
+	// The persistently mapped memory of the whole buffer.
+	std::byte* _persistentData = nullptr;
+
+	size_t _region = 0;
+	// The offset of the free memory in the current region.
+	size_t _regionOffset = 0;
+	bool _isFrameStarted = false;
+	bool _hasUncommittedAllocation = false;
+	std::vector<GLsync> _regionFences;
+
+	Stats _stats;
+};
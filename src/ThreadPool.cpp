@@ -0,0 +1,117 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+
+ThreadPool::ThreadPool(size_t workersCount)
+{
+	_workers.reserve(workersCount);
+	for (size_t i = 0; i < workersCount; ++i) {
+		_workers.emplace_back(&ThreadPool::runWorker, this);
+	}
+}
+
+
+ThreadPool::~ThreadPool() noexcept
+{
+	{
+		std::lock_guard lock(_mutex);
+		_isStopping = true;
+	}
+	_jobCondition.notify_all();
+
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+}
+
+
+size_t ThreadPool::getChunksCount(size_t count, size_t minChunkSize) const
+{
+	const size_t maxChunksCount = (count + std::max<size_t>(minChunkSize, 1) - 1) / std::max<size_t>(minChunkSize, 1);
+	return std::clamp<size_t>(maxChunksCount, 1, getThreadsCount());
+}
+
+
+void ThreadPool::parallelFor(size_t count, size_t minChunkSize, const ChunkFunction& function)
+{
+	if (count == 0) {
+		return;
+	}
+
+	const size_t chunksCount = getChunksCount(count, minChunkSize);
+	if (chunksCount == 1) {
+		function(0, count, 0);
+		return;
+	}
+
+	{
+		// A late worker may still look at the previous job.
+		std::unique_lock lock(_mutex);
+		_doneCondition.wait(lock, [this]() { return _activeWorkersCount == 0; });
+		_function = &function;
+		_count = count;
+		_chunksCount = chunksCount;
+		_nextChunk = 0;
+		_doneChunks = 0;
+		++_jobGeneration;
+	}
+	_jobCondition.notify_all();
+
+	runChunks();
+
+	// The job fields must stay intact, while any worker may read them.
+	std::unique_lock lock(_mutex);
+	_doneCondition.wait(lock, [this]() { return _doneChunks == _chunksCount && _activeWorkersCount == 0; });
+	_function = nullptr;
+}
+
+
+ThreadPool& ThreadPool::getShared()
+{
+	static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+	return pool;
+}
+
+
+void ThreadPool::runWorker()
+{
+	size_t seenGeneration = 0;
+	while (true) {
+		{
+			std::unique_lock lock(_mutex);
+			_jobCondition.wait(lock, [&]() { return _isStopping || _jobGeneration != seenGeneration; });
+			if (_isStopping) {
+				return;
+			}
+			seenGeneration = _jobGeneration;
+			++_activeWorkersCount;
+		}
+
+		runChunks();
+
+		{
+			std::lock_guard lock(_mutex);
+			--_activeWorkersCount;
+		}
+		_doneCondition.notify_all();
+	}
+}
+
+
+void ThreadPool::runChunks()
+{
+	while (true) {
+		const size_t chunk = _nextChunk.fetch_add(1);
+		if (chunk >= _chunksCount) {
+			return;
+		}
+
+		// Chunks differ in size by one element at most.
+		const size_t begin = _count * chunk / _chunksCount;
+		const size_t end = _count * (chunk + 1) / _chunksCount;
+		(*_function)(begin, end, chunk);
+
+		_doneChunks.fetch_add(1);
+	}
+}
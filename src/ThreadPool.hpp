@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief Persistent worker threads for data parallel loops.
+ * The calling thread takes part in the work, so a pool without workers runs the loop in place.
+ */
+class ThreadPool
+{
+public:
+	/**
+	 * @brief The function which processes the chunk [begin, end). chunkIndex is in [0, chunks count).
+	 */
+	using ChunkFunction = std::function<void(size_t begin, size_t end, size_t chunkIndex)>;
+
+public:
+	/**
+	 * @param workersCount The number of threads besides the calling one.
+	 */
+	explicit ThreadPool(size_t workersCount);
+
+	~ThreadPool() noexcept;
+
+	ThreadPool(const ThreadPool&) = delete;
+
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * @brief Returns the number of threads which run chunks, including the calling thread.
+	 */
+	[[nodiscard]]
+	size_t getThreadsCount() const { return _workers.size() + 1; }
+
+	/**
+	 * @brief Returns the number of chunks parallelFor() splits the range into.
+	 */
+	[[nodiscard]]
+	size_t getChunksCount(size_t count, size_t minChunkSize) const;
+
+	/**
+	 * @brief Splits [0, count) into getChunksCount() contiguous chunks and runs them on all threads.
+	 * It returns, when all chunks are done. It must be called from one thread at a time, and not from a chunk function.
+	 * @param minChunkSize Smaller ranges aren't split: the cost of waking threads is higher than the work.
+	 */
+	void parallelFor(size_t count, size_t minChunkSize, const ChunkFunction& function);
+
+	/**
+	 * @brief The pool with a worker per hardware thread besides the calling one.
+	 */
+	static ThreadPool& getShared();
+
+private:
+	void runWorker();
+
+	/**
+	 * @brief Runs chunks of the current job, until they are over.
+	 */
+	void runChunks();
+
+private:
+	std::vector<std::thread> _workers;
+
+	std::mutex _mutex;
+	std::condition_variable _jobCondition;
+	std::condition_variable _doneCondition;
+	// Incremented for every job, so workers notice a new one.
+	size_t _jobGeneration = 0;
+	// Workers which have taken the current job. The job fields are read by them without the lock.
+	size_t _activeWorkersCount = 0;
+	bool _isStopping = false;
+
+	// The current job.
+	const ChunkFunction* _function = nullptr;
+	size_t _count = 0;
+	size_t _chunksCount = 0;
+	std::atomic<size_t> _nextChunk = 0;
+	std::atomic<size_t> _doneChunks = 0;
+};
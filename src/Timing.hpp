@@ -0,0 +1,15 @@
+#pragma once
+
+#include <chrono>
+
+
+namespace Timing {
+	/**
+	 * @brief The milliseconds elapsed since the time point, for the timings in the stats.
+	 */
+	[[nodiscard]]
+	inline double getMsSince(std::chrono::steady_clock::time_point startTime)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	}
+}
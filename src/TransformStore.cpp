@@ -0,0 +1,334 @@
+#include "TransformStore.hpp"
+
+#include "ThreadPool.hpp"
+#include "Utilities.hpp"
+
+
+namespace {
+	struct TransformArrays
+	{
+		const float* positionX;
+		const float* positionY;
+		const float* positionZ;
+		const float* rotationX;
+		const float* rotationY;
+		const float* rotationZ;
+		const float* rotationW;
+		const float* scaleX;
+		const float* scaleY;
+		const float* scaleZ;
+	};
+
+
+	/**
+	 * The rotation matrix of the quaternion is written out, and the scale is applied to its columns.
+	 * The translation is the last column as is. The SIMD kernels do the same operations, so the results are equal.
+	 */
+	void computeModelMatricesScalar(const TransformArrays& arrays, size_t begin, size_t end, glm::mat4* out)
+	{
+		for (size_t i = begin; i < end; ++i) {
+			const float x = arrays.rotationX[i];
+			const float y = arrays.rotationY[i];
+			const float z = arrays.rotationZ[i];
+			const float w = arrays.rotationW[i];
+			const float x2 = x * 2.f;
+			const float y2 = y * 2.f;
+			const float z2 = z * 2.f;
+			const float xx2 = x * x2;
+			const float yy2 = y * y2;
+			const float zz2 = z * z2;
+			const float xy2 = x * y2;
+			const float xz2 = x * z2;
+			const float yz2 = y * z2;
+			const float wx2 = w * x2;
+			const float wy2 = w * y2;
+			const float wz2 = w * z2;
+			const float sx = arrays.scaleX[i];
+			const float sy = arrays.scaleY[i];
+			const float sz = arrays.scaleZ[i];
+
+			glm::mat4& m = out[i];
+			m[0] = glm::vec4((1.f - (yy2 + zz2)) * sx, (xy2 + wz2) * sx, (xz2 - wy2) * sx, 0.f);
+			m[1] = glm::vec4((xy2 - wz2) * sy, (1.f - (xx2 + zz2)) * sy, (yz2 + wx2) * sy, 0.f);
+			m[2] = glm::vec4((xz2 + wy2) * sz, (yz2 - wx2) * sz, (1.f - (xx2 + yy2)) * sz, 0.f);
+			m[3] = glm::vec4(arrays.positionX[i], arrays.positionY[i], arrays.positionZ[i], 1.f);
+		}
+	}
+
+
+#if SIMD_X86
+	/**
+	 * Stores 4 columns, one per matrix: the lanes of x, y, z, w hold the column components of 4 matrices.
+	 */
+	inline void storeColumnsSse(__m128 x, __m128 y, __m128 z, __m128 w, glm::mat4* out, int column)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(&out[0][column][0], x);
+		_mm_storeu_ps(&out[1][column][0], y);
+		_mm_storeu_ps(&out[2][column][0], z);
+		_mm_storeu_ps(&out[3][column][0], w);
+	}
+
+
+	void computeModelMatricesSse(const TransformArrays& arrays, size_t begin, size_t end, glm::mat4* out)
+	{
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 two = _mm_set1_ps(2.f);
+		const __m128 zero = _mm_setzero_ps();
+
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4) {
+			const __m128 x = _mm_loadu_ps(arrays.rotationX + i);
+			const __m128 y = _mm_loadu_ps(arrays.rotationY + i);
+			const __m128 z = _mm_loadu_ps(arrays.rotationZ + i);
+			const __m128 w = _mm_loadu_ps(arrays.rotationW + i);
+			const __m128 x2 = _mm_mul_ps(x, two);
+			const __m128 y2 = _mm_mul_ps(y, two);
+			const __m128 z2 = _mm_mul_ps(z, two);
+			const __m128 xx2 = _mm_mul_ps(x, x2);
+			const __m128 yy2 = _mm_mul_ps(y, y2);
+			const __m128 zz2 = _mm_mul_ps(z, z2);
+			const __m128 xy2 = _mm_mul_ps(x, y2);
+			const __m128 xz2 = _mm_mul_ps(x, z2);
+			const __m128 yz2 = _mm_mul_ps(y, z2);
+			const __m128 wx2 = _mm_mul_ps(w, x2);
+			const __m128 wy2 = _mm_mul_ps(w, y2);
+			const __m128 wz2 = _mm_mul_ps(w, z2);
+			const __m128 sx = _mm_loadu_ps(arrays.scaleX + i);
+			const __m128 sy = _mm_loadu_ps(arrays.scaleY + i);
+			const __m128 sz = _mm_loadu_ps(arrays.scaleZ + i);
+
+			storeColumnsSse(
+					_mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy2, zz2)), sx),
+					_mm_mul_ps(_mm_add_ps(xy2, wz2), sx),
+					_mm_mul_ps(_mm_sub_ps(xz2, wy2), sx),
+					zero, out + i, 0);
+			storeColumnsSse(
+					_mm_mul_ps(_mm_sub_ps(xy2, wz2), sy),
+					_mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx2, zz2)), sy),
+					_mm_mul_ps(_mm_add_ps(yz2, wx2), sy),
+					zero, out + i, 1);
+			storeColumnsSse(
+					_mm_mul_ps(_mm_add_ps(xz2, wy2), sz),
+					_mm_mul_ps(_mm_sub_ps(yz2, wx2), sz),
+					_mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx2, yy2)), sz),
+					zero, out + i, 2);
+			storeColumnsSse(
+					_mm_loadu_ps(arrays.positionX + i),
+					_mm_loadu_ps(arrays.positionY + i),
+					_mm_loadu_ps(arrays.positionZ + i),
+					one, out + i, 3);
+		}
+
+		computeModelMatricesScalar(arrays, i, end, out);
+	}
+#endif
+
+
+#if SIMD_AVX
+	/**
+	 * Stores 8 columns, one per matrix. The 128-bit halves are transposed separately: they hold matrices 0-3 and 4-7.
+	 */
+	SIMD_TARGET_AVX
+	inline void storeColumnsAvx(__m256 x, __m256 y, __m256 z, __m256 w, glm::mat4* out, int column)
+	{
+		const __m256 xyLow = _mm256_unpacklo_ps(x, y);
+		const __m256 xyHigh = _mm256_unpackhi_ps(x, y);
+		const __m256 zwLow = _mm256_unpacklo_ps(z, w);
+		const __m256 zwHigh = _mm256_unpackhi_ps(z, w);
+		const __m256 columns04 = _mm256_shuffle_ps(xyLow, zwLow, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 columns15 = _mm256_shuffle_ps(xyLow, zwLow, _MM_SHUFFLE(3, 2, 3, 2));
+		const __m256 columns26 = _mm256_shuffle_ps(xyHigh, zwHigh, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 columns37 = _mm256_shuffle_ps(xyHigh, zwHigh, _MM_SHUFFLE(3, 2, 3, 2));
+
+		_mm_storeu_ps(&out[0][column][0], _mm256_castps256_ps128(columns04));
+		_mm_storeu_ps(&out[1][column][0], _mm256_castps256_ps128(columns15));
+		_mm_storeu_ps(&out[2][column][0], _mm256_castps256_ps128(columns26));
+		_mm_storeu_ps(&out[3][column][0], _mm256_castps256_ps128(columns37));
+		_mm_storeu_ps(&out[4][column][0], _mm256_extractf128_ps(columns04, 1));
+		_mm_storeu_ps(&out[5][column][0], _mm256_extractf128_ps(columns15, 1));
+		_mm_storeu_ps(&out[6][column][0], _mm256_extractf128_ps(columns26, 1));
+		_mm_storeu_ps(&out[7][column][0], _mm256_extractf128_ps(columns37, 1));
+	}
+
+
+	SIMD_TARGET_AVX
+	void computeModelMatricesAvx(const TransformArrays& arrays, size_t begin, size_t end, glm::mat4* out)
+	{
+		const __m256 one = _mm256_set1_ps(1.f);
+		const __m256 two = _mm256_set1_ps(2.f);
+		const __m256 zero = _mm256_setzero_ps();
+
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8) {
+			const __m256 x = _mm256_loadu_ps(arrays.rotationX + i);
+			const __m256 y = _mm256_loadu_ps(arrays.rotationY + i);
+			const __m256 z = _mm256_loadu_ps(arrays.rotationZ + i);
+			const __m256 w = _mm256_loadu_ps(arrays.rotationW + i);
+			const __m256 x2 = _mm256_mul_ps(x, two);
+			const __m256 y2 = _mm256_mul_ps(y, two);
+			const __m256 z2 = _mm256_mul_ps(z, two);
+			const __m256 xx2 = _mm256_mul_ps(x, x2);
+			const __m256 yy2 = _mm256_mul_ps(y, y2);
+			const __m256 zz2 = _mm256_mul_ps(z, z2);
+			const __m256 xy2 = _mm256_mul_ps(x, y2);
+			const __m256 xz2 = _mm256_mul_ps(x, z2);
+			const __m256 yz2 = _mm256_mul_ps(y, z2);
+			const __m256 wx2 = _mm256_mul_ps(w, x2);
+			const __m256 wy2 = _mm256_mul_ps(w, y2);
+			const __m256 wz2 = _mm256_mul_ps(w, z2);
+			const __m256 sx = _mm256_loadu_ps(arrays.scaleX + i);
+			const __m256 sy = _mm256_loadu_ps(arrays.scaleY + i);
+			const __m256 sz = _mm256_loadu_ps(arrays.scaleZ + i);
+
+			storeColumnsAvx(
+					_mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy2, zz2)), sx),
+					_mm256_mul_ps(_mm256_add_ps(xy2, wz2), sx),
+					_mm256_mul_ps(_mm256_sub_ps(xz2, wy2), sx),
+					zero, out + i, 0);
+			storeColumnsAvx(
+					_mm256_mul_ps(_mm256_sub_ps(xy2, wz2), sy),
+					_mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx2, zz2)), sy),
+					_mm256_mul_ps(_mm256_add_ps(yz2, wx2), sy),
+					zero, out + i, 1);
+			storeColumnsAvx(
+					_mm256_mul_ps(_mm256_add_ps(xz2, wy2), sz),
+					_mm256_mul_ps(_mm256_sub_ps(yz2, wx2), sz),
+					_mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx2, yy2)), sz),
+					zero, out + i, 2);
+			storeColumnsAvx(
+					_mm256_loadu_ps(arrays.positionX + i),
+					_mm256_loadu_ps(arrays.positionY + i),
+					_mm256_loadu_ps(arrays.positionZ + i),
+					one, out + i, 3);
+		}
+
+		computeModelMatricesSse(arrays, i, end, out);
+	}
+#endif
+}
+
+
+size_t TransformStore::add(const Transform& transform)
+{
+	const size_t index = size();
+	_positionX.push_back(transform.position.x);
+	_positionY.push_back(transform.position.y);
+	_positionZ.push_back(transform.position.z);
+	_rotationX.push_back(transform.rotation.x);
+	_rotationY.push_back(transform.rotation.y);
+	_rotationZ.push_back(transform.rotation.z);
+	_rotationW.push_back(transform.rotation.w);
+	_scaleX.push_back(transform.scale.x);
+	_scaleY.push_back(transform.scale.y);
+	_scaleZ.push_back(transform.scale.z);
+	return index;
+}
+
+
+void TransformStore::set(size_t index, const Transform& transform)
+{
+	setPosition(index, transform.position);
+	setRotation(index, transform.rotation);
+	setScale(index, transform.scale);
+}
+
+
+void TransformStore::setPosition(size_t index, const glm::vec3& position)
+{
+	_positionX[index] = position.x;
+	_positionY[index] = position.y;
+	_positionZ[index] = position.z;
+}
+
+
+void TransformStore::setRotation(size_t index, const glm::quat& rotation)
+{
+	_rotationX[index] = rotation.x;
+	_rotationY[index] = rotation.y;
+	_rotationZ[index] = rotation.z;
+	_rotationW[index] = rotation.w;
+}
+
+
+void TransformStore::setScale(size_t index, const glm::vec3& scale)
+{
+	_scaleX[index] = scale.x;
+	_scaleY[index] = scale.y;
+	_scaleZ[index] = scale.z;
+}
+
+
+Transform TransformStore::get(size_t index) const
+{
+	Transform transform;
+	transform.position = glm::vec3(_positionX[index], _positionY[index], _positionZ[index]);
+	transform.rotation = glm::quat(_rotationW[index], _rotationX[index], _rotationY[index], _rotationZ[index]);
+	transform.scale = glm::vec3(_scaleX[index], _scaleY[index], _scaleZ[index]);
+	return transform;
+}
+
+
+void TransformStore::reserve(size_t count)
+{
+	for (FloatArray* array : {&_positionX, &_positionY, &_positionZ, &_rotationX, &_rotationY, &_rotationZ, &_rotationW,
+			&_scaleX, &_scaleY, &_scaleZ}) {
+		array->reserve(count);
+	}
+}
+
+
+void TransformStore::clear()
+{
+	for (FloatArray* array : {&_positionX, &_positionY, &_positionZ, &_rotationX, &_rotationY, &_rotationZ, &_rotationW,
+			&_scaleX, &_scaleY, &_scaleZ}) {
+		array->clear();
+	}
+}
+
+
+void TransformStore::computeModelMatrices(std::span<glm::mat4> outMatrices, Simd::Isa isa) const
+{
+	assertTrue(outMatrices.size() >= size());
+	computeModelMatricesRange(isa, 0, size(), outMatrices.data());
+}
+
+
+void TransformStore::computeModelMatricesParallel(
+		ThreadPool& threadPool,
+		std::span<glm::mat4> outMatrices,
+		Simd::Isa isa
+) const
+{
+	assertTrue(outMatrices.size() >= size());
+	threadPool.parallelFor(size(), MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end, size_t) {
+		computeModelMatricesRange(isa, begin, end, outMatrices.data());
+	});
+}
+
+
+void TransformStore::computeModelMatricesRange(Simd::Isa isa, size_t begin, size_t end, glm::mat4* out) const
+{
+	assertTrueMsg(Simd::isSupported(isa), "The instruction set isn't supported by the CPU.");
+
+	const TransformArrays arrays = {
+			_positionX.data(), _positionY.data(), _positionZ.data(),
+			_rotationX.data(), _rotationY.data(), _rotationZ.data(), _rotationW.data(),
+			_scaleX.data(), _scaleY.data(), _scaleZ.data(),
+	};
+	switch (isa) {
+#if SIMD_AVX
+		case Simd::Isa::Avx:
+			computeModelMatricesAvx(arrays, begin, end, out);
+			break;
+#endif
+#if SIMD_X86
+		case Simd::Isa::Sse:
+			computeModelMatricesSse(arrays, begin, end, out);
+			break;
+#endif
+		default:
+			computeModelMatricesScalar(arrays, begin, end, out);
+			break;
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "AlignedAllocator.hpp"
+#include "Simd.hpp"
+
+#include <cstddef>
+#include <span>
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+
+class ThreadPool;
+
+
+struct Transform
+{
+	glm::vec3 position = glm::vec3(0.f);
+	// It must be normalized.
+	glm::quat rotation = glm::quat(1.f, 0.f, 0.f, 0.f);
+	glm::vec3 scale = glm::vec3(1.f);
+};
+
+
+/**
+ * @brief Transforms of many objects in the SoA layout: every component is in its own aligned array.
+ * The model matrices are composed from the components directly (translation * rotation * scale),
+ * several transforms per instruction, without generic 4x4 matrix multiplications.
+ */
+class TransformStore
+{
+public:
+	// Ranges shorter than this aren't split between threads.
+	static constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 16 * 1024;
+
+public:
+	/**
+	 * @return The index of the transform. Indices don't change, until clear().
+	 */
+	size_t add(const Transform& transform);
+
+	void set(size_t index, const Transform& transform);
+
+	void setPosition(size_t index, const glm::vec3& position);
+
+	void setRotation(size_t index, const glm::quat& rotation);
+
+	void setScale(size_t index, const glm::vec3& scale);
+
+	[[nodiscard]]
+	Transform get(size_t index) const;
+
+	[[nodiscard]]
+	size_t size() const { return _positionX.size(); }
+
+	void reserve(size_t count);
+
+	void clear();
+
+	/**
+	 * @brief The position components are exposed for SoA consumers like the culling.
+	 */
+	[[nodiscard]]
+	std::span<const float> getPositionsX() const { return _positionX; }
+
+	[[nodiscard]]
+	std::span<const float> getPositionsY() const { return _positionY; }
+
+	[[nodiscard]]
+	std::span<const float> getPositionsZ() const { return _positionZ; }
+
+	/**
+	 * @brief Writes the model matrices of all transforms.
+	 * @param outMatrices It must have room for size() matrices.
+	 * @param isa It must be supported by the CPU.
+	 */
+	void computeModelMatrices(std::span<glm::mat4> outMatrices, Simd::Isa isa = Simd::getBestIsa()) const;
+
+	/**
+	 * @brief The same as computeModelMatrices(), but the transforms are split between the threads of the pool.
+	 */
+	void computeModelMatricesParallel(
+			ThreadPool& threadPool,
+			std::span<glm::mat4> outMatrices,
+			Simd::Isa isa = Simd::getBestIsa()
+	) const;
+
+private:
+	using FloatArray = AlignedVector<float, Simd::ALIGNMENT>;
+
+	/**
+	 * @brief Writes the matrices of the transforms [begin, end) to out[begin, end).
+	 */
+	void computeModelMatricesRange(Simd::Isa isa, size_t begin, size_t end, glm::mat4* out) const;
+
+private:
+	FloatArray _positionX;
+	FloatArray _positionY;
+	FloatArray _positionZ;
+	FloatArray _rotationX;
+	FloatArray _rotationY;
+	FloatArray _rotationZ;
+	FloatArray _rotationW;
+	FloatArray _scaleX;
+	FloatArray _scaleY;
+	FloatArray _scaleZ;
+};
@@ -49,6 +49,7 @@ do { \
 } while(false);
 
 
+// Defined in GlErrors.cpp, so the tools without GL don't link the GL loader.
 void debugHandleGLErrors();
 
 
@@ -0,0 +1,185 @@
+#include "VertexArrayCache.hpp"
+
+#include "GlExtensions.hpp"
+#include "GlStateCache.hpp"
+#include "Utilities.hpp"
+
+#include <algorithm>
+
+
+std::vector<VertexArrayCache::Entry> VertexArrayCache::_entries;
+
+
+void VertexArrayCache::setupAttributes(const VertexLayout& layout, size_t offset)
+{
+	for (const VertexAttribute& attribute : layout.attributes) {
+		const auto* pointer = (const void*) (offset + attribute.offset);
+		if (attribute.kind == AttributeKind::Integer) {
+			glVertexAttribIPointer(attribute.location, attribute.componentsCount, attribute.componentType, layout.stride, pointer);
+		} else {
+			const GLboolean isNormalized = (attribute.kind == AttributeKind::Normalized) ? GL_TRUE : GL_FALSE;
+			glVertexAttribPointer(
+					attribute.location,
+					attribute.componentsCount,
+					attribute.componentType,
+					isNormalized,
+					layout.stride,
+					pointer
+			);
+		}
+		glEnableVertexAttribArray(attribute.location);
+		glVertexAttribDivisor(attribute.location, layout.divisor);
+	}
+}
+
+
+void VertexArrayCache::bind(std::span<const VertexStream> streams, GLuint indexBufferId)
+{
+	assertTrue(!streams.empty() && streams.size() <= MAX_STREAMS_COUNT);
+
+	Entry* entry = findEntry(streams, indexBufferId);
+	if (entry == nullptr) {
+		entry = &createEntry(streams, indexBufferId);
+	}
+	GlStateCache::bindVertexArray(entry->vertexArrayId);
+
+	for (size_t i = 0; i < streams.size(); ++i) {
+		const VertexStream& stream = streams[i];
+		if (entry->bufferIds[i] == stream.bufferId && entry->offsets[i] == stream.offset) {
+			continue;
+		}
+		if (GlExtensions::isVertexAttribBindingSupported()) {
+			GlExtensions::bindVertexBuffer((GLuint) i, stream.bufferId, (GLintptr) stream.offset, stream.layout->stride);
+		} else {
+			// E.g. the emulation of the base instance: the same buffer with another offset.
+			GlStateCache::bindBuffer(GL_ARRAY_BUFFER, stream.bufferId);
+			setupAttributes(*stream.layout, stream.offset);
+		}
+		entry->bufferIds[i] = stream.bufferId;
+		entry->offsets[i] = stream.offset;
+	}
+
+	if (entry->indexBufferId != indexBufferId) {
+		GlStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferId);
+		entry->indexBufferId = indexBufferId;
+	}
+}
+
+
+void VertexArrayCache::forgetBuffer(GLuint bufferId)
+{
+	if (GlExtensions::isVertexAttribBindingSupported()) {
+		// GL unbinds a deleted buffer only from the bound VAO, and the name may be reused, so the others rebind it.
+		for (Entry& entry : _entries) {
+			std::replace(entry.bufferIds.begin(), entry.bufferIds.end(), bufferId, UNKNOWN_ID);
+			if (entry.indexBufferId == bufferId) {
+				entry.indexBufferId = UNKNOWN_ID;
+			}
+		}
+		return;
+	}
+
+	const auto isReferencing = [bufferId](const Entry& entry) {
+		const auto bufferIdsEnd = entry.bufferIds.begin() + (ptrdiff_t) entry.streamsCount;
+		return entry.indexBufferId == bufferId || std::find(entry.bufferIds.begin(), bufferIdsEnd, bufferId) != bufferIdsEnd;
+	};
+	for (const Entry& entry : _entries) {
+		if (isReferencing(entry)) {
+			deleteEntry(entry);
+		}
+	}
+	std::erase_if(_entries, isReferencing);
+}
+
+
+void VertexArrayCache::clear()
+{
+	for (const Entry& entry : _entries) {
+		deleteEntry(entry);
+	}
+	_entries.clear();
+}
+
+
+VertexArrayCache::Entry* VertexArrayCache::findEntry(std::span<const VertexStream> streams, GLuint indexBufferId)
+{
+	// On GL 3.3 the buffers are a part of the key. The offsets aren't: they are changed in the found VAO.
+	const bool isBufferKey = !GlExtensions::isVertexAttribBindingSupported();
+	for (Entry& entry : _entries) {
+		if (entry.streamsCount != streams.size() || (isBufferKey && entry.indexBufferId != indexBufferId)) {
+			continue;
+		}
+		bool isEqual = true;
+		for (size_t i = 0; i < streams.size() && isEqual; ++i) {
+			isEqual = (entry.layouts[i] == *streams[i].layout) && (!isBufferKey || entry.bufferIds[i] == streams[i].bufferId);
+		}
+		if (isEqual) {
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+
+VertexArrayCache::Entry& VertexArrayCache::createEntry(std::span<const VertexStream> streams, GLuint indexBufferId)
+{
+	Entry& entry = _entries.emplace_back();
+	entry.streamsCount = streams.size();
+	entry.bufferIds.fill(UNKNOWN_ID);
+	entry.indexBufferId = UNKNOWN_ID;
+
+	glGenVertexArrays(1, &entry.vertexArrayId);
+	GlStateCache::bindVertexArray(entry.vertexArrayId);
+
+	std::vector<GLuint> locations;
+	for (size_t i = 0; i < streams.size(); ++i) {
+		const VertexLayout& layout = *streams[i].layout;
+		entry.layouts[i] = layout;
+		for (const VertexAttribute& attribute : layout.attributes) {
+			assertTrueMsg(std::find(locations.begin(), locations.end(), attribute.location) == locations.end(),
+					"The streams of a VAO must not repeat the locations.");
+			locations.push_back(attribute.location);
+		}
+
+		if (GlExtensions::isVertexAttribBindingSupported()) {
+			// The stream index is the binding index. The buffers are bound by bind().
+			for (const VertexAttribute& attribute : layout.attributes) {
+				if (attribute.kind == AttributeKind::Integer) {
+					GlExtensions::vertexAttribIFormat(attribute.location, attribute.componentsCount, attribute.componentType, attribute.offset);
+				} else {
+					const GLboolean isNormalized = (attribute.kind == AttributeKind::Normalized) ? GL_TRUE : GL_FALSE;
+					GlExtensions::vertexAttribFormat(
+							attribute.location,
+							attribute.componentsCount,
+							attribute.componentType,
+							isNormalized,
+							attribute.offset
+					);
+				}
+				GlExtensions::vertexAttribBinding(attribute.location, (GLuint) i);
+				glEnableVertexAttribArray(attribute.location);
+			}
+			GlExtensions::vertexBindingDivisor((GLuint) i, layout.divisor);
+		} else {
+			GlStateCache::bindBuffer(GL_ARRAY_BUFFER, streams[i].bufferId);
+			setupAttributes(layout, streams[i].offset);
+			entry.bufferIds[i] = streams[i].bufferId;
+			entry.offsets[i] = streams[i].offset;
+		}
+	}
+
+	if (!GlExtensions::isVertexAttribBindingSupported()) {
+		GlStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferId);
+		entry.indexBufferId = indexBufferId;
+	}
+
+	handleGLErrors();
+	return entry;
+}
+
+
+void VertexArrayCache::deleteEntry(const Entry& entry)
+{
+	glDeleteVertexArrays(1, &entry.vertexArrayId);
+	GlStateCache::forgetVertexArray(entry.vertexArrayId);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "VertexLayout.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+
+/**
+ * @brief A buffer with the vertices of a layout.
+ */
+struct VertexStream
+{
+	const VertexLayout* layout = nullptr;
+	GLuint bufferId = 0;
+	// The offset of the first vertex in the buffer, in bytes.
+	size_t offset = 0;
+};
+
+
+/**
+ * @brief Configures VAOs from the vertex layouts and reuses them for identical configurations.
+ *
+ * With GL_ARB_vertex_attrib_binding (GL 4.3) a VAO keeps only the formats of the attributes, and the buffers are bound
+ * to it on the draw. So all meshes with the same layouts share one VAO, whatever buffers they have.
+ * On GL 3.3 the attributes reference the buffers, so a VAO is shared only by the draws of the same buffers.
+ * In both cases the calls are issued only for the buffers and the offsets, which differ from the ones the VAO has.
+ *
+ * Like GlStateCache, it's used on the GL thread only, and the deleted buffers must be reported with forgetBuffer().
+ */
+class VertexArrayCache
+{
+public:
+	static constexpr size_t MAX_STREAMS_COUNT = 4;
+
+public:
+	/**
+	 * @brief Points the attributes of the layout to the buffer bound to GL_ARRAY_BUFFER in the bound VAO.
+	 * @param offset The offset of the first vertex in the buffer, in bytes.
+	 */
+	static void setupAttributes(const VertexLayout& layout, size_t offset = 0);
+
+	/**
+	 * @brief Binds a VAO, which reads the streams with the element buffer. It's created on the first use.
+	 * The streams must not repeat the locations.
+	 */
+	static void bind(std::span<const VertexStream> streams, GLuint indexBufferId);
+
+	/**
+	 * @brief Drops the VAOs and the bindings, which reference the buffer. Call it before glDeleteBuffers.
+	 */
+	static void forgetBuffer(GLuint bufferId);
+
+	/**
+	 * @brief Deletes all VAOs. It must be called while the context is alive.
+	 */
+	static void clear();
+
+	[[nodiscard]]
+	static size_t getVertexArraysCount() { return _entries.size(); }
+
+private:
+	struct Entry
+	{
+		GLuint vertexArrayId = 0;
+		size_t streamsCount = 0;
+		// The key: the layouts, and on GL 3.3 the buffers too.
+		std::array<VertexLayout, MAX_STREAMS_COUNT> layouts;
+		// The buffers and the offsets, which the VAO currently has.
+		std::array<GLuint, MAX_STREAMS_COUNT> bufferIds = {};
+		std::array<size_t, MAX_STREAMS_COUNT> offsets = {};
+		GLuint indexBufferId = 0;
+	};
+
+	// A binding, which isn't known, so the next bind is always issued.
+	static constexpr GLuint UNKNOWN_ID = 0xFFFFFFFF;
+
+	[[nodiscard]]
+	static Entry* findEntry(std::span<const VertexStream> streams, GLuint indexBufferId);
+
+	static Entry& createEntry(std::span<const VertexStream> streams, GLuint indexBufferId);
+
+	static void deleteEntry(const Entry& entry);
+
+private:
+	static std::vector<Entry> _entries;
+};
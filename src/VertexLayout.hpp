@@ -0,0 +1,165 @@
+#pragma once
+
+#include "PackedVertexFormat.hpp"
+#include "ShaderInterface.hpp"
+#include "VertexFormat.hpp"
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+
+/**
+ * @brief How the shader sees the components of an attribute.
+ */
+enum class AttributeKind : uint8_t
+{
+	// Floats or half floats, read as they are.
+	Float,
+	// Integers, mapped to [0, 1] or [-1, 1] floats.
+	Normalized,
+	// Integers, read by int or uint shader inputs.
+	Integer,
+};
+
+
+/**
+ * @brief An attribute of a vertex struct: the arguments of glVertexAttribPointer except the buffer and the stride.
+ */
+struct VertexAttribute
+{
+	GLuint location = 0;
+	GLint componentsCount = 0;
+	GLenum componentType = GL_FLOAT;
+	AttributeKind kind = AttributeKind::Float;
+	// The offset in the vertex, e.g. offsetof(VertexFormat, pos).
+	GLuint offset = 0;
+
+	constexpr bool operator==(const VertexAttribute&) const = default;
+};
+
+
+/**
+ * @brief The attributes of a vertex struct, which is read from one buffer.
+ * Every struct declares its layout once as a constant in VertexLayouts, and VertexArrayCache configures VAOs from it.
+ */
+struct VertexLayout
+{
+	// It must have the static storage duration: the layouts are copied by value, but the attributes aren't.
+	std::span<const VertexAttribute> attributes;
+	GLsizei stride = 0;
+	// 0 - the attributes advance per vertex, 1 - per instance.
+	GLuint divisor = 0;
+
+	/**
+	 * @brief Layouts with equal attributes are equal, even if they are declared separately.
+	 */
+	constexpr bool operator==(const VertexLayout& other) const
+	{
+		return stride == other.stride && divisor == other.divisor
+				&& std::equal(attributes.begin(), attributes.end(), other.attributes.begin(), other.attributes.end());
+	}
+};
+
+
+/**
+ * @return The size of the component type in bytes, or 0 for the types, which aren't supported.
+ */
+[[nodiscard]]
+constexpr GLsizei getComponentSize(GLenum componentType)
+{
+	switch (componentType) {
+		case GL_BYTE:
+		case GL_UNSIGNED_BYTE:
+			return 1;
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+		case GL_HALF_FLOAT:
+			return 2;
+		case GL_INT:
+		case GL_UNSIGNED_INT:
+		case GL_FLOAT:
+			return 4;
+		default:
+			return 0;
+	}
+}
+
+
+/**
+ * @brief Checks the mistakes, which GL doesn't report: attributes outside the vertex or overlapping each other,
+ * repeated locations, integer kinds of float types and so on. The layouts are checked by static_assert.
+ */
+[[nodiscard]]
+constexpr bool isValidLayout(const VertexLayout& layout)
+{
+	if (layout.stride <= 0 || layout.attributes.empty()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < layout.attributes.size(); ++i) {
+		const VertexAttribute& attribute = layout.attributes[i];
+		const GLsizei componentSize = getComponentSize(attribute.componentType);
+		const bool isFloatType = (attribute.componentType == GL_FLOAT || attribute.componentType == GL_HALF_FLOAT);
+		const GLuint end = attribute.offset + (GLuint) (attribute.componentsCount * componentSize);
+		if (componentSize == 0
+				|| attribute.componentsCount < 1 || attribute.componentsCount > 4
+				|| isFloatType != (attribute.kind == AttributeKind::Float)
+				|| attribute.offset % (GLuint) componentSize != 0
+				|| end > (GLuint) layout.stride) {
+			return false;
+		}
+
+		for (size_t j = 0; j < i; ++j) {
+			const VertexAttribute& other = layout.attributes[j];
+			const GLuint otherEnd = other.offset + (GLuint) (other.componentsCount * getComponentSize(other.componentType));
+			if (other.location == attribute.location || (attribute.offset < otherEnd && other.offset < end)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+namespace VertexLayouts {
+	inline constexpr VertexAttribute VERTEX_FORMAT_ATTRIBUTES[] = {
+			{ShaderInterface::Default::aPos, 3, GL_FLOAT, AttributeKind::Float, offsetof(VertexFormat, pos)},
+			{ShaderInterface::Default::aColor, 4, GL_FLOAT, AttributeKind::Float, offsetof(VertexFormat, color)},
+			{ShaderInterface::Default::aTexCoords, 2, GL_FLOAT, AttributeKind::Float, offsetof(VertexFormat, texCoords)},
+	};
+	inline constexpr VertexLayout VERTEX_FORMAT = {VERTEX_FORMAT_ATTRIBUTES, sizeof(VertexFormat)};
+	static_assert(isValidLayout(VERTEX_FORMAT));
+
+	// The packed normal isn't bound: the shaders have no lighting yet.
+	inline constexpr VertexAttribute PACKED_VERTEX_FORMAT_HALF_ATTRIBUTES[] = {
+			{ShaderInterface::Default::aPos, 3, GL_HALF_FLOAT, AttributeKind::Float, offsetof(PackedVertexFormat, pos)},
+			{ShaderInterface::Default::aColor, 4, GL_UNSIGNED_BYTE, AttributeKind::Normalized, offsetof(PackedVertexFormat, color)},
+			{ShaderInterface::Default::aTexCoords, 2, GL_HALF_FLOAT, AttributeKind::Float, offsetof(PackedVertexFormat, texCoords)},
+	};
+	inline constexpr VertexLayout PACKED_VERTEX_FORMAT_HALF = {PACKED_VERTEX_FORMAT_HALF_ATTRIBUTES, sizeof(PackedVertexFormat)};
+	static_assert(isValidLayout(PACKED_VERTEX_FORMAT_HALF));
+
+	inline constexpr VertexAttribute PACKED_VERTEX_FORMAT_UNORM16_ATTRIBUTES[] = {
+			{ShaderInterface::Default::aPos, 3, GL_UNSIGNED_SHORT, AttributeKind::Normalized, offsetof(PackedVertexFormat, pos)},
+			{ShaderInterface::Default::aColor, 4, GL_UNSIGNED_BYTE, AttributeKind::Normalized, offsetof(PackedVertexFormat, color)},
+			{ShaderInterface::Default::aTexCoords, 2, GL_HALF_FLOAT, AttributeKind::Float, offsetof(PackedVertexFormat, texCoords)},
+	};
+	inline constexpr VertexLayout PACKED_VERTEX_FORMAT_UNORM16 = {PACKED_VERTEX_FORMAT_UNORM16_ATTRIBUTES, sizeof(PackedVertexFormat)};
+	static_assert(isValidLayout(PACKED_VERTEX_FORMAT_UNORM16));
+
+	// A mat4 attribute occupies 4 locations: one per column.
+	inline constexpr VertexAttribute INSTANCE_MODEL_MATRIX_ATTRIBUTES[] = {
+			{ShaderInterface::Default::aInstanceModel + 0, 4, GL_FLOAT, AttributeKind::Float, 0 * sizeof(glm::vec4)},
+			{ShaderInterface::Default::aInstanceModel + 1, 4, GL_FLOAT, AttributeKind::Float, 1 * sizeof(glm::vec4)},
+			{ShaderInterface::Default::aInstanceModel + 2, 4, GL_FLOAT, AttributeKind::Float, 2 * sizeof(glm::vec4)},
+			{ShaderInterface::Default::aInstanceModel + 3, 4, GL_FLOAT, AttributeKind::Float, 3 * sizeof(glm::vec4)},
+	};
+	inline constexpr VertexLayout INSTANCE_MODEL_MATRIX = {INSTANCE_MODEL_MATRIX_ATTRIBUTES, sizeof(glm::mat4), 1};
+	static_assert(isValidLayout(INSTANCE_MODEL_MATRIX));
+}
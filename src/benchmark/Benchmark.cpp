@@ -0,0 +1,46 @@
+#include "Benchmark.hpp"
+
+#include <iostream>
+
+
+namespace {
+	struct BenchmarkEntry
+	{
+		std::string_view name;
+		std::string_view description;
+		int (* function)();
+	};
+
+	constexpr BenchmarkEntry BENCHMARKS[] = {
+			{"uniform-store", "Polymorphic vs flat uniform store, 10k/100k/1M sets per frame", &Benchmark::runUniformStoreBenchmark},
+			{"frustum-culling", "Scalar vs SSE/AVX vs multithreaded frustum culling of 100k/1M/4M spheres and boxes", &Benchmark::runFrustumCullingBenchmark},
+			{"transforms", "glm chained TRS vs SoA SIMD/multithreaded model matrices, 10k/100k/1M per frame", &Benchmark::runTransformBenchmark},
+			{"render-queue", "Sort keys, radix sort vs std::stable_sort and state changes of 1M queued draws", &Benchmark::runRenderQueueBenchmark},
+			{"indirect-commands", "Building multi-draw indirect commands for 1M instances of 10/1k/10k meshes", &Benchmark::runIndirectCommandBenchmark},
+			{"command-buffer", "Sequential vs multithreaded recording of 1M queued draws to command buffers and their replay", &Benchmark::runCommandBufferBenchmark},
+			{"software-raster", "Scalar vs SIMD vs multithreaded tile rasterization of 1k/10k/100k textured cubes", &Benchmark::runSoftwareRasterizerBenchmark},
+			{"occlusion-culling", "Hi-Z occlusion culling of 100k/1M candidates behind the blocks of a city, scalar vs SIMD vs multithreaded", &Benchmark::runOcclusionCullingBenchmark},
+			{"vertex-packing", "Half/unorm16/octahedral vertex and 16-bit index packing of 2k/500k vertex spheres, scalar vs SIMD/F16C", &Benchmark::runVertexPackingBenchmark},
+			{"mesh-optimizer", "Tipsify vertex cache, overdraw and vertex fetch ordering of 260k triangle spheres and 1k meshes, ACMR/ATVR", &Benchmark::runMeshOptimizerBenchmark},
+			{"mesh-import", "Multithreaded OBJ/glTF/GLB import of a 1M triangle sphere, MB/s, against loading the binary mesh files", &Benchmark::runMeshImportBenchmark},
+	};
+}
+
+
+int Benchmark::run(std::string_view name)
+{
+	for (const BenchmarkEntry& entry : BENCHMARKS) {
+		if (entry.name == name) {
+			std::cout << "[Benchmark] " << entry.name << ": " << entry.description << std::endl;
+			return entry.function();
+		}
+	}
+
+	std::cerr << "[Benchmark] Unknown benchmark: " << name << "\n"
+			<< "Available benchmarks:\n";
+	for (const BenchmarkEntry& entry : BENCHMARKS) {
+		std::cerr << "\t" << entry.name << " - " << entry.description << "\n";
+	}
+	std::cerr << std::flush;
+	return -1;
+}
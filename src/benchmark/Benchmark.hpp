@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <string_view>
+
+
+/**
+ * CPU-only benchmarks, which are run instead of the main loop:
+ * LearnOpenGL --benchmark <name>
+ */
+namespace Benchmark {
+	/**
+	 * @brief Runs the benchmark with the given name. Prints the list of benchmarks, if the name is unknown.
+	 * @return The exit code of the process.
+	 */
+	int run(std::string_view name);
+
+	/**
+	 * @brief Measures the average duration of one call of the function.
+	 * @return The duration in milliseconds.
+	 */
+	template <typename Func>
+	double measureMs(int iterations, Func&& func)
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; ++i) {
+			func();
+		}
+		const auto endTime = std::chrono::steady_clock::now();
+		const std::chrono::duration<double, std::milli> duration = endTime - startTime;
+		return duration.count() / iterations;
+	}
+
+	/**
+	 * @brief Prevents the compiler from throwing away the calculation of the value.
+	 */
+	template <typename T>
+	void doNotOptimize(const T& value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const void* sink = nullptr;
+		sink = &value;
+#endif
+	}
+
+	// The benchmarks.
+	int runUniformStoreBenchmark();
+
+	int runFrustumCullingBenchmark();
+
+	int runTransformBenchmark();
+
+	int runRenderQueueBenchmark();
+
+	int runIndirectCommandBenchmark();
+
+	int runCommandBufferBenchmark();
+
+	int runSoftwareRasterizerBenchmark();
+
+	int runOcclusionCullingBenchmark();
+
+	int runVertexPackingBenchmark();
+
+	int runMeshOptimizerBenchmark();
+
+	int runMeshImportBenchmark();
+}
@@ -0,0 +1,265 @@
+#include "Benchmark.hpp"
+
+#include "CommandBuffer.hpp"
+#include "RenderQueue.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/mat4x4.hpp>
+
+
+namespace {
+	constexpr int ITERATIONS = 5;
+	constexpr size_t ITEMS_COUNT = 1'000'000;
+	constexpr uint32_t SHADERS_COUNT = 64;
+	constexpr uint32_t MATERIALS_COUNT = 512;
+	constexpr uint32_t VERTEX_ARRAYS_COUNT = 256;
+	constexpr uint32_t MESHES_COUNT = 16;
+	// Every draw is an instance of one of the object kinds, which fix the shader, the material and the mesh.
+	constexpr size_t OBJECT_KINDS_COUNT = 2000;
+	constexpr size_t MIN_CHUNK_SIZE = 4096;
+
+
+	struct Scene
+	{
+		RenderQueue queue;
+		std::vector<glm::mat4> modelMatrices;
+		std::vector<uint32_t> meshIndices;
+	};
+
+
+	Scene generateScene()
+	{
+		std::mt19937 random(42);
+		std::uniform_int_distribution<uint32_t> passDistribution(0, 1);
+		std::uniform_int_distribution<uint32_t> shaderDistribution(0, SHADERS_COUNT - 1);
+		std::uniform_int_distribution<uint32_t> materialDistribution(0, MATERIALS_COUNT - 1);
+		std::uniform_int_distribution<uint32_t> vertexArrayDistribution(0, VERTEX_ARRAYS_COUNT - 1);
+		std::uniform_int_distribution<uint32_t> meshDistribution(0, MESHES_COUNT - 1);
+		std::uniform_int_distribution<size_t> kindDistribution(0, OBJECT_KINDS_COUNT - 1);
+		std::uniform_real_distribution<float> unitDistribution(0.f, 1.f);
+
+		struct ObjectKind
+		{
+			uint64_t opaqueKey = 0;
+			uint32_t mesh = 0;
+		};
+		std::vector<ObjectKind> objectKinds(OBJECT_KINDS_COUNT);
+		for (ObjectKind& kind : objectKinds) {
+			kind.opaqueKey = RenderSortKey::makeOpaque(passDistribution(random), shaderDistribution(random),
+					materialDistribution(random), vertexArrayDistribution(random), 0.f);
+			kind.mesh = meshDistribution(random);
+		}
+
+		Scene scene;
+		scene.queue.reserve(ITEMS_COUNT);
+		scene.modelMatrices.resize(ITEMS_COUNT);
+		scene.meshIndices.resize(ITEMS_COUNT);
+		for (uint32_t i = 0; i < (uint32_t) ITEMS_COUNT; ++i) {
+			const ObjectKind& kind = objectKinds[kindDistribution(random)];
+			const uint64_t key = RenderSortKey::makeOpaque(RenderSortKey::getPass(kind.opaqueKey),
+					RenderSortKey::getShader(kind.opaqueKey), RenderSortKey::getMaterial(kind.opaqueKey),
+					RenderSortKey::getVertexArray(kind.opaqueKey), unitDistribution(random));
+			scene.queue.push(key, i);
+			// The translation identifies the instance in the replayed stream.
+			scene.modelMatrices[i] = glm::translate(glm::mat4(1.f), glm::vec3((float) i, 1.f, 2.f));
+			scene.meshIndices[i] = kind.mesh;
+		}
+		scene.queue.sort();
+		return scene;
+	}
+
+
+	// The same translation as the one of the main loop, but the meshes container is the vertex array.
+	struct RecordingVisitor
+	{
+		const Scene* scene = nullptr;
+		CommandBuffer* commands = nullptr;
+
+		void beginPass(uint32_t pass, bool isTranslucent) { commands->bindPipeline(pass * 2 + (isTranslucent ? 1 : 0)); }
+
+		void bindShader(uint32_t shader) { commands->bindShader(shader); }
+
+		void bindMaterial(uint32_t material) { commands->bindMaterial(material); }
+
+		void bindVertexArray(uint32_t vertexArray) { commands->bindVertexArray(vertexArray); }
+
+		// A chunk may start inside a run without the binding calls, so the state is taken from the key.
+		void draw(std::span<const RenderQueue::Item> items)
+		{
+			const uint32_t vertexArray = RenderSortKey::getVertexArray(items.front().key);
+			const CommandBuffer::DrawInstancesData instances = commands->drawInstances(vertexArray, items.size());
+			for (size_t i = 0; i < items.size(); ++i) {
+				instances.modelMatrices[i] = scene->modelMatrices[items[i].payload];
+				instances.meshIndices[i] = scene->meshIndices[items[i].payload];
+			}
+		}
+	};
+
+
+	// What the GPU would see for one instance: the whole bound state and the instance data.
+	struct DrawnInstance
+	{
+		uint32_t pipeline = 0;
+		uint32_t shader = 0;
+		uint32_t material = 0;
+		uint32_t vertexArray = 0;
+		uint32_t meshes = 0;
+		uint32_t mesh = 0;
+		float translation = 0.f;
+
+		bool operator==(const DrawnInstance&) const = default;
+	};
+
+
+	// Replays the stream into the list of the drawn instances, so streams with differently split draws can be compared.
+	struct FlatteningVisitor
+	{
+		DrawnInstance state;
+		std::vector<DrawnInstance> instances;
+		size_t drawsCount = 0;
+
+		void bindPipeline(uint32_t pipeline) { state.pipeline = pipeline; }
+
+		void bindShader(uint32_t shader) { state.shader = shader; }
+
+		void bindMaterial(uint32_t material) { state.material = material; }
+
+		void bindVertexArray(uint32_t vertexArray) { state.vertexArray = vertexArray; }
+
+		void setUniform(int, const ShaderUniform&) {}
+
+		void drawInstances(uint32_t meshes, std::span<const glm::mat4> modelMatrices, std::span<const uint32_t> meshIndices)
+		{
+			++drawsCount;
+			for (size_t i = 0; i < modelMatrices.size(); ++i) {
+				DrawnInstance& instance = instances.emplace_back(state);
+				instance.meshes = meshes;
+				instance.mesh = meshIndices[i];
+				instance.translation = modelMatrices[i][3].x;
+			}
+		}
+	};
+
+
+	// Touches the instance data only: the benchmark measures the walk itself.
+	struct CountingVisitor
+	{
+		size_t commandsCount = 0;
+		size_t instancesCount = 0;
+		float checksum = 0.f;
+
+		void bindPipeline(uint32_t) { ++commandsCount; }
+
+		void bindShader(uint32_t) { ++commandsCount; }
+
+		void bindMaterial(uint32_t) { ++commandsCount; }
+
+		void bindVertexArray(uint32_t) { ++commandsCount; }
+
+		void setUniform(int, const ShaderUniform&) { ++commandsCount; }
+
+		void drawInstances(uint32_t, std::span<const glm::mat4> modelMatrices, std::span<const uint32_t> meshIndices)
+		{
+			++commandsCount;
+			instancesCount += modelMatrices.size();
+			checksum += modelMatrices.front()[3].x + (float) meshIndices.back();
+		}
+	};
+
+
+	void recordSequential(const Scene& scene, CommandBuffer& commands)
+	{
+		commands.clear();
+		RecordingVisitor visitor = {&scene, &commands};
+		scene.queue.submit(visitor);
+	}
+
+
+	void recordParallel(ThreadPool& pool, const Scene& scene, std::vector<CommandBuffer>& buffers)
+	{
+		CommandBuffer::recordParallel(pool, scene.queue.size(), MIN_CHUNK_SIZE, buffers,
+				[&scene](CommandBuffer& commands, size_t begin, size_t end) {
+					RecordingVisitor visitor = {&scene, &commands};
+					scene.queue.submit(visitor, begin, end);
+				});
+	}
+
+
+	template <typename Visitor>
+	void replayAll(const std::vector<CommandBuffer>& buffers, Visitor& visitor)
+	{
+		for (const CommandBuffer& buffer : buffers) {
+			buffer.replay(visitor);
+		}
+	}
+}
+
+
+int Benchmark::runCommandBufferBenchmark()
+{
+	const Scene scene = generateScene();
+	ThreadPool& pool = ThreadPool::getShared();
+
+	// The first recording allocates the memory, the measured ones reuse it like frames do.
+	CommandBuffer sequentialCommands;
+	recordSequential(scene, sequentialCommands);
+	const double sequentialMs = measureMs(ITERATIONS, [&]() {
+		recordSequential(scene, sequentialCommands);
+	});
+
+	std::vector<CommandBuffer> parallelCommands;
+	recordParallel(pool, scene, parallelCommands);
+	const double parallelMs = measureMs(ITERATIONS, [&]() {
+		recordParallel(pool, scene, parallelCommands);
+	});
+
+	size_t parallelSize = 0;
+	size_t parallelCommandsCount = 0;
+	for (const CommandBuffer& buffer : parallelCommands) {
+		parallelSize += buffer.getSize();
+		parallelCommandsCount += buffer.getCommandsCount();
+	}
+
+	// The chunks split the draws at their boundaries only, so the drawn instances must be the same.
+	FlatteningVisitor expected;
+	sequentialCommands.replay(expected);
+	FlatteningVisitor actual;
+	replayAll(parallelCommands, actual);
+	const bool isStreamCorrect = (expected.instances == actual.instances)
+			&& (expected.instances.size() == ITEMS_COUNT)
+			&& (actual.drawsCount - expected.drawsCount < parallelCommands.size());
+
+	CountingVisitor replayVisitor;
+	const double replayMs = measureMs(ITERATIONS, [&]() {
+		replayVisitor = {};
+		replayAll(parallelCommands, replayVisitor);
+	});
+	doNotOptimize(replayVisitor.checksum);
+
+	std::cout << std::fixed << std::setprecision(3)
+			<< "\t" << ITEMS_COUNT << " items, " << OBJECT_KINDS_COUNT << " object kinds, "
+			<< pool.getThreadsCount() << " threads\n"
+			<< "\tsequential recording: " << sequentialMs << " ms, "
+			<< sequentialCommands.getCommandsCount() << " commands, "
+			<< (double) sequentialCommands.getSize() / (1024.0 * 1024.0) << " MB\n"
+			<< "\tparallel recording:   " << parallelMs << " ms, speedup x" << sequentialMs / parallelMs << ", "
+			<< parallelCommands.size() << " buffers, " << parallelCommandsCount << " commands, "
+			<< (double) parallelSize / (1024.0 * 1024.0) << " MB"
+			<< (isStreamCorrect ? "" : " MISMATCH") << "\n"
+			<< "\treplay:               " << replayMs << " ms, "
+			<< replayMs * 1e6 / (double) replayVisitor.commandsCount << " ns/command" << std::endl;
+
+	if (!isStreamCorrect || replayVisitor.instancesCount != ITEMS_COUNT) {
+		std::cerr << "[CommandBufferBenchmark] The parallel recording differs from the sequential one." << std::endl;
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,192 @@
+#include "Benchmark.hpp"
+
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+#include "culling/FrustumCuller.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+
+namespace {
+	constexpr int ITERATIONS = 10;
+	// The bounds are scattered around the camera, so a part of them is visible, and a part intersects the planes.
+	constexpr float SCENE_HALF_SIZE = 60.f;
+
+	constexpr Simd::Isa ISAS[] = {
+			Simd::Isa::Scalar,
+			Simd::Isa::Sse,
+			Simd::Isa::Avx,
+	};
+
+
+	struct SceneBounds
+	{
+		std::vector<float> centerX;
+		std::vector<float> centerY;
+		std::vector<float> centerZ;
+		std::vector<float> radius;
+		std::vector<float> extentX;
+		std::vector<float> extentY;
+		std::vector<float> extentZ;
+
+		[[nodiscard]]
+		SphereBoundsSoa getSpheres() const { return {centerX, centerY, centerZ, radius}; }
+
+		[[nodiscard]]
+		BoxBoundsSoa getBoxes() const { return {centerX, centerY, centerZ, extentX, extentY, extentZ}; }
+	};
+
+
+	SceneBounds generateBounds(size_t count)
+	{
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> positionDistribution(-SCENE_HALF_SIZE, SCENE_HALF_SIZE);
+		std::uniform_real_distribution<float> sizeDistribution(0.1f, 2.f);
+
+		SceneBounds bounds;
+		for (std::vector<float>* values : {&bounds.centerX, &bounds.centerY, &bounds.centerZ}) {
+			values->resize(count);
+			std::generate(values->begin(), values->end(), [&]() { return positionDistribution(random); });
+		}
+		for (std::vector<float>* values : {&bounds.radius, &bounds.extentX, &bounds.extentY, &bounds.extentZ}) {
+			values->resize(count);
+			std::generate(values->begin(), values->end(), [&]() { return sizeDistribution(random); });
+		}
+		return bounds;
+	}
+
+
+	std::vector<uint32_t> cullSpheresReference(const Frustum& frustum, const SphereBoundsSoa& bounds)
+	{
+		std::vector<uint32_t> visibleIndices;
+		for (size_t i = 0; i < bounds.size(); ++i) {
+			const glm::vec3 center(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+			if (frustum.isSphereVisible(center, bounds.radius[i])) {
+				visibleIndices.push_back((uint32_t) i);
+			}
+		}
+		return visibleIndices;
+	}
+
+
+	std::vector<uint32_t> cullBoxesReference(const Frustum& frustum, const BoxBoundsSoa& bounds)
+	{
+		std::vector<uint32_t> visibleIndices;
+		for (size_t i = 0; i < bounds.size(); ++i) {
+			const glm::vec3 center(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+			const glm::vec3 extents(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+			if (frustum.isBoxVisible(center, extents)) {
+				visibleIndices.push_back((uint32_t) i);
+			}
+		}
+		return visibleIndices;
+	}
+
+
+	bool isSameResult(std::span<const uint32_t> expected, std::span<const uint32_t> actual, size_t actualCount)
+	{
+		return expected.size() == actualCount && std::equal(expected.begin(), expected.end(), actual.begin());
+	}
+
+
+	void printResult(std::string_view label, double ms, double referenceMs, size_t count, bool isCorrect)
+	{
+		std::cout << "\t\t" << std::left << std::setw(16) << label << std::right
+				<< ms << " ms (" << count / ms / 1000.0 << " M/s)"
+				<< " speedup x" << referenceMs / ms
+				<< (isCorrect ? "" : " MISMATCH")
+				<< std::endl;
+	}
+
+
+	/**
+	 * Runs all kernels for one kind of bounds and compares their results with the reference.
+	 * @return The number of mismatches.
+	 */
+	template <typename Bounds, typename ReferenceFunc, typename CullFunc, typename ParallelCullFunc>
+	int runKernels(
+			std::string_view boundsName,
+			const Frustum& frustum,
+			const Bounds& bounds,
+			ReferenceFunc&& cullReference,
+			CullFunc&& cull,
+			ParallelCullFunc&& cullParallel
+	)
+	{
+		ThreadPool& threadPool = ThreadPool::getShared();
+		std::vector<uint32_t> visibleIndices(bounds.size());
+		int mismatchesCount = 0;
+
+		std::vector<uint32_t> expectedIndices;
+		const double referenceMs = Benchmark::measureMs(ITERATIONS, [&]() {
+			expectedIndices = cullReference(frustum, bounds);
+		});
+		std::cout << "\t\t" << boundsName << ": " << expectedIndices.size() << " visible\n";
+		printResult("reference", referenceMs, referenceMs, bounds.size(), true);
+
+		for (const Simd::Isa isa : ISAS) {
+			if (!Simd::isSupported(isa)) {
+				continue;
+			}
+
+			size_t visibleCount = 0;
+			const double ms = Benchmark::measureMs(ITERATIONS, [&]() {
+				visibleCount = cull(frustum, bounds, visibleIndices, isa);
+			});
+			const bool isCorrect = isSameResult(expectedIndices, visibleIndices, visibleCount);
+			mismatchesCount += !isCorrect;
+			printResult(Simd::getIsaName(isa), ms, referenceMs, bounds.size(), isCorrect);
+
+			std::fill(visibleIndices.begin(), visibleIndices.end(), 0);
+			const double parallelMs = Benchmark::measureMs(ITERATIONS, [&]() {
+				visibleCount = cullParallel(threadPool, frustum, bounds, visibleIndices, isa);
+			});
+			const bool isParallelCorrect = isSameResult(expectedIndices, visibleIndices, visibleCount);
+			mismatchesCount += !isParallelCorrect;
+			const std::string label = std::string(Simd::getIsaName(isa)) + " x" + std::to_string(threadPool.getThreadsCount());
+			printResult(label, parallelMs, referenceMs, bounds.size(), isParallelCorrect);
+		}
+
+		return mismatchesCount;
+	}
+}
+
+
+int Benchmark::runFrustumCullingBenchmark()
+{
+	const glm::mat4 view = glm::lookAt(glm::vec3(0.f, 0.f, 3.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+	const glm::mat4 projection = glm::perspective(glm::radians(45.f), 4.f / 3.f, 0.1f, 100.f);
+	const Frustum frustum = Frustum::fromViewProjection(projection * view);
+
+	std::cout << std::fixed << std::setprecision(3)
+			<< "\tBest instruction set: " << Simd::getIsaName(Simd::getBestIsa())
+			<< ", threads: " << ThreadPool::getShared().getThreadsCount() << std::endl;
+
+	int mismatchesCount = 0;
+	for (const size_t count : {100'000, 1'000'000, 4'000'000}) {
+		const SceneBounds bounds = generateBounds(count);
+		std::cout << "\t" << count << " bounds:" << std::endl;
+
+		mismatchesCount += runKernels("spheres", frustum, bounds.getSpheres(),
+				&cullSpheresReference, &FrustumCuller::cullSpheres, &FrustumCuller::cullSpheresParallel);
+		mismatchesCount += runKernels("boxes", frustum, bounds.getBoxes(),
+				&cullBoxesReference, &FrustumCuller::cullBoxes, &FrustumCuller::cullBoxesParallel);
+	}
+
+	if (mismatchesCount > 0) {
+		std::cerr << "[FrustumCullingBenchmark] " << mismatchesCount << " kernels differ from the reference." << std::endl;
+		return -1;
+	}
+	return 0;
+}
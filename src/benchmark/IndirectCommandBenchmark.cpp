@@ -0,0 +1,92 @@
+#include "Benchmark.hpp"
+
+#include "IndirectCommandBuilder.hpp"
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+	constexpr int ITERATIONS = 10;
+	constexpr size_t INSTANCES_COUNT = 1'000'000;
+
+
+	std::vector<MeshRange> generateMeshes(size_t count)
+	{
+		std::vector<MeshRange> meshes;
+		uint32_t firstIndex = 0;
+		int32_t baseVertex = 0;
+		for (size_t i = 0; i < count; ++i) {
+			const uint32_t indexCount = 36 + (uint32_t) (i % 16) * 6;
+			meshes.push_back({indexCount, firstIndex, baseVertex});
+			firstIndex += indexCount;
+			baseVertex += 24;
+		}
+		return meshes;
+	}
+
+
+	/**
+	 * Checks that every instance is drawn once, with its own mesh.
+	 */
+	bool isBuildCorrect(const IndirectCommandBuilder& builder, const std::vector<uint32_t>& instanceMeshes)
+	{
+		const std::span<const uint32_t> instanceOrder = builder.getInstanceOrder();
+		std::vector<bool> isDrawn(instanceMeshes.size(), false);
+		uint32_t expectedBaseInstance = 0;
+		for (const DrawElementsIndirectCommand& command : builder.getCommands()) {
+			if (command.baseInstance != expectedBaseInstance || command.instanceCount == 0) {
+				return false;
+			}
+			for (uint32_t i = command.baseInstance; i < command.baseInstance + command.instanceCount; ++i) {
+				const uint32_t instance = instanceOrder[i];
+				const MeshRange& mesh = builder.getMesh(instanceMeshes[instance]);
+				if (isDrawn[instance] || mesh.firstIndex != command.firstIndex || mesh.baseVertex != command.baseVertex) {
+					return false;
+				}
+				isDrawn[instance] = true;
+			}
+			expectedBaseInstance += command.instanceCount;
+		}
+		return expectedBaseInstance == instanceMeshes.size();
+	}
+}
+
+
+int Benchmark::runIndirectCommandBenchmark()
+{
+	std::mt19937 random(42);
+	bool isCorrect = true;
+
+	std::cout << std::fixed << std::setprecision(3);
+	for (const size_t meshesCount : {10, 1'000, 10'000}) {
+		IndirectCommandBuilder builder(generateMeshes(meshesCount));
+		std::uniform_int_distribution<uint32_t> meshDistribution(0, (uint32_t) meshesCount - 1);
+		std::vector<uint32_t> instanceMeshes(INSTANCES_COUNT);
+		for (uint32_t& mesh : instanceMeshes) {
+			mesh = meshDistribution(random);
+		}
+
+		const double buildMs = measureMs(ITERATIONS, [&]() {
+			builder.build(instanceMeshes);
+		});
+		const bool isMeshesCorrect = isBuildCorrect(builder, instanceMeshes);
+		isCorrect = isCorrect && isMeshesCorrect;
+
+		std::cout << "\t" << INSTANCES_COUNT << " instances of " << meshesCount << " meshes: build " << buildMs << " ms"
+				<< (isMeshesCorrect ? "" : " MISMATCH") << "\n"
+				<< "\t\tglDrawElements per instance:   " << INSTANCES_COUNT << " calls\n"
+				<< "\t\tglDrawElementsInstanced:       " << builder.getCommands().size() << " calls\n"
+				<< "\t\tglMultiDrawElementsIndirect:   1 call of " << builder.getCommands().size() << " commands"
+				<< std::endl;
+	}
+
+	if (!isCorrect) {
+		std::cerr << "[IndirectCommandBenchmark] The commands don't match the instances." << std::endl;
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,380 @@
+#include "Benchmark.hpp"
+
+#include "ThreadPool.hpp"
+#include "import/GltfImporter.hpp"
+#include "import/MeshImporter.hpp"
+#include "model/GeometricModelFactory.hpp"
+#include "model/MeshFile.hpp"
+#include "model/MeshOptimizer.hpp"
+#include "model/PackedModel.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace {
+	constexpr int ITERATIONS = 3;
+	// About 1M triangles.
+	constexpr int SEGMENTS_COUNT = 1024;
+	constexpr int RINGS_COUNT = 512;
+
+
+	void appendFloat(std::string& text, float value)
+	{
+		// The shortest text, which is read back to the same float.
+		char buffer[32];
+		const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		text.append(buffer, result.ptr);
+	}
+
+
+	void appendIndex(std::string& text, size_t value)
+	{
+		char buffer[32];
+		const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		text.append(buffer, result.ptr);
+	}
+
+
+	bool writeFile(const std::filesystem::path& filePath, const void* data, size_t size)
+	{
+		auto outputFile = std::ofstream(filePath, std::ios::binary | std::ios::trunc);
+		outputFile.write(static_cast<const char*>(data), (std::streamsize) size);
+		return outputFile.good();
+	}
+
+
+	/**
+	 * @brief Writes a v and a vt line per vertex, and the triangles as "f a/a b/b c/c".
+	 */
+	std::string writeObj(const GeometricModel& model)
+	{
+		std::string text = "# A generated sphere\no sphere\n";
+		for (const VertexFormat& vertex : model.getVertices()) {
+			text += "v ";
+			appendFloat(text, vertex.pos.x);
+			text += ' ';
+			appendFloat(text, vertex.pos.y);
+			text += ' ';
+			appendFloat(text, vertex.pos.z);
+			text += "\nvt ";
+			appendFloat(text, vertex.texCoords.u);
+			text += ' ';
+			appendFloat(text, vertex.texCoords.v);
+			text += '\n';
+		}
+		const std::vector<GeometricModel::IndexType>& indices = model.getIndices();
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			text += 'f';
+			for (size_t corner = 0; corner < 3; ++corner) {
+				text += ' ';
+				appendIndex(text, indices[i + corner] + 1);
+				text += '/';
+				appendIndex(text, indices[i + corner] + 1);
+			}
+			text += '\n';
+		}
+		return text;
+	}
+
+
+	/**
+	 * @brief Lays out the positions, the texture coordinates with v flipped down and the indices in a binary buffer,
+	 * and describes them in the JSON. The buffer has the URI for .gltf and none for the binary chunk of .glb.
+	 */
+	std::string writeGltfJson(const GeometricModel& model, const char* bufferUri, std::vector<std::byte>& outBuffer)
+	{
+		const size_t verticesCount = model.getVertices().size();
+		const size_t indicesCount = model.getIndices().size();
+		const size_t positionsSize = verticesCount * 3 * sizeof(float);
+		const size_t texCoordsSize = verticesCount * 2 * sizeof(float);
+		const size_t indicesSize = indicesCount * sizeof(uint32_t);
+		outBuffer.resize(positionsSize + texCoordsSize + indicesSize);
+
+		std::byte* positions = outBuffer.data();
+		std::byte* texCoords = positions + positionsSize;
+		for (size_t i = 0; i < verticesCount; ++i) {
+			const VertexFormat& vertex = model.getVertices()[i];
+			const float flippedTexCoords[2] = {vertex.texCoords.u, 1.f - vertex.texCoords.v};
+			std::memcpy(positions + i * 3 * sizeof(float), &vertex.pos, 3 * sizeof(float));
+			std::memcpy(texCoords + i * 2 * sizeof(float), flippedTexCoords, sizeof(flippedTexCoords));
+		}
+		std::memcpy(texCoords + texCoordsSize, model.getIndices().data(), indicesSize);
+
+		const std::string uri = (bufferUri != nullptr) ? std::string("\"uri\": \"") + bufferUri + "\", " : std::string();
+		return "{\n"
+				"\t\"asset\": {\"version\": \"2.0\", \"generator\": \"MeshImportBenchmark\"},\n"
+				"\t\"scene\": 0,\n"
+				"\t\"scenes\": [{\"nodes\": [0]}],\n"
+				"\t\"nodes\": [{\"name\": \"sphere\", \"mesh\": 0}],\n"
+				"\t\"meshes\": [{\"primitives\": [{\"attributes\": {\"POSITION\": 0, \"TEXCOORD_0\": 1}, \"indices\": 2, \"mode\": 4}]}],\n"
+				"\t\"accessors\": [\n"
+				"\t\t{\"bufferView\": 0, \"componentType\": 5126, \"count\": " + std::to_string(verticesCount) + ", \"type\": \"VEC3\"},\n"
+				"\t\t{\"bufferView\": 1, \"componentType\": 5126, \"count\": " + std::to_string(verticesCount) + ", \"type\": \"VEC2\"},\n"
+				"\t\t{\"bufferView\": 2, \"componentType\": 5125, \"count\": " + std::to_string(indicesCount) + ", \"type\": \"SCALAR\"}\n"
+				"\t],\n"
+				"\t\"bufferViews\": [\n"
+				"\t\t{\"buffer\": 0, \"byteOffset\": 0, \"byteLength\": " + std::to_string(positionsSize) + "},\n"
+				"\t\t{\"buffer\": 0, \"byteOffset\": " + std::to_string(positionsSize) + ", \"byteLength\": " + std::to_string(texCoordsSize) + "},\n"
+				"\t\t{\"buffer\": 0, \"byteOffset\": " + std::to_string(positionsSize + texCoordsSize) + ", \"byteLength\": " + std::to_string(indicesSize) + "}\n"
+				"\t],\n"
+				"\t\"buffers\": [{" + uri + "\"byteLength\": " + std::to_string(outBuffer.size()) + "}]\n"
+				"}\n";
+	}
+
+
+	std::vector<std::byte> writeGlb(std::string json, const std::vector<std::byte>& buffer)
+	{
+		// The chunks are 4-byte aligned: JSON is padded with spaces, the binary data with zeros.
+		json.resize((json.size() + 3) / 4 * 4, ' ');
+		const size_t binSize = (buffer.size() + 3) / 4 * 4;
+		const uint32_t header[5] = {
+				0x46546C67, 2, (uint32_t) (12 + 8 + json.size() + 8 + binSize),
+				(uint32_t) json.size(), 0x4E4F534A,
+		};
+		const uint32_t binHeader[2] = {(uint32_t) binSize, 0x004E4942};
+
+		std::vector<std::byte> data(header[2]);
+		std::byte* output = data.data();
+		std::memcpy(output, header, sizeof(header));
+		output += sizeof(header);
+		std::memcpy(output, json.data(), json.size());
+		output += json.size();
+		std::memcpy(output, binHeader, sizeof(binHeader));
+		output += sizeof(binHeader);
+		std::memcpy(output, buffer.data(), buffer.size());
+		return data;
+	}
+
+
+	bool isEqual(const GeometricModel& left, const GeometricModel& right)
+	{
+		return left.getVertices().size() == right.getVertices().size()
+				&& left.getIndices() == right.getIndices()
+				&& std::memcmp(left.getVertices().data(), right.getVertices().data(), left.getVertices().size() * sizeof(VertexFormat)) == 0;
+	}
+
+
+	/**
+	 * @return Whether the models of all thread counts are equal to the expected one.
+	 */
+	bool runFile(const char* label, const std::filesystem::path& filePath, const GeometricModel& expectedModel)
+	{
+		ThreadPool singleThreadPool(0);
+		ThreadPool& sharedPool = ThreadPool::getShared();
+		bool isCorrect = true;
+		for (ThreadPool* pool : {&singleThreadPool, &sharedPool}) {
+			std::optional<GeometricModel> model;
+			ImportStats stats;
+			const double importMs = Benchmark::measureMs(ITERATIONS, [&]() {
+				model = MeshImporter::importFile(filePath, *pool, &stats);
+			});
+			if (!model) {
+				return false;
+			}
+			std::cout << "\t\t" << label << ", " << pool->getThreadsCount() << " threads: " << importMs << " ms, "
+					<< (double) stats.bytesCount / (importMs / 1000.0) / 1e6 << " MB/s, "
+					<< (double) stats.trianglesCount / (importMs / 1000.0) / 1e6 << " M triangles/s"
+					<< " (parse " << stats.parseMs << " ms, weld " << stats.weldMs << " ms, "
+					<< stats.sourceVerticesCount << " -> " << stats.verticesCount << " vertices)" << std::endl;
+			isCorrect = isEqual(*model, expectedModel) && isCorrect;
+		}
+		return isCorrect;
+	}
+
+
+	/**
+	 * @brief Feeds GLB files with truncated data and lying lengths to the importer. They must be rejected
+	 * without reading past the data: the ASan builds catch the reads.
+	 * @return Whether all of them are rejected.
+	 */
+	bool rejectsMalformedGlb(const std::vector<std::byte>& glbData)
+	{
+		const auto setUint32 = [](std::vector<std::byte>& data, size_t offset, uint32_t value) {
+			std::memcpy(data.data() + offset, &value, sizeof(value));
+		};
+		uint32_t jsonLength = 0;
+		std::memcpy(&jsonLength, glbData.data() + 12, sizeof(jsonLength));
+
+		std::vector<std::vector<std::byte>> malformedFiles;
+		// The declared length is 0, and the JSON chunk claims more than the file has.
+		std::vector<std::byte>& zeroLength = malformedFiles.emplace_back(glbData.begin(), glbData.begin() + 51);
+		setUint32(zeroLength, 8, 0);
+		setUint32(zeroLength, 12, 100000);
+		// The declared length ends inside the JSON chunk.
+		std::vector<std::byte>& shortLength = malformedFiles.emplace_back(glbData);
+		setUint32(shortLength, 8, 24);
+		// The file is cut in the middle of the JSON chunk.
+		malformedFiles.emplace_back(glbData.begin(), glbData.begin() + 20 + jsonLength / 2);
+		// The binary chunk claims more than the file has.
+		std::vector<std::byte>& longBinary = malformedFiles.emplace_back(glbData);
+		setUint32(longBinary, 20 + jsonLength, (uint32_t) glbData.size());
+
+		std::cout << "\tMalformed GLB files, the errors are expected:" << std::endl;
+		ThreadPool singleThreadPool(0);
+		bool isCorrect = true;
+		for (const std::vector<std::byte>& data : malformedFiles) {
+			isCorrect = !GltfImporter::importGlb(data, {}, singleThreadPool).has_value() && isCorrect;
+		}
+		return isCorrect;
+	}
+
+
+	/**
+	 * @brief Stands for glBufferData: the driver copies the vertices and the indices from the given memory.
+	 */
+	struct UploadBuffers
+	{
+		std::vector<std::byte> vertices;
+		std::vector<std::byte> indices;
+
+		void upload(std::span<const std::byte> vertexData, std::span<const std::byte> indexData)
+		{
+			vertices.assign(vertexData.begin(), vertexData.end());
+			indices.assign(indexData.begin(), indexData.end());
+		}
+	};
+
+
+	std::span<const std::byte> getBytes(const PackedModel& model)
+	{
+		return {reinterpret_cast<const std::byte*>(model.getVertices().data()), model.getVerticesBytesCount()};
+	}
+
+
+	std::span<const std::byte> getBytes(const PackedIndices& indices)
+	{
+		return {static_cast<const std::byte*>(indices.getData()), indices.getBytesCount()};
+	}
+
+
+	/**
+	 * @brief Measures the way from a file to the uploaded half float vertices: the import and the packing of the sources
+	 * against the mapping of the mesh files.
+	 * @return Whether the data of the mesh files is the same, as the sphere in the encodings.
+	 */
+	bool runUploadReady(
+			const std::filesystem::path& objPath,
+			const std::filesystem::path& glbPath,
+			const std::filesystem::path& meshPath,
+			const std::filesystem::path& floatMeshPath,
+			const GeometricModel& sphere
+	)
+	{
+		ThreadPool& pool = ThreadPool::getShared();
+		bool isCorrect = true;
+		double sourceMs = 0.0;
+		UploadBuffers expectedBuffers;
+		const PackedModel expectedModel = PackedModel::pack(sphere, PackedModel::PositionEncoding::Half);
+		expectedBuffers.upload(getBytes(expectedModel), getBytes(expectedModel.getIndices()));
+
+		const auto printResult = [&](const char* label, double ms) {
+			std::cout << "\t\t" << label << ": " << ms << " ms";
+			if (sourceMs > 0.0) {
+				std::cout << ", " << sourceMs / ms << "x faster than OBJ";
+			}
+			std::cout << std::endl;
+		};
+
+		// The imported models are checked by runFile().
+		for (const auto& [label, filePath] : {std::pair("OBJ import + packing ", objPath), std::pair("GLB import + packing ", glbPath)}) {
+			UploadBuffers buffers;
+			const double loadMs = Benchmark::measureMs(ITERATIONS, [&]() {
+				const std::optional<GeometricModel> model = MeshImporter::importFile(filePath, pool);
+				if (model) {
+					const PackedModel packedModel = PackedModel::pack(*model, PackedModel::PositionEncoding::Half);
+					buffers.upload(getBytes(packedModel), getBytes(packedModel.getIndices()));
+				}
+			});
+			printResult(label, loadMs);
+			if (sourceMs == 0.0) {
+				sourceMs = loadMs;
+			}
+		}
+
+		for (const auto& [label, filePath] : {std::pair("mesh file, half      ", meshPath), std::pair("mesh file, float     ", floatMeshPath)}) {
+			UploadBuffers buffers;
+			const double loadMs = Benchmark::measureMs(ITERATIONS, [&]() {
+				const std::optional<MeshFile> meshFile = MeshFile::open(filePath);
+				if (meshFile) {
+					buffers.upload(meshFile->getVertexData(), meshFile->getIndexData());
+				}
+			});
+			printResult(label, loadMs);
+			if (filePath == meshPath) {
+				isCorrect = buffers.vertices == expectedBuffers.vertices && buffers.indices == expectedBuffers.indices && isCorrect;
+			} else {
+				isCorrect = buffers.vertices.size() == sphere.getVertices().size() * sizeof(VertexFormat)
+						&& std::memcmp(buffers.vertices.data(), sphere.getVertices().data(), buffers.vertices.size()) == 0
+						&& buffers.indices.size() == sphere.getIndices().size() * sizeof(GeometricModel::IndexType)
+						&& std::memcmp(buffers.indices.data(), sphere.getIndices().data(), buffers.indices.size()) == 0
+						&& isCorrect;
+			}
+		}
+		return isCorrect;
+	}
+}
+
+
+int Benchmark::runMeshImportBenchmark()
+{
+	std::cout << std::fixed << std::setprecision(3);
+	const GeometricModel sphere = GeometricModelFactory::createSphereModel(SEGMENTS_COUNT, RINGS_COUNT);
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path();
+	const std::filesystem::path objPath = directory / "mesh-import-benchmark.obj";
+	const std::filesystem::path gltfPath = directory / "mesh-import-benchmark.gltf";
+	const std::filesystem::path binPath = directory / "mesh-import-benchmark.bin";
+	const std::filesystem::path glbPath = directory / "mesh-import-benchmark.glb";
+	const std::filesystem::path meshPath = directory / "mesh-import-benchmark.mesh";
+	const std::filesystem::path floatMeshPath = directory / "mesh-import-benchmark-float.mesh";
+
+	const std::string objText = writeObj(sphere);
+	std::vector<std::byte> buffer;
+	const std::string gltfJson = writeGltfJson(sphere, "mesh-import-benchmark.bin", buffer);
+	const std::vector<std::byte> glbData = writeGlb(writeGltfJson(sphere, nullptr, buffer), buffer);
+	if (!writeFile(objPath, objText.data(), objText.size()) || !writeFile(gltfPath, gltfJson.data(), gltfJson.size())
+			|| !writeFile(binPath, buffer.data(), buffer.size()) || !writeFile(glbPath, glbData.data(), glbData.size())
+			|| !MeshFile::write(meshPath, sphere, PackedModel::PositionEncoding::Half)
+			|| !MeshFile::write(floatMeshPath, sphere, std::nullopt)) {
+		std::cerr << "[MeshImportBenchmark] Can't write the files to " << directory << "." << std::endl;
+		return -1;
+	}
+
+	// OBJ welds the corners in the order of the first use. glTF keeps the vertices, and v is flipped there and back.
+	const GeometricModel expectedObjModel = MeshOptimizer::optimizeVertexFetch(sphere.getVertices(), sphere.getIndices());
+	std::vector<VertexFormat> gltfVertices = sphere.getVertices();
+	for (VertexFormat& vertex : gltfVertices) {
+		vertex.texCoords.v = 1.f - (1.f - vertex.texCoords.v);
+	}
+	const GeometricModel expectedGltfModel(std::move(gltfVertices), sphere.getIndices());
+
+	std::cout << "\tSphere, " << sphere.getVertices().size() << " vertices, " << sphere.getIndices().size() / 3
+			<< " triangles, the files are in the page cache:\n";
+	bool isCorrect = runFile("OBJ  ", objPath, expectedObjModel);
+	isCorrect = runFile("glTF ", gltfPath, expectedGltfModel) && isCorrect;
+	isCorrect = runFile("GLB  ", glbPath, expectedGltfModel) && isCorrect;
+	isCorrect = rejectsMalformedGlb(glbData) && isCorrect;
+	std::cout << "\tLoading to the upload buffers (packed half vertices, unless float), " << ThreadPool::getShared().getThreadsCount() << " threads:\n";
+	isCorrect = runUploadReady(objPath, glbPath, meshPath, floatMeshPath, sphere) && isCorrect;
+
+	std::error_code error;
+	for (const std::filesystem::path& filePath : {objPath, gltfPath, binPath, glbPath, meshPath, floatMeshPath}) {
+		std::filesystem::remove(filePath, error);
+	}
+
+	if (!isCorrect) {
+		std::cerr << "[MeshImportBenchmark] The imported meshes differ from the source or between the threads counts." << std::endl;
+		return -1;
+	}
+	return 0;
+}
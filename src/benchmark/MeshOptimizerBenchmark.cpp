@@ -0,0 +1,184 @@
+#include "Benchmark.hpp"
+
+#include "ThreadPool.hpp"
+#include "model/GeometricModelFactory.hpp"
+#include "model/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+	constexpr int ITERATIONS = 3;
+	constexpr size_t SMALL_MESHES_COUNT = 1000;
+
+
+	/**
+	 * @brief Shuffles the triangles and the vertices, like in a mesh, which was edited and exported without any care.
+	 */
+	GeometricModel shuffle(const GeometricModel& model, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		const std::vector<VertexFormat>& vertices = model.getVertices();
+		const std::vector<GeometricModel::IndexType>& indices = model.getIndices();
+
+		std::vector<uint32_t> vertexOrder(vertices.size());
+		for (size_t i = 0; i < vertexOrder.size(); ++i) {
+			vertexOrder[i] = (uint32_t) i;
+		}
+		std::shuffle(vertexOrder.begin(), vertexOrder.end(), random);
+		std::vector<VertexFormat> shuffledVertices(vertices.size());
+		std::vector<uint32_t> remap(vertices.size());
+		for (size_t i = 0; i < vertexOrder.size(); ++i) {
+			shuffledVertices[i] = vertices[vertexOrder[i]];
+			remap[vertexOrder[i]] = (uint32_t) i;
+		}
+
+		std::vector<uint32_t> triangleOrder(indices.size() / 3);
+		for (size_t i = 0; i < triangleOrder.size(); ++i) {
+			triangleOrder[i] = (uint32_t) i;
+		}
+		std::shuffle(triangleOrder.begin(), triangleOrder.end(), random);
+		std::vector<GeometricModel::IndexType> shuffledIndices;
+		shuffledIndices.reserve(indices.size());
+		for (const uint32_t triangle : triangleOrder) {
+			for (size_t corner = 0; corner < 3; ++corner) {
+				shuffledIndices.push_back(remap[indices[triangle * 3 + corner]]);
+			}
+		}
+		return GeometricModel(std::move(shuffledVertices), std::move(shuffledIndices));
+	}
+
+
+	using TriangleVertices = std::array<VertexFormat, 3>;
+
+
+	/**
+	 * @brief Checks that the models have the same triangles with the same windings, whatever the order is.
+	 */
+	bool hasSameTriangles(const GeometricModel& left, const GeometricModel& right)
+	{
+		const auto collectTriangles = [](const GeometricModel& model) {
+			std::vector<TriangleVertices> triangles(model.getIndices().size() / 3);
+			for (size_t i = 0; i < triangles.size(); ++i) {
+				for (size_t corner = 0; corner < 3; ++corner) {
+					triangles[i][corner] = model.getVertices()[model.getIndices()[i * 3 + corner]];
+				}
+			}
+			std::sort(triangles.begin(), triangles.end(), [](const TriangleVertices& a, const TriangleVertices& b) {
+				return std::memcmp(a.data(), b.data(), sizeof(TriangleVertices)) < 0;
+			});
+			return triangles;
+		};
+		const std::vector<TriangleVertices> leftTriangles = collectTriangles(left);
+		const std::vector<TriangleVertices> rightTriangles = collectTriangles(right);
+		return leftTriangles.size() == rightTriangles.size()
+				&& std::memcmp(leftTriangles.data(), rightTriangles.data(), leftTriangles.size() * sizeof(TriangleVertices)) == 0;
+	}
+
+
+	bool isEqual(const GeometricModel& left, const GeometricModel& right)
+	{
+		return left.getVertices().size() == right.getVertices().size()
+				&& left.getIndices() == right.getIndices()
+				&& std::memcmp(left.getVertices().data(), right.getVertices().data(), left.getVertices().size() * sizeof(VertexFormat)) == 0;
+	}
+
+
+	void printStats(const char* label, const GeometricModel& model)
+	{
+		const std::vector<GeometricModel::IndexType>& indices = model.getIndices();
+		const size_t verticesCount = model.getVertices().size();
+		const MeshOptimizer::VertexCacheStats stats16 = MeshOptimizer::analyzeVertexCache(indices, verticesCount, 16);
+		const MeshOptimizer::VertexCacheStats stats32 = MeshOptimizer::analyzeVertexCache(indices, verticesCount, 32);
+		const double overfetch = MeshOptimizer::analyzeVertexFetch(indices, verticesCount, sizeof(VertexFormat));
+		std::cout << "\t\t\t" << label << ": ACMR " << stats16.acmr << " / " << stats32.acmr
+				<< ", ATVR " << stats16.atvr << " / " << stats32.atvr
+				<< ", overfetch " << overfetch << std::endl;
+	}
+
+
+	/**
+	 * @return Whether the optimized models keep the triangles.
+	 */
+	bool runModel(const char* label, const GeometricModel& model)
+	{
+		const size_t trianglesCount = model.getIndices().size() / 3;
+		std::cout << "\t\t" << label << ", " << model.getVertices().size() << " vertices, " << trianglesCount << " triangles"
+				<< " (ACMR and ATVR for 16 / 32 cache entries):\n";
+		printStats("source            ", model);
+
+		bool isCorrect = true;
+		for (const bool isOverdrawOptimized : {false, true}) {
+			MeshOptimizationOptions options;
+			options.isOverdrawOptimized = isOverdrawOptimized;
+			GeometricModel optimizedModel({}, {});
+			const double optimizeMs = Benchmark::measureMs(ITERATIONS, [&]() {
+				optimizedModel = MeshOptimizer::optimize(model, options);
+			});
+			printStats(isOverdrawOptimized ? "cache + overdraw  " : "cache             ", optimizedModel);
+			std::cout << "\t\t\t\t" << optimizeMs << " ms, " << (double) trianglesCount / (optimizeMs / 1000.0) / 1e6
+					<< " M triangles/s" << std::endl;
+			isCorrect = hasSameTriangles(model, optimizedModel) && isCorrect;
+		}
+		return isCorrect;
+	}
+}
+
+
+int Benchmark::runMeshOptimizerBenchmark()
+{
+	bool isCorrect = true;
+	std::cout << std::fixed << std::setprecision(3);
+
+	std::cout << "\tSingle meshes:\n";
+	const GeometricModel sphere = GeometricModelFactory::createSphereModel(512, 256);
+	isCorrect = runModel("sphere, rings order", sphere) && isCorrect;
+	isCorrect = runModel("sphere, shuffled   ", shuffle(sphere, 42)) && isCorrect;
+
+	// The import of a scene: many small meshes of different sizes.
+	std::vector<GeometricModel> models;
+	size_t trianglesCount = 0;
+	std::mt19937 random(7);
+	std::uniform_int_distribution<int> segmentsDistribution(8, 96);
+	for (size_t i = 0; i < SMALL_MESHES_COUNT; ++i) {
+		const int segmentsCount = segmentsDistribution(random);
+		models.push_back(shuffle(GeometricModelFactory::createSphereModel(segmentsCount, segmentsCount / 2), (uint32_t) i));
+		trianglesCount += models.back().getIndices().size() / 3;
+	}
+
+	ThreadPool singleThreadPool(0);
+	ThreadPool& sharedPool = ThreadPool::getShared();
+	MeshOptimizationOptions options;
+	options.isOverdrawOptimized = true;
+	std::cout << "\t" << SMALL_MESHES_COUNT << " shuffled meshes, " << trianglesCount << " triangles, cache + overdraw:\n";
+	std::vector<GeometricModel> referenceModels;
+	for (ThreadPool* pool : {&singleThreadPool, &sharedPool}) {
+		std::vector<GeometricModel> optimizedModels;
+		const double optimizeMs = Benchmark::measureMs(ITERATIONS, [&]() {
+			optimizedModels = MeshOptimizer::optimizeAll(*pool, models, options);
+		});
+		std::cout << "\t\t" << pool->getThreadsCount() << " threads: " << optimizeMs << " ms, "
+				<< (double) trianglesCount / (optimizeMs / 1000.0) / 1e6 << " M triangles/s" << std::endl;
+
+		// The threads don't change the results.
+		if (referenceModels.empty()) {
+			referenceModels = std::move(optimizedModels);
+			continue;
+		}
+		for (size_t i = 0; i < models.size(); ++i) {
+			isCorrect = isEqual(referenceModels[i], optimizedModels[i]) && isCorrect;
+		}
+	}
+
+	if (!isCorrect) {
+		std::cerr << "[MeshOptimizerBenchmark] The optimized meshes differ from the source or between the threads counts." << std::endl;
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,179 @@
+#include "Benchmark.hpp"
+
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+#include "culling/Frustum.hpp"
+#include "culling/FrustumCuller.hpp"
+#include "culling/OcclusionCuller.hpp"
+#include "model/GeometricModelFactory.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+
+namespace {
+	constexpr int ITERATIONS = 20;
+	// A quarter of the window size in each dimension.
+	constexpr int DEPTH_WIDTH = 256;
+	constexpr int DEPTH_HEIGHT = 182;
+
+	// A city of blocks with streets between them. The camera stands on a street, so the nearest blocks hide most of the city.
+	constexpr int BLOCKS_PER_SIDE = 16;
+	constexpr float BLOCK_STEP = 12.f;
+	constexpr float BLOCK_HALF_SIZE = 4.f;
+	constexpr float CITY_HALF_SIZE = BLOCKS_PER_SIDE * BLOCK_STEP * 0.5f;
+
+
+	struct City
+	{
+		GeometricModel block = GeometricModelFactory::createCubeModel();
+		std::vector<glm::mat4> blockMatrices;
+
+		std::vector<float> centerX;
+		std::vector<float> centerY;
+		std::vector<float> centerZ;
+		std::vector<float> radius;
+
+		[[nodiscard]]
+		SphereBoundsSoa getSpheres() const { return {centerX, centerY, centerZ, radius}; }
+	};
+
+
+	City generateCity(size_t candidatesCount)
+	{
+		City city;
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> heightDistribution(5.f, 30.f);
+		for (int x = 0; x < BLOCKS_PER_SIDE; ++x) {
+			for (int z = 0; z < BLOCKS_PER_SIDE; ++z) {
+				const float halfHeight = heightDistribution(random);
+				const glm::vec3 center(
+						-CITY_HALF_SIZE + ((float) x + 0.5f) * BLOCK_STEP,
+						halfHeight,
+						-((float) z + 0.5f) * BLOCK_STEP
+				);
+				// The cube vertices are in [-1, 1].
+				const glm::mat4 model = glm::translate(glm::mat4(1.f), center);
+				city.blockMatrices.push_back(glm::scale(model, glm::vec3(BLOCK_HALF_SIZE, halfHeight, BLOCK_HALF_SIZE)));
+			}
+		}
+
+		// Props on the streets and on the roofs all over the city.
+		std::uniform_real_distribution<float> xDistribution(-CITY_HALF_SIZE, CITY_HALF_SIZE);
+		std::uniform_real_distribution<float> yDistribution(0.f, 40.f);
+		std::uniform_real_distribution<float> zDistribution(-2.f * CITY_HALF_SIZE, 0.f);
+		std::uniform_real_distribution<float> radiusDistribution(0.2f, 1.5f);
+		for (size_t i = 0; i < candidatesCount; ++i) {
+			city.centerX.push_back(xDistribution(random));
+			city.centerY.push_back(yDistribution(random));
+			city.centerZ.push_back(zDistribution(random));
+			city.radius.push_back(radiusDistribution(random));
+		}
+		return city;
+	}
+
+
+	void printResult(std::string_view label, double ms, size_t count, bool isCorrect)
+	{
+		std::cout << "\t\t" << std::left << std::setw(16) << label << std::right
+				<< ms << " ms (" << count / ms / 1000.0 << " M/s)"
+				<< (isCorrect ? "" : " MISMATCH")
+				<< std::endl;
+	}
+}
+
+
+int Benchmark::runOcclusionCullingBenchmark()
+{
+	ThreadPool singleThreadPool(0);
+	ThreadPool& sharedPool = ThreadPool::getShared();
+	const std::string allThreadsLabel = " x" + std::to_string(sharedPool.getThreadsCount());
+
+	const glm::mat4 view = glm::lookAt(glm::vec3(0.f, 1.7f, 4.f), glm::vec3(0.f, 1.7f, -10.f), glm::vec3(0.f, 1.f, 0.f));
+	const glm::mat4 projection = glm::perspective(glm::radians(60.f), 1024.f / 728.f, 0.1f, 500.f);
+	const glm::mat4 viewProjection = projection * view;
+	const Frustum frustum = Frustum::fromViewProjection(viewProjection);
+
+	std::cout << std::fixed << std::setprecision(3)
+			<< "\tBest instruction set: " << Simd::getIsaName(Simd::getBestIsa())
+			<< ", threads: " << sharedPool.getThreadsCount()
+			<< ", depth buffer: " << DEPTH_WIDTH << "x" << DEPTH_HEIGHT << std::endl;
+
+	int mismatchesCount = 0;
+	for (const size_t count : {100'000, 1'000'000}) {
+		const City city = generateCity(count);
+		const SphereBoundsSoa bounds = city.getSpheres();
+
+		std::vector<uint32_t> frustumIndices(count);
+		frustumIndices.resize(FrustumCuller::cullSpheresParallel(sharedPool, frustum, bounds, frustumIndices));
+
+		OcclusionCuller culler(DEPTH_WIDTH, DEPTH_HEIGHT);
+		const auto rasterizeCity = [&](ThreadPool& pool) {
+			culler.beginFrame(viewProjection);
+			for (const glm::mat4& blockMatrix : city.blockMatrices) {
+				culler.addOccluder(city.block, blockMatrix);
+			}
+			return culler.rasterizeOccluders(pool);
+		};
+
+		OcclusionCuller::Stats stats;
+		const double rasterMs = Benchmark::measureMs(ITERATIONS, [&]() { stats = rasterizeCity(singleThreadPool); });
+		const double parallelRasterMs = Benchmark::measureMs(ITERATIONS, [&]() { stats = rasterizeCity(sharedPool); });
+		std::cout << "\t" << count << " candidates, " << frustumIndices.size() << " in the frustum, "
+				<< city.blockMatrices.size() << " occluders (" << stats.occluderTrianglesCount << " triangles, "
+				<< stats.rasterizedTrianglesCount << " rasterized):\n"
+				<< "\t\tocclusion raster: " << rasterMs << " ms, " << parallelRasterMs << " ms" << allThreadsLabel
+				<< " (pyramid " << stats.pyramidMs << " ms, " << culler.getLevelsCount() << " levels)\n";
+
+		// The scalar single thread result is the reference: the others must be equal to it.
+		std::vector<uint32_t> expectedIndices(frustumIndices.size());
+		size_t expectedCount = 0;
+		const double referenceMs = Benchmark::measureMs(ITERATIONS, [&]() {
+			expectedCount = culler.cullSpheres(bounds, frustumIndices, expectedIndices, Simd::Isa::Scalar);
+		});
+		expectedIndices.resize(expectedCount);
+		std::cout << "\t\t" << expectedCount << " visible, "
+				<< 100.0 * (1.0 - (double) expectedCount / (double) frustumIndices.size()) << "% of the frustum culled\n";
+		printResult("Scalar", referenceMs, frustumIndices.size(), true);
+
+		const Simd::Isa bestIsa = Simd::getBestIsa();
+		std::vector<uint32_t> visibleIndices(frustumIndices.size());
+		for (ThreadPool* pool : {&singleThreadPool, &sharedPool}) {
+			size_t visibleCount = 0;
+			const double ms = Benchmark::measureMs(ITERATIONS, [&]() {
+				visibleCount = culler.cullSpheresParallel(*pool, bounds, frustumIndices, visibleIndices, bestIsa);
+			});
+			const bool isCorrect = (visibleCount == expectedCount)
+					&& std::equal(expectedIndices.begin(), expectedIndices.end(), visibleIndices.begin());
+			mismatchesCount += !isCorrect;
+			const std::string label = std::string(Simd::getIsaName(bestIsa)) + ((pool == &sharedPool) ? allThreadsLabel : "");
+			printResult(label, ms, frustumIndices.size(), isCorrect);
+		}
+
+		// The main loop culls the indices in place.
+		std::vector<uint32_t> inPlaceIndices = frustumIndices;
+		const size_t inPlaceCount = culler.cullSpheresParallel(sharedPool, bounds, inPlaceIndices, inPlaceIndices);
+		const bool isInPlaceCorrect = (inPlaceCount == expectedCount)
+				&& std::equal(expectedIndices.begin(), expectedIndices.end(), inPlaceIndices.begin());
+		mismatchesCount += !isInPlaceCorrect;
+		if (!isInPlaceCorrect) {
+			std::cout << "\t\tin place: MISMATCH" << std::endl;
+		}
+	}
+
+	if (mismatchesCount > 0) {
+		std::cerr << "[OcclusionCullingBenchmark] " << mismatchesCount << " kernels differ from the scalar one." << std::endl;
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,166 @@
+#include "Benchmark.hpp"
+
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+
+namespace {
+	constexpr int ITERATIONS = 5;
+	constexpr size_t ITEMS_COUNT = 1'000'000;
+	constexpr uint32_t SHADERS_COUNT = 64;
+	constexpr uint32_t MATERIALS_COUNT = 512;
+	constexpr uint32_t VERTEX_ARRAYS_COUNT = 256;
+	// Every draw is an instance of one of the object kinds, which fix the shader, the material and the mesh.
+	constexpr size_t OBJECT_KINDS_COUNT = 2000;
+	constexpr float TRANSLUCENT_SHARE = 0.1f;
+
+
+	struct Draw
+	{
+		uint32_t pass = 0;
+		bool isTranslucent = false;
+		uint32_t shader = 0;
+		uint32_t material = 0;
+		uint32_t vertexArray = 0;
+		float depth01 = 0.f;
+	};
+
+
+	std::vector<Draw> generateDraws()
+	{
+		std::mt19937 random(42);
+		std::uniform_int_distribution<uint32_t> passDistribution(0, 1);
+		std::uniform_int_distribution<uint32_t> shaderDistribution(0, SHADERS_COUNT - 1);
+		std::uniform_int_distribution<uint32_t> materialDistribution(0, MATERIALS_COUNT - 1);
+		std::uniform_int_distribution<uint32_t> vertexArrayDistribution(0, VERTEX_ARRAYS_COUNT - 1);
+		std::uniform_real_distribution<float> unitDistribution(0.f, 1.f);
+
+		std::vector<Draw> objectKinds(OBJECT_KINDS_COUNT);
+		for (Draw& kind : objectKinds) {
+			kind.pass = passDistribution(random);
+			kind.isTranslucent = unitDistribution(random) < TRANSLUCENT_SHARE;
+			kind.shader = shaderDistribution(random);
+			kind.material = materialDistribution(random);
+			kind.vertexArray = vertexArrayDistribution(random);
+		}
+
+		std::uniform_int_distribution<size_t> kindDistribution(0, OBJECT_KINDS_COUNT - 1);
+		std::vector<Draw> draws(ITEMS_COUNT);
+		for (Draw& draw : draws) {
+			draw = objectKinds[kindDistribution(random)];
+			draw.depth01 = unitDistribution(random);
+		}
+		return draws;
+	}
+
+
+	void fillQueue(RenderQueue& queue, const std::vector<Draw>& draws)
+	{
+		queue.clear();
+		for (uint32_t i = 0; i < (uint32_t) draws.size(); ++i) {
+			const Draw& draw = draws[i];
+			const uint64_t key = draw.isTranslucent
+					? RenderSortKey::makeTranslucent(draw.pass, draw.shader, draw.material, draw.vertexArray, draw.depth01)
+					: RenderSortKey::makeOpaque(draw.pass, draw.shader, draw.material, draw.vertexArray, draw.depth01);
+			queue.push(key, i);
+		}
+	}
+
+
+	// Counts the calls only: the benchmark measures the walk itself.
+	struct CountingVisitor
+	{
+		size_t drawnItemsCount = 0;
+
+		void beginPass(uint32_t, bool) {}
+
+		void bindShader(uint32_t) {}
+
+		void bindMaterial(uint32_t) {}
+
+		void bindVertexArray(uint32_t) {}
+
+		void draw(std::span<const RenderQueue::Item> items) { drawnItemsCount += items.size(); }
+	};
+
+
+	void printStats(const char* label, const RenderQueue::Stats& stats)
+	{
+		std::cout << "\t" << label << ": "
+				<< stats.drawsCount << " draws, "
+				<< stats.passChanges << " pass, "
+				<< stats.shaderChanges << " shader, "
+				<< stats.materialChanges << " material, "
+				<< stats.vertexArrayChanges << " vertex array changes"
+				<< std::endl;
+	}
+}
+
+
+int Benchmark::runRenderQueueBenchmark()
+{
+	const std::vector<Draw> draws = generateDraws();
+	RenderQueue queue;
+	queue.reserve(ITEMS_COUNT);
+
+	const double fillMs = measureMs(ITERATIONS, [&]() {
+		fillQueue(queue, draws);
+	});
+
+	CountingVisitor unsortedVisitor;
+	const RenderQueue::Stats unsortedStats = queue.submit(unsortedVisitor);
+
+	// std::stable_sort is the reference: the radix sort is stable too, so the results must be equal.
+	std::vector<RenderQueue::Item> expectedItems;
+	const double stableSortMs = measureMs(ITERATIONS, [&]() {
+		expectedItems.assign(queue.getItems().begin(), queue.getItems().end());
+		std::stable_sort(expectedItems.begin(), expectedItems.end(), [](const auto& a, const auto& b) {
+			return a.key < b.key;
+		});
+	});
+
+	double radixSortMs = 0.0;
+	for (int i = 0; i < ITERATIONS; ++i) {
+		fillQueue(queue, draws);
+		radixSortMs += measureMs(1, [&]() {
+			queue.sort();
+		});
+	}
+	radixSortMs /= ITERATIONS;
+
+	const std::span<const RenderQueue::Item> items = queue.getItems();
+	const bool isSortCorrect = std::equal(items.begin(), items.end(), expectedItems.begin(), expectedItems.end(),
+			[](const auto& a, const auto& b) { return a.key == b.key && a.payload == b.payload; });
+
+	CountingVisitor sortedVisitor;
+	RenderQueue::Stats sortedStats;
+	const double submitMs = measureMs(ITERATIONS, [&]() {
+		sortedVisitor = {};
+		sortedStats = queue.submit(sortedVisitor);
+	});
+	doNotOptimize(sortedVisitor.drawnItemsCount);
+
+	std::cout << std::fixed << std::setprecision(3)
+			<< "\t" << ITEMS_COUNT << " items, " << SHADERS_COUNT << " shaders, " << MATERIALS_COUNT << " materials, "
+			<< VERTEX_ARRAYS_COUNT << " vertex arrays, " << OBJECT_KINDS_COUNT << " object kinds, " << TRANSLUCENT_SHARE * 100.f << "% translucent\n"
+			<< "\tfill keys:   " << fillMs << " ms\n"
+			<< "\tstable_sort: " << stableSortMs << " ms\n"
+			<< "\tradix sort:  " << radixSortMs << " ms, speedup x" << stableSortMs / radixSortMs
+			<< (isSortCorrect ? "" : " MISMATCH") << "\n"
+			<< "\tsubmit walk: " << submitMs << " ms" << std::endl;
+	printStats("unsorted", unsortedStats);
+	printStats("sorted  ", sortedStats);
+
+	if (!isSortCorrect || sortedVisitor.drawnItemsCount != ITEMS_COUNT) {
+		std::cerr << "[RenderQueueBenchmark] The radix sort differs from std::stable_sort." << std::endl;
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,152 @@
+#include "Benchmark.hpp"
+
+#include "ThreadPool.hpp"
+#include "model/GeometricModelFactory.hpp"
+#include "raster/SoftwareRasterizer.hpp"
+#include "raster/SoftwareTexture.hpp"
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/mat4x4.hpp>
+
+
+namespace {
+	constexpr int ITERATIONS = 3;
+	constexpr int WIDTH = 1024;
+	constexpr int HEIGHT = 728;
+	constexpr int TEXTURE_SIZE = 256;
+	constexpr float CUBE_SCALE = 0.28f;
+
+
+	struct Scene
+	{
+		GeometricModel cube = GeometricModelFactory::createCubeModel();
+		std::vector<glm::mat4> modelMatrices;
+		glm::mat4 viewProjection = glm::mat4(1.f);
+		SoftwareTexture texture0;
+		SoftwareTexture texture1;
+	};
+
+
+	// An opaque checker board and a translucent disk, like the wall and the face textures of the main scene.
+	void generateTextures(Scene& scene)
+	{
+		std::vector<uint8_t> rgb(TEXTURE_SIZE * TEXTURE_SIZE * 3);
+		std::vector<uint8_t> rgba(TEXTURE_SIZE * TEXTURE_SIZE * 4);
+		for (int y = 0; y < TEXTURE_SIZE; ++y) {
+			for (int x = 0; x < TEXTURE_SIZE; ++x) {
+				const int i = y * TEXTURE_SIZE + x;
+				const bool isDark = ((x / 32) + (y / 32)) % 2 == 0;
+				rgb[i * 3] = isDark ? 90 : 200;
+				rgb[i * 3 + 1] = isDark ? 60 : 170;
+				rgb[i * 3 + 2] = isDark ? 50 : 150;
+
+				const int dx = x - TEXTURE_SIZE / 2;
+				const int dy = y - TEXTURE_SIZE / 2;
+				const bool isDisk = dx * dx + dy * dy < (TEXTURE_SIZE * TEXTURE_SIZE) / 9;
+				rgba[i * 4] = 250;
+				rgba[i * 4 + 1] = 220;
+				rgba[i * 4 + 2] = (uint8_t) x;
+				rgba[i * 4 + 3] = isDisk ? 255 : 0;
+			}
+		}
+		scene.texture0 = SoftwareTexture(TEXTURE_SIZE, TEXTURE_SIZE, 3, rgb.data());
+		scene.texture1 = SoftwareTexture(TEXTURE_SIZE, TEXTURE_SIZE, 4, rgba.data());
+	}
+
+
+	// Cubes in front of the camera. The nearest ones cross the near plane, so the clipping is exercised too.
+	Scene generateScene(size_t cubesCount)
+	{
+		Scene scene;
+		generateTextures(scene);
+
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> xyDistribution(-12.f, 12.f);
+		std::uniform_real_distribution<float> zDistribution(-50.f, 0.3f);
+		std::uniform_real_distribution<float> angleDistribution(0.f, 6.28f);
+		scene.modelMatrices.reserve(cubesCount);
+		for (size_t i = 0; i < cubesCount; ++i) {
+			const glm::vec3 position(xyDistribution(random), xyDistribution(random), zDistribution(random));
+			const glm::vec3 axis = glm::normalize(glm::vec3(0.3f, 1.f, 0.2f));
+			glm::mat4 model = glm::translate(glm::mat4(1.f), position);
+			model = glm::rotate(model, angleDistribution(random), axis);
+			scene.modelMatrices.push_back(glm::scale(model, glm::vec3(CUBE_SCALE)));
+		}
+
+		const glm::mat4 projection = glm::perspective(glm::radians(45.f), (float) WIDTH / (float) HEIGHT, 0.1f, 100.f);
+		const glm::mat4 view = glm::lookAt(glm::vec3(0.f, 0.f, 3.f), glm::vec3(0.f, 0.f, -10.f), glm::vec3(0.f, 1.f, 0.f));
+		scene.viewProjection = projection * view;
+		return scene;
+	}
+
+
+	SoftwareRasterizer::Stats renderScene(const Scene& scene, SoftwareRasterizer& rasterizer, ThreadPool& pool, Simd::Isa isa)
+	{
+		rasterizer.clear(glm::vec4(0.7f, 0.7f, 0.8f, 1.f));
+		rasterizer.drawTexturedInstances(scene.cube, scene.modelMatrices, scene.viewProjection, scene.texture0, scene.texture1);
+		return rasterizer.flush(pool, isa);
+	}
+
+
+	/**
+	 * @return Whether the image equals the reference one.
+	 */
+	bool runVariant(const char* label, const Scene& scene, ThreadPool& pool, Simd::Isa isa, const std::vector<uint8_t>& referencePixels)
+	{
+		SoftwareRasterizer rasterizer(WIDTH, HEIGHT);
+		SoftwareRasterizer::Stats stats;
+		const double frameMs = Benchmark::measureMs(ITERATIONS, [&]() {
+			stats = renderScene(scene, rasterizer, pool, isa);
+		});
+		const bool isEqual = (rasterizer.readPixels() == referencePixels);
+
+		const double frameSeconds = frameMs / 1000.0;
+		std::cout << "\t\t" << label << ": " << frameMs << " ms"
+				<< " (vertex " << stats.vertexMs << ", setup " << stats.setupMs << ", raster " << stats.rasterMs << ")"
+				<< ", " << (double) stats.trianglesCount / frameSeconds / 1e6 << " M triangles/s"
+				<< ", " << (double) stats.shadedPixelsCount / frameSeconds / 1e6 << " M pixels/s"
+				<< (isEqual ? "" : " MISMATCH")
+				<< std::endl;
+		return isEqual;
+	}
+}
+
+
+int Benchmark::runSoftwareRasterizerBenchmark()
+{
+	ThreadPool singleThreadPool(0);
+	ThreadPool& sharedPool = ThreadPool::getShared();
+	const Simd::Isa bestIsa = Simd::getBestIsa();
+
+	bool isCorrect = true;
+	std::cout << std::fixed << std::setprecision(3);
+	for (const size_t cubesCount : {1'000, 10'000, 100'000}) {
+		const Scene scene = generateScene(cubesCount);
+
+		// The scalar single thread image is the reference: the others must be equal to it bit for bit.
+		SoftwareRasterizer referenceRasterizer(WIDTH, HEIGHT);
+		const SoftwareRasterizer::Stats referenceStats = renderScene(scene, referenceRasterizer, singleThreadPool, Simd::Isa::Scalar);
+		const std::vector<uint8_t> referencePixels = referenceRasterizer.readPixels();
+
+		std::cout << "\t" << cubesCount << " cubes, " << referenceStats.trianglesCount << " triangles, "
+				<< referenceStats.setupTrianglesCount << " set up, " << referenceStats.binnedTrianglesCount << " binned, "
+				<< referenceStats.shadedPixelsCount << " shaded pixels, " << WIDTH << "x" << HEIGHT << ":\n";
+		isCorrect = runVariant("scalar, 1 thread ", scene, singleThreadPool, Simd::Isa::Scalar, referencePixels) && isCorrect;
+		isCorrect = runVariant("SIMD, 1 thread   ", scene, singleThreadPool, bestIsa, referencePixels) && isCorrect;
+		std::cout << "\t\t(" << sharedPool.getThreadsCount() << " threads)\n";
+		isCorrect = runVariant("SIMD, all threads", scene, sharedPool, bestIsa, referencePixels) && isCorrect;
+	}
+
+	if (!isCorrect) {
+		std::cerr << "[SoftwareRasterizerBenchmark] The images differ from the scalar single thread one." << std::endl;
+		return -1;
+	}
+	return 0;
+}
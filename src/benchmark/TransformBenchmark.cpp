@@ -0,0 +1,156 @@
+#include "Benchmark.hpp"
+
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+#include "TransformStore.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat4x4.hpp>
+
+
+namespace {
+	constexpr int ITERATIONS = 10;
+	// The kernels compose the rotation differently from glm::rotate(), so the results differ by rounding.
+	constexpr float MAX_ERROR = 1e-4f;
+
+	constexpr Simd::Isa ISAS[] = {
+			Simd::Isa::Scalar,
+			Simd::Isa::Sse,
+			Simd::Isa::Avx,
+	};
+
+
+	// The layout of the main loop before the transform store.
+	struct DrawParams
+	{
+		glm::vec3 position;
+		glm::vec3 rotationAxis;
+		float angleRadians = 0.f;
+		float scale = 1.f;
+	};
+
+
+	std::vector<DrawParams> generateDrawParams(size_t count)
+	{
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> positionDistribution(-100.f, 100.f);
+		std::uniform_real_distribution<float> axisDistribution(-1.f, 1.f);
+		std::uniform_real_distribution<float> angleDistribution(0.f, 6.28f);
+		std::uniform_real_distribution<float> scaleDistribution(0.1f, 2.f);
+
+		std::vector<DrawParams> drawParams(count);
+		for (DrawParams& params : drawParams) {
+			params.position = glm::vec3(positionDistribution(random), positionDistribution(random), positionDistribution(random));
+			params.rotationAxis = glm::normalize(glm::vec3(axisDistribution(random), axisDistribution(random), 1.f));
+			params.angleRadians = angleDistribution(random);
+			params.scale = scaleDistribution(random);
+		}
+		return drawParams;
+	}
+
+
+	void computeChainedMatrices(const std::vector<DrawParams>& drawParams, std::vector<glm::mat4>& outMatrices)
+	{
+		for (size_t i = 0; i < drawParams.size(); ++i) {
+			const DrawParams& params = drawParams[i];
+			glm::mat4 model = glm::mat4(1.f);
+			model = glm::translate(model, params.position);
+			model = glm::scale(model, glm::vec3(params.scale));
+			model = glm::rotate(model, params.angleRadians, params.rotationAxis);
+			outMatrices[i] = model;
+		}
+	}
+
+
+	float getMaxError(const std::vector<glm::mat4>& expected, const std::vector<glm::mat4>& actual)
+	{
+		float maxError = 0.f;
+		for (size_t i = 0; i < expected.size(); ++i) {
+			for (int column = 0; column < 4; ++column) {
+				for (int row = 0; row < 4; ++row) {
+					maxError = std::max(maxError, std::abs(expected[i][column][row] - actual[i][column][row]));
+				}
+			}
+		}
+		return maxError;
+	}
+
+
+	void printResult(std::string_view label, double ms, double baselineMs, size_t count, float maxError)
+	{
+		std::cout << "\t\t" << std::left << std::setw(16) << label << std::right
+				<< ms << " ms (" << count / ms / 1000.0 << " M/s)"
+				<< " speedup x" << baselineMs / ms
+				<< " max error " << std::scientific << maxError << std::fixed
+				<< (maxError <= MAX_ERROR ? "" : " MISMATCH")
+				<< std::endl;
+	}
+}
+
+
+int Benchmark::runTransformBenchmark()
+{
+	ThreadPool& threadPool = ThreadPool::getShared();
+	std::cout << std::fixed << std::setprecision(3)
+			<< "\tBest instruction set: " << Simd::getIsaName(Simd::getBestIsa())
+			<< ", threads: " << threadPool.getThreadsCount() << std::endl;
+
+	int mismatchesCount = 0;
+	for (const size_t count : {10'000, 100'000, 1'000'000}) {
+		const std::vector<DrawParams> drawParams = generateDrawParams(count);
+		TransformStore store;
+		store.reserve(count);
+		for (const DrawParams& params : drawParams) {
+			store.add({params.position, glm::angleAxis(params.angleRadians, params.rotationAxis), glm::vec3(params.scale)});
+		}
+
+		std::vector<glm::mat4> expectedMatrices(count);
+		const double chainedMs = measureMs(ITERATIONS, [&]() {
+			computeChainedMatrices(drawParams, expectedMatrices);
+		});
+		doNotOptimize(expectedMatrices.back());
+
+		std::cout << "\t" << count << " matrices:" << std::endl;
+		printResult("glm chained", chainedMs, chainedMs, count, 0.f);
+
+		std::vector<glm::mat4> matrices(count);
+		for (const Simd::Isa isa : ISAS) {
+			if (!Simd::isSupported(isa)) {
+				continue;
+			}
+
+			std::fill(matrices.begin(), matrices.end(), glm::mat4(0.f));
+			const double ms = measureMs(ITERATIONS, [&]() {
+				store.computeModelMatrices(matrices, isa);
+			});
+			const float maxError = getMaxError(expectedMatrices, matrices);
+			mismatchesCount += maxError > MAX_ERROR;
+			printResult(Simd::getIsaName(isa), ms, chainedMs, count, maxError);
+
+			std::fill(matrices.begin(), matrices.end(), glm::mat4(0.f));
+			const double parallelMs = measureMs(ITERATIONS, [&]() {
+				store.computeModelMatricesParallel(threadPool, matrices, isa);
+			});
+			const float parallelMaxError = getMaxError(expectedMatrices, matrices);
+			mismatchesCount += parallelMaxError > MAX_ERROR;
+			const std::string label = std::string(Simd::getIsaName(isa)) + " x" + std::to_string(threadPool.getThreadsCount());
+			printResult(label, parallelMs, chainedMs, count, parallelMaxError);
+		}
+	}
+
+	if (mismatchesCount > 0) {
+		std::cerr << "[TransformBenchmark] " << mismatchesCount << " kernels differ from glm." << std::endl;
+		return -1;
+	}
+	return 0;
+}
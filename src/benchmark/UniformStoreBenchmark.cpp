@@ -0,0 +1,247 @@
+#include "Benchmark.hpp"
+
+#include "ShaderUniform.hpp"
+#include "ShaderUniformStore.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/mat4x4.hpp>
+
+
+namespace {
+	/**
+	 * The previous store design: one heap allocated polymorphic object with an owned name per set().
+	 * It's kept here only as the baseline for the comparison.
+	 */
+	class LegacyUniform
+	{
+	public:
+		explicit LegacyUniform(std::string_view name)
+				: _name(name)
+		{
+		}
+
+		virtual ~LegacyUniform() noexcept = default;
+
+		[[nodiscard]]
+		const std::string& getName() const { return _name; }
+
+	private:
+		std::string _name;
+	};
+
+
+	class LegacyUniformFloat : public LegacyUniform
+	{
+	public:
+		LegacyUniformFloat(std::string_view name, float value)
+				: LegacyUniform(name)
+				, _value(value)
+		{
+		}
+
+	private:
+		float _value = 0.f;
+	};
+
+
+	class LegacyUniformSampler : public LegacyUniform
+	{
+	public:
+		LegacyUniformSampler(std::string_view name, int value)
+				: LegacyUniform(name)
+				, _value(value)
+		{
+		}
+
+	private:
+		int _value = 0;
+	};
+
+
+	class LegacyUniformMat4 : public LegacyUniform
+	{
+	public:
+		LegacyUniformMat4(std::string_view name, const glm::mat4& mat)
+				: LegacyUniform(name)
+				, _mat(mat)
+		{
+		}
+
+	private:
+		glm::mat4 _mat;
+	};
+
+
+	class LegacyUniformStore
+	{
+	public:
+		void set(std::unique_ptr<LegacyUniform>&& uniformPtr)
+		{
+			_uniforms[uniformPtr->getName()] = std::move(uniformPtr);
+		}
+
+		[[nodiscard]]
+		size_t size() const { return _uniforms.size(); }
+
+	private:
+		std::unordered_map<std::string, std::unique_ptr<LegacyUniform>> _uniforms;
+	};
+
+
+	constexpr UniformName UNIFORM_MODEL = "uModel";
+	constexpr UniformName UNIFORM_VIEW = "uView";
+	constexpr UniformName UNIFORM_PROGRESS = "uProgress";
+	constexpr UniformName UNIFORM_SAMPLER = "sampler0";
+	constexpr UniformName UNIFORM_LIGHTS = "uLights";
+	constexpr int FRAMES_AMOUNT = 5;
+
+
+	// Mimics the frame loop: the model matrix changes on each set, the other values are mostly the same.
+	void fillLegacyStore(LegacyUniformStore& store, int setsAmount, const glm::mat4& view)
+	{
+		for (int i = 0; i < setsAmount; ++i) {
+			switch (i % 4) {
+				case 0: {
+					const glm::mat4 model = glm::translate(glm::mat4(1.f), glm::vec3((float) i, 0.f, 0.f));
+					store.set(std::make_unique<LegacyUniformMat4>(UNIFORM_MODEL.getView(), model));
+					break;
+				}
+				case 1:
+					store.set(std::make_unique<LegacyUniformMat4>(UNIFORM_VIEW.getView(), view));
+					break;
+				case 2:
+					store.set(std::make_unique<LegacyUniformFloat>(UNIFORM_PROGRESS.getView(), 0.5f));
+					break;
+				default:
+					store.set(std::make_unique<LegacyUniformSampler>(UNIFORM_SAMPLER.getView(), 0));
+					break;
+			}
+		}
+	}
+
+
+	void fillStore(ShaderUniformStore& store, int setsAmount, const glm::mat4& view)
+	{
+		for (int i = 0; i < setsAmount; ++i) {
+			switch (i % 4) {
+				case 0: {
+					const glm::mat4 model = glm::translate(glm::mat4(1.f), glm::vec3((float) i, 0.f, 0.f));
+					store.set(ShaderUniform::Mat4(UNIFORM_MODEL, model));
+					break;
+				}
+				case 1:
+					store.set(ShaderUniform::Mat4(UNIFORM_VIEW, view));
+					break;
+				case 2:
+					store.set(ShaderUniform::Float(UNIFORM_PROGRESS, 0.5f));
+					break;
+				default:
+					store.set(ShaderUniform::Sampler(UNIFORM_SAMPLER, 0));
+					break;
+			}
+		}
+	}
+
+
+	// The same as fillStore(), but the slots are resolved once, so no name lookup happens per set.
+	void fillStoreBySlots(ShaderUniformStore& store, int setsAmount, const glm::mat4& view)
+	{
+		const int modelSlot = store.getOrCreateSlot(UNIFORM_MODEL);
+		const int viewSlot = store.getOrCreateSlot(UNIFORM_VIEW);
+		const int progressSlot = store.getOrCreateSlot(UNIFORM_PROGRESS);
+		const int samplerSlot = store.getOrCreateSlot(UNIFORM_SAMPLER);
+
+		for (int i = 0; i < setsAmount; ++i) {
+			switch (i % 4) {
+				case 0: {
+					const glm::mat4 model = glm::translate(glm::mat4(1.f), glm::vec3((float) i, 0.f, 0.f));
+					store.set(modelSlot, ShaderUniform::Mat4(UNIFORM_MODEL, model));
+					break;
+				}
+				case 1:
+					store.set(viewSlot, ShaderUniform::Mat4(UNIFORM_VIEW, view));
+					break;
+				case 2:
+					store.set(progressSlot, ShaderUniform::Float(UNIFORM_PROGRESS, 0.5f));
+					break;
+				default:
+					store.set(samplerSlot, ShaderUniform::Sampler(UNIFORM_SAMPLER, 0));
+					break;
+			}
+		}
+	}
+
+
+	// An empty array must stay empty in the store: no data is read from its (null) pointer, and nothing is uploaded.
+	bool storesEmptyArray()
+	{
+		const ShaderUniform empty = ShaderUniform::FloatArray(UNIFORM_LIGHTS, std::span<const float>());
+		if (empty.getArraySize() != 0 || empty.getDataSize() != 0) {
+			return false;
+		}
+
+		ShaderUniformStore store;
+		const int slot = store.getOrCreateSlot(UNIFORM_LIGHTS);
+		store.set(slot, empty);
+		const ShaderUniform storedEmpty = store.get(slot);
+		if (storedEmpty.getArraySize() != 0 || storedEmpty.getDataSize() != 0) {
+			return false;
+		}
+
+		// The empty array replaces the non-empty one as a new value.
+		const float values[] = {1.f, 2.f};
+		store.set(slot, ShaderUniform::FloatArray(UNIFORM_LIGHTS, values));
+		const uint64_t filledVersion = store.getVersion(slot);
+		store.set(slot, empty);
+		return store.getVersion(slot) != filledVersion && store.get(slot).getArraySize() == 0;
+	}
+}
+
+
+int Benchmark::runUniformStoreBenchmark()
+{
+	if (!storesEmptyArray()) {
+		std::cerr << "[UniformStoreBenchmark] The empty uniform array isn't stored as empty." << std::endl;
+		return -1;
+	}
+
+	const glm::mat4 view = glm::lookAt(glm::vec3(0.f, 0.f, 3.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+
+	std::cout << std::fixed << std::setprecision(3);
+	for (const int setsAmount : {10'000, 100'000, 1'000'000}) {
+		LegacyUniformStore legacyStore;
+		const double legacyMs = measureMs(FRAMES_AMOUNT, [&]() {
+			fillLegacyStore(legacyStore, setsAmount, view);
+		});
+		doNotOptimize(legacyStore.size());
+
+		ShaderUniformStore store;
+		const double flatMs = measureMs(FRAMES_AMOUNT, [&]() {
+			fillStore(store, setsAmount, view);
+		});
+		doNotOptimize(store.getVersion(0));
+
+		ShaderUniformStore slotStore;
+		const double slotMs = measureMs(FRAMES_AMOUNT, [&]() {
+			fillStoreBySlots(slotStore, setsAmount, view);
+		});
+		doNotOptimize(slotStore.getVersion(0));
+
+		std::cout << "\t" << setsAmount << " sets per frame:\n"
+				<< "\t\tlegacy:       " << legacyMs << " ms (" << legacyMs * 1e6 / setsAmount << " ns/set)\n"
+				<< "\t\tflat by name: " << flatMs << " ms (" << flatMs * 1e6 / setsAmount << " ns/set)"
+				<< " speedup x" << legacyMs / flatMs << "\n"
+				<< "\t\tflat by slot: " << slotMs << " ms (" << slotMs * 1e6 / setsAmount << " ns/set)"
+				<< " speedup x" << legacyMs / slotMs
+				<< std::endl;
+	}
+
+	return 0;
+}
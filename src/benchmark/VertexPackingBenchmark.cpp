@@ -0,0 +1,161 @@
+#include "Benchmark.hpp"
+
+#include "model/GeometricModelFactory.hpp"
+#include "model/PackedModel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+#include <glm/vec3.hpp>
+
+
+namespace {
+	constexpr int ITERATIONS = 5;
+	constexpr float RADIUS = 20.f;
+	const glm::vec3 CENTER(100.f, -30.f, 250.f);
+
+
+	// The sphere is moved away from the origin and the vertices get random colors, so every encoding is exercised.
+	GeometricModel generateModel(int segmentsCount, int ringsCount)
+	{
+		const GeometricModel sphere = GeometricModelFactory::createSphereModel(segmentsCount, ringsCount);
+		std::vector<VertexFormat> vertices = sphere.getVertices();
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> colorDistribution(0.f, 1.f);
+		for (VertexFormat& vertex : vertices) {
+			vertex.pos = {
+					CENTER.x + vertex.pos.x * RADIUS,
+					CENTER.y + vertex.pos.y * RADIUS,
+					CENTER.z + vertex.pos.z * RADIUS,
+			};
+			vertex.color = {colorDistribution(random), colorDistribution(random), colorDistribution(random), 1.f};
+		}
+		return GeometricModel(std::move(vertices), sphere.getIndices());
+	}
+
+
+	bool isEqual(const PackedModel& left, const PackedModel& right)
+	{
+		const PackedIndices& leftIndices = left.getIndices();
+		const PackedIndices& rightIndices = right.getIndices();
+		return left.getVertices().size() == right.getVertices().size()
+				&& std::memcmp(left.getVertices().data(), right.getVertices().data(), left.getVerticesBytesCount()) == 0
+				&& leftIndices.getBytesCount() == rightIndices.getBytesCount()
+				&& std::memcmp(leftIndices.getData(), rightIndices.getData(), leftIndices.getBytesCount()) == 0;
+	}
+
+
+	void printErrors(const GeometricModel& model, const std::vector<glm::vec3>& normals, const PackedModel& packedModel)
+	{
+		const GeometricModel unpackedModel = packedModel.unpack();
+		const std::vector<glm::vec3> unpackedNormals = packedModel.unpackNormals();
+		float maxPositionError = 0.f;
+		float maxTexCoordsError = 0.f;
+		float maxColorError = 0.f;
+		float maxNormalAngle = 0.f;
+		for (size_t i = 0; i < model.getVertices().size(); ++i) {
+			const VertexFormat& vertex = model.getVertices()[i];
+			const VertexFormat& unpacked = unpackedModel.getVertices()[i];
+			maxPositionError = std::max({
+					maxPositionError,
+					std::abs(vertex.pos.x - unpacked.pos.x),
+					std::abs(vertex.pos.y - unpacked.pos.y),
+					std::abs(vertex.pos.z - unpacked.pos.z),
+			});
+			maxTexCoordsError = std::max({
+					maxTexCoordsError,
+					std::abs(vertex.texCoords.u - unpacked.texCoords.u),
+					std::abs(vertex.texCoords.v - unpacked.texCoords.v),
+			});
+			maxColorError = std::max({
+					maxColorError,
+					std::abs(vertex.color.r - unpacked.color.r),
+					std::abs(vertex.color.g - unpacked.color.g),
+					std::abs(vertex.color.b - unpacked.color.b),
+			});
+			const float cosAngle = std::clamp(glm::dot(normals[i], unpackedNormals[i]), -1.f, 1.f);
+			maxNormalAngle = std::max(maxNormalAngle, std::acos(cosAngle));
+		}
+
+		std::cout << std::scientific << std::setprecision(2)
+				<< "\t\t\tmax errors: position " << maxPositionError << " (" << maxPositionError / RADIUS << " of the radius)"
+				<< ", tex coords " << maxTexCoordsError << ", color " << maxColorError
+				<< ", normal " << glm::degrees(maxNormalAngle) << " deg" << std::endl
+				<< std::fixed << std::setprecision(3);
+	}
+
+
+	/**
+	 * @return Whether the SIMD result equals the scalar one.
+	 */
+	bool runEncoding(
+			const char* label,
+			const GeometricModel& model,
+			const std::vector<glm::vec3>& normals,
+			PackedModel::PositionEncoding encoding
+	)
+	{
+		const double verticesCount = (double) model.getVertices().size();
+		const double inputBytesCount = verticesCount * (sizeof(VertexFormat) + sizeof(glm::vec3));
+
+		std::cout << "\t\t" << label << ":\n";
+		PackedModel scalarModel;
+		PackedModel simdModel;
+		for (const Simd::Isa isa : {Simd::Isa::Scalar, Simd::getBestIsa()}) {
+			PackedModel& packedModel = (isa == Simd::Isa::Scalar) ? scalarModel : simdModel;
+			const double packMs = Benchmark::measureMs(ITERATIONS, [&]() {
+				packedModel = PackedModel::pack(model, normals, encoding, isa);
+				Benchmark::doNotOptimize(packedModel);
+			});
+			const double packSeconds = packMs / 1000.0;
+			const bool isF16c = (isa != Simd::Isa::Scalar) && Simd::isF16cSupported();
+			std::cout << "\t\t\t" << Simd::getIsaName(isa) << (isF16c ? " + F16C" : "") << ": " << packMs << " ms"
+					<< ", " << verticesCount / packSeconds / 1e6 << " M vertices/s"
+					<< ", " << inputBytesCount / packSeconds / 1e6 << " MB/s of float vertices" << std::endl;
+		}
+
+		printErrors(model, normals, scalarModel);
+		return isEqual(scalarModel, simdModel);
+	}
+}
+
+
+int Benchmark::runVertexPackingBenchmark()
+{
+	bool isCorrect = true;
+	std::cout << std::fixed << std::setprecision(3);
+	// The small sphere has 16-bit indices, the large one doesn't fit them.
+	for (const int segmentsCount : {64, 1024}) {
+		const GeometricModel model = generateModel(segmentsCount, segmentsCount / 2);
+		const std::vector<glm::vec3> normals = PackedModel::computeNormals(model);
+		const PackedModel packedModel = PackedModel::pack(model, normals, PackedModel::PositionEncoding::Half);
+
+		const size_t verticesCount = model.getVertices().size();
+		const size_t indicesCount = model.getIndices().size();
+		const size_t floatBytesCount = verticesCount * (sizeof(VertexFormat) + sizeof(glm::vec3))
+				+ indicesCount * sizeof(GeometricModel::IndexType);
+		const size_t packedBytesCount = packedModel.getVerticesBytesCount() + packedModel.getIndices().getBytesCount();
+		std::cout << "\t" << verticesCount << " vertices, " << indicesCount << " indices:\n"
+				<< "\t\tvertex: " << sizeof(VertexFormat) << " bytes, " << sizeof(VertexFormat) + sizeof(glm::vec3)
+				<< " with a float normal -> " << sizeof(PackedVertexFormat) << " packed"
+				<< "; index: " << sizeof(GeometricModel::IndexType) << " -> " << packedModel.getIndices().getIndexSize() << " bytes\n"
+				<< "\t\tmesh: " << (double) floatBytesCount / 1e6 << " MB -> " << (double) packedBytesCount / 1e6 << " MB ("
+				<< 100.0 * (double) packedBytesCount / (double) floatBytesCount << "%)" << std::endl;
+
+		isCorrect = runEncoding("half positions", model, normals, PackedModel::PositionEncoding::Half) && isCorrect;
+		isCorrect = runEncoding("unorm16 positions", model, normals, PackedModel::PositionEncoding::Unorm16) && isCorrect;
+	}
+
+	if (!isCorrect) {
+		std::cerr << "[VertexPackingBenchmark] The SIMD packing differs from the scalar one." << std::endl;
+		return -1;
+	}
+	return 0;
+}
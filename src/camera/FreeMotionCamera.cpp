@@ -2,6 +2,7 @@
 
 #include <algorithm>
 
+#include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
 
@@ -12,6 +13,18 @@ glm::mat4 FreeMotionCamera::getViewMatrix() const
 }
 
 
+glm::mat4 FreeMotionCamera::getProjectionMatrix(float aspectRatio) const
+{
+	return glm::perspective(getFovYRadians(), aspectRatio, Z_NEAR, Z_FAR);
+}
+
+
+Frustum FreeMotionCamera::getFrustum(float aspectRatio) const
+{
+	return Frustum::fromViewProjection(getProjectionMatrix(aspectRatio) * getViewMatrix());
+}
+
+
 float FreeMotionCamera::getFovYRadians() const
 {
 	return glm::radians(_fovDegrees);
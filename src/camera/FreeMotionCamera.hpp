@@ -1,5 +1,7 @@
 #pragma once
 
+#include "culling/Frustum.hpp"
+
 #include <glm/mat4x4.hpp>
 
 
@@ -13,10 +15,23 @@ private:
 	static constexpr float CAMERA_ZOOM_SENSITIVITY = 0.5f;
 	static constexpr glm::vec3 WORLD_UP_DIRECTION = {0.f, 1.f, 0.f};
 
+public:
+	static constexpr float Z_NEAR = 0.1f;
+	static constexpr float Z_FAR = 100.f;
+
 public:
 	[[nodiscard]]
 	glm::mat4 getViewMatrix() const;
 
+	[[nodiscard]]
+	glm::mat4 getProjectionMatrix(float aspectRatio) const;
+
+	/**
+	 * @brief Returns the view volume in world space for the culling.
+	 */
+	[[nodiscard]]
+	Frustum getFrustum(float aspectRatio) const;
+
 	[[nodiscard]]
 	float getFovYRadians() const;
 
@@ -0,0 +1,56 @@
+#include "Frustum.hpp"
+
+#include <cmath>
+
+
+Frustum Frustum::fromViewProjection(const glm::mat4& viewProjection)
+{
+	// A clip space point is inside, if -w <= x, y, z <= w. Each inequality is a plane made of matrix rows.
+	const glm::mat4& m = viewProjection;
+	const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	Frustum frustum;
+	frustum.planes[Left] = row3 + row0;
+	frustum.planes[Right] = row3 - row0;
+	frustum.planes[Bottom] = row3 + row1;
+	frustum.planes[Top] = row3 - row1;
+	frustum.planes[Near] = row3 + row2;
+	frustum.planes[Far] = row3 - row2;
+
+	for (glm::vec4& plane : frustum.planes) {
+		const float normalLength = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+		plane /= normalLength;
+	}
+
+	return frustum;
+}
+
+
+bool Frustum::isSphereVisible(const glm::vec3& center, float radius) const
+{
+	for (const glm::vec4& plane : planes) {
+		// The evaluation order is the same as in the batch kernels, so the results match exactly.
+		const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+		if (!(distance >= -radius)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool Frustum::isBoxVisible(const glm::vec3& center, const glm::vec3& extents) const
+{
+	for (const glm::vec4& plane : planes) {
+		const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+		// The projection of the box extents on the plane normal.
+		const float radius = extents.x * std::abs(plane.x) + extents.y * std::abs(plane.y) + extents.z * std::abs(plane.z);
+		if (!(distance >= -radius)) {
+			return false;
+		}
+	}
+	return true;
+}
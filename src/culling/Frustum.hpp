@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+
+
+/**
+ * @brief The view volume as 6 planes with normals pointing inside.
+ * A point p is inside the plane, if dot(plane.xyz, p) + plane.w >= 0.
+ */
+struct Frustum
+{
+	enum Plane {
+		Left,
+		Right,
+		Bottom,
+		Top,
+		Near,
+		Far,
+		PlanesCount,
+	};
+
+	// Normalized, so the plane equation gives the distance.
+	std::array<glm::vec4, PlanesCount> planes;
+
+	/**
+	 * @brief Extracts the planes from the view-projection matrix (Gribb-Hartmann method).
+	 * The planes are in world space. With projection only they would be in view space.
+	 */
+	[[nodiscard]]
+	static Frustum fromViewProjection(const glm::mat4& viewProjection);
+
+	/**
+	 * @brief The reference test of one sphere. The batch kernels of FrustumCuller give the same results.
+	 */
+	[[nodiscard]]
+	bool isSphereVisible(const glm::vec3& center, float radius) const;
+
+	/**
+	 * @brief The reference test of one axis aligned box.
+	 * @param extents Half sizes of the box.
+	 */
+	[[nodiscard]]
+	bool isBoxVisible(const glm::vec3& center, const glm::vec3& extents) const;
+};
@@ -0,0 +1,373 @@
+#include "FrustumCuller.hpp"
+
+#include "ThreadPool.hpp"
+#include "Utilities.hpp"
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+
+namespace {
+	/**
+	 * Writes indices of the visible bounds from [begin, end) to out.
+	 * @return The number of written indices.
+	 */
+	template <typename Bounds>
+	using CullFunction = size_t (*)(const Frustum& frustum, const Bounds& bounds, size_t begin, size_t end, uint32_t* out);
+
+
+	size_t cullSpheresScalar(const Frustum& frustum, const SphereBoundsSoa& bounds, size_t begin, size_t end, uint32_t* out)
+	{
+		size_t visibleCount = 0;
+		for (size_t i = begin; i < end; ++i) {
+			const glm::vec3 center(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+			// Branchless compaction: the index is always written, but kept only if the sphere is visible.
+			out[visibleCount] = (uint32_t) i;
+			visibleCount += frustum.isSphereVisible(center, bounds.radius[i]);
+		}
+		return visibleCount;
+	}
+
+
+	size_t cullBoxesScalar(const Frustum& frustum, const BoxBoundsSoa& bounds, size_t begin, size_t end, uint32_t* out)
+	{
+		size_t visibleCount = 0;
+		for (size_t i = begin; i < end; ++i) {
+			const glm::vec3 center(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+			const glm::vec3 extents(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+			out[visibleCount] = (uint32_t) i;
+			visibleCount += frustum.isBoxVisible(center, extents);
+		}
+		return visibleCount;
+	}
+
+
+	/**
+	 * Appends the indices of the set bits of the mask to out.
+	 */
+	inline size_t writeVisibleIndices(unsigned int visibleMask, size_t firstIndex, uint32_t* out)
+	{
+		size_t visibleCount = 0;
+		while (visibleMask != 0) {
+			out[visibleCount++] = (uint32_t) (firstIndex + std::countr_zero(visibleMask));
+			visibleMask &= visibleMask - 1;
+		}
+		return visibleCount;
+	}
+
+
+#if SIMD_X86
+	struct PlaneSse
+	{
+		__m128 x;
+		__m128 y;
+		__m128 z;
+		__m128 w;
+		__m128 absX;
+		__m128 absY;
+		__m128 absZ;
+	};
+
+
+	void splatPlanes(const Frustum& frustum, PlaneSse (& planes)[Frustum::PlanesCount])
+	{
+		for (int p = 0; p < Frustum::PlanesCount; ++p) {
+			const glm::vec4& plane = frustum.planes[p];
+			planes[p] = {
+					_mm_set1_ps(plane.x),
+					_mm_set1_ps(plane.y),
+					_mm_set1_ps(plane.z),
+					_mm_set1_ps(plane.w),
+					_mm_set1_ps(std::abs(plane.x)),
+					_mm_set1_ps(std::abs(plane.y)),
+					_mm_set1_ps(std::abs(plane.z)),
+			};
+		}
+	}
+
+
+	// The operation order is the same as in Frustum, so the results are bit exact.
+	inline __m128 getPlaneDistanceSse(const PlaneSse& plane, __m128 x, __m128 y, __m128 z)
+	{
+		__m128 distance = _mm_add_ps(_mm_mul_ps(plane.x, x), _mm_mul_ps(plane.y, y));
+		distance = _mm_add_ps(distance, _mm_mul_ps(plane.z, z));
+		return _mm_add_ps(distance, plane.w);
+	}
+
+
+	size_t cullSpheresSse(const Frustum& frustum, const SphereBoundsSoa& bounds, size_t begin, size_t end, uint32_t* out)
+	{
+		PlaneSse planes[Frustum::PlanesCount];
+		splatPlanes(frustum, planes);
+		const __m128 signMask = _mm_set1_ps(-0.f);
+
+		size_t visibleCount = 0;
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4) {
+			const __m128 x = _mm_loadu_ps(&bounds.centerX[i]);
+			const __m128 y = _mm_loadu_ps(&bounds.centerY[i]);
+			const __m128 z = _mm_loadu_ps(&bounds.centerZ[i]);
+			const __m128 negRadius = _mm_xor_ps(_mm_loadu_ps(&bounds.radius[i]), signMask);
+
+			__m128 isVisible = _mm_cmpge_ps(getPlaneDistanceSse(planes[0], x, y, z), negRadius);
+			for (int p = 1; p < Frustum::PlanesCount; ++p) {
+				isVisible = _mm_and_ps(isVisible, _mm_cmpge_ps(getPlaneDistanceSse(planes[p], x, y, z), negRadius));
+			}
+			visibleCount += writeVisibleIndices(_mm_movemask_ps(isVisible), i, out + visibleCount);
+		}
+
+		return visibleCount + cullSpheresScalar(frustum, bounds, i, end, out + visibleCount);
+	}
+
+
+	size_t cullBoxesSse(const Frustum& frustum, const BoxBoundsSoa& bounds, size_t begin, size_t end, uint32_t* out)
+	{
+		PlaneSse planes[Frustum::PlanesCount];
+		splatPlanes(frustum, planes);
+		const __m128 signMask = _mm_set1_ps(-0.f);
+
+		size_t visibleCount = 0;
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4) {
+			const __m128 x = _mm_loadu_ps(&bounds.centerX[i]);
+			const __m128 y = _mm_loadu_ps(&bounds.centerY[i]);
+			const __m128 z = _mm_loadu_ps(&bounds.centerZ[i]);
+			const __m128 extentX = _mm_loadu_ps(&bounds.extentX[i]);
+			const __m128 extentY = _mm_loadu_ps(&bounds.extentY[i]);
+			const __m128 extentZ = _mm_loadu_ps(&bounds.extentZ[i]);
+
+			__m128 isVisible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (const PlaneSse& plane : planes) {
+				__m128 radius = _mm_add_ps(_mm_mul_ps(extentX, plane.absX), _mm_mul_ps(extentY, plane.absY));
+				radius = _mm_add_ps(radius, _mm_mul_ps(extentZ, plane.absZ));
+				const __m128 distance = getPlaneDistanceSse(plane, x, y, z);
+				isVisible = _mm_and_ps(isVisible, _mm_cmpge_ps(distance, _mm_xor_ps(radius, signMask)));
+			}
+			visibleCount += writeVisibleIndices(_mm_movemask_ps(isVisible), i, out + visibleCount);
+		}
+
+		return visibleCount + cullBoxesScalar(frustum, bounds, i, end, out + visibleCount);
+	}
+#endif
+
+
+#if SIMD_AVX
+	struct PlaneAvx
+	{
+		__m256 x;
+		__m256 y;
+		__m256 z;
+		__m256 w;
+		__m256 absX;
+		__m256 absY;
+		__m256 absZ;
+	};
+
+
+	SIMD_TARGET_AVX
+	void splatPlanes(const Frustum& frustum, PlaneAvx (& planes)[Frustum::PlanesCount])
+	{
+		for (int p = 0; p < Frustum::PlanesCount; ++p) {
+			const glm::vec4& plane = frustum.planes[p];
+			planes[p] = {
+					_mm256_set1_ps(plane.x),
+					_mm256_set1_ps(plane.y),
+					_mm256_set1_ps(plane.z),
+					_mm256_set1_ps(plane.w),
+					_mm256_set1_ps(std::abs(plane.x)),
+					_mm256_set1_ps(std::abs(plane.y)),
+					_mm256_set1_ps(std::abs(plane.z)),
+			};
+		}
+	}
+
+
+	SIMD_TARGET_AVX
+	inline __m256 getPlaneDistanceAvx(const PlaneAvx& plane, __m256 x, __m256 y, __m256 z)
+	{
+		// No FMA: it would round differently from the scalar reference.
+		__m256 distance = _mm256_add_ps(_mm256_mul_ps(plane.x, x), _mm256_mul_ps(plane.y, y));
+		distance = _mm256_add_ps(distance, _mm256_mul_ps(plane.z, z));
+		return _mm256_add_ps(distance, plane.w);
+	}
+
+
+	SIMD_TARGET_AVX
+	size_t cullSpheresAvx(const Frustum& frustum, const SphereBoundsSoa& bounds, size_t begin, size_t end, uint32_t* out)
+	{
+		PlaneAvx planes[Frustum::PlanesCount];
+		splatPlanes(frustum, planes);
+		const __m256 signMask = _mm256_set1_ps(-0.f);
+
+		size_t visibleCount = 0;
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8) {
+			const __m256 x = _mm256_loadu_ps(&bounds.centerX[i]);
+			const __m256 y = _mm256_loadu_ps(&bounds.centerY[i]);
+			const __m256 z = _mm256_loadu_ps(&bounds.centerZ[i]);
+			const __m256 negRadius = _mm256_xor_ps(_mm256_loadu_ps(&bounds.radius[i]), signMask);
+
+			__m256 isVisible = _mm256_cmp_ps(getPlaneDistanceAvx(planes[0], x, y, z), negRadius, _CMP_GE_OQ);
+			for (int p = 1; p < Frustum::PlanesCount; ++p) {
+				const __m256 distance = getPlaneDistanceAvx(planes[p], x, y, z);
+				isVisible = _mm256_and_ps(isVisible, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+			}
+			visibleCount += writeVisibleIndices(_mm256_movemask_ps(isVisible), i, out + visibleCount);
+		}
+
+		return visibleCount + cullSpheresSse(frustum, bounds, i, end, out + visibleCount);
+	}
+
+
+	SIMD_TARGET_AVX
+	size_t cullBoxesAvx(const Frustum& frustum, const BoxBoundsSoa& bounds, size_t begin, size_t end, uint32_t* out)
+	{
+		PlaneAvx planes[Frustum::PlanesCount];
+		splatPlanes(frustum, planes);
+		const __m256 signMask = _mm256_set1_ps(-0.f);
+
+		size_t visibleCount = 0;
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8) {
+			const __m256 x = _mm256_loadu_ps(&bounds.centerX[i]);
+			const __m256 y = _mm256_loadu_ps(&bounds.centerY[i]);
+			const __m256 z = _mm256_loadu_ps(&bounds.centerZ[i]);
+			const __m256 extentX = _mm256_loadu_ps(&bounds.extentX[i]);
+			const __m256 extentY = _mm256_loadu_ps(&bounds.extentY[i]);
+			const __m256 extentZ = _mm256_loadu_ps(&bounds.extentZ[i]);
+
+			__m256 isVisible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (const PlaneAvx& plane : planes) {
+				__m256 radius = _mm256_add_ps(_mm256_mul_ps(extentX, plane.absX), _mm256_mul_ps(extentY, plane.absY));
+				radius = _mm256_add_ps(radius, _mm256_mul_ps(extentZ, plane.absZ));
+				const __m256 distance = getPlaneDistanceAvx(plane, x, y, z);
+				isVisible = _mm256_and_ps(isVisible, _mm256_cmp_ps(distance, _mm256_xor_ps(radius, signMask), _CMP_GE_OQ));
+			}
+			visibleCount += writeVisibleIndices(_mm256_movemask_ps(isVisible), i, out + visibleCount);
+		}
+
+		return visibleCount + cullBoxesSse(frustum, bounds, i, end, out + visibleCount);
+	}
+#endif
+
+
+	CullFunction<SphereBoundsSoa> getSpheresFunction(FrustumCuller::Isa isa)
+	{
+		assertTrueMsg(Simd::isSupported(isa), "The instruction set isn't supported by the CPU.");
+		switch (isa) {
+#if SIMD_AVX
+			case FrustumCuller::Isa::Avx:
+				return &cullSpheresAvx;
+#endif
+#if SIMD_X86
+			case FrustumCuller::Isa::Sse:
+				return &cullSpheresSse;
+#endif
+			default:
+				return &cullSpheresScalar;
+		}
+	}
+
+
+	CullFunction<BoxBoundsSoa> getBoxesFunction(FrustumCuller::Isa isa)
+	{
+		assertTrueMsg(Simd::isSupported(isa), "The instruction set isn't supported by the CPU.");
+		switch (isa) {
+#if SIMD_AVX
+			case FrustumCuller::Isa::Avx:
+				return &cullBoxesAvx;
+#endif
+#if SIMD_X86
+			case FrustumCuller::Isa::Sse:
+				return &cullBoxesSse;
+#endif
+			default:
+				return &cullBoxesScalar;
+		}
+	}
+
+
+	template <typename Bounds>
+	size_t cullParallel(
+			ThreadPool& threadPool,
+			CullFunction<Bounds> function,
+			const Frustum& frustum,
+			const Bounds& bounds,
+			std::span<uint32_t> outVisibleIndices
+	)
+	{
+		const size_t count = bounds.size();
+		assertTrue(outVisibleIndices.size() >= count);
+
+		// Every chunk writes its indices at its own beginning, as there are no more of them than the chunk size.
+		const size_t chunksCount = threadPool.getChunksCount(count, FrustumCuller::MIN_PARALLEL_CHUNK_SIZE);
+		std::vector<size_t> chunkBegins(chunksCount);
+		std::vector<size_t> chunkVisibleCounts(chunksCount);
+		threadPool.parallelFor(count, FrustumCuller::MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end, size_t chunk) {
+			chunkBegins[chunk] = begin;
+			chunkVisibleCounts[chunk] = function(frustum, bounds, begin, end, outVisibleIndices.data() + begin);
+		});
+
+		// The chunks are in order, so moving them to the prefix sums of the counts keeps the indices sorted.
+		size_t visibleCount = chunkVisibleCounts[0];
+		for (size_t chunk = 1; chunk < chunksCount; ++chunk) {
+			std::memmove(
+					outVisibleIndices.data() + visibleCount,
+					outVisibleIndices.data() + chunkBegins[chunk],
+					chunkVisibleCounts[chunk] * sizeof(uint32_t)
+			);
+			visibleCount += chunkVisibleCounts[chunk];
+		}
+		return visibleCount;
+	}
+}
+
+
+size_t FrustumCuller::cullSpheres(
+		const Frustum& frustum,
+		const SphereBoundsSoa& bounds,
+		std::span<uint32_t> outVisibleIndices,
+		Isa isa
+)
+{
+	assertTrue(outVisibleIndices.size() >= bounds.size());
+	return getSpheresFunction(isa)(frustum, bounds, 0, bounds.size(), outVisibleIndices.data());
+}
+
+
+size_t FrustumCuller::cullBoxes(
+		const Frustum& frustum,
+		const BoxBoundsSoa& bounds,
+		std::span<uint32_t> outVisibleIndices,
+		Isa isa
+)
+{
+	assertTrue(outVisibleIndices.size() >= bounds.size());
+	return getBoxesFunction(isa)(frustum, bounds, 0, bounds.size(), outVisibleIndices.data());
+}
+
+
+size_t FrustumCuller::cullSpheresParallel(
+		ThreadPool& threadPool,
+		const Frustum& frustum,
+		const SphereBoundsSoa& bounds,
+		std::span<uint32_t> outVisibleIndices,
+		Isa isa
+)
+{
+	return cullParallel(threadPool, getSpheresFunction(isa), frustum, bounds, outVisibleIndices);
+}
+
+
+size_t FrustumCuller::cullBoxesParallel(
+		ThreadPool& threadPool,
+		const Frustum& frustum,
+		const BoxBoundsSoa& bounds,
+		std::span<uint32_t> outVisibleIndices,
+		Isa isa
+)
+{
+	return cullParallel(threadPool, getBoxesFunction(isa), frustum, bounds, outVisibleIndices);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Frustum.hpp"
+#include "Simd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+
+class ThreadPool;
+
+
+/**
+ * @brief Bounding spheres in the SoA layout: all arrays have the same size.
+ */
+struct SphereBoundsSoa
+{
+	std::span<const float> centerX;
+	std::span<const float> centerY;
+	std::span<const float> centerZ;
+	std::span<const float> radius;
+
+	[[nodiscard]]
+	size_t size() const { return centerX.size(); }
+};
+
+
+/**
+ * @brief Axis aligned bounding boxes in the SoA layout: all arrays have the same size.
+ */
+struct BoxBoundsSoa
+{
+	std::span<const float> centerX;
+	std::span<const float> centerY;
+	std::span<const float> centerZ;
+	// Half sizes of the boxes.
+	std::span<const float> extentX;
+	std::span<const float> extentY;
+	std::span<const float> extentZ;
+
+	[[nodiscard]]
+	size_t size() const { return centerX.size(); }
+};
+
+
+/**
+ * @brief Tests batches of bounds against the frustum planes, 4 or 8 bounds per instruction.
+ * The results are the compacted indices of the visible bounds in the ascending order.
+ * All kernels give exactly the same results as Frustum::isSphereVisible() and Frustum::isBoxVisible().
+ */
+class FrustumCuller
+{
+public:
+	using Isa = Simd::Isa;
+
+	// Ranges shorter than this aren't split between threads.
+	static constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 16 * 1024;
+
+public:
+	FrustumCuller() = delete;
+
+	/**
+	 * @param outVisibleIndices It must have room for bounds.size() indices.
+	 * @param isa It must be supported by the CPU.
+	 * @return The number of visible bounds, which are written to the beginning of outVisibleIndices.
+	 */
+	static size_t cullSpheres(
+			const Frustum& frustum,
+			const SphereBoundsSoa& bounds,
+			std::span<uint32_t> outVisibleIndices,
+			Isa isa = Simd::getBestIsa()
+	);
+
+	static size_t cullBoxes(
+			const Frustum& frustum,
+			const BoxBoundsSoa& bounds,
+			std::span<uint32_t> outVisibleIndices,
+			Isa isa = Simd::getBestIsa()
+	);
+
+	/**
+	 * @brief The same as cullSpheres(), but the bounds are split between the threads of the pool.
+	 * The order of the indices is the same as in the single threaded version.
+	 */
+	static size_t cullSpheresParallel(
+			ThreadPool& threadPool,
+			const Frustum& frustum,
+			const SphereBoundsSoa& bounds,
+			std::span<uint32_t> outVisibleIndices,
+			Isa isa = Simd::getBestIsa()
+	);
+
+	static size_t cullBoxesParallel(
+			ThreadPool& threadPool,
+			const Frustum& frustum,
+			const BoxBoundsSoa& bounds,
+			std::span<uint32_t> outVisibleIndices,
+			Isa isa = Simd::getBestIsa()
+	);
+};
@@ -0,0 +1,590 @@
+#include "OcclusionCuller.hpp"
+
+#include "ThreadPool.hpp"
+#include "Timing.hpp"
+#include "Utilities.hpp"
+#include "model/GeometricModel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+
+namespace {
+	// Rows of the depth buffer and of the pyramid levels per thread at least.
+	constexpr size_t MIN_ROWS_CHUNK_SIZE = 16;
+
+
+	// The same selection as _mm_min_ps and _mm_max_ps, so the scalar and the SIMD kernels are bit exact.
+	inline float minFloat(float a, float b)
+	{
+		return (a < b) ? a : b;
+	}
+
+
+	inline float maxFloat(float a, float b)
+	{
+		return (a > b) ? a : b;
+	}
+
+
+	inline glm::vec3 getCenter(const SphereBoundsSoa& bounds, uint32_t index)
+	{
+		return {bounds.centerX[index], bounds.centerY[index], bounds.centerZ[index]};
+	}
+
+
+	inline glm::vec3 getCenter(const BoxBoundsSoa& bounds, uint32_t index)
+	{
+		return {bounds.centerX[index], bounds.centerY[index], bounds.centerZ[index]};
+	}
+
+
+	// A sphere is tested by its bounding box.
+	inline glm::vec3 getExtents(const SphereBoundsSoa& bounds, uint32_t index)
+	{
+		return glm::vec3(bounds.radius[index]);
+	}
+
+
+	inline glm::vec3 getExtents(const BoxBoundsSoa& bounds, uint32_t index)
+	{
+		return {bounds.extentX[index], bounds.extentY[index], bounds.extentZ[index]};
+	}
+
+
+#if SIMD_X86
+	inline __m128 gather(std::span<const float> values, const uint32_t* indices)
+	{
+		return _mm_setr_ps(values[indices[0]], values[indices[1]], values[indices[2]], values[indices[3]]);
+	}
+
+
+	inline void gatherCenters(const SphereBoundsSoa& bounds, const uint32_t* indices, __m128& x, __m128& y, __m128& z)
+	{
+		x = gather(bounds.centerX, indices);
+		y = gather(bounds.centerY, indices);
+		z = gather(bounds.centerZ, indices);
+	}
+
+
+	inline void gatherCenters(const BoxBoundsSoa& bounds, const uint32_t* indices, __m128& x, __m128& y, __m128& z)
+	{
+		x = gather(bounds.centerX, indices);
+		y = gather(bounds.centerY, indices);
+		z = gather(bounds.centerZ, indices);
+	}
+
+
+	inline void gatherExtents(const SphereBoundsSoa& bounds, const uint32_t* indices, __m128& x, __m128& y, __m128& z)
+	{
+		x = gather(bounds.radius, indices);
+		y = x;
+		z = x;
+	}
+
+
+	inline void gatherExtents(const BoxBoundsSoa& bounds, const uint32_t* indices, __m128& x, __m128& y, __m128& z)
+	{
+		x = gather(bounds.extentX, indices);
+		y = gather(bounds.extentY, indices);
+		z = gather(bounds.extentZ, indices);
+	}
+#endif
+}
+
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+		: _width(width)
+		, _height(height)
+{
+	assertTrue(width > 0 && height > 0);
+	size_t offset = 0;
+	int levelWidth = width;
+	int levelHeight = height;
+	while (true) {
+		_levels.push_back({levelWidth, levelHeight, offset});
+		offset += (size_t) levelWidth * levelHeight;
+		if (levelWidth == 1 && levelHeight == 1) {
+			break;
+		}
+		levelWidth = (levelWidth + 1) / 2;
+		levelHeight = (levelHeight + 1) / 2;
+	}
+	_depthPyramid.resize(offset, 1.f);
+}
+
+
+void OcclusionCuller::beginFrame(const glm::mat4& viewProjection)
+{
+	_viewProjection = viewProjection;
+	_occluderVertices.clear();
+}
+
+
+void OcclusionCuller::addOccluder(const GeometricModel& model, const glm::mat4& modelMatrix)
+{
+	const glm::mat4 modelViewProjection = _viewProjection * modelMatrix;
+	const std::vector<VertexFormat>& vertices = model.getVertices();
+	for (const GeometricModel::IndexType index : model.getIndices()) {
+		const VertexFormat& vertex = vertices[index];
+		_occluderVertices.push_back(modelViewProjection * glm::vec4(vertex.pos.x, vertex.pos.y, vertex.pos.z, 1.f));
+	}
+}
+
+
+OcclusionCuller::Stats OcclusionCuller::rasterizeOccluders(ThreadPool& threadPool)
+{
+	Stats stats;
+	stats.occluderTrianglesCount = _occluderVertices.size() / 3;
+
+	// The setup is serial: there are few occluders, and the rows of every triangle are split between the threads.
+	auto startTime = std::chrono::steady_clock::now();
+	_setupTriangles.clear();
+	for (size_t i = 0; i + 2 < _occluderVertices.size(); i += 3) {
+		const glm::vec4* vertices = &_occluderVertices[i];
+
+		// Triangles outside a side plane are dropped. Only the near plane clips, the rest is done by the pixel bounds.
+		bool isOutside = false;
+		for (int axis = 0; axis < 2 && !isOutside; ++axis) {
+			const auto isBeyond = [axis](const glm::vec4& vertex, float sign) {
+				return vertex[axis] * sign > vertex.w;
+			};
+			isOutside = (isBeyond(vertices[0], 1.f) && isBeyond(vertices[1], 1.f) && isBeyond(vertices[2], 1.f))
+					|| (isBeyond(vertices[0], -1.f) && isBeyond(vertices[1], -1.f) && isBeyond(vertices[2], -1.f));
+		}
+		if (isOutside) {
+			continue;
+		}
+
+		// Sutherland-Hodgman by the near plane: a triangle becomes a triangle or a quad.
+		glm::vec4 polygon[4];
+		int polygonSize = 0;
+		for (int current = 0; current < 3; ++current) {
+			const int next = (current + 1) % 3;
+			const float currentDistance = vertices[current].z + vertices[current].w;
+			const float nextDistance = vertices[next].z + vertices[next].w;
+			if (currentDistance >= 0.f) {
+				polygon[polygonSize++] = vertices[current];
+			}
+			if ((currentDistance >= 0.f) != (nextDistance >= 0.f)) {
+				const float t = currentDistance / (currentDistance - nextDistance);
+				polygon[polygonSize++] = vertices[current] + (vertices[next] - vertices[current]) * t;
+			}
+		}
+		for (int vertex = 2; vertex < polygonSize; ++vertex) {
+			setupTriangle(polygon[0], polygon[vertex - 1], polygon[vertex]);
+		}
+	}
+	stats.rasterizedTrianglesCount = _setupTriangles.size();
+
+	threadPool.parallelFor(_height, MIN_ROWS_CHUNK_SIZE, [this](size_t begin, size_t end, size_t) {
+		rasterizeRows((int) begin, (int) end);
+	});
+	stats.rasterMs = Timing::getMsSince(startTime);
+
+	startTime = std::chrono::steady_clock::now();
+	for (int level = 1; level < (int) _levels.size(); ++level) {
+		threadPool.parallelFor(_levels[level].height, MIN_ROWS_CHUNK_SIZE, [this, level](size_t begin, size_t end, size_t) {
+			buildLevelRows(level, (int) begin, (int) end);
+		});
+	}
+	stats.pyramidMs = Timing::getMsSince(startTime);
+	return stats;
+}
+
+
+size_t OcclusionCuller::cullSpheres(
+		const SphereBoundsSoa& bounds,
+		std::span<const uint32_t> candidateIndices,
+		std::span<uint32_t> outVisibleIndices,
+		Isa isa
+) const
+{
+	return cull(nullptr, bounds, candidateIndices, outVisibleIndices, isa);
+}
+
+
+size_t OcclusionCuller::cullBoxes(
+		const BoxBoundsSoa& bounds,
+		std::span<const uint32_t> candidateIndices,
+		std::span<uint32_t> outVisibleIndices,
+		Isa isa
+) const
+{
+	return cull(nullptr, bounds, candidateIndices, outVisibleIndices, isa);
+}
+
+
+size_t OcclusionCuller::cullSpheresParallel(
+		ThreadPool& threadPool,
+		const SphereBoundsSoa& bounds,
+		std::span<const uint32_t> candidateIndices,
+		std::span<uint32_t> outVisibleIndices,
+		Isa isa
+) const
+{
+	return cull(&threadPool, bounds, candidateIndices, outVisibleIndices, isa);
+}
+
+
+size_t OcclusionCuller::cullBoxesParallel(
+		ThreadPool& threadPool,
+		const BoxBoundsSoa& bounds,
+		std::span<const uint32_t> candidateIndices,
+		std::span<uint32_t> outVisibleIndices,
+		Isa isa
+) const
+{
+	return cull(&threadPool, bounds, candidateIndices, outVisibleIndices, isa);
+}
+
+
+template <typename Bounds>
+size_t OcclusionCuller::cull(
+		ThreadPool* threadPool,
+		const Bounds& bounds,
+		std::span<const uint32_t> candidateIndices,
+		std::span<uint32_t> outVisibleIndices,
+		Isa isa
+) const
+{
+	assertTrue(outVisibleIndices.size() >= candidateIndices.size());
+	assertTrueMsg(Simd::isSupported(isa), "The instruction set isn't supported by the CPU.");
+	const auto cullRange = [this, &bounds, isa](const uint32_t* candidates, size_t begin, size_t end, uint32_t* out) {
+		switch (isa) {
+#if SIMD_X86
+			case Isa::Avx:
+			case Isa::Sse:
+				return cullSse(bounds, candidates, begin, end, out);
+#endif
+			default:
+				return cullScalar(bounds, candidates, begin, end, out);
+		}
+	};
+
+	const size_t count = candidateIndices.size();
+	if (threadPool == nullptr || count == 0) {
+		return cullRange(candidateIndices.data(), 0, count, outVisibleIndices.data());
+	}
+
+	// Every chunk writes its indices at its own beginning, like in FrustumCuller. A chunk reads its candidates
+	// before it writes over them, so the culling may be in place.
+	const size_t chunksCount = threadPool->getChunksCount(count, MIN_PARALLEL_CHUNK_SIZE);
+	std::vector<size_t> chunkBegins(chunksCount);
+	std::vector<size_t> chunkVisibleCounts(chunksCount);
+	threadPool->parallelFor(count, MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end, size_t chunk) {
+		chunkBegins[chunk] = begin;
+		chunkVisibleCounts[chunk] = cullRange(candidateIndices.data(), begin, end, outVisibleIndices.data() + begin);
+	});
+
+	size_t visibleCount = chunkVisibleCounts[0];
+	for (size_t chunk = 1; chunk < chunksCount; ++chunk) {
+		std::memmove(
+				outVisibleIndices.data() + visibleCount,
+				outVisibleIndices.data() + chunkBegins[chunk],
+				chunkVisibleCounts[chunk] * sizeof(uint32_t)
+		);
+		visibleCount += chunkVisibleCounts[chunk];
+	}
+	return visibleCount;
+}
+
+
+template <typename Bounds>
+size_t OcclusionCuller::cullScalar(const Bounds& bounds, const uint32_t* candidates, size_t begin, size_t end, uint32_t* out) const
+{
+	const glm::mat4& m = _viewProjection;
+	size_t visibleCount = 0;
+	for (size_t i = begin; i < end; ++i) {
+		const uint32_t index = candidates[i];
+		const glm::vec3 center = getCenter(bounds, index);
+		const glm::vec3 extents = getExtents(bounds, index);
+
+		// A corner of the box is the clip center plus or minus the clip axes, so the matrix is applied once.
+		float clipCenter[4];
+		float axisX[4];
+		float axisY[4];
+		float axisZ[4];
+		for (int row = 0; row < 4; ++row) {
+			clipCenter[row] = m[0][row] * center.x + m[1][row] * center.y + m[2][row] * center.z + m[3][row];
+			axisX[row] = m[0][row] * extents.x;
+			axisY[row] = m[1][row] * extents.y;
+			axisZ[row] = m[2][row] * extents.z;
+		}
+
+		bool isCrossingNear = false;
+		float minX = std::numeric_limits<float>::infinity();
+		float minY = minX;
+		float minZ = minX;
+		float maxX = -minX;
+		float maxY = -minX;
+		for (int corner = 0; corner < 8; ++corner) {
+			float position[4];
+			for (int row = 0; row < 4; ++row) {
+				float value = (corner & 1) ? clipCenter[row] + axisX[row] : clipCenter[row] - axisX[row];
+				value = (corner & 2) ? value + axisY[row] : value - axisY[row];
+				position[row] = (corner & 4) ? value + axisZ[row] : value - axisZ[row];
+			}
+			isCrossingNear = isCrossingNear || (position[2] < -position[3]);
+
+			const float inverseW = 1.f / position[3];
+			const float x = position[0] * inverseW;
+			const float y = position[1] * inverseW;
+			minX = minFloat(minX, x);
+			minY = minFloat(minY, y);
+			minZ = minFloat(minZ, position[2] * inverseW);
+			maxX = maxFloat(maxX, x);
+			maxY = maxFloat(maxY, y);
+		}
+
+		// The bounds in front of the camera and behind it can't be projected, so they are visible.
+		out[visibleCount] = index;
+		visibleCount += isCrossingNear || isRectVisible(minX, minY, maxX, maxY, minZ);
+	}
+	return visibleCount;
+}
+
+
+#if SIMD_X86
+template <typename Bounds>
+size_t OcclusionCuller::cullSse(const Bounds& bounds, const uint32_t* candidates, size_t begin, size_t end, uint32_t* out) const
+{
+	// The operations are the same as in the scalar kernel and in the same order, so the results are equal bit for bit.
+	__m128 m[4][4];
+	for (int column = 0; column < 4; ++column) {
+		for (int row = 0; row < 4; ++row) {
+			m[column][row] = _mm_set1_ps(_viewProjection[column][row]);
+		}
+	}
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 signMask = _mm_set1_ps(-0.f);
+
+	alignas(16) float minXs[4];
+	alignas(16) float minYs[4];
+	alignas(16) float minZs[4];
+	alignas(16) float maxXs[4];
+	alignas(16) float maxYs[4];
+	size_t visibleCount = 0;
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4) {
+		// The indices are read before any of them is overwritten, so the culling may be in place.
+		const uint32_t indices[4] = {candidates[i], candidates[i + 1], candidates[i + 2], candidates[i + 3]};
+		__m128 centerX, centerY, centerZ;
+		__m128 extentX, extentY, extentZ;
+		gatherCenters(bounds, indices, centerX, centerY, centerZ);
+		gatherExtents(bounds, indices, extentX, extentY, extentZ);
+
+		__m128 clipCenter[4];
+		__m128 axisX[4];
+		__m128 axisY[4];
+		__m128 axisZ[4];
+		for (int row = 0; row < 4; ++row) {
+			__m128 value = _mm_add_ps(_mm_mul_ps(m[0][row], centerX), _mm_mul_ps(m[1][row], centerY));
+			value = _mm_add_ps(value, _mm_mul_ps(m[2][row], centerZ));
+			clipCenter[row] = _mm_add_ps(value, m[3][row]);
+			axisX[row] = _mm_mul_ps(m[0][row], extentX);
+			axisY[row] = _mm_mul_ps(m[1][row], extentY);
+			axisZ[row] = _mm_mul_ps(m[2][row], extentZ);
+		}
+
+		__m128 isCrossingNear = _mm_setzero_ps();
+		__m128 minX = _mm_set1_ps(std::numeric_limits<float>::infinity());
+		__m128 minY = minX;
+		__m128 minZ = minX;
+		__m128 maxX = _mm_xor_ps(minX, signMask);
+		__m128 maxY = maxX;
+		for (int corner = 0; corner < 8; ++corner) {
+			__m128 position[4];
+			for (int row = 0; row < 4; ++row) {
+				__m128 value = (corner & 1) ? _mm_add_ps(clipCenter[row], axisX[row]) : _mm_sub_ps(clipCenter[row], axisX[row]);
+				value = (corner & 2) ? _mm_add_ps(value, axisY[row]) : _mm_sub_ps(value, axisY[row]);
+				position[row] = (corner & 4) ? _mm_add_ps(value, axisZ[row]) : _mm_sub_ps(value, axisZ[row]);
+			}
+			isCrossingNear = _mm_or_ps(isCrossingNear, _mm_cmplt_ps(position[2], _mm_xor_ps(position[3], signMask)));
+
+			const __m128 inverseW = _mm_div_ps(one, position[3]);
+			const __m128 x = _mm_mul_ps(position[0], inverseW);
+			const __m128 y = _mm_mul_ps(position[1], inverseW);
+			minX = _mm_min_ps(minX, x);
+			minY = _mm_min_ps(minY, y);
+			minZ = _mm_min_ps(minZ, _mm_mul_ps(position[2], inverseW));
+			maxX = _mm_max_ps(maxX, x);
+			maxY = _mm_max_ps(maxY, y);
+		}
+
+		// The pyramid lookups are gathers, so they are per lane.
+		_mm_store_ps(minXs, minX);
+		_mm_store_ps(minYs, minY);
+		_mm_store_ps(minZs, minZ);
+		_mm_store_ps(maxXs, maxX);
+		_mm_store_ps(maxYs, maxY);
+		const int crossingMask = _mm_movemask_ps(isCrossingNear);
+		for (int lane = 0; lane < 4; ++lane) {
+			out[visibleCount] = indices[lane];
+			visibleCount += ((crossingMask >> lane) & 1) || isRectVisible(minXs[lane], minYs[lane], maxXs[lane], maxYs[lane], minZs[lane]);
+		}
+	}
+
+	return visibleCount + cullScalar(bounds, candidates, i, end, out + visibleCount);
+}
+#endif
+
+
+bool OcclusionCuller::isRectVisible(float minX, float minY, float maxX, float maxY, float nearestZ) const
+{
+	// The viewport transform of GL, the same as for the occluders.
+	const float pixelMinX = (minX * 0.5f + 0.5f) * (float) _width;
+	const float pixelMinY = (minY * 0.5f + 0.5f) * (float) _height;
+	const float pixelMaxX = (maxX * 0.5f + 0.5f) * (float) _width;
+	const float pixelMaxY = (maxY * 0.5f + 0.5f) * (float) _height;
+	if (pixelMaxX < 0.f || pixelMaxY < 0.f || pixelMinX >= (float) _width || pixelMinY >= (float) _height) {
+		return false;
+	}
+
+	// All pixels, which the rectangle touches.
+	const int x0 = (int) std::max(pixelMinX, 0.f);
+	const int y0 = (int) std::max(pixelMinY, 0.f);
+	const int x1 = (int) std::min(pixelMaxX, (float) (_width - 1));
+	const int y1 = (int) std::min(pixelMaxY, (float) (_height - 1));
+
+	// At the level 2^L, where the rectangle size is less than 2^L pixels, it covers at most 2x2 texels.
+	const auto size = (unsigned int) std::max(x1 - x0, y1 - y0);
+	const int levelIndex = std::min((int) std::bit_width(size), (int) _levels.size() - 1);
+	const Level& level = _levels[levelIndex];
+	const float* depths = _depthPyramid.data() + level.offset;
+
+	float maxDepth = 0.f;
+	for (int y = y0 >> levelIndex; y <= (y1 >> levelIndex); ++y) {
+		for (int x = x0 >> levelIndex; x <= (x1 >> levelIndex); ++x) {
+			maxDepth = std::max(maxDepth, depths[(size_t) y * level.width + x]);
+		}
+	}
+	return nearestZ * 0.5f + 0.5f <= maxDepth;
+}
+
+
+void OcclusionCuller::setupTriangle(const glm::vec4& p0, const glm::vec4& p1, const glm::vec4& p2)
+{
+	const glm::vec4* vertices[3] = {&p0, &p1, &p2};
+	float positionsX[3];
+	float positionsY[3];
+	float depths[3];
+	for (int i = 0; i < 3; ++i) {
+		const float inverseW = 1.f / vertices[i]->w;
+		positionsX[i] = (vertices[i]->x * inverseW * 0.5f + 0.5f) * (float) _width;
+		positionsY[i] = (vertices[i]->y * inverseW * 0.5f + 0.5f) * (float) _height;
+		depths[i] = vertices[i]->z * inverseW * 0.5f + 0.5f;
+	}
+
+	// Both windings occlude. Clockwise triangles are turned, so the inside is positive.
+	float doubleArea = (positionsX[1] - positionsX[0]) * (positionsY[2] - positionsY[0])
+			- (positionsX[2] - positionsX[0]) * (positionsY[1] - positionsY[0]);
+	if (!(doubleArea != 0.f) || !std::isfinite(doubleArea)) {
+		return;
+	}
+	if (doubleArea < 0.f) {
+		std::swap(positionsX[1], positionsX[2]);
+		std::swap(positionsY[1], positionsY[2]);
+		std::swap(depths[1], depths[2]);
+		doubleArea = -doubleArea;
+	}
+
+	const int minX = (int) std::max(0.f, std::ceil(std::min({positionsX[0], positionsX[1], positionsX[2]}) - 0.5f));
+	const int maxX = (int) std::min((float) (_width - 1), std::floor(std::max({positionsX[0], positionsX[1], positionsX[2]}) - 0.5f));
+	const int minY = (int) std::max(0.f, std::ceil(std::min({positionsY[0], positionsY[1], positionsY[2]}) - 0.5f));
+	const int maxY = (int) std::min((float) (_height - 1), std::floor(std::max({positionsY[0], positionsY[1], positionsY[2]}) - 0.5f));
+	if (minX > maxX || minY > maxY) {
+		return;
+	}
+
+	SetupTriangle& triangle = _setupTriangles.emplace_back();
+	for (int edge = 0; edge < 3; ++edge) {
+		const int next = (edge + 1) % 3;
+		triangle.edgeA[edge] = positionsY[edge] - positionsY[next];
+		triangle.edgeB[edge] = positionsX[next] - positionsX[edge];
+		triangle.edgeC[edge] = positionsX[edge] * positionsY[next] - positionsX[next] * positionsY[edge];
+		triangle.inverseEdgeA[edge] = (triangle.edgeA[edge] != 0.f) ? 1.f / triangle.edgeA[edge] : 0.f;
+	}
+
+	const float inverseArea = 1.f / doubleArea;
+	const float deltaX1 = positionsX[1] - positionsX[0];
+	const float deltaY1 = positionsY[1] - positionsY[0];
+	const float deltaX2 = positionsX[2] - positionsX[0];
+	const float deltaY2 = positionsY[2] - positionsY[0];
+	const float deltaDepth1 = depths[1] - depths[0];
+	const float deltaDepth2 = depths[2] - depths[0];
+	triangle.depthPlane[0] = (deltaDepth1 * deltaY2 - deltaDepth2 * deltaY1) * inverseArea;
+	triangle.depthPlane[1] = (deltaDepth2 * deltaX1 - deltaDepth1 * deltaX2) * inverseArea;
+	triangle.depthPlane[2] = depths[0] - triangle.depthPlane[0] * positionsX[0] - triangle.depthPlane[1] * positionsY[0];
+	triangle.minX = minX;
+	triangle.minY = minY;
+	triangle.maxX = maxX;
+	triangle.maxY = maxY;
+}
+
+
+void OcclusionCuller::rasterizeRows(int beginY, int endY)
+{
+	float* depthRows = _depthPyramid.data();
+	std::fill(depthRows + (size_t) beginY * _width, depthRows + (size_t) endY * _width, 1.f);
+
+	// The depth test is the minimum, which doesn't depend on the order, so the triangles may overlap on the edges.
+	for (const SetupTriangle& triangle : _setupTriangles) {
+		const int triangleBeginY = std::max(triangle.minY, beginY);
+		const int triangleEndY = std::min(triangle.maxY + 1, endY);
+		for (int y = triangleBeginY; y < triangleEndY; ++y) {
+			// The edge functions are linear in x, so the covered pixel centers of the row are one span.
+			const float pixelY = (float) y + 0.5f;
+			float spanBegin = (float) triangle.minX + 0.5f;
+			float spanEnd = (float) triangle.maxX + 0.5f;
+			for (int edge = 0; edge < 3; ++edge) {
+				const float a = triangle.edgeA[edge];
+				const float value = triangle.edgeB[edge] * pixelY + triangle.edgeC[edge];
+				if (a > 0.f) {
+					spanBegin = std::max(spanBegin, -value * triangle.inverseEdgeA[edge]);
+				} else if (a < 0.f) {
+					spanEnd = std::min(spanEnd, -value * triangle.inverseEdgeA[edge]);
+				} else if (value < 0.f) {
+					spanEnd = -1.f;
+				}
+			}
+			if (!(spanBegin <= spanEnd)) {
+				continue;
+			}
+			const int x0 = (int) std::ceil(spanBegin - 0.5f);
+			const int x1 = (int) std::floor(spanEnd - 0.5f);
+
+			float* row = depthRows + (size_t) y * _width;
+			const float rowDepth = triangle.depthPlane[1] * pixelY + triangle.depthPlane[2];
+			for (int x = x0; x <= x1; ++x) {
+				const float depth = triangle.depthPlane[0] * ((float) x + 0.5f) + rowDepth;
+				row[x] = std::min(row[x], depth);
+			}
+		}
+	}
+}
+
+
+void OcclusionCuller::buildLevelRows(int levelIndex, int beginY, int endY)
+{
+	const Level& source = _levels[levelIndex - 1];
+	const Level& level = _levels[levelIndex];
+	const float* sourceDepths = _depthPyramid.data() + source.offset;
+	float* depths = _depthPyramid.data() + level.offset;
+
+	// Odd sizes are rounded up, so the last texel covers one source texel in that dimension.
+	for (int y = beginY; y < endY; ++y) {
+		const float* sourceRow0 = sourceDepths + (size_t) (2 * y) * source.width;
+		const float* sourceRow1 = sourceDepths + (size_t) std::min(2 * y + 1, source.height - 1) * source.width;
+		float* row = depths + (size_t) y * level.width;
+		for (int x = 0; x < level.width; ++x) {
+			const int x0 = 2 * x;
+			const int x1 = std::min(2 * x + 1, source.width - 1);
+			row[x] = std::max(std::max(sourceRow0[x0], sourceRow0[x1]), std::max(sourceRow1[x0], sourceRow1[x1]));
+		}
+	}
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "AlignedAllocator.hpp"
+#include "FrustumCuller.hpp"
+#include "Simd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+
+class GeometricModel;
+class ThreadPool;
+
+
+/**
+ * @brief Culls the bounds, which are hidden behind the occluders, with a hierarchical depth buffer (Hi-Z) on CPU.
+ * The occluders are rasterized to a low resolution depth buffer, and a pyramid of the max depths is built over it.
+ * A candidate is projected to a screen rectangle with its nearest depth, and the rectangle is tested against
+ * the pyramid level, where it covers at most 2x2 texels. So a test costs the same for any bounds size.
+ *
+ * The test is conservative for the bounds, which contain the occluder geometry, so the occluders are candidates too.
+ * The occluders are sampled at the pixel centers like on GPU, so a candidate may be culled, if it's visible only
+ * through the gaps narrower than a pixel of the depth buffer.
+ *
+ * Usage per frame: beginFrame(), addOccluder() for every occluder, rasterizeOccluders(), then any number of culls.
+ */
+class OcclusionCuller
+{
+public:
+	using Isa = Simd::Isa;
+
+	// Ranges shorter than this aren't split between threads.
+	static constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 16 * 1024;
+
+	/**
+	 * @brief Counters and timings of rasterizeOccluders().
+	 */
+	struct Stats
+	{
+		size_t occluderTrianglesCount = 0;
+		// Triangles which have passed the clipping and have covered pixel centers.
+		size_t rasterizedTrianglesCount = 0;
+		double rasterMs = 0.0;
+		double pyramidMs = 0.0;
+	};
+
+public:
+	/**
+	 * @param width, height The size of the depth buffer. A quarter of the screen size in each dimension is enough
+	 * 	for the occluders, which are much larger than the candidates.
+	 */
+	OcclusionCuller(int width, int height);
+
+	[[nodiscard]]
+	int getWidth() const { return _width; }
+
+	[[nodiscard]]
+	int getHeight() const { return _height; }
+
+	[[nodiscard]]
+	int getLevelsCount() const { return (int) _levels.size(); }
+
+	/**
+	 * @brief Removes the occluders of the previous frame and sets the camera of the frame.
+	 */
+	void beginFrame(const glm::mat4& viewProjection);
+
+	/**
+	 * @brief Transforms the triangles of the model to the clip space. The model isn't referenced after the call.
+	 */
+	void addOccluder(const GeometricModel& model, const glm::mat4& modelMatrix);
+
+	/**
+	 * @brief Rasterizes the occluders to the depth buffer and builds the pyramid. The rows are split between the threads.
+	 */
+	Stats rasterizeOccluders(ThreadPool& threadPool);
+
+	/**
+	 * @brief Tests the candidates, which are the indices of the bounds, e.g. the ones after the frustum culling.
+	 * @param outVisibleIndices It must have room for candidateIndices.size() indices. It may be candidateIndices itself.
+	 * @param isa It must be supported by the CPU. AVX uses the SSE kernel: the pyramid lookups are per candidate,
+	 * 	so wider projections don't pay off.
+	 * @return The number of visible candidates, which are written to the beginning of outVisibleIndices in the same order.
+	 * 	All instruction sets and threads counts give the same results.
+	 */
+	size_t cullSpheres(
+			const SphereBoundsSoa& bounds,
+			std::span<const uint32_t> candidateIndices,
+			std::span<uint32_t> outVisibleIndices,
+			Isa isa = Simd::getBestIsa()
+	) const;
+
+	size_t cullBoxes(
+			const BoxBoundsSoa& bounds,
+			std::span<const uint32_t> candidateIndices,
+			std::span<uint32_t> outVisibleIndices,
+			Isa isa = Simd::getBestIsa()
+	) const;
+
+	/**
+	 * @brief The same as cullSpheres(), but the candidates are split between the threads of the pool.
+	 */
+	size_t cullSpheresParallel(
+			ThreadPool& threadPool,
+			const SphereBoundsSoa& bounds,
+			std::span<const uint32_t> candidateIndices,
+			std::span<uint32_t> outVisibleIndices,
+			Isa isa = Simd::getBestIsa()
+	) const;
+
+	size_t cullBoxesParallel(
+			ThreadPool& threadPool,
+			const BoxBoundsSoa& bounds,
+			std::span<const uint32_t> candidateIndices,
+			std::span<uint32_t> outVisibleIndices,
+			Isa isa = Simd::getBestIsa()
+	) const;
+
+private:
+	/**
+	 * @brief An occluder triangle in the screen space. Values are evaluated at pixel centers as a * x + b * y + c.
+	 */
+	struct SetupTriangle
+	{
+		// Edge functions: a pixel center is inside, if none of them is negative.
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		// The span of a row is bounded by the x, where an edge function is 0, so the division is precomputed.
+		float inverseEdgeA[3];
+		float depthPlane[3];
+		// Covered pixel bounds, inclusive.
+		int minX = 0;
+		int minY = 0;
+		int maxX = 0;
+		int maxY = 0;
+	};
+
+	struct Level
+	{
+		int width = 0;
+		int height = 0;
+		// The offset of the level in _depthPyramid.
+		size_t offset = 0;
+	};
+
+	template <typename Bounds>
+	size_t cull(
+			ThreadPool* threadPool,
+			const Bounds& bounds,
+			std::span<const uint32_t> candidateIndices,
+			std::span<uint32_t> outVisibleIndices,
+			Isa isa
+	) const;
+
+	template <typename Bounds>
+	size_t cullScalar(const Bounds& bounds, const uint32_t* candidates, size_t begin, size_t end, uint32_t* out) const;
+
+#if SIMD_X86
+	template <typename Bounds>
+	size_t cullSse(const Bounds& bounds, const uint32_t* candidates, size_t begin, size_t end, uint32_t* out) const;
+#endif
+
+	/**
+	 * @brief Tests the screen rectangle of a candidate in NDC against the pyramid.
+	 */
+	[[nodiscard]]
+	bool isRectVisible(float minX, float minY, float maxX, float maxY, float nearestZ) const;
+
+	void setupTriangle(const glm::vec4& p0, const glm::vec4& p1, const glm::vec4& p2);
+
+	void rasterizeRows(int beginY, int endY);
+
+	void buildLevelRows(int level, int beginY, int endY);
+
+private:
+	int _width = 0;
+	int _height = 0;
+	glm::mat4 _viewProjection = glm::mat4(1.f);
+
+	// Clip space vertices, 3 per triangle.
+	std::vector<glm::vec4> _occluderVertices;
+	std::vector<SetupTriangle> _setupTriangles;
+
+	// The window depths in [0, 1] of all levels: the full resolution first, then the halves up to 1x1.
+	// Rows go from bottom to top, like in GL.
+	AlignedVector<float, Simd::ALIGNMENT> _depthPyramid;
+	std::vector<Level> _levels;
+};
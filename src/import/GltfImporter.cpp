@@ -0,0 +1,839 @@
+#include "GltfImporter.hpp"
+
+#include "Hash.hpp"
+#include "Json.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+#include "Timing.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/matrix.hpp>
+
+
+namespace {
+	constexpr uint32_t NO_INDEX = UINT32_MAX;
+	const VertexFormat::Color DEFAULT_COLOR = {1.f, 1.f, 1.f, 1.f};
+
+	constexpr uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+	constexpr uint32_t GLB_VERSION = 2;
+	constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+	constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942; // "BIN\0"
+	constexpr size_t GLB_HEADER_SIZE = 12;
+	constexpr size_t GLB_CHUNK_HEADER_SIZE = 8;
+
+	constexpr int MODE_TRIANGLES = 4;
+
+	constexpr int COMPONENT_BYTE = 5120;
+	constexpr int COMPONENT_UNSIGNED_BYTE = 5121;
+	constexpr int COMPONENT_SHORT = 5122;
+	constexpr int COMPONENT_UNSIGNED_SHORT = 5123;
+	constexpr int COMPONENT_UNSIGNED_INT = 5125;
+	constexpr int COMPONENT_FLOAT = 5126;
+
+	// JSON numbers are doubles: larger integers aren't exact.
+	constexpr double MAX_EXACT_INTEGER = 9007199254740992.0;
+
+	constexpr std::array<int8_t, 256> BASE64_VALUES = []() {
+		std::array<int8_t, 256> values = {};
+		values.fill(-1);
+		for (int i = 0; i < 26; ++i) {
+			values['A' + i] = (int8_t) i;
+			values['a' + i] = (int8_t) (26 + i);
+		}
+		for (int i = 0; i < 10; ++i) {
+			values['0' + i] = (int8_t) (52 + i);
+		}
+		values['+'] = 62;
+		values['/'] = 63;
+		return values;
+	}();
+
+
+	bool fail(const char* message)
+	{
+		std::cerr << "[GltfImporter] " << message << std::endl;
+		return false;
+	}
+
+
+	/**
+	 * @brief A typed view of a buffer: the elements are read with memcpy, since they may be unaligned.
+	 */
+	struct Accessor
+	{
+		const std::byte* data = nullptr;
+		size_t count = 0;
+		size_t stride = 0;
+		int componentType = 0;
+		size_t componentsCount = 0;
+		bool isNormalized = false;
+	};
+
+
+	/**
+	 * @brief A triangle primitive of a mesh instance and its place in the merged arrays.
+	 */
+	struct Primitive
+	{
+		Accessor positions;
+		std::optional<Accessor> texCoords;
+		std::optional<Accessor> colors;
+		std::optional<Accessor> indices;
+		glm::mat4 transform = glm::mat4(1.f);
+		bool isIdentity = true;
+		// A mirroring transform turns the triangles inside out, so their winding is swapped back.
+		bool isMirrored = false;
+		size_t firstVertex = 0;
+		size_t firstIndex = 0;
+		size_t indicesCount = 0;
+	};
+
+
+	/**
+	 * @brief The document and the data of its buffers. The buffers are views of the mapped files, the GLB chunk
+	 * or the decoded data URIs, which are owned here.
+	 */
+	struct Asset
+	{
+		const JsonValue* document = nullptr;
+		std::vector<std::span<const std::byte>> buffers;
+		std::vector<std::unique_ptr<MappedFile>> mappedFiles;
+		std::vector<std::vector<std::byte>> decodedBuffers;
+		size_t bytesCount = 0;
+	};
+
+
+	/**
+	 * @brief Reads a non-negative integer member. A missing member gets the default value.
+	 * @return false, if the member is invalid or it's missing and required (the default value is SIZE_MAX).
+	 */
+	bool getSize(const JsonValue& object, std::string_view key, size_t defaultValue, size_t& outValue)
+	{
+		const JsonValue* value = object.find(key);
+		if (value == nullptr) {
+			outValue = defaultValue;
+			return defaultValue != SIZE_MAX;
+		}
+		const double number = value->getNumber(-1.0);
+		if (!(number >= 0.0 && number <= MAX_EXACT_INTEGER) || number != std::floor(number)) {
+			return false;
+		}
+		outValue = (size_t) number;
+		return true;
+	}
+
+
+	/**
+	 * @brief Returns the element of a top-level array of the document, e.g. "accessors", by the index value, or nullptr.
+	 */
+	const JsonValue* getElement(const JsonValue& document, std::string_view arrayKey, const JsonValue* indexValue)
+	{
+		const JsonValue* array = document.find(arrayKey);
+		if (array == nullptr || array->getType() != JsonValue::Type::Array || indexValue == nullptr) {
+			return nullptr;
+		}
+		const double index = indexValue->getNumber(-1.0);
+		const std::span<const JsonValue> elements = array->getElements();
+		if (!(index >= 0.0 && index < (double) elements.size()) || index != std::floor(index)) {
+			return nullptr;
+		}
+		return &elements[(size_t) index];
+	}
+
+
+	bool decodeBase64(std::string_view text, std::vector<std::byte>& outData)
+	{
+		outData.reserve(text.size() / 4 * 3);
+		uint32_t bits = 0;
+		int bitsCount = 0;
+		for (const char c : text) {
+			if (c == '=') {
+				break;
+			}
+			const int8_t value = BASE64_VALUES[(uint8_t) c];
+			if (value < 0) {
+				return false;
+			}
+			bits = (bits << 6) | (uint32_t) value;
+			bitsCount += 6;
+			if (bitsCount >= 8) {
+				bitsCount -= 8;
+				outData.push_back((std::byte) (bits >> bitsCount));
+			}
+		}
+		return true;
+	}
+
+
+	/**
+	 * @brief Decodes the %XX escapes of a relative URI, e.g. %20 of the spaces in the file names.
+	 */
+	std::string decodeUri(std::string_view uri)
+	{
+		std::string path;
+		path.reserve(uri.size());
+		for (size_t i = 0; i < uri.size(); ++i) {
+			uint8_t value = 0;
+			if (uri[i] == '%' && i + 3 <= uri.size()
+					&& std::from_chars(uri.data() + i + 1, uri.data() + i + 3, value, 16).ptr == uri.data() + i + 3) {
+				path.push_back((char) value);
+				i += 2;
+			} else {
+				path.push_back(uri[i]);
+			}
+		}
+		return path;
+	}
+
+
+	bool loadBuffers(Asset& asset, std::optional<std::span<const std::byte>> binChunk, const std::filesystem::path& directory)
+	{
+		const JsonValue* buffers = asset.document->find("buffers");
+		if (buffers == nullptr) {
+			return true;
+		}
+		for (const JsonValue& buffer : buffers->getElements()) {
+			size_t byteLength = 0;
+			if (!getSize(buffer, "byteLength", SIZE_MAX, byteLength)) {
+				return fail("A buffer has no valid byteLength.");
+			}
+
+			std::span<const std::byte> data;
+			const JsonValue* uriValue = buffer.find("uri");
+			const std::string_view uri = (uriValue != nullptr) ? uriValue->getString() : std::string_view();
+			if (uriValue == nullptr) {
+				// Only the first buffer of GLB may refer to the binary chunk.
+				if (!asset.buffers.empty() || !binChunk.has_value()) {
+					return fail("A buffer has no URI.");
+				}
+				data = *binChunk;
+			} else if (uri.starts_with("data:")) {
+				const size_t dataStart = uri.find(',');
+				if (dataStart == std::string_view::npos || !uri.substr(0, dataStart).ends_with(";base64")) {
+					return fail("Only base64 data URIs are supported.");
+				}
+				std::vector<std::byte>& decodedData = asset.decodedBuffers.emplace_back();
+				if (!decodeBase64(uri.substr(dataStart + 1), decodedData)) {
+					return fail("Invalid base64 data of a buffer.");
+				}
+				data = decodedData;
+			} else {
+				const std::filesystem::path filePath = directory / std::filesystem::path(decodeUri(uri));
+				const MappedFile& file = *asset.mappedFiles.emplace_back(std::make_unique<MappedFile>(filePath));
+				if (!file.isOpen()) {
+					std::cerr << "[GltfImporter] Can't open the buffer file " << filePath << "." << std::endl;
+					return false;
+				}
+				data = file.getBytes();
+				asset.bytesCount += file.getSize();
+			}
+
+			if (data.size() < byteLength) {
+				return fail("A buffer is shorter than its byteLength.");
+			}
+			asset.buffers.push_back(data.first(byteLength));
+		}
+		return true;
+	}
+
+
+	size_t getComponentSize(int componentType)
+	{
+		switch (componentType) {
+			case COMPONENT_BYTE:
+			case COMPONENT_UNSIGNED_BYTE:
+				return 1;
+			case COMPONENT_SHORT:
+			case COMPONENT_UNSIGNED_SHORT:
+				return 2;
+			case COMPONENT_UNSIGNED_INT:
+			case COMPONENT_FLOAT:
+				return 4;
+			default:
+				return 0;
+		}
+	}
+
+
+	size_t getComponentsCount(std::string_view type)
+	{
+		if (type == "SCALAR") {
+			return 1;
+		}
+		if (type == "VEC2") {
+			return 2;
+		}
+		if (type == "VEC3") {
+			return 3;
+		}
+		if (type == "VEC4") {
+			return 4;
+		}
+		return 0;
+	}
+
+
+	/**
+	 * @brief Resolves the accessor and checks that all its elements lie in the buffer view.
+	 */
+	bool getAccessor(const Asset& asset, const JsonValue* indexValue, Accessor& outAccessor)
+	{
+		const JsonValue& document = *asset.document;
+		const JsonValue* accessor = getElement(document, "accessors", indexValue);
+		if (accessor == nullptr) {
+			return fail("Invalid accessor index.");
+		}
+		if (accessor->find("sparse") != nullptr) {
+			return fail("Sparse accessors aren't supported.");
+		}
+		const JsonValue* bufferView = getElement(document, "bufferViews", accessor->find("bufferView"));
+		if (bufferView == nullptr) {
+			return fail("Accessors without buffer views aren't supported.");
+		}
+
+		const JsonValue* componentTypeValue = accessor->find("componentType");
+		const JsonValue* typeValue = accessor->find("type");
+		outAccessor.componentType = (int) ((componentTypeValue != nullptr) ? componentTypeValue->getNumber() : 0.0);
+		outAccessor.componentsCount = (typeValue != nullptr) ? getComponentsCount(typeValue->getString()) : 0;
+		const JsonValue* normalizedValue = accessor->find("normalized");
+		outAccessor.isNormalized = (normalizedValue != nullptr) && normalizedValue->getBool();
+		const size_t componentSize = getComponentSize(outAccessor.componentType);
+		if (componentSize == 0 || outAccessor.componentsCount == 0) {
+			return fail("Unsupported accessor type: only scalars and vectors of the standard components are read.");
+		}
+
+		size_t bufferIndex = 0;
+		size_t accessorOffset = 0;
+		size_t viewOffset = 0;
+		size_t viewLength = 0;
+		size_t viewStride = 0;
+		if (!getSize(*accessor, "count", SIZE_MAX, outAccessor.count)
+				|| !getSize(*accessor, "byteOffset", 0, accessorOffset)
+				|| !getSize(*bufferView, "buffer", SIZE_MAX, bufferIndex)
+				|| !getSize(*bufferView, "byteOffset", 0, viewOffset)
+				|| !getSize(*bufferView, "byteLength", SIZE_MAX, viewLength)
+				|| !getSize(*bufferView, "byteStride", 0, viewStride)) {
+			return fail("Invalid accessor or buffer view fields.");
+		}
+		if (bufferIndex >= asset.buffers.size()) {
+			return fail("Invalid buffer index.");
+		}
+		const std::span<const std::byte> buffer = asset.buffers[bufferIndex];
+		const size_t elementSize = componentSize * outAccessor.componentsCount;
+		outAccessor.stride = (viewStride != 0) ? viewStride : elementSize;
+		// The count is checked first, so the end of the last element doesn't overflow.
+		if (viewOffset > buffer.size() || viewLength > buffer.size() - viewOffset || outAccessor.count > viewLength
+				|| (outAccessor.count > 0
+						&& accessorOffset + outAccessor.stride * (outAccessor.count - 1) + elementSize > viewLength)) {
+			return fail("An accessor is out of its buffer.");
+		}
+		outAccessor.data = buffer.data() + viewOffset + accessorOffset;
+		return true;
+	}
+
+
+	template <typename Component>
+	float convertComponent(Component value, bool isNormalized)
+	{
+		if constexpr (std::is_floating_point_v<Component>) {
+			return value;
+		} else if (!isNormalized) {
+			return (float) value;
+		} else if constexpr (std::is_signed_v<Component>) {
+			return std::max((float) value / (float) std::numeric_limits<Component>::max(), -1.f);
+		} else {
+			return (float) value / (float) std::numeric_limits<Component>::max();
+		}
+	}
+
+
+	template <typename Component, typename Function>
+	void readElements(const Accessor& accessor, size_t begin, size_t end, Function&& function)
+	{
+		float values[4] = {};
+		for (size_t i = begin; i < end; ++i) {
+			const std::byte* element = accessor.data + i * accessor.stride;
+			for (size_t component = 0; component < accessor.componentsCount; ++component) {
+				Component value;
+				std::memcpy(&value, element + component * sizeof(Component), sizeof(Component));
+				values[component] = convertComponent(value, accessor.isNormalized);
+			}
+			function(i, values);
+		}
+	}
+
+
+	/**
+	 * @brief Calls function(index, const float* values) for the elements [begin, end) converted to floats.
+	 * The switch is out of the loop, so every component type has its own loop.
+	 */
+	template <typename Function>
+	void forEachElement(const Accessor& accessor, size_t begin, size_t end, Function&& function)
+	{
+		switch (accessor.componentType) {
+			case COMPONENT_BYTE:
+				readElements<int8_t>(accessor, begin, end, function);
+				break;
+			case COMPONENT_UNSIGNED_BYTE:
+				readElements<uint8_t>(accessor, begin, end, function);
+				break;
+			case COMPONENT_SHORT:
+				readElements<int16_t>(accessor, begin, end, function);
+				break;
+			case COMPONENT_UNSIGNED_SHORT:
+				readElements<uint16_t>(accessor, begin, end, function);
+				break;
+			case COMPONENT_UNSIGNED_INT:
+				readElements<uint32_t>(accessor, begin, end, function);
+				break;
+			case COMPONENT_FLOAT:
+				readElements<float>(accessor, begin, end, function);
+				break;
+			default:
+				break;
+		}
+	}
+
+
+	template <typename Component>
+	void readIndices(const Accessor& accessor, size_t begin, size_t end, GeometricModel::IndexType* outIndices)
+	{
+		for (size_t i = begin; i < end; ++i) {
+			Component value;
+			std::memcpy(&value, accessor.data + i * accessor.stride, sizeof(Component));
+			outIndices[i] = value;
+		}
+	}
+
+
+	glm::mat4 getNodeTransform(const JsonValue& node)
+	{
+		const JsonValue* matrix = node.find("matrix");
+		if (matrix != nullptr && matrix->getElements().size() == 16) {
+			// Column-major, like glm.
+			glm::mat4 transform;
+			for (size_t i = 0; i < 16; ++i) {
+				transform[(int) (i / 4)][(int) (i % 4)] = (float) matrix->getElements()[i].getNumber();
+			}
+			return transform;
+		}
+
+		const auto readVector = [&](std::string_view key, float defaultValue, float* outValues, size_t count) {
+			const JsonValue* vector = node.find(key);
+			const bool isValid = (vector != nullptr) && vector->getElements().size() == count;
+			for (size_t i = 0; i < count; ++i) {
+				outValues[i] = isValid ? (float) vector->getElements()[i].getNumber(defaultValue) : defaultValue;
+			}
+		};
+		glm::vec3 translation;
+		glm::vec3 scale;
+		float rotation[4];
+		readVector("translation", 0.f, &translation.x, 3);
+		readVector("scale", 1.f, &scale.x, 3);
+		readVector("rotation", 0.f, rotation, 4);
+		if (node.find("rotation") == nullptr) {
+			rotation[3] = 1.f;
+		}
+		// glTF quaternions are x, y, z, w.
+		const glm::quat orientation(rotation[3], rotation[0], rotation[1], rotation[2]);
+		return glm::translate(glm::mat4(1.f), translation) * glm::mat4_cast(orientation) * glm::scale(glm::mat4(1.f), scale);
+	}
+
+
+	/**
+	 * @brief Collects the meshes of the default scene with their world transforms. A document without scenes is
+	 * a library of meshes: every one is added once without a transform.
+	 */
+	bool collectMeshInstances(const JsonValue& document, std::vector<std::pair<const JsonValue*, glm::mat4>>& outInstances)
+	{
+		const JsonValue* scenes = document.find("scenes");
+		if (scenes == nullptr || scenes->getElements().empty()) {
+			const JsonValue* meshes = document.find("meshes");
+			if (meshes != nullptr) {
+				for (const JsonValue& mesh : meshes->getElements()) {
+					outInstances.emplace_back(&mesh, glm::mat4(1.f));
+				}
+			}
+			return true;
+		}
+
+		const JsonValue* sceneIndex = document.find("scene");
+		const JsonValue* scene = (sceneIndex != nullptr) ? getElement(document, "scenes", sceneIndex) : &scenes->getElements()[0];
+		if (scene == nullptr) {
+			return fail("Invalid scene index.");
+		}
+		const JsonValue* nodes = document.find("nodes");
+		const size_t nodesCount = (nodes != nullptr) ? nodes->getElements().size() : 0;
+
+		// The nodes are visited in the order of the document, without recursion, since the hierarchies may be deep.
+		struct NodeVisit
+		{
+			const JsonValue* index;
+			glm::mat4 parentTransform;
+			size_t depth;
+		};
+		std::vector<NodeVisit> stack;
+		const JsonValue* rootNodes = scene->find("nodes");
+		if (rootNodes != nullptr) {
+			for (auto it = rootNodes->getElements().rbegin(); it != rootNodes->getElements().rend(); ++it) {
+				stack.push_back({&*it, glm::mat4(1.f), 0});
+			}
+		}
+		while (!stack.empty()) {
+			const NodeVisit visit = stack.back();
+			stack.pop_back();
+			// A node can't be deeper than the count of the nodes, unless the hierarchy has a cycle.
+			const JsonValue* node = getElement(document, "nodes", visit.index);
+			if (node == nullptr || visit.depth >= nodesCount) {
+				return fail("Invalid node index or a cycle of nodes.");
+			}
+
+			const glm::mat4 transform = visit.parentTransform * getNodeTransform(*node);
+			const JsonValue* meshIndex = node->find("mesh");
+			if (meshIndex != nullptr) {
+				const JsonValue* mesh = getElement(document, "meshes", meshIndex);
+				if (mesh == nullptr) {
+					return fail("Invalid mesh index.");
+				}
+				outInstances.emplace_back(mesh, transform);
+			}
+			const JsonValue* children = node->find("children");
+			if (children != nullptr) {
+				for (auto it = children->getElements().rbegin(); it != children->getElements().rend(); ++it) {
+					stack.push_back({&*it, transform, visit.depth + 1});
+				}
+			}
+		}
+		return true;
+	}
+
+
+	/**
+	 * @brief Resolves the accessors of the triangle primitives and lays them out in the merged arrays.
+	 */
+	bool collectPrimitives(const Asset& asset, std::vector<Primitive>& outPrimitives, size_t& outVerticesCount, size_t& outIndicesCount)
+	{
+		std::vector<std::pair<const JsonValue*, glm::mat4>> instances;
+		if (!collectMeshInstances(*asset.document, instances)) {
+			return false;
+		}
+
+		size_t skippedCount = 0;
+		for (const auto& [mesh, transform] : instances) {
+			const JsonValue* primitives = mesh->find("primitives");
+			if (primitives == nullptr) {
+				continue;
+			}
+			for (const JsonValue& primitiveValue : primitives->getElements()) {
+				if (primitiveValue.getNumber("mode", MODE_TRIANGLES) != MODE_TRIANGLES) {
+					++skippedCount;
+					continue;
+				}
+				const JsonValue* attributes = primitiveValue.find("attributes");
+				if (attributes == nullptr || attributes->find("POSITION") == nullptr) {
+					return fail("A primitive has no positions.");
+				}
+
+				Primitive primitive;
+				if (!getAccessor(asset, attributes->find("POSITION"), primitive.positions)) {
+					return false;
+				}
+				const size_t verticesCount = primitive.positions.count;
+				const auto getOptionalAccessor = [&](const JsonValue* indexValue, std::optional<Accessor>& outAccessor) {
+					if (indexValue == nullptr) {
+						return true;
+					}
+					return getAccessor(asset, indexValue, outAccessor.emplace());
+				};
+				if (!getOptionalAccessor(attributes->find("TEXCOORD_0"), primitive.texCoords)
+						|| !getOptionalAccessor(attributes->find("COLOR_0"), primitive.colors)
+						|| !getOptionalAccessor(primitiveValue.find("indices"), primitive.indices)) {
+					return false;
+				}
+				if (primitive.positions.componentsCount != 3
+						|| (primitive.texCoords && (primitive.texCoords->componentsCount != 2 || primitive.texCoords->count != verticesCount))
+						|| (primitive.colors && (primitive.colors->componentsCount < 3 || primitive.colors->count != verticesCount))) {
+					return fail("Invalid attribute types or counts.");
+				}
+				if (primitive.indices && (primitive.indices->componentsCount != 1 || primitive.indices->componentType == COMPONENT_BYTE
+						|| primitive.indices->componentType == COMPONENT_SHORT || primitive.indices->componentType == COMPONENT_FLOAT)) {
+					return fail("Invalid index type.");
+				}
+
+				primitive.indicesCount = primitive.indices ? primitive.indices->count : verticesCount;
+				if (primitive.indicesCount % 3 != 0) {
+					return fail("The vertices of a primitive aren't whole triangles.");
+				}
+				primitive.transform = transform;
+				primitive.isIdentity = (transform == glm::mat4(1.f));
+				primitive.isMirrored = glm::determinant(glm::mat3(transform)) < 0.f;
+				primitive.firstVertex = outVerticesCount;
+				primitive.firstIndex = outIndicesCount;
+				outVerticesCount += verticesCount;
+				outIndicesCount += primitive.indicesCount;
+				outPrimitives.push_back(primitive);
+			}
+		}
+
+		if (skippedCount > 0) {
+			std::cerr << "[GltfImporter] Skipped " << skippedCount << " primitives of other modes than triangles." << std::endl;
+		}
+		if (outVerticesCount > NO_INDEX) {
+			return fail("Too many vertices.");
+		}
+		return true;
+	}
+
+
+	bool convertPrimitive(
+			const Primitive& primitive,
+			ThreadPool& threadPool,
+			std::vector<VertexFormat>& vertices,
+			std::vector<GeometricModel::IndexType>& indices
+	)
+	{
+		VertexFormat* primitiveVertices = vertices.data() + primitive.firstVertex;
+		threadPool.parallelFor(primitive.positions.count, GltfImporter::MIN_VERTICES_CHUNK_SIZE, [&](size_t begin, size_t end, size_t) {
+			forEachElement(primitive.positions, begin, end, [&](size_t i, const float* values) {
+				VertexFormat& vertex = primitiveVertices[i];
+				if (primitive.isIdentity) {
+					vertex.pos = {values[0], values[1], values[2]};
+				} else {
+					const glm::vec4 pos = primitive.transform * glm::vec4(values[0], values[1], values[2], 1.f);
+					vertex.pos = {pos.x, pos.y, pos.z};
+				}
+				vertex.color = DEFAULT_COLOR;
+			});
+			if (primitive.texCoords) {
+				// glTF v goes down from the top of the image.
+				forEachElement(*primitive.texCoords, begin, end, [&](size_t i, const float* values) {
+					primitiveVertices[i].texCoords = {values[0], 1.f - values[1]};
+				});
+			}
+			if (primitive.colors) {
+				const bool hasAlpha = primitive.colors->componentsCount == 4;
+				forEachElement(*primitive.colors, begin, end, [&](size_t i, const float* values) {
+					primitiveVertices[i].color = {values[0], values[1], values[2], hasAlpha ? values[3] : 1.f};
+				});
+			}
+		});
+
+		std::atomic<bool> isValid = true;
+		GeometricModel::IndexType* primitiveIndices = indices.data() + primitive.firstIndex;
+		const auto verticesCount = (GeometricModel::IndexType) primitive.positions.count;
+		const auto firstVertex = (GeometricModel::IndexType) primitive.firstVertex;
+		const size_t trianglesCount = primitive.indicesCount / 3;
+		threadPool.parallelFor(trianglesCount, GltfImporter::MIN_VERTICES_CHUNK_SIZE, [&](size_t begin, size_t end, size_t) {
+			if (!primitive.indices) {
+				for (size_t i = begin * 3; i < end * 3; ++i) {
+					primitiveIndices[i] = (GeometricModel::IndexType) i;
+				}
+			} else if (primitive.indices->componentType == COMPONENT_UNSIGNED_BYTE) {
+				readIndices<uint8_t>(*primitive.indices, begin * 3, end * 3, primitiveIndices);
+			} else if (primitive.indices->componentType == COMPONENT_UNSIGNED_SHORT) {
+				readIndices<uint16_t>(*primitive.indices, begin * 3, end * 3, primitiveIndices);
+			} else {
+				readIndices<uint32_t>(*primitive.indices, begin * 3, end * 3, primitiveIndices);
+			}
+
+			for (size_t i = begin * 3; i < end * 3; ++i) {
+				if (primitiveIndices[i] >= verticesCount) {
+					isValid = false;
+					return;
+				}
+				primitiveIndices[i] += firstVertex;
+			}
+			if (primitive.isMirrored) {
+				for (size_t triangle = begin; triangle < end; ++triangle) {
+					std::swap(primitiveIndices[triangle * 3 + 1], primitiveIndices[triangle * 3 + 2]);
+				}
+			}
+		});
+		return isValid || fail("An index is out of the vertices of its primitive.");
+	}
+
+
+	/**
+	 * @brief Welds the vertices with equal bytes in the order of the first occurrence. The hashes are calculated on
+	 * all threads, the table is filled sequentially.
+	 */
+	void weldVertices(ThreadPool& threadPool, std::vector<VertexFormat>& vertices, std::vector<GeometricModel::IndexType>& indices)
+	{
+		std::vector<uint64_t> hashes(vertices.size());
+		threadPool.parallelFor(vertices.size(), GltfImporter::MIN_VERTICES_CHUNK_SIZE, [&](size_t begin, size_t end, size_t) {
+			for (size_t i = begin; i < end; ++i) {
+				hashes[i] = Hash::fnv1a64({reinterpret_cast<const char*>(&vertices[i]), sizeof(VertexFormat)});
+			}
+		});
+
+		// Open addressing with linear probing at most half full.
+		const size_t tableSize = std::bit_ceil(std::max<size_t>(vertices.size() * 2, 1));
+		std::vector<uint32_t> table(tableSize, NO_INDEX);
+		std::vector<GeometricModel::IndexType> remap(vertices.size());
+		size_t uniqueCount = 0;
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			const uint64_t hash = hashes[i];
+			size_t slot = hash & (tableSize - 1);
+			while (table[slot] != NO_INDEX
+					&& (hashes[table[slot]] != hash || std::memcmp(&vertices[table[slot]], &vertices[i], sizeof(VertexFormat)) != 0)) {
+				slot = (slot + 1) & (tableSize - 1);
+			}
+			if (table[slot] == NO_INDEX) {
+				// The unique vertices are compacted in place: their index is never past the current one.
+				table[slot] = (uint32_t) uniqueCount;
+				vertices[uniqueCount] = vertices[i];
+				hashes[uniqueCount] = hash;
+				++uniqueCount;
+			}
+			remap[i] = table[slot];
+		}
+		vertices.resize(uniqueCount);
+
+		threadPool.parallelFor(indices.size(), GltfImporter::MIN_VERTICES_CHUNK_SIZE, [&](size_t begin, size_t end, size_t) {
+			for (size_t i = begin; i < end; ++i) {
+				indices[i] = remap[indices[i]];
+			}
+		});
+	}
+
+
+	std::optional<GeometricModel> importAsset(
+			std::string_view json,
+			std::optional<std::span<const std::byte>> binChunk,
+			size_t fileSize,
+			const std::filesystem::path& directory,
+			ThreadPool& threadPool,
+			ImportStats* outStats
+	)
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+		const std::optional<JsonValue> document = JsonValue::parse(json);
+		if (!document) {
+			fail("Invalid JSON.");
+			return std::nullopt;
+		}
+		const JsonValue* asset = document->find("asset");
+		const JsonValue* version = (asset != nullptr) ? asset->find("version") : nullptr;
+		if (version == nullptr || !version->getString().starts_with("2.")) {
+			fail("Only glTF 2.x is supported.");
+			return std::nullopt;
+		}
+
+		Asset assetData;
+		assetData.document = &*document;
+		assetData.bytesCount = fileSize;
+		std::vector<Primitive> primitives;
+		size_t verticesCount = 0;
+		size_t indicesCount = 0;
+		if (!loadBuffers(assetData, binChunk, directory) || !collectPrimitives(assetData, primitives, verticesCount, indicesCount)) {
+			return std::nullopt;
+		}
+
+		std::vector<VertexFormat> vertices(verticesCount);
+		std::vector<GeometricModel::IndexType> indices(indicesCount);
+		for (const Primitive& primitive : primitives) {
+			if (!convertPrimitive(primitive, threadPool, vertices, indices)) {
+				return std::nullopt;
+			}
+		}
+		const double parseMs = Timing::getMsSince(startTime);
+
+		const auto weldStartTime = std::chrono::steady_clock::now();
+		weldVertices(threadPool, vertices, indices);
+
+		if (outStats != nullptr) {
+			outStats->bytesCount = assetData.bytesCount;
+			outStats->sourceVerticesCount = verticesCount;
+			outStats->verticesCount = vertices.size();
+			outStats->trianglesCount = indices.size() / 3;
+			outStats->parseMs = parseMs;
+			outStats->weldMs = Timing::getMsSince(weldStartTime);
+			outStats->totalMs = Timing::getMsSince(startTime);
+		}
+		return GeometricModel(std::move(vertices), std::move(indices));
+	}
+
+
+	uint32_t readUint32(std::span<const std::byte> data, size_t offset)
+	{
+		uint32_t value;
+		std::memcpy(&value, data.data() + offset, sizeof(value));
+		return value;
+	}
+}
+
+
+std::optional<GeometricModel> GltfImporter::importGltf(
+		std::string_view text,
+		const std::filesystem::path& directory,
+		ThreadPool& threadPool,
+		ImportStats* outStats
+)
+{
+	return importAsset(text, std::nullopt, text.size(), directory, threadPool, outStats);
+}
+
+
+std::optional<GeometricModel> GltfImporter::importGlb(
+		std::span<const std::byte> data,
+		const std::filesystem::path& directory,
+		ThreadPool& threadPool,
+		ImportStats* outStats
+)
+{
+	// The header: magic, version and length, then the chunks of length, type and data. The fields are little-endian.
+	if (data.size() < GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE || readUint32(data, 0) != GLB_MAGIC) {
+		fail("Not a GLB file.");
+		return std::nullopt;
+	}
+	if (readUint32(data, 4) != GLB_VERSION) {
+		fail("Only GLB version 2 is supported.");
+		return std::nullopt;
+	}
+	// The declared length may lie: it's clamped to the data, and the chunks are checked against it without subtractions,
+	// so a short length can't wrap a check around.
+	const size_t jsonStart = GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE;
+	const size_t length = std::min<size_t>(readUint32(data, 8), data.size());
+	if (length < jsonStart) {
+		fail("The GLB length is shorter than its header.");
+		return std::nullopt;
+	}
+	const size_t jsonLength = readUint32(data, GLB_HEADER_SIZE);
+	if (readUint32(data, GLB_HEADER_SIZE + 4) != GLB_CHUNK_JSON || jsonStart + jsonLength > length) {
+		fail("Invalid JSON chunk.");
+		return std::nullopt;
+	}
+	const std::string_view json(reinterpret_cast<const char*>(data.data() + jsonStart), jsonLength);
+
+	std::optional<std::span<const std::byte>> binChunk;
+	const size_t binHeaderStart = jsonStart + jsonLength;
+	const size_t binStart = binHeaderStart + GLB_CHUNK_HEADER_SIZE;
+	if (binStart <= length && readUint32(data, binHeaderStart + 4) == GLB_CHUNK_BIN) {
+		const size_t binLength = readUint32(data, binHeaderStart);
+		if (binStart + binLength > length) {
+			fail("Invalid binary chunk.");
+			return std::nullopt;
+		}
+		binChunk = data.subspan(binStart, binLength);
+	}
+	return importAsset(json, binChunk, data.size(), directory, threadPool, outStats);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "MeshImporter.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+
+
+/**
+ * @brief Loads the triangle meshes of glTF 2.0 assets. The meshes of the default scene are transformed by their nodes
+ * and merged. The attributes are POSITION, TEXCOORD_0 and COLOR_0 of any component type: the normalized integers
+ * are converted to floats. Other primitive modes and sparse accessors aren't supported.
+ *
+ * The buffers are referenced in place: the GLB binary chunk and the .bin files are memory-mapped, only the base64
+ * data URIs are decoded. The vertices of a primitive are converted by ranges on the threads of the pool.
+ * Then the exactly equal vertices are welded with a hash table, since exporters often split them by the primitives.
+ */
+class GltfImporter
+{
+public:
+	// Smaller ranges of vertices aren't split between threads.
+	static constexpr size_t MIN_VERTICES_CHUNK_SIZE = 64 * 1024;
+
+public:
+	/**
+	 * @param text The JSON of a .gltf file.
+	 * @param directory The directory of the file: the relative buffer URIs are resolved against it.
+	 */
+	[[nodiscard]]
+	static std::optional<GeometricModel> importGltf(
+			std::string_view text,
+			const std::filesystem::path& directory,
+			ThreadPool& threadPool,
+			ImportStats* outStats = nullptr
+	);
+
+	/**
+	 * @param data The contents of a .glb file: the header, the JSON chunk and the optional binary chunk.
+	 */
+	[[nodiscard]]
+	static std::optional<GeometricModel> importGlb(
+			std::span<const std::byte> data,
+			const std::filesystem::path& directory,
+			ThreadPool& threadPool,
+			ImportStats* outStats = nullptr
+	);
+};
@@ -0,0 +1,286 @@
+#include "Json.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+
+
+class JsonValue::Parser
+{
+public:
+	explicit Parser(std::string_view text)
+			: _text(text)
+	{
+	}
+
+	bool parseDocument(JsonValue& outValue)
+	{
+		if (!parseValue(outValue, 0)) {
+			return false;
+		}
+		skipWhitespace();
+		return (_position == _text.size()) || fail("Unexpected data after the document");
+	}
+
+private:
+	bool parseValue(JsonValue& outValue, int depth)
+	{
+		if (depth > MAX_DEPTH) {
+			return fail("The document is too deep");
+		}
+		skipWhitespace();
+		if (_position == _text.size()) {
+			return fail("Unexpected end");
+		}
+
+		switch (_text[_position]) {
+			case '{':
+				return parseObject(outValue, depth);
+			case '[':
+				return parseArray(outValue, depth);
+			case '"':
+				outValue._type = Type::String;
+				return parseString(outValue._string);
+			case 't':
+				outValue._type = Type::Bool;
+				outValue._bool = true;
+				return parseLiteral("true");
+			case 'f':
+				outValue._type = Type::Bool;
+				outValue._bool = false;
+				return parseLiteral("false");
+			case 'n':
+				outValue._type = Type::Null;
+				return parseLiteral("null");
+			default:
+				return parseNumber(outValue);
+		}
+	}
+
+	bool parseObject(JsonValue& outValue, int depth)
+	{
+		outValue._type = Type::Object;
+		++_position;
+		skipWhitespace();
+		if (consume('}')) {
+			return true;
+		}
+		do {
+			skipWhitespace();
+			std::string& key = outValue._keys.emplace_back();
+			if (!parseString(key)) {
+				return false;
+			}
+			skipWhitespace();
+			if (!consume(':')) {
+				return fail("Expected ':'");
+			}
+			if (!parseValue(outValue._elements.emplace_back(), depth + 1)) {
+				return false;
+			}
+			skipWhitespace();
+		} while (consume(','));
+		return consume('}') || fail("Expected ',' or '}'");
+	}
+
+	bool parseArray(JsonValue& outValue, int depth)
+	{
+		outValue._type = Type::Array;
+		++_position;
+		skipWhitespace();
+		if (consume(']')) {
+			return true;
+		}
+		do {
+			if (!parseValue(outValue._elements.emplace_back(), depth + 1)) {
+				return false;
+			}
+			skipWhitespace();
+		} while (consume(','));
+		return consume(']') || fail("Expected ',' or ']'");
+	}
+
+	bool parseString(std::string& outString)
+	{
+		if (!consume('"')) {
+			return fail("Expected a string");
+		}
+		while (_position < _text.size()) {
+			const char c = _text[_position++];
+			if (c == '"') {
+				return true;
+			}
+			if ((unsigned char) c < 0x20) {
+				return fail("A control character in a string");
+			}
+			if (c != '\\') {
+				outString.push_back(c);
+				continue;
+			}
+
+			if (_position == _text.size()) {
+				break;
+			}
+			const char escaped = _text[_position++];
+			switch (escaped) {
+				case '"':
+				case '\\':
+				case '/':
+					outString.push_back(escaped);
+					break;
+				case 'b':
+					outString.push_back('\b');
+					break;
+				case 'f':
+					outString.push_back('\f');
+					break;
+				case 'n':
+					outString.push_back('\n');
+					break;
+				case 'r':
+					outString.push_back('\r');
+					break;
+				case 't':
+					outString.push_back('\t');
+					break;
+				case 'u':
+					if (!parseCodePoint(outString)) {
+						return false;
+					}
+					break;
+				default:
+					return fail("Unknown escape sequence");
+			}
+		}
+		return fail("Unterminated string");
+	}
+
+	/**
+	 * @brief Parses the hex digits after \u, including a surrogate pair, and appends the code point in UTF-8.
+	 */
+	bool parseCodePoint(std::string& outString)
+	{
+		uint32_t codePoint = 0;
+		if (!parseHex4(codePoint)) {
+			return false;
+		}
+		if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+			uint32_t lowSurrogate = 0;
+			if (!consume('\\') || !consume('u') || !parseHex4(lowSurrogate) || lowSurrogate < 0xDC00 || lowSurrogate > 0xDFFF) {
+				return fail("Invalid surrogate pair");
+			}
+			codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+		}
+
+		if (codePoint < 0x80) {
+			outString.push_back((char) codePoint);
+		} else if (codePoint < 0x800) {
+			outString.push_back((char) (0xC0 | (codePoint >> 6)));
+			outString.push_back((char) (0x80 | (codePoint & 0x3F)));
+		} else if (codePoint < 0x10000) {
+			outString.push_back((char) (0xE0 | (codePoint >> 12)));
+			outString.push_back((char) (0x80 | ((codePoint >> 6) & 0x3F)));
+			outString.push_back((char) (0x80 | (codePoint & 0x3F)));
+		} else {
+			outString.push_back((char) (0xF0 | (codePoint >> 18)));
+			outString.push_back((char) (0x80 | ((codePoint >> 12) & 0x3F)));
+			outString.push_back((char) (0x80 | ((codePoint >> 6) & 0x3F)));
+			outString.push_back((char) (0x80 | (codePoint & 0x3F)));
+		}
+		return true;
+	}
+
+	bool parseHex4(uint32_t& outValue)
+	{
+		if (_text.size() - _position < 4) {
+			return fail("Unterminated escape sequence");
+		}
+		const char* begin = _text.data() + _position;
+		const std::from_chars_result result = std::from_chars(begin, begin + 4, outValue, 16);
+		if (result.ptr != begin + 4) {
+			return fail("Invalid escape sequence");
+		}
+		_position += 4;
+		return true;
+	}
+
+	bool parseLiteral(std::string_view literal)
+	{
+		if (_text.substr(_position, literal.size()) != literal) {
+			return fail("Unknown literal");
+		}
+		_position += literal.size();
+		return true;
+	}
+
+	bool parseNumber(JsonValue& outValue)
+	{
+		outValue._type = Type::Number;
+		const char* begin = _text.data() + _position;
+		const std::from_chars_result result = std::from_chars(begin, _text.data() + _text.size(), outValue._number);
+		if (result.ec != std::errc() || begin == result.ptr) {
+			return fail("Invalid value");
+		}
+		_position += (size_t) (result.ptr - begin);
+		return true;
+	}
+
+	void skipWhitespace()
+	{
+		while (_position < _text.size()) {
+			const char c = _text[_position];
+			if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+				break;
+			}
+			++_position;
+		}
+	}
+
+	bool consume(char c)
+	{
+		if (_position < _text.size() && _text[_position] == c) {
+			++_position;
+			return true;
+		}
+		return false;
+	}
+
+	bool fail(const char* message) const
+	{
+		std::cerr << "[JsonValue] " << message << " at the offset " << _position << "." << std::endl;
+		return false;
+	}
+
+private:
+	std::string_view _text;
+	size_t _position = 0;
+};
+
+
+std::optional<JsonValue> JsonValue::parse(std::string_view text)
+{
+	JsonValue document;
+	Parser parser(text);
+	if (!parser.parseDocument(document)) {
+		return std::nullopt;
+	}
+	return document;
+}
+
+
+const JsonValue* JsonValue::find(std::string_view key) const
+{
+	for (size_t i = 0; i < _keys.size(); ++i) {
+		if (_keys[i] == key) {
+			return &_elements[i];
+		}
+	}
+	return nullptr;
+}
+
+
+double JsonValue::getNumber(std::string_view key, double defaultValue) const
+{
+	const JsonValue* value = find(key);
+	return (value != nullptr) ? value->getNumber(defaultValue) : defaultValue;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief A parsed JSON document, e.g. the glTF scene description. The values are immutable after parsing.
+ * The getters of a wrong type return the default values, so the optional fields are read without checks.
+ */
+class JsonValue
+{
+public:
+	enum class Type
+	{
+		Null,
+		Bool,
+		Number,
+		String,
+		Array,
+		Object,
+	};
+
+	// Deeper documents are rejected, so a malicious file can't overflow the stack of the recursive parser.
+	static constexpr int MAX_DEPTH = 256;
+
+public:
+	JsonValue() = default;
+
+	/**
+	 * @brief Parses the whole text. Errors are printed with the offset.
+	 */
+	[[nodiscard]]
+	static std::optional<JsonValue> parse(std::string_view text);
+
+	[[nodiscard]]
+	Type getType() const { return _type; }
+
+	[[nodiscard]]
+	bool getBool(bool defaultValue = false) const { return (_type == Type::Bool) ? _bool : defaultValue; }
+
+	[[nodiscard]]
+	double getNumber(double defaultValue = 0.0) const { return (_type == Type::Number) ? _number : defaultValue; }
+
+	[[nodiscard]]
+	std::string_view getString() const { return _string; }
+
+	/**
+	 * @brief The elements of an array or the values of an object. Empty for the other types.
+	 */
+	[[nodiscard]]
+	std::span<const JsonValue> getElements() const { return _elements; }
+
+	/**
+	 * @brief Returns the value of the object member, or nullptr, if there's no such member or it's not an object.
+	 */
+	[[nodiscard]]
+	const JsonValue* find(std::string_view key) const;
+
+	/**
+	 * @brief Returns the number of the member, or the default value, if there's no such member or it's not a number.
+	 */
+	[[nodiscard]]
+	double getNumber(std::string_view key, double defaultValue) const;
+
+private:
+	class Parser;
+
+	Type _type = Type::Null;
+	bool _bool = false;
+	double _number = 0.0;
+	std::string _string;
+	std::vector<JsonValue> _elements;
+	// The keys of an object, in the order of _elements.
+	std::vector<std::string> _keys;
+};
@@ -0,0 +1,49 @@
+#include "MeshImporter.hpp"
+
+#include "GltfImporter.hpp"
+#include "MappedFile.hpp"
+#include "ObjImporter.hpp"
+
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+
+std::optional<GeometricModel> MeshImporter::importFile(
+		const std::filesystem::path& filePath,
+		ThreadPool& threadPool,
+		ImportStats* outStats
+)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+	const MappedFile file(filePath);
+	if (!file.isOpen()) {
+		std::cerr << "[MeshImporter] Can't open the file " << filePath << "." << std::endl;
+		return std::nullopt;
+	}
+
+	std::string extension = filePath.extension().string();
+	for (char& c : extension) {
+		c = (char) std::tolower((unsigned char) c);
+	}
+	std::optional<GeometricModel> model;
+	if (extension == ".obj") {
+		model = ObjImporter::import(file.getText(), threadPool, outStats);
+	} else if (extension == ".gltf") {
+		model = GltfImporter::importGltf(file.getText(), filePath.parent_path(), threadPool, outStats);
+	} else if (extension == ".glb") {
+		model = GltfImporter::importGlb(file.getBytes(), filePath.parent_path(), threadPool, outStats);
+	} else {
+		std::cerr << "[MeshImporter] Unknown mesh format: " << filePath << "." << std::endl;
+		return std::nullopt;
+	}
+
+	if (!model) {
+		std::cerr << "[MeshImporter] Failed to import " << filePath << "." << std::endl;
+	} else if (outStats != nullptr) {
+		// Including the mapping of the file.
+		outStats->totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	}
+	return model;
+}
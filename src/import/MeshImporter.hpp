@@ -0,0 +1,51 @@
+#pragma once
+
+#include "model/GeometricModel.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+
+
+class ThreadPool;
+
+
+/**
+ * @brief Counters and timings of an import.
+ */
+struct ImportStats
+{
+	// The size of the files, which were read.
+	size_t bytesCount = 0;
+	// The vertices before the welding: the face corners of OBJ or the vertices of the glTF primitives.
+	size_t sourceVerticesCount = 0;
+	size_t verticesCount = 0;
+	size_t trianglesCount = 0;
+	double parseMs = 0.0;
+	double weldMs = 0.0;
+	double totalMs = 0.0;
+};
+
+
+/**
+ * @brief Loads meshes of Wavefront OBJ (.obj) and glTF 2.0 (.gltf with .bin or embedded buffers, .glb) files.
+ * All meshes of a file are merged into one GeometricModel, and the vertices with equal attributes are welded.
+ *
+ * The files are memory-mapped and parsed in place: no copies of the text or per-token strings.
+ * OBJ is parsed by chunks of lines on the threads of the pool. glTF buffers are converted by ranges of vertices.
+ * The texture coordinates follow the GL convention: v goes up, like in the textures flipped on loading.
+ * Errors are printed, and std::nullopt is returned.
+ */
+class MeshImporter
+{
+public:
+	/**
+	 * @brief Picks the format by the extension.
+	 */
+	[[nodiscard]]
+	static std::optional<GeometricModel> importFile(
+			const std::filesystem::path& filePath,
+			ThreadPool& threadPool,
+			ImportStats* outStats = nullptr
+	);
+};
@@ -0,0 +1,376 @@
+#include "ObjImporter.hpp"
+
+#include "ThreadPool.hpp"
+#include "Timing.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+
+namespace {
+	constexpr uint32_t NO_INDEX = UINT32_MAX;
+	constexpr size_t MIN_VERTICES_CHUNK_SIZE = 64 * 1024;
+	const VertexFormat::Color DEFAULT_COLOR = {1.f, 1.f, 1.f, 1.f};
+
+
+	/**
+	 * @brief Moves the boundary of a chunk to the beginning of the next line. A chunk parses the lines, which begin in it.
+	 */
+	size_t alignToLine(std::string_view text, size_t position)
+	{
+		if (position == 0 || position >= text.size() || text[position - 1] == '\n') {
+			return std::min(position, text.size());
+		}
+		const size_t lineEnd = text.find('\n', position);
+		return (lineEnd == std::string_view::npos) ? text.size() : lineEnd + 1;
+	}
+
+
+	/**
+	 * @brief Reads the tokens of a line in place.
+	 */
+	class LineReader
+	{
+	public:
+		LineReader(const char* begin, const char* end)
+				: _position(begin)
+				, _end(end)
+		{
+		}
+
+		void skipSpaces()
+		{
+			while (_position < _end && (*_position == ' ' || *_position == '\t' || *_position == '\r')) {
+				++_position;
+			}
+		}
+
+		/**
+		 * @brief Checks whether only spaces or a comment are left.
+		 */
+		bool isAtEnd()
+		{
+			skipSpaces();
+			return _position == _end || *_position == '#';
+		}
+
+		/**
+		 * @brief Reads the keyword at the beginning of the line, e.g. "v" or "vt".
+		 */
+		std::string_view readKeyword()
+		{
+			skipSpaces();
+			const char* begin = _position;
+			while (_position < _end && *_position != ' ' && *_position != '\t' && *_position != '\r') {
+				++_position;
+			}
+			return {begin, (size_t) (_position - begin)};
+		}
+
+		bool readFloat(float& outValue)
+		{
+			skipSpaces();
+			if (_position < _end && *_position == '+') {
+				++_position;
+			}
+			const std::from_chars_result result = std::from_chars(_position, _end, outValue);
+			if (result.ec != std::errc()) {
+				return false;
+			}
+			_position = result.ptr;
+			return true;
+		}
+
+		bool readInt(int64_t& outValue)
+		{
+			const std::from_chars_result result = std::from_chars(_position, _end, outValue);
+			if (result.ec != std::errc()) {
+				return false;
+			}
+			_position = result.ptr;
+			return true;
+		}
+
+		bool consume(char c)
+		{
+			if (_position < _end && *_position == c) {
+				++_position;
+				return true;
+			}
+			return false;
+		}
+
+	private:
+		const char* _position = nullptr;
+		const char* _end = nullptr;
+	};
+
+
+	/**
+	 * @brief The results of a chunk of lines.
+	 */
+	struct Chunk
+	{
+		size_t begin = 0;
+		size_t end = 0;
+		// The counts of the first pass, and the indices of the first ones in the merged arrays.
+		size_t positionsCount = 0;
+		size_t texCoordsCount = 0;
+		size_t firstPosition = 0;
+		size_t firstTexCoords = 0;
+		// The positions of the chunk have colors. The other ones are white.
+		std::vector<VertexFormat::Color> colors;
+		// The corners of the triangles: the indices in the merged arrays.
+		std::vector<uint32_t> cornerPositions;
+		std::vector<uint32_t> cornerTexCoords;
+		// The offset of the first malformed line, if any.
+		size_t errorOffset = SIZE_MAX;
+	};
+
+
+	void countChunk(std::string_view text, Chunk& chunk)
+	{
+		for (size_t lineBegin = chunk.begin; lineBegin < chunk.end;) {
+			const size_t newLine = text.find('\n', lineBegin);
+			const size_t lineEnd = (newLine == std::string_view::npos) ? text.size() : newLine;
+			LineReader reader(text.data() + lineBegin, text.data() + lineEnd);
+			const std::string_view keyword = reader.readKeyword();
+			if (keyword == "v") {
+				++chunk.positionsCount;
+			} else if (keyword == "vt") {
+				++chunk.texCoordsCount;
+			}
+			lineBegin = lineEnd + 1;
+		}
+	}
+
+
+	/**
+	 * @brief Resolves a 1-based or a negative relative OBJ index to the merged array.
+	 * @param definedCount The number of the elements before the line.
+	 */
+	bool resolveIndex(int64_t index, size_t definedCount, size_t totalCount, uint32_t& outIndex)
+	{
+		const int64_t resolved = (index > 0) ? index - 1 : (int64_t) definedCount + index;
+		if (index == 0 || resolved < 0 || resolved >= (int64_t) totalCount) {
+			return false;
+		}
+		outIndex = (uint32_t) resolved;
+		return true;
+	}
+
+
+	struct Attributes
+	{
+		std::vector<VertexFormat::Pos> positions;
+		std::vector<VertexFormat::TextureCoords> texCoords;
+	};
+
+
+	bool parseFace(LineReader& reader, Chunk& chunk, size_t positionsCount, size_t texCoordsCount, const Attributes& attributes)
+	{
+		uint32_t firstPosition = NO_INDEX;
+		uint32_t firstTexCoords = NO_INDEX;
+		uint32_t previousPosition = NO_INDEX;
+		uint32_t previousTexCoords = NO_INDEX;
+		size_t cornersCount = 0;
+		while (!reader.isAtEnd()) {
+			// p, p/t, p//n or p/t/n.
+			int64_t index = 0;
+			uint32_t position = NO_INDEX;
+			uint32_t texCoords = NO_INDEX;
+			if (!reader.readInt(index) || !resolveIndex(index, positionsCount, attributes.positions.size(), position)) {
+				return false;
+			}
+			if (reader.consume('/')) {
+				if (!reader.consume('/')) {
+					if (!reader.readInt(index) || !resolveIndex(index, texCoordsCount, attributes.texCoords.size(), texCoords)) {
+						return false;
+					}
+					if (reader.consume('/') && !reader.readInt(index)) {
+						return false;
+					}
+				} else if (!reader.readInt(index)) {
+					return false;
+				}
+			}
+
+			if (cornersCount == 0) {
+				firstPosition = position;
+				firstTexCoords = texCoords;
+			} else if (cornersCount >= 2) {
+				chunk.cornerPositions.insert(chunk.cornerPositions.end(), {firstPosition, previousPosition, position});
+				chunk.cornerTexCoords.insert(chunk.cornerTexCoords.end(), {firstTexCoords, previousTexCoords, texCoords});
+			}
+			previousPosition = position;
+			previousTexCoords = texCoords;
+			++cornersCount;
+		}
+		return cornersCount >= 3;
+	}
+
+
+	void parseChunk(std::string_view text, Chunk& chunk, Attributes& attributes)
+	{
+		size_t positionsCount = chunk.firstPosition;
+		size_t texCoordsCount = chunk.firstTexCoords;
+		for (size_t lineBegin = chunk.begin; lineBegin < chunk.end;) {
+			const size_t newLine = text.find('\n', lineBegin);
+			const size_t lineEnd = (newLine == std::string_view::npos) ? text.size() : newLine;
+			LineReader reader(text.data() + lineBegin, text.data() + lineEnd);
+			const std::string_view keyword = reader.readKeyword();
+
+			bool isValid = true;
+			if (keyword == "v") {
+				VertexFormat::Pos& position = attributes.positions[positionsCount];
+				isValid = reader.readFloat(position.x) && reader.readFloat(position.y) && reader.readFloat(position.z);
+				// x y z, x y z w or x y z r g b.
+				float extra[3] = {};
+				int extraCount = 0;
+				while (isValid && extraCount < 3 && !reader.isAtEnd()) {
+					isValid = reader.readFloat(extra[extraCount++]);
+				}
+				if (isValid && extraCount == 3) {
+					chunk.colors.resize(positionsCount - chunk.firstPosition, DEFAULT_COLOR);
+					chunk.colors.push_back({extra[0], extra[1], extra[2], 1.f});
+				}
+				isValid = isValid && reader.isAtEnd() && extraCount != 2;
+				++positionsCount;
+			} else if (keyword == "vt") {
+				VertexFormat::TextureCoords& texCoords = attributes.texCoords[texCoordsCount];
+				// u, u v or u v w.
+				float w = 0.f;
+				isValid = reader.readFloat(texCoords.u) && (reader.isAtEnd() || reader.readFloat(texCoords.v))
+						&& (reader.isAtEnd() || reader.readFloat(w)) && reader.isAtEnd();
+				++texCoordsCount;
+			} else if (keyword == "f") {
+				isValid = parseFace(reader, chunk, positionsCount, texCoordsCount, attributes);
+			}
+
+			if (!isValid) {
+				chunk.errorOffset = lineBegin;
+				return;
+			}
+			lineBegin = lineEnd + 1;
+		}
+	}
+
+
+	void printError(std::string_view text, size_t offset)
+	{
+		const size_t lineNumber = (size_t) std::count(text.begin(), text.begin() + (ptrdiff_t) offset, '\n') + 1;
+		const std::string_view line = text.substr(offset, std::min(text.find('\n', offset), text.size()) - offset);
+		std::cerr << "[ObjImporter] Malformed line " << lineNumber << ": " << line.substr(0, 80) << std::endl;
+	}
+}
+
+
+std::optional<GeometricModel> ObjImporter::import(std::string_view text, ThreadPool& threadPool, ImportStats* outStats)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	std::vector<Chunk> chunks(threadPool.getChunksCount(text.size(), MIN_CHUNK_SIZE));
+	threadPool.parallelFor(text.size(), MIN_CHUNK_SIZE, [&](size_t begin, size_t end, size_t chunkIndex) {
+		Chunk& chunk = chunks[chunkIndex];
+		chunk.begin = alignToLine(text, begin);
+		chunk.end = alignToLine(text, end);
+		countChunk(text, chunk);
+	});
+
+	Attributes attributes;
+	size_t positionsCount = 0;
+	size_t texCoordsCount = 0;
+	for (Chunk& chunk : chunks) {
+		chunk.firstPosition = positionsCount;
+		chunk.firstTexCoords = texCoordsCount;
+		positionsCount += chunk.positionsCount;
+		texCoordsCount += chunk.texCoordsCount;
+	}
+	if (positionsCount > NO_INDEX || texCoordsCount > NO_INDEX) {
+		std::cerr << "[ObjImporter] Too many vertices." << std::endl;
+		return std::nullopt;
+	}
+	attributes.positions.resize(positionsCount);
+	attributes.texCoords.resize(texCoordsCount);
+
+	threadPool.parallelFor(text.size(), MIN_CHUNK_SIZE, [&](size_t, size_t, size_t chunkIndex) {
+		parseChunk(text, chunks[chunkIndex], attributes);
+	});
+
+	size_t cornersCount = 0;
+	bool hasColors = false;
+	for (const Chunk& chunk : chunks) {
+		if (chunk.errorOffset != SIZE_MAX) {
+			printError(text, chunk.errorOffset);
+			return std::nullopt;
+		}
+		cornersCount += chunk.cornerPositions.size();
+		hasColors = hasColors || !chunk.colors.empty();
+	}
+	const double parseMs = Timing::getMsSince(startTime);
+
+	// Weld the corners: the vertices of a position are chained, and a chain is short, as it has a vertex per seam.
+	const auto weldStartTime = std::chrono::steady_clock::now();
+	std::vector<uint32_t> firstVertices(positionsCount, NO_INDEX);
+	std::vector<uint32_t> vertexPositions;
+	std::vector<uint32_t> vertexTexCoords;
+	std::vector<uint32_t> nextVertices;
+	std::vector<GeometricModel::IndexType> indices(cornersCount);
+	size_t cornerIndex = 0;
+	for (const Chunk& chunk : chunks) {
+		for (size_t i = 0; i < chunk.cornerPositions.size(); ++i) {
+			const uint32_t position = chunk.cornerPositions[i];
+			const uint32_t texCoords = chunk.cornerTexCoords[i];
+			uint32_t* vertex = &firstVertices[position];
+			while (*vertex != NO_INDEX && vertexTexCoords[*vertex] != texCoords) {
+				vertex = &nextVertices[*vertex];
+			}
+			if (*vertex == NO_INDEX) {
+				// The link is written before the push, which may reallocate it.
+				*vertex = (uint32_t) vertexPositions.size();
+				vertexPositions.push_back(position);
+				vertexTexCoords.push_back(texCoords);
+				nextVertices.push_back(NO_INDEX);
+				indices[cornerIndex++] = (GeometricModel::IndexType) (vertexPositions.size() - 1);
+			} else {
+				indices[cornerIndex++] = *vertex;
+			}
+		}
+	}
+
+	std::vector<VertexFormat::Color> colors;
+	if (hasColors) {
+		colors.reserve(positionsCount);
+		for (const Chunk& chunk : chunks) {
+			colors.insert(colors.end(), chunk.colors.begin(), chunk.colors.end());
+			colors.resize(chunk.firstPosition + chunk.positionsCount, DEFAULT_COLOR);
+		}
+	}
+
+	std::vector<VertexFormat> vertices(vertexPositions.size());
+	threadPool.parallelFor(vertices.size(), MIN_VERTICES_CHUNK_SIZE, [&](size_t begin, size_t end, size_t) {
+		for (size_t i = begin; i < end; ++i) {
+			VertexFormat& vertex = vertices[i];
+			vertex.pos = attributes.positions[vertexPositions[i]];
+			vertex.color = hasColors ? colors[vertexPositions[i]] : DEFAULT_COLOR;
+			if (vertexTexCoords[i] != NO_INDEX) {
+				vertex.texCoords = attributes.texCoords[vertexTexCoords[i]];
+			}
+		}
+	});
+
+	if (outStats != nullptr) {
+		outStats->bytesCount = text.size();
+		outStats->sourceVerticesCount = cornersCount;
+		outStats->verticesCount = vertices.size();
+		outStats->trianglesCount = cornersCount / 3;
+		outStats->parseMs = parseMs;
+		outStats->weldMs = Timing::getMsSince(weldStartTime);
+		outStats->totalMs = Timing::getMsSince(startTime);
+	}
+	return GeometricModel(std::move(vertices), std::move(indices));
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "MeshImporter.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+
+/**
+ * @brief Parses Wavefront OBJ text: the positions (with the optional vertex colors after them), the texture coordinates
+ * and the polygons, which are triangulated as fans. The normals, the groups and the materials are skipped.
+ *
+ * The text is split into chunks of lines, which are parsed on all threads in two passes. The first one counts
+ * the positions and the texture coordinates of every chunk, so the second one resolves the relative indices and
+ * writes the attributes straight to their places in the merged arrays. Then the corners are welded into the vertices
+ * by the pairs of the position and the texture coordinates indices, in the order of the first use.
+ */
+class ObjImporter
+{
+public:
+	// Smaller texts aren't split between threads.
+	static constexpr size_t MIN_CHUNK_SIZE = 1024 * 1024;
+
+public:
+	[[nodiscard]]
+	static std::optional<GeometricModel> import(std::string_view text, ThreadPool& threadPool, ImportStats* outStats = nullptr);
+};
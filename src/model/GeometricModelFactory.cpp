@@ -1,5 +1,7 @@
 #include "GeometricModelFactory.hpp"
 
+#include <cmath>
+
 
 [[nodiscard]]
 GeometricModel GeometricModelFactory::createRectangleModel()
@@ -82,3 +84,43 @@ GeometricModel GeometricModelFactory::createCubeModel()
 
 	return GeometricModel(std::move(vertices), std::move(indices));
 }
+
+
+[[nodiscard]]
+GeometricModel GeometricModelFactory::createSphereModel(int segmentsCount, int ringsCount)
+{
+	constexpr float PI = 3.14159265358979f;
+	VertexFormat::Color color = {1.f, 1.f, 1.f, 1.f};
+
+	std::vector<VertexFormat> vertices;
+	vertices.reserve((size_t) (segmentsCount + 1) * (ringsCount + 1));
+	for (int ring = 0; ring <= ringsCount; ++ring) {
+		const float v = (float) ring / (float) ringsCount;
+		const float polarAngle = v * PI;
+		for (int segment = 0; segment <= segmentsCount; ++segment) {
+			const float u = (float) segment / (float) segmentsCount;
+			const float azimuth = u * 2.f * PI;
+			const VertexFormat::Pos pos = {
+					std::sin(polarAngle) * std::cos(azimuth),
+					-std::cos(polarAngle),
+					-std::sin(polarAngle) * std::sin(azimuth),
+			};
+			vertices.push_back(VertexFormat{pos, color, {u, v}});
+		}
+	}
+
+	// Counter-clockwise from outside, like the cube.
+	std::vector<GeometricModel::IndexType> indices;
+	indices.reserve((size_t) segmentsCount * ringsCount * 6);
+	const auto rowSize = (GeometricModel::IndexType) (segmentsCount + 1);
+	for (int ring = 0; ring < ringsCount; ++ring) {
+		for (int segment = 0; segment < segmentsCount; ++segment) {
+			const GeometricModel::IndexType bottomLeft = ring * rowSize + segment;
+			const GeometricModel::IndexType topLeft = bottomLeft + rowSize;
+			indices.insert(indices.end(), {bottomLeft, bottomLeft + 1, topLeft + 1});
+			indices.insert(indices.end(), {bottomLeft, topLeft + 1, topLeft});
+		}
+	}
+
+	return GeometricModel(std::move(vertices), std::move(indices));
+}
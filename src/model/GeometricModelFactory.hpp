@@ -11,4 +11,11 @@ public:
 
 	[[nodiscard]]
 	static GeometricModel createCubeModel();
+
+	/**
+	 * @brief Creates a UV sphere of the radius 1. The seam and the poles have own vertices, so the texture isn't stretched.
+	 * It has (segmentsCount + 1) * (ringsCount + 1) vertices: large ones are stress tests for the vertex processing.
+	 */
+	[[nodiscard]]
+	static GeometricModel createSphereModel(int segmentsCount, int ringsCount);
 };
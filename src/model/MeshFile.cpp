@@ -0,0 +1,335 @@
+#include "MeshFile.hpp"
+
+#include "PackedIndices.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/common.hpp>
+
+
+namespace {
+	// "LOGM" - LearnOpenGL mesh.
+	constexpr uint32_t MESH_FILE_MAGIC = 0x4D474F4C;
+	constexpr size_t MAX_ATTRIBUTES_COUNT = 8;
+
+	// The layouts, which the shaders read. The attributes of a file must match one of them exactly.
+	const VertexLayout* const KNOWN_LAYOUTS[] = {
+			&VertexLayouts::VERTEX_FORMAT,
+			&VertexLayouts::PACKED_VERTEX_FORMAT_HALF,
+			&VertexLayouts::PACKED_VERTEX_FORMAT_UNORM16,
+	};
+
+
+	struct FileAttribute
+	{
+		uint32_t location = 0;
+		uint32_t componentsCount = 0;
+		uint32_t componentType = 0;
+		uint32_t kind = 0;
+		uint32_t offset = 0;
+	};
+
+
+	struct FileHeader
+	{
+		uint32_t magic = MESH_FILE_MAGIC;
+		uint32_t version = MeshFile::VERSION;
+		uint64_t fileSize = 0;
+
+		// The vertex layout.
+		uint32_t vertexStride = 0;
+		uint32_t attributesCount = 0;
+		FileAttribute attributes[MAX_ATTRIBUTES_COUNT] = {};
+
+		uint32_t verticesCount = 0;
+		uint32_t indicesCount = 0;
+		uint32_t indexSize = 0;
+		uint32_t submeshesCount = 0;
+		uint32_t lodsCount = 0;
+		uint32_t reserved = 0;
+
+		float boundsMin[3] = {};
+		float boundsMax[3] = {};
+		float dequantizationOffset[3] = {};
+		float dequantizationScale[3] = {1.f, 1.f, 1.f};
+
+		// The offsets from the beginning of the file and the sizes in bytes.
+		uint64_t submeshesOffset = 0;
+		uint64_t lodsOffset = 0;
+		uint64_t vertexDataOffset = 0;
+		uint64_t vertexDataSize = 0;
+		uint64_t indexDataOffset = 0;
+		uint64_t indexDataSize = 0;
+	};
+	// The layout of the file: the sizes change only with the version.
+	static_assert(sizeof(FileAttribute) == 20 && sizeof(FileHeader) == 304);
+	static_assert(sizeof(MeshFile::Submesh) == 32 && sizeof(MeshFile::Lod) == 24);
+
+
+	bool fail(const std::filesystem::path& filePath, const std::string& message)
+	{
+		std::cerr << "[MeshFile] " << message << ": " << filePath.generic_string() << std::endl;
+		return false;
+	}
+
+
+	uint64_t alignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+
+	/**
+	 * @brief Checks that the range lies in the file, and it starts at a multiple of the alignment.
+	 */
+	bool isRangeInFile(uint64_t offset, uint64_t size, size_t alignment, size_t fileSize)
+	{
+		return offset % alignment == 0 && offset <= fileSize && size <= fileSize - offset;
+	}
+
+
+	const VertexLayout* findLayout(const FileHeader& header)
+	{
+		if (header.attributesCount > MAX_ATTRIBUTES_COUNT) {
+			return nullptr;
+		}
+		VertexAttribute attributes[MAX_ATTRIBUTES_COUNT];
+		for (size_t i = 0; i < header.attributesCount; ++i) {
+			const FileAttribute& attribute = header.attributes[i];
+			attributes[i] = {
+					attribute.location,
+					(GLint) attribute.componentsCount,
+					attribute.componentType,
+					(AttributeKind) attribute.kind,
+					attribute.offset,
+			};
+		}
+		const VertexLayout layout = {std::span(attributes, header.attributesCount), (GLsizei) header.vertexStride};
+		for (const VertexLayout* knownLayout : KNOWN_LAYOUTS) {
+			if (*knownLayout == layout) {
+				return knownLayout;
+			}
+		}
+		return nullptr;
+	}
+
+
+	template <typename Index>
+	uint32_t getMaxIndex(const std::byte* data, size_t count)
+	{
+		// The blob is aligned in the mapping, so it's read in place.
+		const auto* indices = reinterpret_cast<const Index*>(data);
+		uint32_t maxIndex = 0;
+		for (size_t i = 0; i < count; ++i) {
+			maxIndex = std::max<uint32_t>(maxIndex, indices[i]);
+		}
+		return maxIndex;
+	}
+
+
+	void writePadding(std::ofstream& outputFile, uint64_t size)
+	{
+		static constexpr char ZEROS[MeshFile::BLOB_ALIGNMENT] = {};
+		outputFile.write(ZEROS, (std::streamsize) size);
+	}
+}
+
+
+std::optional<MeshFile> MeshFile::open(const std::filesystem::path& filePath)
+{
+	MeshFile meshFile;
+	meshFile._file = MappedFile(filePath);
+	if (!meshFile._file.isOpen()) {
+		fail(filePath, "File opening failed");
+		return std::nullopt;
+	}
+
+	const std::span<const std::byte> bytes = meshFile._file.getBytes();
+	FileHeader header;
+	if (bytes.size() < sizeof(header)) {
+		fail(filePath, "Not a mesh file");
+		return std::nullopt;
+	}
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	if (header.magic != MESH_FILE_MAGIC) {
+		fail(filePath, "Not a mesh file");
+		return std::nullopt;
+	}
+	if (header.version != VERSION) {
+		fail(filePath, "The version " + std::to_string(header.version) + " isn't supported, convert the source again");
+		return std::nullopt;
+	}
+
+	const size_t fileSize = bytes.size();
+	const bool isValid = header.fileSize == fileSize
+			&& (header.indexSize == sizeof(uint16_t) || header.indexSize == sizeof(uint32_t))
+			&& header.lodsCount > 0
+			&& isRangeInFile(header.submeshesOffset, (uint64_t) header.submeshesCount * sizeof(Submesh), alignof(Submesh), fileSize)
+			&& isRangeInFile(header.lodsOffset, (uint64_t) header.lodsCount * sizeof(Lod), alignof(Lod), fileSize)
+			&& isRangeInFile(header.vertexDataOffset, header.vertexDataSize, BLOB_ALIGNMENT, fileSize)
+			&& isRangeInFile(header.indexDataOffset, header.indexDataSize, BLOB_ALIGNMENT, fileSize)
+			&& header.vertexDataSize == (uint64_t) header.verticesCount * header.vertexStride
+			&& header.indexDataSize == (uint64_t) header.indicesCount * header.indexSize;
+	if (!isValid) {
+		fail(filePath, "The file is truncated or corrupted");
+		return std::nullopt;
+	}
+	meshFile._vertexLayout = findLayout(header);
+	if (meshFile._vertexLayout == nullptr) {
+		fail(filePath, "Unknown vertex layout");
+		return std::nullopt;
+	}
+
+	meshFile._verticesCount = header.verticesCount;
+	meshFile._indicesCount = header.indicesCount;
+	meshFile._indexSize = header.indexSize;
+	meshFile._vertexData = bytes.subspan(header.vertexDataOffset, header.vertexDataSize);
+	meshFile._indexData = bytes.subspan(header.indexDataOffset, header.indexDataSize);
+	meshFile._submeshes = {reinterpret_cast<const Submesh*>(bytes.data() + header.submeshesOffset), header.submeshesCount};
+	meshFile._lods = {reinterpret_cast<const Lod*>(bytes.data() + header.lodsOffset), header.lodsCount};
+	meshFile._boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+	meshFile._boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+	meshFile._dequantization.offset = glm::vec3(header.dequantizationOffset[0], header.dequantizationOffset[1], header.dequantizationOffset[2]);
+	meshFile._dequantization.scale = glm::vec3(header.dequantizationScale[0], header.dequantizationScale[1], header.dequantizationScale[2]);
+
+	const auto isIndexRangeValid = [&](uint32_t firstIndex, uint32_t indicesCount) {
+		return firstIndex <= header.indicesCount && indicesCount <= header.indicesCount - firstIndex && indicesCount % 3 == 0;
+	};
+	for (const Submesh& submesh : meshFile._submeshes) {
+		if (!isIndexRangeValid(submesh.firstIndex, submesh.indicesCount)) {
+			fail(filePath, "A submesh is out of the indices");
+			return std::nullopt;
+		}
+	}
+	for (const Lod& lod : meshFile._lods) {
+		if (!isIndexRangeValid(lod.firstIndex, lod.indicesCount)
+				|| lod.firstSubmesh > header.submeshesCount || lod.submeshesCount > header.submeshesCount - lod.firstSubmesh) {
+			fail(filePath, "A LOD is out of the indices or the submeshes");
+			return std::nullopt;
+		}
+	}
+
+	// An index out of the vertex buffer reads past it on the GPU. It's a linear pass over the memory,
+	// which the upload reads anyway.
+	if (header.indicesCount > 0) {
+		const uint32_t maxIndex = (header.indexSize == sizeof(uint16_t))
+				? getMaxIndex<uint16_t>(meshFile._indexData.data(), header.indicesCount)
+				: getMaxIndex<uint32_t>(meshFile._indexData.data(), header.indicesCount);
+		if (maxIndex >= header.verticesCount) {
+			fail(filePath, "An index is out of the vertices");
+			return std::nullopt;
+		}
+	}
+	return meshFile;
+}
+
+
+bool MeshFile::write(
+		const std::filesystem::path& filePath,
+		const GeometricModel& model,
+		std::optional<PackedModel::PositionEncoding> encoding
+)
+{
+	const std::vector<VertexFormat>& vertices = model.getVertices();
+	if (vertices.size() > UINT32_MAX || model.getIndices().size() > UINT32_MAX) {
+		return fail(filePath, "The model is too large");
+	}
+
+	FileHeader header;
+	glm::vec3 boundsMin = vertices.empty() ? glm::vec3(0.f) : glm::vec3(vertices[0].pos.x, vertices[0].pos.y, vertices[0].pos.z);
+	glm::vec3 boundsMax = boundsMin;
+	for (const VertexFormat& vertex : vertices) {
+		const glm::vec3 pos(vertex.pos.x, vertex.pos.y, vertex.pos.z);
+		boundsMin = glm::min(boundsMin, pos);
+		boundsMax = glm::max(boundsMax, pos);
+	}
+
+	// The vertices and the indices as they are uploaded.
+	const VertexLayout* layout = &VertexLayouts::VERTEX_FORMAT;
+	const void* vertexData = vertices.data();
+	PackedModel packedModel;
+	PackedIndices floatModelIndices;
+	const PackedIndices* indices = &floatModelIndices;
+	if (encoding) {
+		packedModel = PackedModel::pack(model, *encoding);
+		layout = (*encoding == PackedModel::PositionEncoding::Half)
+				? &VertexLayouts::PACKED_VERTEX_FORMAT_HALF
+				: &VertexLayouts::PACKED_VERTEX_FORMAT_UNORM16;
+		vertexData = packedModel.getVertices().data();
+		indices = &packedModel.getIndices();
+		const PackedModel::Dequantization& dequantization = packedModel.getDequantization();
+		std::memcpy(header.dequantizationOffset, &dequantization.offset, sizeof(header.dequantizationOffset));
+		std::memcpy(header.dequantizationScale, &dequantization.scale, sizeof(header.dequantizationScale));
+	} else {
+		floatModelIndices = PackedIndices(model.getIndices(), vertices.size());
+	}
+
+	header.vertexStride = (uint32_t) layout->stride;
+	header.attributesCount = (uint32_t) layout->attributes.size();
+	for (size_t i = 0; i < layout->attributes.size(); ++i) {
+		const VertexAttribute& attribute = layout->attributes[i];
+		header.attributes[i] = {
+				attribute.location,
+				(uint32_t) attribute.componentsCount,
+				attribute.componentType,
+				(uint32_t) attribute.kind,
+				attribute.offset,
+		};
+	}
+	header.verticesCount = (uint32_t) vertices.size();
+	header.indicesCount = (uint32_t) indices->getCount();
+	header.indexSize = (uint32_t) indices->getIndexSize();
+	header.submeshesCount = 1;
+	header.lodsCount = 1;
+	std::memcpy(header.boundsMin, &boundsMin, sizeof(header.boundsMin));
+	std::memcpy(header.boundsMax, &boundsMax, sizeof(header.boundsMax));
+
+	header.submeshesOffset = sizeof(FileHeader);
+	header.lodsOffset = header.submeshesOffset + header.submeshesCount * sizeof(Submesh);
+	header.vertexDataOffset = alignUp(header.lodsOffset + header.lodsCount * sizeof(Lod), BLOB_ALIGNMENT);
+	header.vertexDataSize = (uint64_t) header.verticesCount * header.vertexStride;
+	header.indexDataOffset = alignUp(header.vertexDataOffset + header.vertexDataSize, BLOB_ALIGNMENT);
+	header.indexDataSize = indices->getBytesCount();
+	header.fileSize = header.indexDataOffset + header.indexDataSize;
+
+	Submesh submesh;
+	submesh.indicesCount = header.indicesCount;
+	std::memcpy(submesh.boundsMin, header.boundsMin, sizeof(submesh.boundsMin));
+	std::memcpy(submesh.boundsMax, header.boundsMax, sizeof(submesh.boundsMax));
+	Lod lod;
+	lod.indicesCount = header.indicesCount;
+	lod.submeshesCount = 1;
+
+	// Write to a temporary file first, so a reader never maps a partially written mesh.
+	const std::filesystem::path tempFilePath = filePath.string() + ".tmp";
+	{
+		auto outputFile = std::ofstream(tempFilePath, std::ios::binary | std::ios::trunc);
+		if (!outputFile) {
+			return fail(tempFilePath, "File opening failed");
+		}
+		outputFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		outputFile.write(reinterpret_cast<const char*>(&submesh), sizeof(submesh));
+		outputFile.write(reinterpret_cast<const char*>(&lod), sizeof(lod));
+		writePadding(outputFile, header.vertexDataOffset - (header.lodsOffset + sizeof(lod)));
+		outputFile.write(static_cast<const char*>(vertexData), (std::streamsize) header.vertexDataSize);
+		writePadding(outputFile, header.indexDataOffset - (header.vertexDataOffset + header.vertexDataSize));
+		outputFile.write(static_cast<const char*>(indices->getData()), (std::streamsize) header.indexDataSize);
+		outputFile.flush();
+		if (!outputFile) {
+			return fail(tempFilePath, "Writing failed");
+		}
+	}
+
+	std::error_code errorCode;
+	std::filesystem::rename(tempFilePath, filePath, errorCode);
+	if (errorCode) {
+		std::filesystem::remove(tempFilePath, errorCode);
+		return fail(filePath, "Mesh file storing failed");
+	}
+	return true;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "GeometricModel.hpp"
+#include "MappedFile.hpp"
+#include "PackedModel.hpp"
+#include "VertexLayout.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+#include <glm/vec3.hpp>
+
+
+/**
+ * @brief A mesh in the binary file format, which is loaded without parsing. The file is memory-mapped, and the vertex
+ * and index blobs are uploaded to the GPU straight from the mapping: no GeometricModel or other copies on the way.
+ *
+ * The file is the header (the vertex layout, the bounds and the dequantization of the packed positions), the tables
+ * of the submeshes and the LODs, then the vertex and the index blobs aligned to BLOB_ALIGNMENT. The fields are
+ * little-endian, like on all targets. The version is bumped on every change: older files are rejected, not migrated,
+ * since they are rebuilt from the sources by MeshConverter.
+ */
+class MeshFile
+{
+public:
+	static constexpr uint32_t VERSION = 1;
+	// The mapping is page-aligned, so the blobs are aligned for SIMD reads in the mapped memory too.
+	static constexpr size_t BLOB_ALIGNMENT = 64;
+
+	/**
+	 * @brief A part of the mesh, e.g. an imported mesh of a scene. Its triangles are a range of the index blob.
+	 */
+	struct Submesh
+	{
+		uint32_t firstIndex = 0;
+		uint32_t indicesCount = 0;
+		float boundsMin[3] = {};
+		float boundsMax[3] = {};
+	};
+
+	/**
+	 * @brief A level of detail: a contiguous range of the index blob with the submeshes of this level.
+	 * All levels share the vertex blob.
+	 */
+	struct Lod
+	{
+		uint32_t firstIndex = 0;
+		uint32_t indicesCount = 0;
+		uint32_t firstSubmesh = 0;
+		uint32_t submeshesCount = 0;
+		// The geometric error of the simplification relative to the mesh size. 0 for the source level.
+		float error = 0.f;
+		uint32_t reserved = 0;
+	};
+
+public:
+	MeshFile(MeshFile&& other) noexcept = default;
+
+	MeshFile& operator=(MeshFile&& other) noexcept = default;
+
+	/**
+	 * @brief Maps the file and validates the header, the tables and the indices, since GL doesn't check them.
+	 * Errors are printed.
+	 */
+	[[nodiscard]]
+	static std::optional<MeshFile> open(const std::filesystem::path& filePath);
+
+	/**
+	 * @brief Writes the model as one submesh with one LOD. The indices take 16 bits, if the vertices allow it.
+	 * @param encoding The packed vertices of the encoding, or the float VertexFormat ones, if it's std::nullopt.
+	 * @return false, if the file can't be written. The file is replaced atomically, so readers never see a partial one.
+	 */
+	static bool write(
+			const std::filesystem::path& filePath,
+			const GeometricModel& model,
+			std::optional<PackedModel::PositionEncoding> encoding
+	);
+
+	/**
+	 * @brief One of the layouts in VertexLayouts: the files with other layouts aren't opened.
+	 */
+	[[nodiscard]]
+	const VertexLayout& getVertexLayout() const { return *_vertexLayout; }
+
+	[[nodiscard]]
+	std::span<const std::byte> getVertexData() const { return _vertexData; }
+
+	[[nodiscard]]
+	std::span<const std::byte> getIndexData() const { return _indexData; }
+
+	[[nodiscard]]
+	size_t getVerticesCount() const { return _verticesCount; }
+
+	[[nodiscard]]
+	size_t getIndicesCount() const { return _indicesCount; }
+
+	/**
+	 * @return 2 or 4.
+	 */
+	[[nodiscard]]
+	size_t getIndexSize() const { return _indexSize; }
+
+	/**
+	 * @brief The dequantization of the packed positions. It's the identity for the float vertices.
+	 */
+	[[nodiscard]]
+	const PackedModel::Dequantization& getDequantization() const { return _dequantization; }
+
+	[[nodiscard]]
+	const glm::vec3& getBoundsMin() const { return _boundsMin; }
+
+	[[nodiscard]]
+	const glm::vec3& getBoundsMax() const { return _boundsMax; }
+
+	[[nodiscard]]
+	std::span<const Submesh> getSubmeshes() const { return _submeshes; }
+
+	[[nodiscard]]
+	std::span<const Lod> getLods() const { return _lods; }
+
+private:
+	MeshFile() = default;
+
+private:
+	MappedFile _file;
+	const VertexLayout* _vertexLayout = &VertexLayouts::VERTEX_FORMAT;
+	// The views of the mapping.
+	std::span<const std::byte> _vertexData;
+	std::span<const std::byte> _indexData;
+	std::span<const Submesh> _submeshes;
+	std::span<const Lod> _lods;
+	size_t _verticesCount = 0;
+	size_t _indicesCount = 0;
+	size_t _indexSize = sizeof(uint32_t);
+	PackedModel::Dequantization _dequantization;
+	glm::vec3 _boundsMin = glm::vec3(0.f);
+	glm::vec3 _boundsMax = glm::vec3(0.f);
+};
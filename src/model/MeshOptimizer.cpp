@@ -0,0 +1,373 @@
+#include "MeshOptimizer.hpp"
+
+#include "ThreadPool.hpp"
+#include "Utilities.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+
+
+namespace {
+	constexpr uint32_t NO_VERTEX = std::numeric_limits<uint32_t>::max();
+
+
+	/**
+	 * @brief The FIFO cache by timestamps: a vertex is in the cache, if less than cacheSize vertices were added after it.
+	 * It's the model of Tipsify, so the analysis and the ordering agree.
+	 */
+	class FifoCache
+	{
+	public:
+		FifoCache(size_t entriesCount, size_t cacheSize)
+				: _timestamps(entriesCount, 0)
+				, _cacheSize((uint32_t) cacheSize)
+				, _time((uint32_t) cacheSize + 1)
+		{
+		}
+
+		/**
+		 * @return Whether it was a miss.
+		 */
+		bool access(uint32_t entry)
+		{
+			if (_time - _timestamps[entry] <= _cacheSize) {
+				return false;
+			}
+			_timestamps[entry] = _time++;
+			return true;
+		}
+
+		/**
+		 * @brief The number of entries added after the entry, plus one. Larger than the cache size, if it's not cached.
+		 */
+		[[nodiscard]]
+		uint32_t getAge(uint32_t entry) const { return _time - _timestamps[entry]; }
+
+		void flush() { _time += _cacheSize + 1; }
+
+	private:
+		std::vector<uint32_t> _timestamps;
+		uint32_t _cacheSize = 0;
+		uint32_t _time = 0;
+	};
+
+
+	glm::vec3 getPosition(const VertexFormat& vertex)
+	{
+		return glm::vec3(vertex.pos.x, vertex.pos.y, vertex.pos.z);
+	}
+}
+
+
+GeometricModel MeshOptimizer::optimize(const GeometricModel& model, const MeshOptimizationOptions& options)
+{
+	const std::vector<VertexFormat>& vertices = model.getVertices();
+	assertTrueMsg(model.getIndices().size() % 3 == 0, "The model must consist of triangles.");
+
+	std::vector<size_t> clusterStarts;
+	std::vector<IndexType> indices = optimizeVertexCache(
+			model.getIndices(),
+			vertices.size(),
+			options.cacheSize,
+			options.isOverdrawOptimized ? &clusterStarts : nullptr
+	);
+	if (options.isOverdrawOptimized) {
+		indices = optimizeOverdraw(indices, vertices, clusterStarts, options.cacheSize, options.overdrawThreshold);
+	}
+	return optimizeVertexFetch(vertices, indices);
+}
+
+
+std::vector<GeometricModel> MeshOptimizer::optimizeAll(
+		ThreadPool& threadPool,
+		std::span<const GeometricModel> models,
+		const MeshOptimizationOptions& options
+)
+{
+	std::vector<GeometricModel> optimizedModels(models.size(), GeometricModel({}, {}));
+	// The models are taken one by one from the counter, so a large model doesn't hold up a chunk of small ones.
+	std::atomic<size_t> nextModel = 0;
+	threadPool.parallelFor(std::min(models.size(), threadPool.getThreadsCount()), 1, [&](size_t, size_t, size_t) {
+		for (size_t i = nextModel++; i < models.size(); i = nextModel++) {
+			optimizedModels[i] = optimize(models[i], options);
+		}
+	});
+	return optimizedModels;
+}
+
+
+std::vector<MeshOptimizer::IndexType> MeshOptimizer::optimizeVertexCache(
+		std::span<const IndexType> indices,
+		size_t verticesCount,
+		size_t cacheSize,
+		std::vector<size_t>* outClusterStarts
+)
+{
+	const size_t trianglesCount = indices.size() / 3;
+	std::vector<IndexType> result;
+	result.reserve(trianglesCount * 3);
+	if (outClusterStarts != nullptr) {
+		outClusterStarts->clear();
+	}
+	if (trianglesCount == 0) {
+		return result;
+	}
+
+	// The triangles around every vertex, and the number of the ones which aren't emitted yet.
+	std::vector<uint32_t> liveTrianglesCounts(verticesCount, 0);
+	for (size_t i = 0; i < trianglesCount * 3; ++i) {
+		++liveTrianglesCounts[indices[i]];
+	}
+	std::vector<uint32_t> adjacencyOffsets(verticesCount + 1, 0);
+	for (size_t vertex = 0; vertex < verticesCount; ++vertex) {
+		adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveTrianglesCounts[vertex];
+	}
+	std::vector<uint32_t> adjacency(trianglesCount * 3);
+	{
+		std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < trianglesCount * 3; ++i) {
+			adjacency[fillOffsets[indices[i]]++] = (uint32_t) (i / 3);
+		}
+	}
+
+	FifoCache cache(verticesCount, cacheSize);
+	std::vector<bool> isEmitted(trianglesCount, false);
+	// The recently used vertices: where the fanning continues, if no candidate is good.
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	size_t cursor = 0;
+
+	const auto findDeadEnd = [&]() {
+		while (!deadEnds.empty()) {
+			const uint32_t vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTrianglesCounts[vertex] > 0) {
+				return vertex;
+			}
+		}
+		for (; cursor < verticesCount; ++cursor) {
+			if (liveTrianglesCounts[cursor] > 0) {
+				return (uint32_t) cursor;
+			}
+		}
+		return NO_VERTEX;
+	};
+
+	uint32_t fanVertex = findDeadEnd();
+	bool isJump = true;
+	while (fanVertex != NO_VERTEX) {
+		if (isJump && outClusterStarts != nullptr) {
+			outClusterStarts->push_back(result.size() / 3);
+		}
+
+		// Emit all remaining triangles around the vertex.
+		candidates.clear();
+		for (uint32_t k = adjacencyOffsets[fanVertex]; k < adjacencyOffsets[fanVertex + 1]; ++k) {
+			const uint32_t triangle = adjacency[k];
+			if (isEmitted[triangle]) {
+				continue;
+			}
+			isEmitted[triangle] = true;
+			for (size_t corner = 0; corner < 3; ++corner) {
+				const uint32_t vertex = indices[triangle * 3 + corner];
+				result.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				--liveTrianglesCounts[vertex];
+				cache.access(vertex);
+			}
+		}
+
+		// The next fan is the oldest vertex, which stays in the cache, while all its triangles are emitted.
+		uint32_t nextVertex = NO_VERTEX;
+		uint32_t bestPriority = 0;
+		for (const uint32_t vertex : candidates) {
+			if (liveTrianglesCounts[vertex] == 0) {
+				continue;
+			}
+			const uint32_t age = cache.getAge(vertex);
+			const uint32_t priority = (age + 2 * liveTrianglesCounts[vertex] <= cacheSize) ? age : 0;
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				nextVertex = vertex;
+			}
+		}
+
+		isJump = (nextVertex == NO_VERTEX);
+		fanVertex = isJump ? findDeadEnd() : nextVertex;
+	}
+	return result;
+}
+
+
+std::vector<MeshOptimizer::IndexType> MeshOptimizer::optimizeOverdraw(
+		std::span<const IndexType> indices,
+		std::span<const VertexFormat> vertices,
+		std::span<const size_t> clusterStarts,
+		size_t cacheSize,
+		float threshold
+)
+{
+	const size_t trianglesCount = indices.size() / 3;
+	if (trianglesCount == 0) {
+		return {};
+	}
+
+	// Soft boundaries: a hard cluster is cut, where the running ACMR from the last cut reaches the one of the cluster.
+	// The cache is flushed at every cut, so the clusters can be drawn in any order for the same cost.
+	FifoCache cache(vertices.size(), cacheSize);
+	const auto countMisses = [&](size_t triangle) {
+		size_t missesCount = 0;
+		for (size_t corner = 0; corner < 3; ++corner) {
+			missesCount += cache.access(indices[triangle * 3 + corner]) ? 1 : 0;
+		}
+		return missesCount;
+	};
+
+	std::vector<size_t> clusters;
+	const size_t hardClustersCount = std::max<size_t>(clusterStarts.size(), 1);
+	for (size_t hardCluster = 0; hardCluster < hardClustersCount; ++hardCluster) {
+		const size_t begin = clusterStarts.empty() ? 0 : clusterStarts[hardCluster];
+		const size_t end = (hardCluster + 1 < clusterStarts.size()) ? clusterStarts[hardCluster + 1] : trianglesCount;
+
+		cache.flush();
+		size_t clusterMissesCount = 0;
+		for (size_t triangle = begin; triangle < end; ++triangle) {
+			clusterMissesCount += countMisses(triangle);
+		}
+		const double clusterThreshold = threshold * (double) clusterMissesCount / (double) (end - begin);
+
+		cache.flush();
+		clusters.push_back(begin);
+		size_t runningMissesCount = 0;
+		size_t runningTrianglesCount = 0;
+		for (size_t triangle = begin; triangle + 1 < end; ++triangle) {
+			runningMissesCount += countMisses(triangle);
+			++runningTrianglesCount;
+			if ((double) runningMissesCount <= clusterThreshold * (double) runningTrianglesCount) {
+				clusters.push_back(triangle + 1);
+				cache.flush();
+				runningMissesCount = 0;
+				runningTrianglesCount = 0;
+			}
+		}
+	}
+
+	// The clusters on the outside, which face outwards, hide the others from most views, so they go first.
+	glm::vec3 meshCenter(0.f);
+	for (size_t i = 0; i < trianglesCount * 3; ++i) {
+		meshCenter += getPosition(vertices[indices[i]]);
+	}
+	meshCenter /= (float) (trianglesCount * 3);
+
+	const size_t clustersCount = clusters.size();
+	std::vector<float> sortKeys(clustersCount);
+	for (size_t cluster = 0; cluster < clustersCount; ++cluster) {
+		const size_t end = (cluster + 1 < clustersCount) ? clusters[cluster + 1] : trianglesCount;
+		glm::vec3 weightedCenter(0.f);
+		glm::vec3 normal(0.f);
+		float area = 0.f;
+		for (size_t triangle = clusters[cluster]; triangle < end; ++triangle) {
+			const glm::vec3 p0 = getPosition(vertices[indices[triangle * 3]]);
+			const glm::vec3 p1 = getPosition(vertices[indices[triangle * 3 + 1]]);
+			const glm::vec3 p2 = getPosition(vertices[indices[triangle * 3 + 2]]);
+			// The length of the cross product is twice the area, so the sums are area weighted.
+			const glm::vec3 triangleNormal = glm::cross(p1 - p0, p2 - p0);
+			const float triangleArea = glm::length(triangleNormal);
+			weightedCenter += (p0 + p1 + p2) * (triangleArea / 3.f);
+			normal += triangleNormal;
+			area += triangleArea;
+		}
+		const float normalLength = glm::length(normal);
+		sortKeys[cluster] = (area > 0.f && normalLength > 0.f)
+				? glm::dot(weightedCenter / area - meshCenter, normal / normalLength)
+				: 0.f;
+	}
+
+	std::vector<size_t> clusterOrder(clustersCount);
+	for (size_t cluster = 0; cluster < clustersCount; ++cluster) {
+		clusterOrder[cluster] = cluster;
+	}
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](size_t left, size_t right) {
+		return sortKeys[left] > sortKeys[right];
+	});
+
+	std::vector<IndexType> result;
+	result.reserve(trianglesCount * 3);
+	for (const size_t cluster : clusterOrder) {
+		const size_t end = (cluster + 1 < clustersCount) ? clusters[cluster + 1] : trianglesCount;
+		result.insert(result.end(), indices.begin() + (ptrdiff_t) (clusters[cluster] * 3), indices.begin() + (ptrdiff_t) (end * 3));
+	}
+	return result;
+}
+
+
+GeometricModel MeshOptimizer::optimizeVertexFetch(std::span<const VertexFormat> vertices, std::span<const IndexType> indices)
+{
+	std::vector<uint32_t> remap(vertices.size(), NO_VERTEX);
+	std::vector<VertexFormat> optimizedVertices;
+	std::vector<IndexType> optimizedIndices(indices.size());
+	for (size_t i = 0; i < indices.size(); ++i) {
+		uint32_t& newIndex = remap[indices[i]];
+		if (newIndex == NO_VERTEX) {
+			newIndex = (uint32_t) optimizedVertices.size();
+			optimizedVertices.push_back(vertices[indices[i]]);
+		}
+		optimizedIndices[i] = newIndex;
+	}
+	return GeometricModel(std::move(optimizedVertices), std::move(optimizedIndices));
+}
+
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::analyzeVertexCache(
+		std::span<const IndexType> indices,
+		size_t verticesCount,
+		size_t cacheSize
+)
+{
+	FifoCache cache(verticesCount, cacheSize);
+	std::vector<bool> isReferenced(verticesCount, false);
+	size_t referencedCount = 0;
+	VertexCacheStats stats;
+	for (const IndexType index : indices) {
+		stats.transformedVerticesCount += cache.access(index) ? 1 : 0;
+		if (!isReferenced[index]) {
+			isReferenced[index] = true;
+			++referencedCount;
+		}
+	}
+
+	const size_t trianglesCount = indices.size() / 3;
+	stats.acmr = (trianglesCount > 0) ? (double) stats.transformedVerticesCount / (double) trianglesCount : 0.0;
+	stats.atvr = (referencedCount > 0) ? (double) stats.transformedVerticesCount / (double) referencedCount : 0.0;
+	return stats;
+}
+
+
+double MeshOptimizer::analyzeVertexFetch(std::span<const IndexType> indices, size_t verticesCount, size_t vertexSize)
+{
+	const size_t linesCount = (verticesCount * vertexSize + FETCH_CACHE_LINE_SIZE - 1) / FETCH_CACHE_LINE_SIZE;
+	FifoCache cache(linesCount, FETCH_CACHE_LINES_COUNT);
+	std::vector<bool> isReferenced(verticesCount, false);
+	size_t referencedCount = 0;
+	size_t fetchedLinesCount = 0;
+	for (const IndexType index : indices) {
+		// A vertex may straddle two lines.
+		const size_t firstLine = index * vertexSize / FETCH_CACHE_LINE_SIZE;
+		const size_t lastLine = ((size_t) index * vertexSize + vertexSize - 1) / FETCH_CACHE_LINE_SIZE;
+		for (size_t line = firstLine; line <= lastLine; ++line) {
+			fetchedLinesCount += cache.access((uint32_t) line) ? 1 : 0;
+		}
+		if (!isReferenced[index]) {
+			isReferenced[index] = true;
+			++referencedCount;
+		}
+	}
+	return (referencedCount > 0)
+			? (double) (fetchedLinesCount * FETCH_CACHE_LINE_SIZE) / (double) (referencedCount * vertexSize)
+			: 0.0;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "GeometricModel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+class ThreadPool;
+
+
+/**
+ * @brief The steps of MeshOptimizer::optimize().
+ */
+struct MeshOptimizationOptions
+{
+	// The FIFO post-transform cache size, which the triangle order is tuned for. 16-32 entries match most GPUs.
+	size_t cacheSize = 16;
+	// Reorders the clusters of triangles, so the outer ones are drawn first and hide the inner ones.
+	bool isOverdrawOptimized = false;
+	// A cluster is closed, when its own ACMR gets within this factor of the one of the whole cache-ordered run.
+	// Larger values give smaller clusters: less overdraw, but more cache misses.
+	float overdrawThreshold = 1.05f;
+};
+
+
+/**
+ * @brief Reorders the triangles and the vertices of models for the GPU caches. The models stay the same otherwise.
+ *
+ * 1. The triangles are ordered for the post-transform vertex cache with Tipsify (Sander, Nehab, Barczak,
+ * "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007): it fans around the vertices,
+ * which are still in the cache, so a vertex is shaded about once instead of up to 6 times.
+ * 2. Optionally the cache-ordered run is cut into clusters, and they are sorted from outside in by their normals.
+ * 3. The vertices are reordered by the first use, so the vertex fetch reads the buffer sequentially.
+ */
+class MeshOptimizer
+{
+public:
+	using IndexType = GeometricModel::IndexType;
+
+	/**
+	 * @brief The vertex shading cost of the triangle order in a FIFO cache.
+	 */
+	struct VertexCacheStats
+	{
+		size_t transformedVerticesCount = 0;
+		// Average cache miss ratio: transformed vertices per triangle. 0.5 is the ideal for large regular meshes, 3 is the worst.
+		double acmr = 0.0;
+		// Average transform to vertex ratio: transformed vertices per referenced vertex. 1 is the ideal.
+		double atvr = 0.0;
+	};
+
+	// The cache of the vertex fetch in analyzeVertexFetch(): 64-byte lines, 4 KiB.
+	static constexpr size_t FETCH_CACHE_LINE_SIZE = 64;
+	static constexpr size_t FETCH_CACHE_LINES_COUNT = 64;
+
+public:
+	/**
+	 * @brief Runs the steps of the options. Unreferenced vertices are removed.
+	 */
+	[[nodiscard]]
+	static GeometricModel optimize(const GeometricModel& model, const MeshOptimizationOptions& options);
+
+	/**
+	 * @brief Optimizes every model independently on the threads of the pool, e.g. all meshes of an imported file.
+	 */
+	[[nodiscard]]
+	static std::vector<GeometricModel> optimizeAll(
+			ThreadPool& threadPool,
+			std::span<const GeometricModel> models,
+			const MeshOptimizationOptions& options
+	);
+
+	/**
+	 * @brief Orders the triangles for the vertex cache with Tipsify.
+	 * @param outClusterStarts If it isn't nullptr, it receives the first triangle of every run, which had to jump
+	 * 	to a vertex out of the cache. They are the hard boundaries for optimizeOverdraw().
+	 */
+	[[nodiscard]]
+	static std::vector<IndexType> optimizeVertexCache(
+			std::span<const IndexType> indices,
+			size_t verticesCount,
+			size_t cacheSize,
+			std::vector<size_t>* outClusterStarts = nullptr
+	);
+
+	/**
+	 * @brief Sorts the clusters of the cache-ordered triangles, so the ones facing outwards on the outside go first.
+	 * @param indices The result of optimizeVertexCache().
+	 * @param clusterStarts The hard boundaries from optimizeVertexCache(). The clusters are split further,
+	 * 	where the cache efficiency allows.
+	 */
+	[[nodiscard]]
+	static std::vector<IndexType> optimizeOverdraw(
+			std::span<const IndexType> indices,
+			std::span<const VertexFormat> vertices,
+			std::span<const size_t> clusterStarts,
+			size_t cacheSize,
+			float threshold
+	);
+
+	/**
+	 * @brief Reorders the vertices by the first use in the indices, and drops the unreferenced ones.
+	 */
+	[[nodiscard]]
+	static GeometricModel optimizeVertexFetch(std::span<const VertexFormat> vertices, std::span<const IndexType> indices);
+
+	/**
+	 * @brief Simulates the FIFO post-transform cache.
+	 */
+	[[nodiscard]]
+	static VertexCacheStats analyzeVertexCache(std::span<const IndexType> indices, size_t verticesCount, size_t cacheSize);
+
+	/**
+	 * @brief Simulates a small FIFO cache of the vertex fetch.
+	 * @return The fetched bytes divided by the size of the referenced vertices: 1 is the ideal.
+	 */
+	[[nodiscard]]
+	static double analyzeVertexFetch(std::span<const IndexType> indices, size_t verticesCount, size_t vertexSize);
+};
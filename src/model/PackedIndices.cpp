@@ -0,0 +1,32 @@
+#include "PackedIndices.hpp"
+
+#include "Utilities.hpp"
+
+
+PackedIndices::PackedIndices(std::span<const uint32_t> indices, size_t verticesCount, Simd::Isa isa)
+		: _isShort(verticesCount <= MAX_SHORT_VERTICES_COUNT)
+{
+	assertTrueMsg(Simd::isSupported(isa), "The instruction set isn't supported by the CPU.");
+	if (!_isShort) {
+		_indices.assign(indices.begin(), indices.end());
+		return;
+	}
+
+	_shortIndices.resize(indices.size());
+	size_t i = 0;
+#if SIMD_X86
+	if (isa != Simd::Isa::Scalar) {
+		// SSE2 packs with the signed saturation only, so the indices are shifted to the signed range and back.
+		const __m128i bias = _mm_set1_epi32(0x8000);
+		const __m128i unbias = _mm_set1_epi16((short) 0x8000);
+		for (; i + 8 <= indices.size(); i += 8) {
+			const __m128i low = _mm_sub_epi32(_mm_loadu_si128((const __m128i*) &indices[i]), bias);
+			const __m128i high = _mm_sub_epi32(_mm_loadu_si128((const __m128i*) &indices[i + 4]), bias);
+			_mm_storeu_si128((__m128i*) &_shortIndices[i], _mm_xor_si128(_mm_packs_epi32(low, high), unbias));
+		}
+	}
+#endif
+	for (; i < indices.size(); ++i) {
+		_shortIndices[i] = (uint16_t) indices[i];
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Simd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+/**
+ * @brief Triangle indices in the narrowest width, which fits the vertices: 16 bits up to 65536 vertices, 32 bits otherwise.
+ * Most meshes are small, so the index buffers and the index fetch are halved for them.
+ */
+class PackedIndices
+{
+public:
+	// The largest vertices count with 16-bit indices: the last index is 65535.
+	static constexpr size_t MAX_SHORT_VERTICES_COUNT = 65536;
+
+public:
+	PackedIndices() = default;
+
+	/**
+	 * @param verticesCount The number of the vertices, which the indices address. It picks the width.
+	 * @param isa The narrowing to 16 bits uses SSE2 for any SIMD level. It must be supported by the CPU.
+	 */
+	PackedIndices(std::span<const uint32_t> indices, size_t verticesCount, Simd::Isa isa = Simd::getBestIsa());
+
+	/**
+	 * @return 2 or 4.
+	 */
+	[[nodiscard]]
+	size_t getIndexSize() const { return _isShort ? sizeof(uint16_t) : sizeof(uint32_t); }
+
+	[[nodiscard]]
+	size_t getCount() const { return _isShort ? _shortIndices.size() : _indices.size(); }
+
+	[[nodiscard]]
+	size_t getBytesCount() const { return getCount() * getIndexSize(); }
+
+	/**
+	 * @brief The indices as they are uploaded to the element buffer.
+	 */
+	[[nodiscard]]
+	const void* getData() const { return _isShort ? (const void*) _shortIndices.data() : (const void*) _indices.data(); }
+
+	[[nodiscard]]
+	uint32_t operator[](size_t i) const { return _isShort ? _shortIndices[i] : _indices[i]; }
+
+private:
+	bool _isShort = false;
+	std::vector<uint16_t> _shortIndices;
+	std::vector<uint32_t> _indices;
+};
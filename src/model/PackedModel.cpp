@@ -0,0 +1,317 @@
+#include "PackedModel.hpp"
+
+#include "Utilities.hpp"
+#include "VertexPacking.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/geometric.hpp>
+
+
+namespace {
+	struct PackParameters
+	{
+		PackedModel::PositionEncoding positionEncoding = PackedModel::PositionEncoding::Half;
+		glm::vec3 offset = glm::vec3(0.f);
+		// 1 / Dequantization::scale, Unorm16 only.
+		glm::vec3 inverseScale = glm::vec3(1.f);
+	};
+
+
+	void packPositionScalar(const VertexFormat& input, const PackParameters& parameters, PackedVertexFormat& output)
+	{
+		const float position[3] = {
+				input.pos.x - parameters.offset.x,
+				input.pos.y - parameters.offset.y,
+				input.pos.z - parameters.offset.z,
+		};
+		for (int axis = 0; axis < 3; ++axis) {
+			output.pos[axis] = (parameters.positionEncoding == PackedModel::PositionEncoding::Half)
+					? VertexPacking::floatToHalf(position[axis])
+					: VertexPacking::floatToUnorm16(position[axis] * parameters.inverseScale[axis]);
+		}
+		output.pos[3] = 0;
+	}
+
+
+	void packColorScalar(const VertexFormat& input, PackedVertexFormat& output)
+	{
+		output.color[0] = VertexPacking::floatToUnorm8(input.color.r);
+		output.color[1] = VertexPacking::floatToUnorm8(input.color.g);
+		output.color[2] = VertexPacking::floatToUnorm8(input.color.b);
+		output.color[3] = VertexPacking::floatToUnorm8(input.color.a);
+	}
+
+
+	void packTexCoordsScalar(const VertexFormat& input, PackedVertexFormat& output)
+	{
+		output.texCoords[0] = VertexPacking::floatToHalf(input.texCoords.u);
+		output.texCoords[1] = VertexPacking::floatToHalf(input.texCoords.v);
+	}
+
+
+	void packVerticesScalar(
+			std::span<const VertexFormat> vertices,
+			std::span<const glm::vec3> normals,
+			const PackParameters& parameters,
+			PackedVertexFormat* out
+	)
+	{
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			packPositionScalar(vertices[i], parameters, out[i]);
+			packColorScalar(vertices[i], out[i]);
+			packTexCoordsScalar(vertices[i], out[i]);
+			VertexPacking::encodeOctahedral(normals[i], out[i].normal);
+		}
+	}
+
+
+#if SIMD_X86
+	// The vertices are AoS, so a vertex is converted at a time: the position and the color are 4 lanes each.
+	// The operations are the same as in VertexPacking and in the same order, so the results are equal bit for bit.
+	struct PackParametersSse
+	{
+		__m128 offset;
+		__m128 inverseScale;
+	};
+
+
+	PackParametersSse splatParameters(const PackParameters& parameters)
+	{
+		// The 4th lane reads the red of the color after the position, and it's multiplied by 0.
+		return {
+				_mm_setr_ps(parameters.offset.x, parameters.offset.y, parameters.offset.z, 0.f),
+				_mm_setr_ps(parameters.inverseScale.x, parameters.inverseScale.y, parameters.inverseScale.z, 0.f),
+		};
+	}
+
+
+	inline void packPositionUnorm16Sse(const VertexFormat& input, const PackParametersSse& parameters, PackedVertexFormat& output)
+	{
+		__m128 position = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&input.pos.x), parameters.offset), parameters.inverseScale);
+		position = _mm_mul_ps(position, _mm_set1_ps(65535.f));
+		position = _mm_min_ps(_mm_max_ps(position, _mm_setzero_ps()), _mm_set1_ps(65535.f));
+		// SSE2 packs with the signed saturation only, so the values are shifted to the signed range and back.
+		const __m128i values = _mm_sub_epi32(_mm_cvtps_epi32(position), _mm_set1_epi32(0x8000));
+		const __m128i packed = _mm_xor_si128(_mm_packs_epi32(values, values), _mm_set1_epi16((short) 0x8000));
+		_mm_storel_epi64((__m128i*) output.pos, packed);
+	}
+
+
+	inline void packColorSse(const VertexFormat& input, PackedVertexFormat& output)
+	{
+		__m128 color = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&input.color.r), _mm_setzero_ps()), _mm_set1_ps(1.f));
+		color = _mm_mul_ps(color, _mm_set1_ps(255.f));
+		__m128i values = _mm_cvtps_epi32(color);
+		values = _mm_packs_epi32(values, values);
+		values = _mm_packus_epi16(values, values);
+		const int packed = _mm_cvtsi128_si32(values);
+		std::memcpy(output.color, &packed, sizeof(output.color));
+	}
+
+
+	void packVerticesSse(
+			std::span<const VertexFormat> vertices,
+			std::span<const glm::vec3> normals,
+			const PackParameters& parameters,
+			PackedVertexFormat* out
+	)
+	{
+		const PackParametersSse parametersSse = splatParameters(parameters);
+		const bool isHalf = (parameters.positionEncoding == PackedModel::PositionEncoding::Half);
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			if (isHalf) {
+				packPositionScalar(vertices[i], parameters, out[i]);
+			} else {
+				packPositionUnorm16Sse(vertices[i], parametersSse, out[i]);
+			}
+			packColorSse(vertices[i], out[i]);
+			packTexCoordsScalar(vertices[i], out[i]);
+			VertexPacking::encodeOctahedral(normals[i], out[i].normal);
+		}
+	}
+#endif
+
+
+#if SIMD_F16C
+	SIMD_TARGET_F16C
+	void packVerticesF16c(
+			std::span<const VertexFormat> vertices,
+			std::span<const glm::vec3> normals,
+			const PackParameters& parameters,
+			PackedVertexFormat* out
+	)
+	{
+		const PackParametersSse parametersSse = splatParameters(parameters);
+		const bool isHalf = (parameters.positionEncoding == PackedModel::PositionEncoding::Half);
+		const __m128 positionMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			const VertexFormat& input = vertices[i];
+			if (isHalf) {
+				// The 4th lane becomes 0, which is the half float 0 too.
+				const __m128 position = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(&input.pos.x), parametersSse.offset), positionMask);
+				_mm_storel_epi64((__m128i*) out[i].pos, _mm_cvtps_ph(position, _MM_FROUND_TO_NEAREST_INT));
+			} else {
+				packPositionUnorm16Sse(input, parametersSse, out[i]);
+			}
+			packColorSse(input, out[i]);
+
+			const __m128 texCoords = _mm_castpd_ps(_mm_load_sd((const double*) &input.texCoords.u));
+			const int packedTexCoords = _mm_cvtsi128_si32(_mm_cvtps_ph(texCoords, _MM_FROUND_TO_NEAREST_INT));
+			std::memcpy(out[i].texCoords, &packedTexCoords, sizeof(out[i].texCoords));
+
+			VertexPacking::encodeOctahedral(normals[i], out[i].normal);
+		}
+	}
+#endif
+}
+
+
+glm::mat4 PackedModel::Dequantization::getMatrix() const
+{
+	return glm::scale(glm::translate(glm::mat4(1.f), offset), scale);
+}
+
+
+PackedModel PackedModel::pack(const GeometricModel& model, PositionEncoding encoding, Isa isa)
+{
+	return pack(model, computeNormals(model), encoding, isa);
+}
+
+
+PackedModel PackedModel::pack(
+		const GeometricModel& model,
+		std::span<const glm::vec3> normals,
+		PositionEncoding encoding,
+		Isa isa
+)
+{
+	assertTrueMsg(Simd::isSupported(isa), "The instruction set isn't supported by the CPU.");
+	const std::vector<VertexFormat>& vertices = model.getVertices();
+	assertTrue(normals.size() == vertices.size());
+
+	PackedModel packedModel;
+	packedModel._positionEncoding = encoding;
+	packedModel._indices = PackedIndices(model.getIndices(), vertices.size(), isa);
+	if (vertices.empty()) {
+		return packedModel;
+	}
+
+	glm::vec3 minPosition(vertices[0].pos.x, vertices[0].pos.y, vertices[0].pos.z);
+	glm::vec3 maxPosition = minPosition;
+	for (const VertexFormat& vertex : vertices) {
+		const glm::vec3 position(vertex.pos.x, vertex.pos.y, vertex.pos.z);
+		minPosition = glm::min(minPosition, position);
+		maxPosition = glm::max(maxPosition, position);
+	}
+
+	// Half floats are the most precise near 0, so they are centered. Normalized values span the bounds.
+	PackParameters parameters;
+	parameters.positionEncoding = encoding;
+	Dequantization& dequantization = packedModel._dequantization;
+	if (encoding == PositionEncoding::Half) {
+		dequantization.offset = (minPosition + maxPosition) * 0.5f;
+	} else {
+		const glm::vec3 size = maxPosition - minPosition;
+		dequantization.offset = minPosition;
+		dequantization.scale = glm::vec3(
+				(size.x > 0.f) ? size.x : 1.f,
+				(size.y > 0.f) ? size.y : 1.f,
+				(size.z > 0.f) ? size.z : 1.f
+		);
+		parameters.inverseScale = 1.f / dequantization.scale;
+	}
+	parameters.offset = dequantization.offset;
+
+	packedModel._vertices.resize(vertices.size());
+	PackedVertexFormat* out = packedModel._vertices.data();
+	switch (isa) {
+#if SIMD_X86
+		case Isa::Avx:
+		case Isa::Sse:
+#if SIMD_F16C
+			if (Simd::isF16cSupported()) {
+				packVerticesF16c(vertices, normals, parameters, out);
+				break;
+			}
+#endif
+			packVerticesSse(vertices, normals, parameters, out);
+			break;
+#endif
+		default:
+			packVerticesScalar(vertices, normals, parameters, out);
+			break;
+	}
+	return packedModel;
+}
+
+
+std::vector<glm::vec3> PackedModel::computeNormals(const GeometricModel& model)
+{
+	const std::vector<VertexFormat>& vertices = model.getVertices();
+	const std::vector<GeometricModel::IndexType>& indices = model.getIndices();
+	std::vector<glm::vec3> normals(vertices.size(), glm::vec3(0.f));
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		const auto getPosition = [&](size_t index) {
+			const VertexFormat::Pos& pos = vertices[indices[index]].pos;
+			return glm::vec3(pos.x, pos.y, pos.z);
+		};
+		const glm::vec3 p0 = getPosition(i);
+		// The length of the cross product is twice the area.
+		const glm::vec3 faceNormal = glm::cross(getPosition(i + 1) - p0, getPosition(i + 2) - p0);
+		for (size_t corner = 0; corner < 3; ++corner) {
+			normals[indices[i + corner]] += faceNormal;
+		}
+	}
+
+	for (glm::vec3& normal : normals) {
+		const float length = glm::length(normal);
+		normal = (length > 0.f) ? normal / length : glm::vec3(0.f, 0.f, 1.f);
+	}
+	return normals;
+}
+
+
+GeometricModel PackedModel::unpack() const
+{
+	std::vector<VertexFormat> vertices;
+	vertices.reserve(_vertices.size());
+	for (const PackedVertexFormat& packed : _vertices) {
+		float position[3];
+		for (int axis = 0; axis < 3; ++axis) {
+			const float encoded = (_positionEncoding == PositionEncoding::Half)
+					? VertexPacking::halfToFloat(packed.pos[axis])
+					: VertexPacking::unorm16ToFloat(packed.pos[axis]);
+			position[axis] = _dequantization.offset[axis] + _dequantization.scale[axis] * encoded;
+		}
+
+		VertexFormat& vertex = vertices.emplace_back();
+		vertex.pos = {position[0], position[1], position[2]};
+		vertex.color = {
+				(float) packed.color[0] / 255.f,
+				(float) packed.color[1] / 255.f,
+				(float) packed.color[2] / 255.f,
+				(float) packed.color[3] / 255.f,
+		};
+		vertex.texCoords = {VertexPacking::halfToFloat(packed.texCoords[0]), VertexPacking::halfToFloat(packed.texCoords[1])};
+	}
+
+	std::vector<GeometricModel::IndexType> indices(_indices.getCount());
+	for (size_t i = 0; i < indices.size(); ++i) {
+		indices[i] = _indices[i];
+	}
+	return GeometricModel(std::move(vertices), std::move(indices));
+}
+
+
+std::vector<glm::vec3> PackedModel::unpackNormals() const
+{
+	std::vector<glm::vec3> normals;
+	normals.reserve(_vertices.size());
+	for (const PackedVertexFormat& packed : _vertices) {
+		normals.push_back(VertexPacking::decodeOctahedral(packed.normal));
+	}
+	return normals;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "GeometricModel.hpp"
+#include "PackedIndices.hpp"
+#include "PackedVertexFormat.hpp"
+#include "Simd.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+
+/**
+ * @brief A GeometricModel in the compact encodings: PackedVertexFormat vertices and PackedIndices.
+ * The positions are relative to the mesh bounds, so the dequantization maps them back to the model space.
+ * It's a scale and an offset, which are folded into the model matrix: the shaders read the positions as they are.
+ */
+class PackedModel
+{
+public:
+	using Isa = Simd::Isa;
+
+	enum class PositionEncoding
+	{
+		// Half floats relative to the bounds center. The precision is relative: about 1/2048 of the distance to the center.
+		Half,
+		// 16-bit normalized values in the bounds. The precision is absolute: 1/65535 of the bounds size.
+		Unorm16,
+	};
+
+	/**
+	 * @brief The model space position is offset + scale * encoded position.
+	 */
+	struct Dequantization
+	{
+		glm::vec3 offset = glm::vec3(0.f);
+		glm::vec3 scale = glm::vec3(1.f);
+
+		/**
+		 * @brief Returns the matrix, which the model matrix is multiplied by from the right.
+		 */
+		[[nodiscard]]
+		glm::mat4 getMatrix() const;
+	};
+
+public:
+	PackedModel() = default;
+
+	/**
+	 * @brief Packs the model. The normals are computed from the triangles.
+	 * @param isa Scalar or SIMD conversion. It must be supported by the CPU. The half floats are converted with F16C,
+	 * 	if the CPU has it. All paths give the same vertices bit for bit.
+	 */
+	[[nodiscard]]
+	static PackedModel pack(const GeometricModel& model, PositionEncoding encoding, Isa isa = Simd::getBestIsa());
+
+	/**
+	 * @param normals Unit normals of the vertices.
+	 */
+	[[nodiscard]]
+	static PackedModel pack(
+			const GeometricModel& model,
+			std::span<const glm::vec3> normals,
+			PositionEncoding encoding,
+			Isa isa = Simd::getBestIsa()
+	);
+
+	/**
+	 * @brief Returns the area weighted average of the normals of the triangles around every vertex.
+	 */
+	[[nodiscard]]
+	static std::vector<glm::vec3> computeNormals(const GeometricModel& model);
+
+	[[nodiscard]]
+	const std::vector<PackedVertexFormat>& getVertices() const { return _vertices; }
+
+	[[nodiscard]]
+	const PackedIndices& getIndices() const { return _indices; }
+
+	[[nodiscard]]
+	PositionEncoding getPositionEncoding() const { return _positionEncoding; }
+
+	[[nodiscard]]
+	const Dequantization& getDequantization() const { return _dequantization; }
+
+	[[nodiscard]]
+	size_t getVerticesBytesCount() const { return _vertices.size() * sizeof(PackedVertexFormat); }
+
+	/**
+	 * @brief Decodes the model back to the float vertices and the 32-bit indices, e.g. to measure the errors.
+	 */
+	[[nodiscard]]
+	GeometricModel unpack() const;
+
+	[[nodiscard]]
+	std::vector<glm::vec3> unpackNormals() const;
+
+private:
+	std::vector<PackedVertexFormat> _vertices;
+	PackedIndices _indices;
+	PositionEncoding _positionEncoding = PositionEncoding::Half;
+	Dequantization _dequantization;
+};
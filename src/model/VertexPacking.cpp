@@ -0,0 +1,125 @@
+#include "VertexPacking.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include <glm/geometric.hpp>
+
+
+namespace {
+	// The same selection as _mm_max_ps(value, low) and _mm_min_ps(value, high), so NaN becomes low like in SIMD.
+	inline float clampLikeSimd(float value, float low, float high)
+	{
+		value = (value > low) ? value : low;
+		return (value < high) ? value : high;
+	}
+
+
+	inline float signNotZero(float value)
+	{
+		return (value >= 0.f) ? 1.f : -1.f;
+	}
+}
+
+
+uint16_t VertexPacking::floatToHalf(float value)
+{
+	uint32_t bits = std::bit_cast<uint32_t>(value);
+	const uint32_t sign = (bits >> 16) & 0x8000u;
+	bits &= 0x7FFFFFFFu;
+
+	// Infinity and NaN. NaN keeps the top of its payload and becomes quiet, like with F16C.
+	if (bits >= 0x7F800000u) {
+		return (uint16_t) (sign | 0x7C00u | ((bits > 0x7F800000u) ? (0x0200u | ((bits >> 13) & 0x03FFu)) : 0u));
+	}
+	// 2^16 and more overflow. Smaller values, which round up to 2^16, overflow by the carry below.
+	if (bits >= 0x47800000u) {
+		return (uint16_t) (sign | 0x7C00u);
+	}
+	// Subnormals: adding 0.5 aligns the 10 mantissa bits at the bottom of the float, and the FPU rounds them to nearest even.
+	if (bits < 0x38800000u) {
+		constexpr uint32_t SUBNORMAL_MAGIC = 0x3F000000u;
+		const float aligned = std::bit_cast<float>(bits) + std::bit_cast<float>(SUBNORMAL_MAGIC);
+		return (uint16_t) (sign | (std::bit_cast<uint32_t>(aligned) - SUBNORMAL_MAGIC));
+	}
+	// Normals: rebias the exponent and round the 13 dropped bits to nearest even.
+	const uint32_t isMantissaOdd = (bits >> 13) & 1u;
+	bits += (uint32_t) ((15 - 127) << 23) + 0x0FFFu + isMantissaOdd;
+	return (uint16_t) (sign | (bits >> 13));
+}
+
+
+float VertexPacking::halfToFloat(uint16_t half)
+{
+	constexpr uint32_t SHIFTED_EXPONENT = 0x7C00u << 13;
+	uint32_t bits = ((uint32_t) half & 0x7FFFu) << 13;
+	const uint32_t exponent = bits & SHIFTED_EXPONENT;
+	bits += (uint32_t) (127 - 15) << 23;
+
+	if (exponent == SHIFTED_EXPONENT) {
+		// Infinity and NaN.
+		bits += (uint32_t) (128 - 16) << 23;
+	} else if (exponent == 0) {
+		// Zero and subnormals: renormalize by the float subtraction.
+		bits += 1u << 23;
+		bits = std::bit_cast<uint32_t>(std::bit_cast<float>(bits) - std::bit_cast<float>(113u << 23));
+	}
+	return std::bit_cast<float>(bits | (((uint32_t) half & 0x8000u) << 16));
+}
+
+
+uint16_t VertexPacking::floatToUnorm16(float value)
+{
+	return (uint16_t) std::lrint(clampLikeSimd(value * 65535.f, 0.f, 65535.f));
+}
+
+
+float VertexPacking::unorm16ToFloat(uint16_t value)
+{
+	return (float) value / 65535.f;
+}
+
+
+uint8_t VertexPacking::floatToUnorm8(float value)
+{
+	return (uint8_t) std::lrint(clampLikeSimd(value, 0.f, 1.f) * 255.f);
+}
+
+
+void VertexPacking::encodeOctahedral(const glm::vec3& normal, int16_t (&outEncoded)[2])
+{
+	const float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (!(sum > 0.f)) {
+		outEncoded[0] = 0;
+		outEncoded[1] = 0;
+		return;
+	}
+
+	// The upper half of the octahedron is the inner diamond of the square, the lower one is folded to the corners.
+	float x = normal.x / sum;
+	float y = normal.y / sum;
+	if (normal.z < 0.f) {
+		const float foldedX = (1.f - std::abs(y)) * signNotZero(x);
+		y = (1.f - std::abs(x)) * signNotZero(y);
+		x = foldedX;
+	}
+	outEncoded[0] = (int16_t) std::lrint(clampLikeSimd(x, -1.f, 1.f) * 32767.f);
+	outEncoded[1] = (int16_t) std::lrint(clampLikeSimd(y, -1.f, 1.f) * 32767.f);
+}
+
+
+glm::vec3 VertexPacking::decodeOctahedral(const int16_t (&encoded)[2])
+{
+	// -32768 is -1 too, like in GL.
+	glm::vec3 normal;
+	normal.x = std::max((float) encoded[0] / 32767.f, -1.f);
+	normal.y = std::max((float) encoded[1] / 32767.f, -1.f);
+	normal.z = 1.f - std::abs(normal.x) - std::abs(normal.y);
+	if (normal.z < 0.f) {
+		const float unfoldedX = (1.f - std::abs(normal.y)) * signNotZero(normal.x);
+		normal.y = (1.f - std::abs(normal.x)) * signNotZero(normal.y);
+		normal.x = unfoldedX;
+	}
+	return glm::normalize(normal);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/vec3.hpp>
+
+
+/**
+ * @brief Scalar conversions of the vertex attributes to the packed encodings and back.
+ * The rounding is to nearest even everywhere, like in the SIMD kernels of PackedModel, so their results are equal.
+ */
+namespace VertexPacking {
+	/**
+	 * @brief Converts to IEEE 754 binary16 like F16C does: overflows become infinities, small values become subnormals.
+	 */
+	[[nodiscard]]
+	uint16_t floatToHalf(float value);
+
+	[[nodiscard]]
+	float halfToFloat(uint16_t half);
+
+	/**
+	 * @brief Maps [0, 1] to [0, 65535]. Values outside are clamped.
+	 */
+	[[nodiscard]]
+	uint16_t floatToUnorm16(float value);
+
+	[[nodiscard]]
+	float unorm16ToFloat(uint16_t value);
+
+	/**
+	 * @brief Maps [0, 1] to [0, 255]. Values outside are clamped.
+	 */
+	[[nodiscard]]
+	uint8_t floatToUnorm8(float value);
+
+	/**
+	 * @brief Projects the unit normal to the octahedron and unfolds it to a square, which is stored as 2 snorm16 values.
+	 * The error is below 0.01 degree, and any normal is encoded, unlike with 2 of 3 components.
+	 */
+	void encodeOctahedral(const glm::vec3& normal, int16_t (&outEncoded)[2]);
+
+	[[nodiscard]]
+	glm::vec3 decodeOctahedral(const int16_t (&encoded)[2]);
+}
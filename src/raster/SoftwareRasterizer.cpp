@@ -0,0 +1,526 @@
+#include "SoftwareRasterizer.hpp"
+
+#include "ImageFile.hpp"
+#include "SoftwareTexture.hpp"
+#include "ThreadPool.hpp"
+#include "Timing.hpp"
+#include "Utilities.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+
+namespace {
+	// The distance of the vertex to the near plane in the clip space. It's negative behind the plane.
+	inline float getNearDistance(const glm::vec4& position)
+	{
+		return position.z + position.w;
+	}
+
+
+	/**
+	 * @brief Computes the plane equation of a value, which is linear in the screen space.
+	 * @param values The values at the vertices.
+	 */
+	inline void computePlane(const glm::vec2 (&positions)[3], const float (&values)[3], float inverseArea, float (&outPlane)[3])
+	{
+		const glm::vec2 edge1 = positions[1] - positions[0];
+		const glm::vec2 edge2 = positions[2] - positions[0];
+		const float delta1 = values[1] - values[0];
+		const float delta2 = values[2] - values[0];
+		outPlane[0] = (delta1 * edge2.y - delta2 * edge1.y) * inverseArea;
+		outPlane[1] = (delta2 * edge1.x - delta1 * edge2.x) * inverseArea;
+		outPlane[2] = values[0] - outPlane[0] * positions[0].x - outPlane[1] * positions[0].y;
+	}
+
+
+	inline uint32_t packColor(const glm::vec4& color)
+	{
+		const auto toByte = [](float value) {
+			return (uint32_t) (std::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+		};
+		return toByte(color.r) | (toByte(color.g) << 8) | (toByte(color.b) << 16) | (toByte(color.a) << 24);
+	}
+}
+
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height)
+		: _width(width)
+		, _height(height)
+		, _tilesCountX((width + TILE_SIZE - 1) / TILE_SIZE)
+		, _tilesCountY((height + TILE_SIZE - 1) / TILE_SIZE)
+		, _bufferStride(_tilesCountX * TILE_SIZE)
+{
+	const size_t bufferSize = (size_t) _bufferStride * _tilesCountY * TILE_SIZE;
+	_colorBuffer.resize(bufferSize);
+	_depthBuffer.resize(bufferSize);
+}
+
+
+SoftwareRasterizer::~SoftwareRasterizer() = default;
+
+
+void SoftwareRasterizer::clear(const glm::vec4& color)
+{
+	std::fill(_colorBuffer.begin(), _colorBuffer.end(), packColor(color));
+	std::fill(_depthBuffer.begin(), _depthBuffer.end(), 1.f);
+}
+
+
+void SoftwareRasterizer::drawTexturedInstances(
+		const GeometricModel& model,
+		std::span<const glm::mat4> modelMatrices,
+		const glm::mat4& viewProjection,
+		const SoftwareTexture& texture0,
+		const SoftwareTexture& texture1
+)
+{
+	assertTrue(texture0.isValid() && texture1.isValid());
+	const size_t trianglesPerInstance = model.getIndices().size() / 3;
+	if (modelMatrices.empty() || trianglesPerInstance == 0) {
+		return;
+	}
+
+	Draw& draw = _draws.emplace_back();
+	draw.model = &model;
+	draw.modelMatrices = modelMatrices;
+	draw.viewProjection = viewProjection;
+	draw.texture0 = &texture0;
+	draw.texture1 = &texture1;
+	draw.firstVertex = _verticesCount;
+	draw.firstTriangle = _trianglesCount;
+
+	_verticesCount += modelMatrices.size() * model.getVertices().size();
+	_trianglesCount += modelMatrices.size() * trianglesPerInstance;
+}
+
+
+SoftwareRasterizer::Stats SoftwareRasterizer::flush(ThreadPool& pool, Isa isa)
+{
+	assertTrueMsg(Simd::isSupported(isa), "The instruction set isn't supported by the CPU.");
+
+	Stats stats;
+	stats.trianglesCount = _trianglesCount;
+
+	auto startTime = std::chrono::steady_clock::now();
+	_clipVertices.resize(_verticesCount);
+	pool.parallelFor(_verticesCount, MIN_VERTEX_CHUNK_SIZE, [this](size_t begin, size_t end, size_t) {
+		transformVertices(begin, end);
+	});
+	stats.vertexMs = Timing::getMsSince(startTime);
+
+	// Every chunk bins its triangles separately, so the chunks don't synchronize.
+	// A tile walks the bins of the chunks in order, which keeps the draw order.
+	startTime = std::chrono::steady_clock::now();
+	const int tilesCount = _tilesCountX * _tilesCountY;
+	_setupChunks.resize(pool.getChunksCount(_trianglesCount, MIN_SETUP_CHUNK_SIZE));
+	for (SetupChunk& chunk : _setupChunks) {
+		chunk.triangles.clear();
+		chunk.tileBins.resize(tilesCount);
+		for (std::vector<uint32_t>& bin : chunk.tileBins) {
+			bin.clear();
+		}
+	}
+	pool.parallelFor(_trianglesCount, MIN_SETUP_CHUNK_SIZE, [this](size_t begin, size_t end, size_t chunkIndex) {
+		setupTriangles(begin, end, _setupChunks[chunkIndex]);
+	});
+	for (const SetupChunk& chunk : _setupChunks) {
+		stats.setupTrianglesCount += chunk.triangles.size();
+		for (const std::vector<uint32_t>& bin : chunk.tileBins) {
+			stats.binnedTrianglesCount += bin.size();
+		}
+	}
+	stats.setupMs = Timing::getMsSince(startTime);
+
+	// Tiles differ a lot in the work, so threads take them one by one instead of the fixed ranges.
+	startTime = std::chrono::steady_clock::now();
+	std::atomic<int> nextTile = 0;
+	std::atomic<size_t> shadedPixelsCount = 0;
+	pool.parallelFor(pool.getThreadsCount(), 1, [&](size_t, size_t, size_t) {
+		size_t threadShadedPixelsCount = 0;
+		for (int tile = nextTile++; tile < tilesCount; tile = nextTile++) {
+			threadShadedPixelsCount += rasterizeTile(tile, isa);
+		}
+		shadedPixelsCount += threadShadedPixelsCount;
+	});
+	stats.shadedPixelsCount = shadedPixelsCount;
+	stats.rasterMs = Timing::getMsSince(startTime);
+
+	_draws.clear();
+	_verticesCount = 0;
+	_trianglesCount = 0;
+	return stats;
+}
+
+
+std::vector<uint8_t> SoftwareRasterizer::readPixels() const
+{
+	std::vector<uint8_t> pixels((size_t) _width * _height * 3);
+	uint8_t* out = pixels.data();
+	for (int y = _height - 1; y >= 0; --y) {
+		const uint32_t* row = _colorBuffer.data() + (size_t) y * _bufferStride;
+		for (int x = 0; x < _width; ++x) {
+			const uint32_t color = row[x];
+			*out++ = (uint8_t) color;
+			*out++ = (uint8_t) (color >> 8);
+			*out++ = (uint8_t) (color >> 16);
+		}
+	}
+	return pixels;
+}
+
+
+bool SoftwareRasterizer::saveImage(std::string_view fileName) const
+{
+	return ImageFile::savePpm(fileName, _width, _height, readPixels());
+}
+
+
+size_t SoftwareRasterizer::findDraw(size_t index, size_t Draw::* first) const
+{
+	const auto nextDraw = std::upper_bound(_draws.begin(), _draws.end(), index, [first](size_t value, const Draw& draw) {
+		return value < draw.*first;
+	});
+	return (size_t) (nextDraw - _draws.begin()) - 1;
+}
+
+
+void SoftwareRasterizer::transformVertices(size_t begin, size_t end)
+{
+	size_t i = begin;
+	for (size_t drawIndex = findDraw(begin, &Draw::firstVertex); i < end; ++drawIndex) {
+		const Draw& draw = _draws[drawIndex];
+		const std::vector<VertexFormat>& vertices = draw.model->getVertices();
+		const size_t drawEnd = std::min(end, draw.firstVertex + draw.modelMatrices.size() * vertices.size());
+
+		while (i < drawEnd) {
+			const size_t instance = (i - draw.firstVertex) / vertices.size();
+			size_t vertex = (i - draw.firstVertex) % vertices.size();
+			// The same as uViewProjection * getModelMatrix() * vec4(aPos, 1.0) in default.vsh.
+			const glm::mat4 modelViewProjection = draw.viewProjection * draw.modelMatrices[instance];
+			for (; vertex < vertices.size() && i < drawEnd; ++vertex, ++i) {
+				const VertexFormat& input = vertices[vertex];
+				ClipVertex& output = _clipVertices[i];
+				output.position = modelViewProjection * glm::vec4(input.pos.x, input.pos.y, input.pos.z, 1.f);
+				output.texCoords = glm::vec2(input.texCoords.u, input.texCoords.v);
+			}
+		}
+	}
+}
+
+
+void SoftwareRasterizer::setupTriangles(size_t begin, size_t end, SetupChunk& chunk) const
+{
+	size_t i = begin;
+	for (size_t drawIndex = findDraw(begin, &Draw::firstTriangle); i < end; ++drawIndex) {
+		const Draw& draw = _draws[drawIndex];
+		const std::vector<GeometricModel::IndexType>& indices = draw.model->getIndices();
+		const size_t verticesCount = draw.model->getVertices().size();
+		const size_t trianglesPerInstance = indices.size() / 3;
+		const size_t drawEnd = std::min(end, draw.firstTriangle + draw.modelMatrices.size() * trianglesPerInstance);
+
+		for (; i < drawEnd; ++i) {
+			const size_t instance = (i - draw.firstTriangle) / trianglesPerInstance;
+			const size_t triangle = (i - draw.firstTriangle) % trianglesPerInstance;
+			const ClipVertex* instanceVertices = _clipVertices.data() + draw.firstVertex + instance * verticesCount;
+			const ClipVertex* vertices[3] = {
+					&instanceVertices[indices[triangle * 3]],
+					&instanceVertices[indices[triangle * 3 + 1]],
+					&instanceVertices[indices[triangle * 3 + 2]],
+			};
+
+			// Triangles outside any plane are dropped. The rest are clipped by the near plane only:
+			// the others are handled by the pixel bounds and the depth test against the cleared far depth.
+			bool isOutside = false;
+			for (int axis = 0; axis < 3 && !isOutside; ++axis) {
+				const auto isBeyond = [axis](const ClipVertex* vertex, float sign) {
+					return vertex->position[axis] * sign > vertex->position.w;
+				};
+				isOutside = (isBeyond(vertices[0], 1.f) && isBeyond(vertices[1], 1.f) && isBeyond(vertices[2], 1.f))
+						|| (isBeyond(vertices[0], -1.f) && isBeyond(vertices[1], -1.f) && isBeyond(vertices[2], -1.f));
+			}
+			if (isOutside) {
+				continue;
+			}
+
+			const float distances[3] = {
+					getNearDistance(vertices[0]->position),
+					getNearDistance(vertices[1]->position),
+					getNearDistance(vertices[2]->position),
+			};
+			if (distances[0] >= 0.f && distances[1] >= 0.f && distances[2] >= 0.f) {
+				setupTriangle(*vertices[0], *vertices[1], *vertices[2], (uint32_t) drawIndex, chunk);
+				continue;
+			}
+
+			// Sutherland-Hodgman by one plane: a triangle becomes a triangle or a quad.
+			// A crossing is always interpolated from the inner vertex, so the neighbor triangles get the same point.
+			ClipVertex polygon[4];
+			int polygonSize = 0;
+			for (int current = 0; current < 3; ++current) {
+				const int next = (current + 1) % 3;
+				const bool isCurrentInside = distances[current] >= 0.f;
+				if (isCurrentInside) {
+					polygon[polygonSize++] = *vertices[current];
+				}
+				if (isCurrentInside != (distances[next] >= 0.f)) {
+					const int inner = isCurrentInside ? current : next;
+					const int outer = isCurrentInside ? next : current;
+					const float t = distances[inner] / (distances[inner] - distances[outer]);
+					ClipVertex& crossing = polygon[polygonSize++];
+					crossing.position = vertices[inner]->position + (vertices[outer]->position - vertices[inner]->position) * t;
+					crossing.texCoords = vertices[inner]->texCoords + (vertices[outer]->texCoords - vertices[inner]->texCoords) * t;
+				}
+			}
+			for (int vertex = 2; vertex < polygonSize; ++vertex) {
+				setupTriangle(polygon[0], polygon[vertex - 1], polygon[vertex], (uint32_t) drawIndex, chunk);
+			}
+		}
+	}
+}
+
+
+void SoftwareRasterizer::setupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, uint32_t drawIndex, SetupChunk& chunk) const
+{
+	const ClipVertex* vertices[3] = {&v0, &v1, &v2};
+	glm::vec2 positions[3];
+	float depths[3];
+	float inverseWs[3];
+	float uOverWs[3];
+	float vOverWs[3];
+	for (int i = 0; i < 3; ++i) {
+		const glm::vec4& position = vertices[i]->position;
+		const float inverseW = 1.f / position.w;
+		// The viewport transform of GL: y goes up, the depth range is [0, 1].
+		positions[i].x = (position.x * inverseW * 0.5f + 0.5f) * (float) _width;
+		positions[i].y = (position.y * inverseW * 0.5f + 0.5f) * (float) _height;
+		depths[i] = position.z * inverseW * 0.5f + 0.5f;
+		inverseWs[i] = inverseW;
+		uOverWs[i] = vertices[i]->texCoords.x * inverseW;
+		vOverWs[i] = vertices[i]->texCoords.y * inverseW;
+	}
+
+	// Both windings are drawn, like with GL_CULL_FACE off. Clockwise triangles are turned, so the inside is positive.
+	float doubleArea = (positions[1].x - positions[0].x) * (positions[2].y - positions[0].y)
+			- (positions[2].x - positions[0].x) * (positions[1].y - positions[0].y);
+	if (!(doubleArea != 0.f) || !std::isfinite(doubleArea)) {
+		return;
+	}
+	if (doubleArea < 0.f) {
+		std::swap(positions[1], positions[2]);
+		std::swap(depths[1], depths[2]);
+		std::swap(inverseWs[1], inverseWs[2]);
+		std::swap(uOverWs[1], uOverWs[2]);
+		std::swap(vOverWs[1], vOverWs[2]);
+		doubleArea = -doubleArea;
+	}
+
+	// The pixels whose centers are inside the bounds.
+	const float minPositionX = std::min({positions[0].x, positions[1].x, positions[2].x});
+	const float maxPositionX = std::max({positions[0].x, positions[1].x, positions[2].x});
+	const float minPositionY = std::min({positions[0].y, positions[1].y, positions[2].y});
+	const float maxPositionY = std::max({positions[0].y, positions[1].y, positions[2].y});
+	const int minX = (int) std::max(0.f, std::ceil(minPositionX - 0.5f));
+	const int maxX = (int) std::min((float) (_width - 1), std::floor(maxPositionX - 0.5f));
+	const int minY = (int) std::max(0.f, std::ceil(minPositionY - 0.5f));
+	const int maxY = (int) std::min((float) (_height - 1), std::floor(maxPositionY - 0.5f));
+	if (minX > maxX || minY > maxY) {
+		return;
+	}
+
+	SetupTriangle& triangle = chunk.triangles.emplace_back();
+	for (int edge = 0; edge < 3; ++edge) {
+		// The edge from the vertex i to j. The edge of a neighbor triangle goes from j to i,
+		// and its function is exactly the negated one, so a pixel is never drawn by both triangles or by none.
+		const glm::vec2& from = positions[edge];
+		const glm::vec2& to = positions[(edge + 1) % 3];
+		const float a = from.y - to.y;
+		const float b = to.x - from.x;
+		triangle.edgeA[edge] = a;
+		triangle.edgeB[edge] = b;
+		triangle.edgeC[edge] = from.x * to.y - to.x * from.y;
+		// The gradient points inside: to the right for a left edge, down for a top one.
+		triangle.isEdgeTopLeft[edge] = (a > 0.f) || (a == 0.f && b < 0.f);
+	}
+
+	const float inverseArea = 1.f / doubleArea;
+	computePlane(positions, depths, inverseArea, triangle.depthPlane);
+	computePlane(positions, inverseWs, inverseArea, triangle.inverseWPlane);
+	computePlane(positions, uOverWs, inverseArea, triangle.uOverWPlane);
+	computePlane(positions, vOverWs, inverseArea, triangle.vOverWPlane);
+	triangle.minX = minX;
+	triangle.minY = minY;
+	triangle.maxX = maxX;
+	triangle.maxY = maxY;
+	triangle.drawIndex = drawIndex;
+
+	const uint32_t triangleIndex = (uint32_t) chunk.triangles.size() - 1;
+	for (int tileY = minY / TILE_SIZE; tileY <= maxY / TILE_SIZE; ++tileY) {
+		for (int tileX = minX / TILE_SIZE; tileX <= maxX / TILE_SIZE; ++tileX) {
+			chunk.tileBins[tileY * _tilesCountX + tileX].push_back(triangleIndex);
+		}
+	}
+}
+
+
+size_t SoftwareRasterizer::rasterizeTile(int tileIndex, Isa isa)
+{
+	const int tileMinX = (tileIndex % _tilesCountX) * TILE_SIZE;
+	const int tileMinY = (tileIndex / _tilesCountX) * TILE_SIZE;
+	const int tileMaxX = std::min(tileMinX + TILE_SIZE, _width) - 1;
+	const int tileMaxY = std::min(tileMinY + TILE_SIZE, _height) - 1;
+
+	size_t shadedPixelsCount = 0;
+	for (const SetupChunk& chunk : _setupChunks) {
+		for (const uint32_t triangleIndex : chunk.tileBins[tileIndex]) {
+			const SetupTriangle& triangle = chunk.triangles[triangleIndex];
+			const Draw& draw = _draws[triangle.drawIndex];
+			const int minX = std::max(triangle.minX, tileMinX);
+			const int minY = std::max(triangle.minY, tileMinY);
+			const int maxX = std::min(triangle.maxX, tileMaxX);
+			const int maxY = std::min(triangle.maxY, tileMaxY);
+
+			switch (isa) {
+#if SIMD_X86
+				case Isa::Avx:
+				case Isa::Sse:
+					shadedPixelsCount += rasterizeTriangleSse(triangle, draw, minX, minY, maxX, maxY,
+							_colorBuffer.data(), _depthBuffer.data(), _bufferStride);
+					break;
+#endif
+				default:
+					shadedPixelsCount += rasterizeTriangleScalar(triangle, draw, minX, minY, maxX, maxY,
+							_colorBuffer.data(), _depthBuffer.data(), _bufferStride);
+					break;
+			}
+		}
+	}
+	return shadedPixelsCount;
+}
+
+
+uint32_t SoftwareRasterizer::shadePixel(const Draw& draw, float u, float v)
+{
+	const glm::vec4 color0 = draw.texture0->sample(u, v);
+	const glm::vec4 color1 = draw.texture1->sample(u, v);
+	return packColor(color0 * (1.f - color1.a) + color1);
+}
+
+
+size_t SoftwareRasterizer::rasterizeTriangleScalar(const SetupTriangle& triangle, const Draw& draw,
+		int minX, int minY, int maxX, int maxY, uint32_t* colorRows, float* depthRows, int stride)
+{
+	size_t shadedPixelsCount = 0;
+	for (int y = minY; y <= maxY; ++y) {
+		const float pixelY = (float) y + 0.5f;
+		uint32_t* colorRow = colorRows + (size_t) y * stride;
+		float* depthRow = depthRows + (size_t) y * stride;
+
+		for (int x = minX; x <= maxX; ++x) {
+			const float pixelX = (float) x + 0.5f;
+
+			bool isInside = true;
+			for (int edge = 0; edge < 3; ++edge) {
+				const float value = triangle.edgeA[edge] * pixelX + triangle.edgeB[edge] * pixelY + triangle.edgeC[edge];
+				isInside = isInside && ((value > 0.f) || (value == 0.f && triangle.isEdgeTopLeft[edge]));
+			}
+			if (!isInside) {
+				continue;
+			}
+
+			const float depth = triangle.depthPlane[0] * pixelX + triangle.depthPlane[1] * pixelY + triangle.depthPlane[2];
+			if (!(depth < depthRow[x])) {
+				continue;
+			}
+			depthRow[x] = depth;
+
+			const float inverseW = triangle.inverseWPlane[0] * pixelX + triangle.inverseWPlane[1] * pixelY + triangle.inverseWPlane[2];
+			const float uOverW = triangle.uOverWPlane[0] * pixelX + triangle.uOverWPlane[1] * pixelY + triangle.uOverWPlane[2];
+			const float vOverW = triangle.vOverWPlane[0] * pixelX + triangle.vOverWPlane[1] * pixelY + triangle.vOverWPlane[2];
+			colorRow[x] = shadePixel(draw, uOverW / inverseW, vOverW / inverseW);
+			++shadedPixelsCount;
+		}
+	}
+	return shadedPixelsCount;
+}
+
+
+#if SIMD_X86
+size_t SoftwareRasterizer::rasterizeTriangleSse(const SetupTriangle& triangle, const Draw& draw,
+		int minX, int minY, int maxX, int maxY, uint32_t* colorRows, float* depthRows, int stride)
+{
+	// The operations are the same as in the scalar kernel and in the same order, so the results are equal bit for bit.
+	__m128 edgeA[3];
+	__m128 edgeC[3];
+	__m128 topLeftMasks[3];
+	for (int edge = 0; edge < 3; ++edge) {
+		edgeA[edge] = _mm_set1_ps(triangle.edgeA[edge]);
+		edgeC[edge] = _mm_set1_ps(triangle.edgeC[edge]);
+		topLeftMasks[edge] = _mm_castsi128_ps(_mm_set1_epi32(triangle.isEdgeTopLeft[edge] ? -1 : 0));
+	}
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 minPixelX = _mm_set1_ps((float) minX + 0.5f);
+	const __m128 maxPixelX = _mm_set1_ps((float) maxX + 0.5f);
+	const __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+
+	alignas(16) float us[4];
+	alignas(16) float vs[4];
+	size_t shadedPixelsCount = 0;
+	// Rows are tile-padded and aligned, so the 4 pixel groups start at multiples of 4.
+	const int firstX = minX & ~3;
+	for (int y = minY; y <= maxY; ++y) {
+		const float pixelY = (float) y + 0.5f;
+		uint32_t* colorRow = colorRows + (size_t) y * stride;
+		float* depthRow = depthRows + (size_t) y * stride;
+
+		__m128 edgeBY[3];
+		for (int edge = 0; edge < 3; ++edge) {
+			edgeBY[edge] = _mm_set1_ps(triangle.edgeB[edge] * pixelY);
+		}
+		const __m128 depthBY = _mm_set1_ps(triangle.depthPlane[1] * pixelY);
+
+		for (int x = firstX; x <= maxX; x += 4) {
+			const __m128 pixelX = _mm_add_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x), laneOffsets)), _mm_set1_ps(0.5f));
+			__m128 mask = _mm_and_ps(_mm_cmpge_ps(pixelX, minPixelX), _mm_cmple_ps(pixelX, maxPixelX));
+			for (int edge = 0; edge < 3; ++edge) {
+				const __m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[edge], pixelX), edgeBY[edge]), edgeC[edge]);
+				const __m128 isInside = _mm_or_ps(_mm_cmpgt_ps(value, zero), _mm_and_ps(_mm_cmpeq_ps(value, zero), topLeftMasks[edge]));
+				mask = _mm_and_ps(mask, isInside);
+			}
+			if (_mm_movemask_ps(mask) == 0) {
+				continue;
+			}
+
+			const __m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.depthPlane[0]), pixelX), depthBY),
+					_mm_set1_ps(triangle.depthPlane[2]));
+			const __m128 oldDepth = _mm_load_ps(depthRow + x);
+			mask = _mm_and_ps(mask, _mm_cmplt_ps(depth, oldDepth));
+			unsigned int passedMask = (unsigned int) _mm_movemask_ps(mask);
+			if (passedMask == 0) {
+				continue;
+			}
+			_mm_store_ps(depthRow + x, _mm_or_ps(_mm_and_ps(mask, depth), _mm_andnot_ps(mask, oldDepth)));
+
+			const auto evaluate = [pixelX, pixelY](const float (&plane)[3]) {
+				return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), pixelX), _mm_set1_ps(plane[1] * pixelY)),
+						_mm_set1_ps(plane[2]));
+			};
+			const __m128 inverseW = evaluate(triangle.inverseWPlane);
+			_mm_store_ps(us, _mm_div_ps(evaluate(triangle.uOverWPlane), inverseW));
+			_mm_store_ps(vs, _mm_div_ps(evaluate(triangle.vOverWPlane), inverseW));
+
+			// Texture fetches don't vectorize without gathers, so the shading is per pixel.
+			shadedPixelsCount += std::popcount(passedMask);
+			while (passedMask != 0) {
+				const int lane = std::countr_zero(passedMask);
+				colorRow[x + lane] = shadePixel(draw, us[lane], vs[lane]);
+				passedMask &= passedMask - 1;
+			}
+		}
+	}
+	return shadedPixelsCount;
+}
+#endif
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "AlignedAllocator.hpp"
+#include "Simd.hpp"
+#include "model/GeometricModel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+
+class SoftwareTexture;
+class ThreadPool;
+
+
+/**
+ * @brief The CPU rendering backend for machines without GPU.
+ * It draws the same models, textures and matrices as the GL path, and shades them like default.vsh/default.fsh
+ * with TEXTURED and INSTANCED: two textures are blended with perspective-correct coordinates and the depth test.
+ *
+ * Draws are only queued. flush() runs the pipeline on all threads of the pool:
+ * - the vertex stage transforms the vertices of all instances;
+ * - the setup clips the triangles by the near plane, computes the edge and the interpolation equations
+ * 	and bins the triangles to the screen tiles;
+ * - every tile is rasterized by one thread, 4 pixels per edge function evaluation with SSE.
+ * The triangles of a tile are rasterized in the draw order, and the result doesn't depend on the threads count
+ * or the instruction set, so the images are reproducible bit for bit.
+ */
+class SoftwareRasterizer
+{
+public:
+	using Isa = Simd::Isa;
+
+	// The size of the screen tiles in pixels. A tile of the color and depth buffers fits L2 cache.
+	static constexpr int TILE_SIZE = 64;
+
+	/**
+	 * @brief Counters and timings of the last flush().
+	 */
+	struct Stats
+	{
+		size_t trianglesCount = 0;
+		// Triangles which have passed the clipping and have covered pixel centers in their bounds.
+		size_t setupTrianglesCount = 0;
+		// Pairs of a triangle and a tile it overlaps.
+		size_t binnedTrianglesCount = 0;
+		// Pixels which have passed the depth test and have been shaded.
+		size_t shadedPixelsCount = 0;
+		double vertexMs = 0.0;
+		double setupMs = 0.0;
+		double rasterMs = 0.0;
+	};
+
+public:
+	SoftwareRasterizer(int width, int height);
+
+	~SoftwareRasterizer();
+
+	[[nodiscard]]
+	int getWidth() const { return _width; }
+
+	[[nodiscard]]
+	int getHeight() const { return _height; }
+
+	/**
+	 * @brief Fills the color buffer with the color and the depth buffer with the far plane depth.
+	 */
+	void clear(const glm::vec4& color);
+
+	/**
+	 * @brief Queues the instances of the model. The model, the matrices and the textures must outlive flush().
+	 * The fragment color is sampler0 * (1 - sampler1.a) + sampler1, like in default.fsh.
+	 */
+	void drawTexturedInstances(
+			const GeometricModel& model,
+			std::span<const glm::mat4> modelMatrices,
+			const glm::mat4& viewProjection,
+			const SoftwareTexture& texture0,
+			const SoftwareTexture& texture1
+	);
+
+	/**
+	 * @brief Draws the queued instances and clears the queue.
+	 * @param isa Scalar or SIMD rasterization. It must be supported by the CPU. AVX uses the SSE kernel:
+	 * 	the shading of a pixel is scalar, so wider coverage tests don't pay off.
+	 */
+	Stats flush(ThreadPool& pool, Isa isa = Simd::getBestIsa());
+
+	/**
+	 * @brief Returns the color buffer as RGB rows from top to bottom, like HeadlessContext::readPixels().
+	 */
+	[[nodiscard]]
+	std::vector<uint8_t> readPixels() const;
+
+	/**
+	 * @brief Saves the color buffer to a binary PPM file.
+	 */
+	bool saveImage(std::string_view fileName) const;
+
+private:
+	struct Draw
+	{
+		const GeometricModel* model = nullptr;
+		std::span<const glm::mat4> modelMatrices;
+		glm::mat4 viewProjection = glm::mat4(1.f);
+		const SoftwareTexture* texture0 = nullptr;
+		const SoftwareTexture* texture1 = nullptr;
+		// The positions of the first instance vertex and the first instance triangle in the frame.
+		size_t firstVertex = 0;
+		size_t firstTriangle = 0;
+	};
+
+	struct ClipVertex
+	{
+		glm::vec4 position;
+		glm::vec2 texCoords;
+	};
+
+	/**
+	 * @brief A triangle in the screen space. Values are evaluated at pixel centers as a * x + b * y + c.
+	 */
+	struct SetupTriangle
+	{
+		// Edge functions: a pixel is inside, if all of them are positive.
+		// A pixel exactly on an edge belongs to the triangle, if the edge is a top or a left one.
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		bool isEdgeTopLeft[3];
+		// The window depth is linear in the screen space. The texture coordinates are divided by w,
+		// so they are linear too, and they are divided by the interpolated 1 / w per pixel.
+		float depthPlane[3];
+		float inverseWPlane[3];
+		float uOverWPlane[3];
+		float vOverWPlane[3];
+		// Covered pixel bounds, inclusive.
+		int minX = 0;
+		int minY = 0;
+		int maxX = 0;
+		int maxY = 0;
+		uint32_t drawIndex = 0;
+	};
+
+	/**
+	 * @brief The triangles which are set up by one chunk of the setup stage, and their bins.
+	 */
+	struct SetupChunk
+	{
+		std::vector<SetupTriangle> triangles;
+		// The indices of the triangles of the chunk per tile.
+		std::vector<std::vector<uint32_t>> tileBins;
+	};
+
+	static constexpr size_t MIN_VERTEX_CHUNK_SIZE = 16 * 1024;
+	static constexpr size_t MIN_SETUP_CHUNK_SIZE = 4 * 1024;
+
+	/**
+	 * @brief Returns the index of the draw, which the vertex or the triangle with the given frame index belongs to.
+	 * @param first Draw::firstVertex or Draw::firstTriangle.
+	 */
+	[[nodiscard]]
+	size_t findDraw(size_t index, size_t Draw::* first) const;
+
+	void transformVertices(size_t begin, size_t end);
+
+	void setupTriangles(size_t begin, size_t end, SetupChunk& chunk) const;
+
+	void setupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, uint32_t drawIndex, SetupChunk& chunk) const;
+
+	/**
+	 * @return The number of shaded pixels.
+	 */
+	size_t rasterizeTile(int tileIndex, Isa isa);
+
+	/**
+	 * @brief Rasterizes the part of the triangle in the rectangle, which is inside the triangle bounds.
+	 * @param colorRows, depthRows The buffer rows which start with the row of the pixel y = 0.
+	 * @return The number of shaded pixels.
+	 */
+	static size_t rasterizeTriangleScalar(const SetupTriangle& triangle, const Draw& draw,
+			int minX, int minY, int maxX, int maxY, uint32_t* colorRows, float* depthRows, int stride);
+
+#if SIMD_X86
+	static size_t rasterizeTriangleSse(const SetupTriangle& triangle, const Draw& draw,
+			int minX, int minY, int maxX, int maxY, uint32_t* colorRows, float* depthRows, int stride);
+#endif
+
+	/**
+	 * @brief Shades the pixel like default.fsh with TEXTURED and returns it in RGBA8.
+	 */
+	static uint32_t shadePixel(const Draw& draw, float u, float v);
+
+private:
+	int _width = 0;
+	int _height = 0;
+	int _tilesCountX = 0;
+	int _tilesCountY = 0;
+	// The buffers are tile-padded, so SIMD loads of 4 pixels never cross the rows. Rows go from bottom to top.
+	int _bufferStride = 0;
+	AlignedVector<uint32_t, Simd::ALIGNMENT> _colorBuffer;
+	AlignedVector<float, Simd::ALIGNMENT> _depthBuffer;
+
+	std::vector<Draw> _draws;
+	size_t _verticesCount = 0;
+	size_t _trianglesCount = 0;
+	std::vector<ClipVertex> _clipVertices;
+	std::vector<SetupChunk> _setupChunks;
+};
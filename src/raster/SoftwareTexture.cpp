@@ -0,0 +1,70 @@
+#include "SoftwareTexture.hpp"
+
+#include "Utilities.hpp"
+
+#include <cmath>
+
+
+SoftwareTexture::SoftwareTexture(int width, int height, int channelsCount, const uint8_t* data)
+		: _width(width)
+		, _height(height)
+{
+	assertTrue(channelsCount == 3 || channelsCount == 4);
+	if (width <= 0 || height <= 0 || data == nullptr) {
+		return;
+	}
+
+	_texels.resize((size_t) width * height);
+	for (size_t i = 0; i < _texels.size(); ++i) {
+		const uint8_t* texel = data + i * channelsCount;
+		const uint32_t alpha = (channelsCount == 4) ? texel[3] : 255;
+		_texels[i] = texel[0] | (texel[1] << 8) | (texel[2] << 16) | (alpha << 24);
+	}
+}
+
+
+glm::vec4 SoftwareTexture::sample(float u, float v) const
+{
+	// GL_LINEAR: the 4 texels around the sample point, whose centers are at half-integer coordinates.
+	const float x = u * (float) _width - 0.5f;
+	const float y = v * (float) _height - 0.5f;
+	const float floorX = std::floor(x);
+	const float floorY = std::floor(y);
+	const float fractionX = x - floorX;
+	const float fractionY = y - floorY;
+
+	// GL_REPEAT. The integer remainder is several times cheaper than fmod, which is left for the coordinates
+	// beyond the exact float integers only, so the results are the same.
+	const auto wrap = [](float coordinate, int size) {
+		constexpr float MAX_EXACT_INTEGER = 16777216.f;
+		if (std::abs(coordinate) >= MAX_EXACT_INTEGER) {
+			coordinate = std::fmod(coordinate, (float) size);
+		}
+		// Power of two sizes don't need a division: the mask keeps the non-negative remainder of two's complement.
+		if ((size & (size - 1)) == 0) {
+			return (int) coordinate & (size - 1);
+		}
+		const int wrapped = (int) coordinate % size;
+		return (wrapped < 0) ? wrapped + size : wrapped;
+	};
+	const int x0 = wrap(floorX, _width);
+	const int y0 = wrap(floorY, _height);
+	const int x1 = (x0 + 1 == _width) ? 0 : x0 + 1;
+	const int y1 = (y0 + 1 == _height) ? 0 : y0 + 1;
+
+	const glm::vec4 bottom = getTexel(x0, y0) * (1.f - fractionX) + getTexel(x1, y0) * fractionX;
+	const glm::vec4 top = getTexel(x0, y1) * (1.f - fractionX) + getTexel(x1, y1) * fractionX;
+	return bottom * (1.f - fractionY) + top * fractionY;
+}
+
+
+glm::vec4 SoftwareTexture::getTexel(int x, int y) const
+{
+	const uint32_t texel = _texels[(size_t) y * _width + x];
+	return glm::vec4(
+			(float) (texel & 0xFF),
+			(float) ((texel >> 8) & 0xFF),
+			(float) ((texel >> 16) & 0xFF),
+			(float) (texel >> 24)
+	) / 255.f;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec4.hpp>
+
+
+/**
+ * @brief An RGBA8 texture of the software rasterizer.
+ * Sampling repeats the texture and filters it bilinearly, like the scene textures in GL (GL_REPEAT, GL_LINEAR).
+ * There are no mipmaps, so minified textures alias more than on GPU.
+ */
+class SoftwareTexture
+{
+public:
+	SoftwareTexture() = default;
+
+	/**
+	 * @param channelsCount 3 for RGB, where the alpha is 1, or 4 for RGBA.
+	 * @param data Tightly packed rows from bottom to top, like the ones uploaded to GL.
+	 */
+	SoftwareTexture(int width, int height, int channelsCount, const uint8_t* data);
+
+	[[nodiscard]]
+	bool isValid() const { return !_texels.empty(); }
+
+	[[nodiscard]]
+	int getWidth() const { return _width; }
+
+	[[nodiscard]]
+	int getHeight() const { return _height; }
+
+	/**
+	 * @brief Returns the filtered color in [0, 1]. (0, 0) is the bottom left corner, like in GL.
+	 */
+	[[nodiscard]]
+	glm::vec4 sample(float u, float v) const;
+
+private:
+	[[nodiscard]]
+	glm::vec4 getTexel(int x, int y) const;
+
+private:
+	int _width = 0;
+	int _height = 0;
+	// RGBA8 texels. Floats would be 4 times larger, and minified textures are sampled sparsely,
+	// so the cache misses would cost more than the conversion.
+	std::vector<uint32_t> _texels;
+};
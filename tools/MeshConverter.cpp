@@ -0,0 +1,88 @@
+/**
+ * Converts OBJ and glTF meshes to the binary mesh files, which are mapped and uploaded without parsing (see MeshFile).
+ *
+ * Usage: MeshConverter [--encoding float|half|unorm16] [--no-optimize] <input .obj/.gltf/.glb> <output .mesh>
+ *
+ * The meshes of the input are merged and welded by MeshImporter. Then the triangles and the vertices are ordered
+ * for the vertex caches by MeshOptimizer, unless --no-optimize is given. The default encoding is half: the packed
+ * 20-byte vertices with the half float positions. float keeps the 36-byte VertexFormat vertices as they are.
+ */
+
+#include "ThreadPool.hpp"
+#include "Timing.hpp"
+#include "import/MeshImporter.hpp"
+#include "model/MeshFile.hpp"
+#include "model/MeshOptimizer.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string_view>
+
+
+namespace {
+	constexpr std::string_view USAGE =
+			"Usage: MeshConverter [--encoding float|half|unorm16] [--no-optimize] <input .obj/.gltf/.glb> <output .mesh>";
+}
+
+
+int main(int argc, char* argv[])
+{
+	std::optional<PackedModel::PositionEncoding> encoding = PackedModel::PositionEncoding::Half;
+	bool isOptimized = true;
+	std::filesystem::path inputFile;
+	std::filesystem::path outputFile;
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view argument = argv[i];
+		if (argument == "--encoding" && i + 1 < argc) {
+			const std::string_view value = argv[++i];
+			if (value == "float") {
+				encoding = std::nullopt;
+			} else if (value == "half") {
+				encoding = PackedModel::PositionEncoding::Half;
+			} else if (value == "unorm16") {
+				encoding = PackedModel::PositionEncoding::Unorm16;
+			} else {
+				std::cerr << "Unknown encoding: " << value << "\n" << USAGE << std::endl;
+				return 1;
+			}
+		} else if (argument == "--no-optimize") {
+			isOptimized = false;
+		} else if (inputFile.empty()) {
+			inputFile = argument;
+		} else if (outputFile.empty()) {
+			outputFile = argument;
+		} else {
+			std::cerr << USAGE << std::endl;
+			return 1;
+		}
+	}
+	if (inputFile.empty() || outputFile.empty()) {
+		std::cerr << USAGE << std::endl;
+		return 1;
+	}
+
+	ImportStats stats;
+	std::optional<GeometricModel> model = MeshImporter::importFile(inputFile, ThreadPool::getShared(), &stats);
+	if (!model) {
+		return 1;
+	}
+	std::cout << inputFile.generic_string() << ": " << stats.trianglesCount << " triangles, "
+			<< stats.sourceVerticesCount << " -> " << stats.verticesCount << " vertices, imported in " << stats.totalMs << " ms" << std::endl;
+
+	if (isOptimized) {
+		const auto startTime = std::chrono::steady_clock::now();
+		const MeshOptimizer::VertexCacheStats sourceStats = MeshOptimizer::analyzeVertexCache(model->getIndices(), model->getVertices().size(), 16);
+		model = MeshOptimizer::optimize(*model, MeshOptimizationOptions());
+		const MeshOptimizer::VertexCacheStats optimizedStats = MeshOptimizer::analyzeVertexCache(model->getIndices(), model->getVertices().size(), 16);
+		std::cout << "ACMR " << sourceStats.acmr << " -> " << optimizedStats.acmr << ", optimized in " << Timing::getMsSince(startTime) << " ms" << std::endl;
+	}
+
+	if (!MeshFile::write(outputFile, *model, encoding)) {
+		return 1;
+	}
+	std::error_code errorCode;
+	std::cout << outputFile.generic_string() << ": " << std::filesystem::file_size(outputFile, errorCode) << " bytes" << std::endl;
+	return 0;
+}
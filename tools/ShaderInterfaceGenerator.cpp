@@ -0,0 +1,493 @@
+/**
+ * Generates the C++ interface of the shaders in a directory.
+ *
+ * Usage: ShaderInterfaceGenerator <shaders directory> <output header>
+ *
+ * A program is a pair of <name>.vsh and <name>.fsh files. The uniform declarations of all programs
+ * (including the files pulled by #include, and the declarations of all permutations) get global slot indices,
+ * so every shader uniform store has the same layout. Vertex attributes with explicit locations become constants.
+ * The header is rewritten only when its contents change, so unchanged shaders don't trigger recompilation.
+ *
+ * Declarations, which can't be represented in C++ (e.g. one name with different types in different programs),
+ * fail the generation, so the mismatch is reported by the build.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace {
+	struct GlslType
+	{
+		std::string_view glslName;
+		std::string_view cppType;
+		std::string_view uniformType;
+	};
+
+	constexpr GlslType GLSL_TYPES[] = {
+			{"sampler2D", "int", "Sampler"},
+			{"samplerCube", "int", "Sampler"},
+			{"sampler2DArray", "int", "Sampler"},
+			{"sampler3D", "int", "Sampler"},
+			{"int", "int", "Int"},
+			{"float", "float", "Float"},
+			{"vec2", "glm::vec2", "Vec2"},
+			{"vec3", "glm::vec3", "Vec3"},
+			{"vec4", "glm::vec4", "Vec4"},
+			{"mat4", "glm::mat4", "Mat4"},
+	};
+
+	struct Declaration
+	{
+		std::string type;
+		std::string name;
+		int arraySize = 1;
+		// The location from the layout qualifier. -1, if there is no one.
+		int location = -1;
+		// file:line for error messages.
+		std::string origin;
+	};
+
+	struct Program
+	{
+		std::string name;
+		std::vector<Declaration> uniforms;
+		std::vector<Declaration> attributes;
+	};
+
+	struct Line
+	{
+		std::string text;
+		std::string origin;
+	};
+
+
+	const GlslType* findGlslType(std::string_view name)
+	{
+		for (const GlslType& type : GLSL_TYPES) {
+			if (type.glslName == name) {
+				return &type;
+			}
+		}
+		return nullptr;
+	}
+
+
+	std::optional<std::string> readFile(const std::filesystem::path& filePath)
+	{
+		auto inputFile = std::ifstream(filePath, std::ios::binary);
+		if (!inputFile) {
+			return std::nullopt;
+		}
+		std::stringstream ss;
+		ss << inputFile.rdbuf();
+		return ss.str();
+	}
+
+
+	std::string_view trim(std::string_view text)
+	{
+		const size_t start = text.find_first_not_of(" \t\r\n");
+		if (start == std::string_view::npos) {
+			return {};
+		}
+		const size_t end = text.find_last_not_of(" \t\r\n");
+		return text.substr(start, end - start + 1);
+	}
+
+
+	/**
+	 * Reads the file with its includes into lines without comments and preprocessor directives.
+	 * All conditional branches are kept: the interface covers all permutations.
+	 */
+	bool readLines(const std::filesystem::path& filePath, std::set<std::string>& includedFiles, std::vector<Line>& lines)
+	{
+		const std::string normalizedPath = filePath.lexically_normal().generic_string();
+		if (!includedFiles.insert(normalizedPath).second) {
+			return true;
+		}
+
+		const std::optional<std::string> text = readFile(filePath);
+		if (!text) {
+			std::cerr << normalizedPath << ": error: the file can't be opened" << std::endl;
+			return false;
+		}
+
+		bool isInBlockComment = false;
+		int lineNumber = 0;
+		std::istringstream stream(*text);
+		std::string rawLine;
+		while (std::getline(stream, rawLine)) {
+			++lineNumber;
+			const std::string origin = normalizedPath + ":" + std::to_string(lineNumber);
+
+			// Strip comments.
+			std::string line;
+			for (size_t i = 0; i < rawLine.size(); ++i) {
+				if (isInBlockComment) {
+					if (rawLine.compare(i, 2, "*/") == 0) {
+						isInBlockComment = false;
+						++i;
+					}
+					continue;
+				}
+				if (rawLine.compare(i, 2, "//") == 0) {
+					break;
+				}
+				if (rawLine.compare(i, 2, "/*") == 0) {
+					isInBlockComment = true;
+					++i;
+					continue;
+				}
+				line.push_back(rawLine[i]);
+			}
+
+			const std::string_view trimmedLine = trim(line);
+			if (trimmedLine.starts_with('#')) {
+				const std::string_view directive = trim(trimmedLine.substr(1));
+				if (directive.starts_with("include")) {
+					const size_t openQuote = directive.find('"');
+					const size_t closeQuote = directive.find('"', openQuote + 1);
+					if (openQuote == std::string_view::npos || closeQuote == std::string_view::npos) {
+						std::cerr << origin << ": error: malformed #include" << std::endl;
+						return false;
+					}
+					const std::string_view includeName = directive.substr(openQuote + 1, closeQuote - openQuote - 1);
+					if (!readLines(filePath.parent_path() / includeName, includedFiles, lines)) {
+						std::cerr << origin << ": note: included from here" << std::endl;
+						return false;
+					}
+				}
+				continue;
+			}
+
+			lines.push_back({line, origin});
+		}
+
+		return true;
+	}
+
+
+	std::vector<std::string> tokenize(std::string_view statement)
+	{
+		std::vector<std::string> tokens;
+		size_t i = 0;
+		while (i < statement.size()) {
+			const char c = statement[i];
+			if (std::isspace(static_cast<unsigned char>(c))) {
+				++i;
+			} else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_') {
+				const size_t start = i;
+				while (i < statement.size() && (std::isalnum(static_cast<unsigned char>(statement[i])) || statement[i] == '_')) {
+					++i;
+				}
+				tokens.emplace_back(statement.substr(start, i - start));
+			} else {
+				tokens.emplace_back(1, c);
+				++i;
+			}
+		}
+		return tokens;
+	}
+
+
+	enum class ParseResult
+	{
+		NotDeclaration,
+		Declaration,
+		// The error is printed.
+		Error,
+	};
+
+
+	/**
+	 * Parses a location or an array size. They must be literals: the generator doesn't evaluate macros.
+	 */
+	bool parseLiteral(const std::string& token, const char* what, const Declaration& declaration, int& outValue)
+	{
+		const char* end = token.data() + token.size();
+		const std::from_chars_result result = std::from_chars(token.data(), end, outValue);
+		if (result.ec != std::errc() || result.ptr != end) {
+			std::cerr << declaration.origin << ": error: non-literal " << what << ": " << token << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+
+	/**
+	 * Parses a global declaration like: layout (location = 0) in vec3 aPos
+	 */
+	ParseResult parseDeclaration(const std::vector<std::string>& tokens, std::string& storage, Declaration& declaration)
+	{
+		size_t i = 0;
+		if (i < tokens.size() && tokens[i] == "layout") {
+			++i;
+			if (i >= tokens.size() || tokens[i] != "(") {
+				return ParseResult::NotDeclaration;
+			}
+			for (++i; i < tokens.size() && tokens[i] != ")"; ++i) {
+				if (tokens[i] == "location" && i + 2 < tokens.size() && tokens[i + 1] == "="
+						&& !parseLiteral(tokens[i + 2], "location", declaration, declaration.location)) {
+					return ParseResult::Error;
+				}
+			}
+			++i;
+		}
+
+		constexpr std::string_view skippedQualifiers[] = {"flat", "smooth", "noperspective", "highp", "mediump", "lowp"};
+		storage.clear();
+		for (; i < tokens.size(); ++i) {
+			const std::string& token = tokens[i];
+			if (token == "uniform" || token == "in") {
+				storage = token;
+			} else if (std::find(std::begin(skippedQualifiers), std::end(skippedQualifiers), token) == std::end(skippedQualifiers)) {
+				break;
+			}
+		}
+
+		if (storage.empty() || i + 1 >= tokens.size()) {
+			return ParseResult::NotDeclaration;
+		}
+		declaration.type = tokens[i];
+		declaration.name = tokens[i + 1];
+		i += 2;
+		if (i + 2 < tokens.size() && tokens[i] == "[" && tokens[i + 2] == "]"
+				&& !parseLiteral(tokens[i + 1], "array size", declaration, declaration.arraySize)) {
+			return ParseResult::Error;
+		}
+		return ParseResult::Declaration;
+	}
+
+
+	/**
+	 * Collects global declarations of the file. Blocks (uniform blocks, structs, functions) are skipped:
+	 * the members of uniform blocks are fed through buffers, not through the uniform store.
+	 */
+	bool parseShader(const std::filesystem::path& filePath, bool isVertexShader, Program& program)
+	{
+		std::set<std::string> includedFiles;
+		std::vector<Line> lines;
+		if (!readLines(filePath, includedFiles, lines)) {
+			return false;
+		}
+
+		int braceDepth = 0;
+		std::string statement;
+		std::string statementOrigin;
+		for (const Line& line : lines) {
+			for (const char c : line.text) {
+				if (c == '{') {
+					++braceDepth;
+					statement.clear();
+					continue;
+				}
+				if (c == '}') {
+					--braceDepth;
+					continue;
+				}
+				if (braceDepth > 0) {
+					continue;
+				}
+				if (c != ';') {
+					if (trim(statement).empty()) {
+						statementOrigin = line.origin;
+					}
+					statement.push_back(c);
+					continue;
+				}
+
+				std::string storage;
+				Declaration declaration;
+				declaration.origin = statementOrigin;
+				const std::vector<std::string> tokens = tokenize(statement);
+				statement.clear();
+				const ParseResult result = parseDeclaration(tokens, storage, declaration);
+				if (result == ParseResult::Error) {
+					return false;
+				}
+				if (result == ParseResult::NotDeclaration) {
+					continue;
+				}
+
+				if (storage == "uniform") {
+					if (findGlslType(declaration.type) == nullptr) {
+						std::cerr << declaration.origin << ": error: unsupported uniform type: " << declaration.type << std::endl;
+						return false;
+					}
+					program.uniforms.push_back(declaration);
+				} else if (isVertexShader) {
+					if (declaration.location < 0) {
+						std::cerr << declaration.origin << ": error: vertex attribute without explicit location: "
+								<< declaration.name << std::endl;
+						return false;
+					}
+					program.attributes.push_back(declaration);
+				}
+			}
+			statement.push_back('\n');
+		}
+
+		return true;
+	}
+
+
+	std::string makeTypeName(std::string_view programName)
+	{
+		std::string result;
+		bool isWordStart = true;
+		for (const char c : programName) {
+			if (!std::isalnum(static_cast<unsigned char>(c))) {
+				isWordStart = true;
+				continue;
+			}
+			result.push_back(isWordStart ? (char) std::toupper(static_cast<unsigned char>(c)) : c);
+			isWordStart = false;
+		}
+		return result;
+	}
+
+
+	std::string generateHeader(const std::vector<Program>& programs, const std::vector<Declaration>& uniforms)
+	{
+		std::ostringstream out;
+		out << "// Generated by ShaderInterfaceGenerator from assets/shaders. Don't edit it.\n"
+				<< "#pragma once\n"
+				<< "\n"
+				<< "#include \"ShaderUniformSlot.hpp\"\n"
+				<< "\n"
+				<< "#include <array>\n"
+				<< "\n"
+				<< "#include <glm/mat4x4.hpp>\n"
+				<< "#include <glm/vec2.hpp>\n"
+				<< "#include <glm/vec3.hpp>\n"
+				<< "#include <glm/vec4.hpp>\n"
+				<< "\n"
+				<< "\n"
+				<< "namespace ShaderInterface {\n"
+				<< "\t// Uniforms of all programs. The slot of a uniform is the same in every store.\n"
+				<< "\tnamespace Uniforms {\n";
+		for (size_t slot = 0; slot < uniforms.size(); ++slot) {
+			const Declaration& uniform = uniforms[slot];
+			const GlslType* type = findGlslType(uniform.type);
+			out << "\t\tinline constexpr ShaderUniformSlot<" << type->cppType << "> " << uniform.name
+					<< " = {" << slot << ", \"" << uniform.name << "\", ShaderUniform::Type::" << type->uniformType
+					<< ", " << uniform.arraySize << "};\n";
+		}
+		out << "\t}\n"
+				<< "\n"
+				<< "\t// The names in the slot order. Pass them to ShaderUniformStore::setPredefinedSlots().\n"
+				<< "\tinline constexpr std::array<UniformName, " << uniforms.size() << "> UNIFORM_NAMES = {\n";
+		for (const Declaration& uniform : uniforms) {
+			out << "\t\t\tUniforms::" << uniform.name << ".name,\n";
+		}
+		out << "\t};\n";
+
+		for (const Program& program : programs) {
+			out << "\n"
+					<< "\t// " << program.name << ".vsh, " << program.name << ".fsh\n"
+					<< "\tstruct " << makeTypeName(program.name) << "\n"
+					<< "\t{\n";
+			for (const Declaration& attribute : program.attributes) {
+				out << "\t\t// in " << attribute.type << " " << attribute.name << "\n"
+						<< "\t\tstatic constexpr unsigned int " << attribute.name << " = " << attribute.location << ";\n";
+			}
+			for (const Declaration& uniform : program.uniforms) {
+				out << "\t\tstatic constexpr const auto& " << uniform.name << " = Uniforms::" << uniform.name << ";\n";
+			}
+			out << "\t};\n";
+		}
+		out << "}\n";
+
+		return out.str();
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3) {
+		std::cerr << "Usage: ShaderInterfaceGenerator <shaders directory> <output header>" << std::endl;
+		return 1;
+	}
+	const std::filesystem::path shadersDirectory = argv[1];
+	const std::filesystem::path outputFile = argv[2];
+
+	std::vector<std::string> programNames;
+	std::error_code errorCode;
+	for (const auto& entry : std::filesystem::directory_iterator(shadersDirectory, errorCode)) {
+		if (entry.path().extension() == ".vsh") {
+			programNames.push_back(entry.path().stem().string());
+		}
+	}
+	if (errorCode) {
+		std::cerr << shadersDirectory.generic_string() << ": error: " << errorCode.message() << std::endl;
+		return 1;
+	}
+	std::sort(programNames.begin(), programNames.end());
+
+	std::vector<Program> programs;
+	// Uniforms of all programs by names. std::map keeps the slot order stable.
+	std::map<std::string, Declaration> uniformsByName;
+	for (const std::string& programName : programNames) {
+		Program& program = programs.emplace_back();
+		program.name = programName;
+		const bool isParsed = parseShader(shadersDirectory / (programName + ".vsh"), true, program)
+				&& parseShader(shadersDirectory / (programName + ".fsh"), false, program);
+		if (!isParsed) {
+			return 1;
+		}
+
+		// A uniform declared in both stages is one uniform of the program.
+		std::vector<Declaration> programUniforms;
+		for (const Declaration& uniform : program.uniforms) {
+			const auto [it, isInserted] = uniformsByName.try_emplace(uniform.name, uniform);
+			const Declaration& known = it->second;
+			if (known.type != uniform.type || known.arraySize != uniform.arraySize) {
+				std::cerr << uniform.origin << ": error: uniform " << uniform.name << " is declared as " << uniform.type
+						<< "[" << uniform.arraySize << "]" << ", but it's " << known.type << "[" << known.arraySize << "]"
+						<< " in " << known.origin << std::endl;
+				return 1;
+			}
+			const bool isDuplicate = std::any_of(programUniforms.begin(), programUniforms.end(), [&](const Declaration& d) {
+				return d.name == uniform.name;
+			});
+			if (!isDuplicate) {
+				programUniforms.push_back(uniform);
+			}
+		}
+		program.uniforms = programUniforms;
+	}
+
+	std::vector<Declaration> uniforms;
+	for (const auto& [name, uniform] : uniformsByName) {
+		uniforms.push_back(uniform);
+	}
+
+	const std::string header = generateHeader(programs, uniforms);
+	if (readFile(outputFile) == header) {
+		return 0;
+	}
+
+	std::filesystem::create_directories(outputFile.parent_path(), errorCode);
+	auto output = std::ofstream(outputFile, std::ios::binary | std::ios::trunc);
+	output << header;
+	if (!output) {
+		std::cerr << outputFile.generic_string() << ": error: the file can't be written" << std::endl;
+		return 1;
+	}
+
+	std::cout << "[ShaderInterfaceGenerator] Generated: " << outputFile.generic_string() << std::endl;
+	return 0;
+}